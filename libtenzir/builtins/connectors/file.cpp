@@ -10,11 +10,12 @@
 #include <tenzir/concept/parseable/tenzir/data.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
 #include <tenzir/concept/parseable/to.hpp>
+#include <tenzir/config.hpp>
 #include <tenzir/defaults.hpp>
 #include <tenzir/detail/env.hpp>
-#include <tenzir/detail/fdinbuf.hpp>
 #include <tenzir/detail/fdoutbuf.hpp>
 #include <tenzir/detail/file_path_to_plugin_name.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/detail/posix.hpp>
 #include <tenzir/detail/string.hpp>
 #include <tenzir/diagnostics.hpp>
@@ -31,6 +32,8 @@
 #include <fcntl.h>
 #include <filesystem>
 #include <memory>
+#include <poll.h>
+#include <span>
 #include <string_view>
 #include <unistd.h>
 #include <variant>
@@ -230,12 +233,71 @@ private:
   bool close_;
 };
 
+// We use 2^20 for the upper bound of a chunk size, which exactly matches the
+// upper limit defined by execution nodes for transporting events.
+// TODO: Get the backpressure-adjusted value at runtime from the execution node.
+constexpr size_t file_loader_chunk_size = 1 << 20;
+
+struct read_result {
+  /// The number of bytes read; zero indicates EOF or a timeout.
+  size_t bytes = 0;
+  /// Whether no data became available within the read timeout.
+  bool timed_out = false;
+};
+
+/// Reads up to *size* bytes from *fd* into *buffer* with a single call to
+/// `read(2)`, waiting at most *timeout* for data to become available.
+///
+/// Like `detail::fdinbuf`, this treats read errors as EOF, and does not switch
+/// the file descriptor to non-blocking mode as it might refer to stdin.
+auto read_some(int fd, std::byte* buffer, size_t size,
+               std::chrono::milliseconds timeout) -> read_result {
+  auto pfd = pollfd{fd, POLLIN, 0};
+  auto res = int{};
+  while ((res = ::poll(&pfd, 1, detail::narrow_cast<int>(timeout.count())))
+         == -1) {
+    if (errno != EINTR) {
+      break;
+    }
+  }
+  if (res == 0) {
+    return {.bytes = 0, .timed_out = true};
+  }
+  if (res < 1 or not((pfd.revents & POLLIN) or (pfd.revents & POLLHUP))) {
+    return {};
+  }
+  auto n = ssize_t{};
+  do {
+    n = ::read(fd, buffer, size);
+  } while (n < 0 and errno == EINTR);
+  if (n <= 0) {
+    return {};
+  }
+  return {.bytes = static_cast<size_t>(n)};
+}
+
+/// Turns the first *size* bytes of *buffer* into a chunk. Full buffers are
+/// handed over to the chunk without a copy and *buffer* is reset. Mostly empty
+/// buffers, which occur on timeouts or at the end of the input, are copied to
+/// avoid pinning a large allocation for a few bytes; *buffer* is then kept for
+/// the next read.
+auto make_chunk(std::unique_ptr<std::byte[]>& buffer, size_t size)
+  -> chunk_ptr {
+  if (size == 0) {
+    return chunk::make_empty();
+  }
+  if (size < file_loader_chunk_size / 4) {
+    return chunk::copy(std::span{buffer.get(), size});
+  }
+  auto* data = buffer.get();
+  return chunk::make(data, size, [buffer = std::move(buffer)]() noexcept {
+    static_cast<void>(buffer);
+  });
+}
+
 class file_loader final : public plugin_loader {
 public:
-  // We use 2^20 for the upper bound of a chunk size, which exactly matches the
-  // upper limit defined by execution nodes for transporting events.
-  // TODO: Get the backpressure-adjusted value at runtime from the execution node.
-  static constexpr size_t max_chunk_size = 1 << 20;
+  static constexpr size_t max_chunk_size = file_loader_chunk_size;
 
   file_loader() = default;
 
@@ -246,31 +308,34 @@ public:
     -> std::optional<generator<chunk_ptr>> override {
     auto make = [](std::chrono::milliseconds timeout, fd_wrapper fd,
                    bool following) -> generator<chunk_ptr> {
-      auto in_buf = detail::fdinbuf(fd, max_chunk_size);
-      in_buf.read_timeout() = timeout;
-      auto current_data = std::vector<std::byte>{};
-      current_data.reserve(max_chunk_size);
+#if TENZIR_LINUX
+      // Tell the kernel that we read sequentially so that it reads ahead more
+      // aggressively. This fails harmlessly for pipes and sockets.
+      static_cast<void>(::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL));
+#endif
+      auto buffer = std::unique_ptr<std::byte[]>{};
+      auto size = size_t{0};
       auto eof_reached = false;
       while (following or not eof_reached) {
-        auto current_char = in_buf.sbumpc();
-        if (current_char != detail::fdinbuf::traits_type::eof()) {
-          current_data.emplace_back(static_cast<std::byte>(current_char));
+        if (not buffer) {
+          // Intentionally not value-initialized: read(2) overwrites the bytes.
+          buffer = std::unique_ptr<std::byte[]>{new std::byte[max_chunk_size]};
+          size = 0;
+        }
+        auto result
+          = read_some(fd, buffer.get() + size, max_chunk_size - size, timeout);
+        size += result.bytes;
+        if (result.bytes != 0 and size < max_chunk_size) {
+          continue;
+        }
+        eof_reached = result.bytes == 0 and not result.timed_out;
+        if (eof_reached and size == 0 and not following) {
+          break;
         }
-        if (current_char == detail::fdinbuf::traits_type::eof()
-            or current_data.size() == max_chunk_size) {
-          eof_reached = (current_char == detail::fdinbuf::traits_type::eof()
-                         and not in_buf.timed_out());
-          if (eof_reached and current_data.empty() and not following) {
-            break;
-          }
-          // Note that we copy and manually clear here rather than moving the
-          // buffer into the chunk and reserving again to avoid excess memory
-          // usage from unused capacity.
-          co_yield chunk::copy(current_data);
-          if (eof_reached and not following) {
-            break;
-          }
-          current_data.clear();
+        co_yield make_chunk(buffer, size);
+        size = 0;
+        if (eof_reached and not following) {
+          break;
         }
       }
       co_return;
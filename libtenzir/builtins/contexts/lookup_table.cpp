@@ -9,11 +9,15 @@
 #include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/concept/parseable/numeric/bool.hpp>
 #include <tenzir/data.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/detail/range_map.hpp>
 #include <tenzir/expression.hpp>
 #include <tenzir/fbs/data.hpp>
+#include <tenzir/fbs/lookup_table.hpp>
+#include <tenzir/fbs/utils.hpp>
 #include <tenzir/flatbuffer.hpp>
 #include <tenzir/fwd.hpp>
+#include <tenzir/hash/hash.hpp>
 #include <tenzir/operator.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/series.hpp>
@@ -25,26 +29,123 @@
 #include <arrow/array.h>
 #include <arrow/array/array_base.h>
 #include <arrow/array/builder_primitive.h>
+#include <arrow/array/concatenate.h>
+#include <arrow/buffer_builder.h>
+#include <arrow/compute/api.h>
+#include <arrow/scalar.h>
 #include <arrow/type.h>
 #include <caf/error.hpp>
 #include <caf/sum_type.hpp>
 #include <tsl/robin_map.h>
 
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <tuple>
 
 namespace tenzir::plugins::lookup_table {
 
 namespace {
 
+/// The number of overwritten entries from which on an update compacts the
+/// stored batches, provided that they also outnumber the live entries.
+constexpr auto min_dead_rows_for_compaction = size_t{65'536};
+
+/// The types of keys that have a dedicated index. Keys of all other types are
+/// indexed by their materialized `data`.
+template <class Type>
+concept indexed_key_type
+  = detail::is_any_v<Type, bool_type, int64_type, uint64_type, double_type,
+                     duration_type, time_type, string_type, ip_type>;
+
+/// Hashes keys such that equal keys have equal hashes, including owned keys
+/// and their views.
+struct key_hash {
+  using is_transparent = void;
+
+  template <class T>
+  auto operator()(const T& x) const noexcept -> size_t {
+    if constexpr (std::is_same_v<T, data>) {
+      return std::hash<data>{}(x);
+    } else if constexpr (std::is_same_v<T, double>) {
+      // Positive and negative zero compare equal.
+      return tenzir::hash(x == 0.0 ? 0.0 : x);
+    } else {
+      return tenzir::hash(x);
+    }
+  }
+};
+
+/// Refers to the row of a stored batch that holds the context for a key.
+struct entry {
+  uint32_t batch = {};
+  uint32_t row = {};
+};
+
+template <class Key>
+using key_index = tsl::robin_map<Key, entry, key_hash, std::equal_to<>>;
+
+/// One hash index per key type.
+using key_indices
+  = std::tuple<key_index<bool>, key_index<int64_t>, key_index<uint64_t>,
+               key_index<double>, key_index<duration>, key_index<time>,
+               key_index<std::string>, key_index<ip>, key_index<data>>;
+
+/// Returns the storage array of a key array, unwrapping extension types.
+template <concrete_type Type>
+auto storage_array(const arrow::Array& array)
+  -> const type_to_arrow_array_storage_t<Type>& {
+  if constexpr (arrow::is_extension_type<type_to_arrow_type_t<Type>>::value) {
+    return caf::get<type_to_arrow_array_storage_t<Type>>(
+      *caf::get<type_to_arrow_array_t<Type>>(array).storage());
+  } else {
+    return caf::get<type_to_arrow_array_t<Type>>(array);
+  }
+}
+
+/// Calls `f(row, index, key)` for every row of an array of keys, where
+/// `index` is the index responsible for keys of the array's type. Null keys
+/// are looked up as null `data`.
+template <class Indices, class F>
+void visit_keys(Indices& indices, const type& key_type,
+                const arrow::Array& keys, F&& f) {
+  auto& fallback = std::get<key_index<data>>(indices);
+  auto g = [&]<concrete_type Type>([[maybe_unused]] const Type& type) {
+    if constexpr (indexed_key_type<Type>) {
+      auto& index = std::get<key_index<type_to_data_t<Type>>>(indices);
+      const auto& array = storage_array<Type>(keys);
+      for (auto row = int64_t{0}; row < array.length(); ++row) {
+        if (array.IsNull(row)) {
+          f(row, fallback, data{});
+        } else {
+          f(row, index, value_at(type, array, row));
+        }
+      }
+    } else {
+      auto row = int64_t{0};
+      for (auto&& value : values(key_type, keys)) {
+        f(row++, fallback, materialize(value));
+      }
+    }
+  };
+  caf::visit(g, key_type);
+}
+
 class ctx final : public virtual context {
 public:
   ctx() noexcept = default;
 
-  explicit ctx(tsl::robin_map<data, data> context_entries) noexcept
-    : context_entries{std::move(context_entries)} {
-    // nop
+  /// Creates a context from table slices with the fields `key` and `context`
+  /// that have no duplicate keys.
+  explicit ctx(std::vector<table_slice> slices) {
+    for (auto& slice : slices) {
+      if (slice.rows() > 0) {
+        add_batch(std::move(slice), nullptr);
+      }
+    }
   }
 
   /// Emits context information for every event in `slice` in order.
@@ -66,26 +167,50 @@ public:
     if (not field_name) {
       return caf::make_error(ec::invalid_argument, "missing argument `field`");
     }
-    auto field_builder = series_builder{};
     auto column_offset = slice.schema().resolve_key_or_concept(*field_name);
     if (not column_offset) {
+      auto field_builder = series_builder{};
       for (auto i = size_t{0}; i < slice.rows(); ++i) {
         field_builder.null();
       }
       return field_builder.finish();
     }
-    auto keys = series{resolved_slice, *column_offset};
-    for (const auto& value : keys.values()) {
-      if (auto it = context_entries.find(value); it != context_entries.end()) {
-        auto r = field_builder.record();
-        r.field("key", it->first);
-        r.field("context", it->second);
-        r.field("timestamp", std::chrono::system_clock::now());
+    auto [key_type, key_array] = column_offset->get(resolved_slice);
+    const auto entries = probe(key_type, *key_array);
+    const auto now = time{std::chrono::system_clock::now()};
+    // We emit one series per run of rows whose context shares a schema, with
+    // unmatched rows joining the surrounding run.
+    auto result = std::vector<series>{};
+    auto begin = size_t{0};
+    while (begin < entries.size()) {
+      auto schema_id = std::optional<uint32_t>{};
+      auto end = begin;
+      for (; end < entries.size(); ++end) {
+        if (not entries[end]) {
+          continue;
+        }
+        const auto current = batch_schemas_[entries[end]->batch];
+        if (not schema_id) {
+          schema_id = current;
+        } else if (*schema_id != current) {
+          break;
+        }
+      }
+      const auto length = detail::narrow_cast<int64_t>(end - begin);
+      if (not schema_id) {
+        result.emplace_back(null_type{},
+                            arrow::MakeArrayOfNull(arrow::null(), length)
+                              .ValueOrDie());
       } else {
-        field_builder.null();
+        result.push_back(gather(key_type,
+                                key_array->Slice(
+                                  detail::narrow_cast<int64_t>(begin), length),
+                                std::span{entries}.subspan(begin, end - begin),
+                                *schema_id, now));
       }
+      begin = end;
     }
-    return field_builder.finish();
+    return result;
   }
 
   auto snapshot(parameter_map parameters) const
@@ -95,20 +220,26 @@ public:
       return caf::make_error(ec::invalid_argument, "missing 'field' parameter");
     }
     auto keys = list{};
-    keys.reserve(context_entries.size());
+    keys.reserve(num_entries());
     auto first_index = std::optional<size_t>{};
-    for (const auto& [k, _] : context_entries) {
-      keys.emplace_back(k);
-      auto current_index = k.get_data().index();
-      if (not first_index) [[unlikely]] {
-        first_index = current_index;
-      } else if (*first_index != current_index) [[unlikely]] {
-        // TODO: With the language revamp, we should get heterogeneous lookups
-        // for free.
-        return caf::make_error(ec::unimplemented,
-                               "lookup-table does not support snapshots for "
-                               "heterogeneous keys");
+    auto heterogeneous = false;
+    for_each_index([&](const auto& index) {
+      for (const auto& [k, _] : index) {
+        auto& key = keys.emplace_back(k);
+        auto current_index = key.get_data().index();
+        if (not first_index) [[unlikely]] {
+          first_index = current_index;
+        } else if (*first_index != current_index) [[unlikely]] {
+          heterogeneous = true;
+        }
       }
+    });
+    if (heterogeneous) {
+      // TODO: With the language revamp, we should get heterogeneous lookups
+      // for free.
+      return caf::make_error(ec::unimplemented,
+                             "lookup-table does not support snapshots for "
+                             "heterogeneous keys");
     }
     return expression{
       predicate{
@@ -121,7 +252,7 @@ public:
 
   /// Inspects the context.
   auto show() const -> record override {
-    return record{{"num_entries", context_entries.size()}};
+    return record{{"num_entries", num_entries()}};
   }
 
   /// Updates the context.
@@ -131,7 +262,7 @@ public:
     if (parameters.contains("clear")) {
       auto clear = parameters["clear"];
       if (not clear or (clear and clear->empty())) {
-        context_entries.clear();
+        reset();
       } else if (clear) {
         auto clear_v = false;
         if (not parsers::boolean(*clear, clear_v)) {
@@ -140,7 +271,7 @@ public:
                                  "boolean <true/false>");
         }
         if (clear_v) {
-          context_entries.clear();
+          reset();
         }
       }
     }
@@ -158,24 +289,28 @@ public:
       // If there's no key column then we cannot do much.
       return update_result{record{}};
     }
+    // We store the slice as a batch with the fields `key` and `context`,
+    // which is exactly what we emit for matching rows.
     auto [key_type, key_array] = key_column->get(slice);
     auto context_array = std::static_pointer_cast<arrow::Array>(
       to_record_batch(slice)->ToStructArray().ValueOrDie());
-    auto key_values = values(key_type, *key_array);
+    auto schema = type{
+      "tenzir.lookup_table",
+      record_type{
+        {"key", key_type},
+        {"context", type{caf::get<record_type>(slice.schema())}},
+      },
+    };
+    auto batch
+      = arrow::RecordBatch::Make(schema.to_arrow_schema(), key_array->length(),
+                                 {key_array, context_array});
     auto key_values_list = list{};
-    auto context_values = values(slice.schema(), *context_array);
-    auto key_it = key_values.begin();
-    auto context_it = context_values.begin();
-    while (key_it != key_values.end()) {
-      TENZIR_ASSERT_CHEAP(context_it != context_values.end());
-      auto materialized_key = materialize(*key_it);
-      context_entries.insert_or_assign(materialized_key,
-                                       materialize(*context_it));
-      key_values_list.emplace_back(materialized_key);
-      ++key_it;
-      ++context_it;
+    key_values_list.reserve(slice.rows());
+    add_batch(table_slice{batch, schema}, &key_values_list);
+    if (dead_rows_ >= min_dead_rows_for_compaction
+        and dead_rows_ > num_entries()) {
+      compact();
     }
-    TENZIR_ASSERT_CHEAP(context_it == context_values.end());
     auto query_f = [key_values_list = std::move(key_values_list)](
                      parameter_map params) -> caf::expected<expression> {
       auto column = params["field"];
@@ -208,40 +343,330 @@ public:
   }
 
   auto save() const -> caf::expected<chunk_ptr> override {
-    // We save the context by formatting into a record of this format:
-    //   [{key: key, value: value}, ...]
+    // We save the live entries as one table slice per schema in the Arrow IPC
+    // format, so that loading the context does not need to copy them.
     auto builder = flatbuffers::FlatBufferBuilder{};
-    auto value_offsets = std::vector<flatbuffers::Offset<fbs::Data>>{};
-    value_offsets.reserve(context_entries.size());
-    for (const auto& [key, value] : context_entries) {
-      auto field_offsets
-        = std::vector<flatbuffers::Offset<fbs::data::RecordField>>{};
-      field_offsets.reserve(2);
-      const auto key_key_offset = builder.CreateSharedString("key");
-      const auto key_value_offset = pack(builder, key);
-      field_offsets.emplace_back(fbs::data::CreateRecordField(
-        builder, key_key_offset, key_value_offset));
-      const auto value_key_offset = builder.CreateSharedString("value");
-      const auto value_value_offset = pack(builder, value);
-      field_offsets.emplace_back(fbs::data::CreateRecordField(
-        builder, value_key_offset, value_value_offset));
-      const auto record_offset
-        = fbs::data::CreateRecordDirect(builder, &field_offsets);
-      value_offsets.emplace_back(fbs::CreateData(
-        builder, fbs::data::Data::record, record_offset.Union()));
+    auto slice_offsets
+      = std::vector<flatbuffers::Offset<fbs::FlatTableSlice>>{};
+    for (auto& slice : live_slices()) {
+      if (not slice.is_serialized()) {
+        slice = table_slice{to_record_batch(slice), slice.schema(),
+                            table_slice::serialize::yes};
+      }
+      const auto bytes = as_bytes(slice);
+      // Aligning the nested table slice keeps its Arrow buffers aligned.
+      builder.ForceVectorAlignment(bytes.size(), sizeof(uint8_t), 64);
+      const auto data_offset = builder.CreateVector(
+        reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+      slice_offsets.emplace_back(
+        fbs::CreateFlatTableSlice(builder, data_offset));
     }
-    const auto list_offset
-      = fbs::data::CreateListDirect(builder, &value_offsets);
-    const auto data_offset
-      = fbs::CreateData(builder, fbs::data::Data::list, list_offset.Union());
-    fbs::FinishDataBuffer(builder, data_offset);
-    return chunk::make(builder.Release());
+    const auto lookup_table_offset
+      = fbs::context::lookup_table::CreateLookupTableDataDirect(builder,
+                                                                &slice_offsets);
+    fbs::context::lookup_table::FinishLookupTableDataBuffer(
+      builder, lookup_table_offset);
+    return fbs::release(builder);
   }
 
 private:
-  tsl::robin_map<data, data> context_entries;
+  /// Returns the number of keys in the context.
+  auto num_entries() const -> size_t {
+    auto result = size_t{0};
+    for_each_index([&](const auto& index) {
+      result += index.size();
+    });
+    return result;
+  }
+
+  template <class F>
+  void for_each_index(F&& f) const {
+    std::apply(
+      [&](const auto&... index) {
+        (f(index), ...);
+      },
+      indices_);
+  }
+
+  /// Removes all entries.
+  void reset() {
+    indices_ = key_indices{};
+    batches_.clear();
+    batch_schemas_.clear();
+    context_types_.clear();
+    dead_rows_ = 0;
+  }
+
+  /// Stores a batch with the fields `key` and `context`, and indexes its
+  /// keys. Optionally collects the keys for the query of the update.
+  void add_batch(table_slice slice, list* keys) {
+    const auto batch_id = detail::narrow_cast<uint32_t>(batches_.size());
+    const auto& schema = caf::get<record_type>(slice.schema());
+    const auto key_type = schema.field(0).type;
+    const auto context_type = schema.field(1).type;
+    auto schema_id = std::find(context_types_.begin(), context_types_.end(),
+                               context_type)
+                     - context_types_.begin();
+    if (schema_id == std::ssize(context_types_)) {
+      context_types_.push_back(context_type);
+    }
+    batch_schemas_.push_back(detail::narrow_cast<uint32_t>(schema_id));
+    const auto key_array = to_record_batch(slice)->column(0);
+    batches_.push_back(std::move(slice));
+    visit_keys(indices_, key_type, *key_array,
+               [&](int64_t row, auto& index, const auto& key) {
+                 using index_key =
+                   typename std::remove_cvref_t<decltype(index)>::key_type;
+                 auto [_, inserted] = index.insert_or_assign(
+                   index_key{key},
+                   entry{batch_id, detail::narrow_cast<uint32_t>(row)});
+                 if (not inserted) {
+                   ++dead_rows_;
+                 }
+                 if (keys) {
+                   keys->emplace_back(index_key{key});
+                 }
+               });
+  }
+
+  /// Looks up the keys of an array, returning the take-indices into the
+  /// stored batches for every row.
+  auto probe(const type& key_type, const arrow::Array& keys) const
+    -> std::vector<std::optional<entry>> {
+    auto result = std::vector<std::optional<entry>>(
+      detail::narrow_cast<size_t>(keys.length()));
+    visit_keys(indices_, key_type, keys,
+               [&](int64_t row, const auto& index, const auto& key) {
+                 if (auto it = index.find(key); it != index.end()) {
+                   result[row] = it->second;
+                 }
+               });
+    return result;
+  }
+
+  /// Creates the series `{key, context, timestamp}` for a run of rows whose
+  /// entries refer only to batches of the same schema, with nulls for the
+  /// rows without an entry.
+  auto gather(const type& key_type, std::shared_ptr<arrow::Array> keys,
+              std::span<const std::optional<entry>> entries,
+              uint32_t schema_id, time now) const -> series {
+    const auto length = detail::narrow_cast<int64_t>(entries.size());
+    // Group the rows to take by the batch they are stored in. Afterwards, the
+    // position of a row in the concatenation of the groups is its offset in
+    // its group plus the total size of all preceding groups.
+    auto group_of = tsl::robin_map<uint32_t, size_t>{};
+    auto group_batches = std::vector<uint32_t>{};
+    auto group_rows = std::vector<std::vector<int64_t>>{};
+    auto positions = std::vector<std::pair<size_t, int64_t>>{};
+    positions.reserve(entries.size());
+    auto valid = arrow::TypedBufferBuilder<bool>{};
+    TENZIR_ASSERT_CHEAP(valid.Reserve(length).ok());
+    for (const auto& entry : entries) {
+      valid.UnsafeAppend(entry.has_value());
+      if (not entry) {
+        continue;
+      }
+      auto [it, inserted] = group_of.try_emplace(entry->batch, group_of.size());
+      if (inserted) {
+        group_batches.push_back(entry->batch);
+        group_rows.emplace_back();
+      }
+      auto& rows = group_rows[it->second];
+      positions.emplace_back(it->second, std::ssize(rows));
+      rows.push_back(entry->row);
+    }
+    auto make_indices = [](const auto& xs) {
+      auto builder = arrow::Int64Builder{};
+      TENZIR_ASSERT_CHEAP(builder.AppendValues(xs).ok());
+      return builder.Finish().ValueOrDie();
+    };
+    auto take = [](const std::shared_ptr<arrow::Array>& values,
+                   const std::shared_ptr<arrow::Array>& indices) {
+      return arrow::compute::Take(values, indices).ValueOrDie().make_array();
+    };
+    auto context_of = [&](uint32_t batch) {
+      return to_record_batch(batches_[batch])->column(1);
+    };
+    auto contexts = std::shared_ptr<arrow::Array>{};
+    auto indices = arrow::Int64Builder{};
+    TENZIR_ASSERT_CHEAP(indices.Reserve(length).ok());
+    auto position = positions.begin();
+    if (group_batches.size() == 1) {
+      // With a single batch, we can take from it directly.
+      contexts = context_of(group_batches[0]);
+      for (const auto& entry : entries) {
+        if (entry) {
+          indices.UnsafeAppend(entry->row);
+        } else {
+          indices.UnsafeAppendNull();
+        }
+      }
+    } else {
+      auto taken = arrow::ArrayVector{};
+      auto group_offsets = std::vector<int64_t>{};
+      auto offset = int64_t{0};
+      for (auto group = size_t{0}; group < group_batches.size(); ++group) {
+        taken.push_back(take(context_of(group_batches[group]),
+                             make_indices(group_rows[group])));
+        group_offsets.push_back(offset);
+        offset += std::ssize(group_rows[group]);
+      }
+      contexts = arrow::Concatenate(taken).ValueOrDie();
+      for (const auto& entry : entries) {
+        if (entry) {
+          indices.UnsafeAppend(group_offsets[position->first]
+                               + position->second);
+          ++position;
+        } else {
+          indices.UnsafeAppendNull();
+        }
+      }
+    }
+    contexts = take(contexts, indices.Finish().ValueOrDie());
+    auto timestamps
+      = arrow::MakeArrayFromScalar(
+          arrow::TimestampScalar{now.time_since_epoch().count(),
+                                 time_type::to_arrow_type()},
+          length)
+          .ValueOrDie();
+    const auto null_count = valid.false_count();
+    auto array = arrow::StructArray::Make(
+                   arrow::ArrayVector{std::move(keys), std::move(contexts),
+                                      std::move(timestamps)},
+                   std::vector<std::string>{"key", "context", "timestamp"},
+                   valid.Finish().ValueOrDie(), null_count)
+                   .ValueOrDie();
+    auto result_type = type{record_type{
+      {"key", key_type},
+      {"context", context_types_[schema_id]},
+      {"timestamp", time_type{}},
+    }};
+    return series{std::move(result_type), std::move(array)};
+  }
+
+  /// Returns the live entries with one table slice per schema.
+  auto live_slices() const -> std::vector<table_slice> {
+    auto live_rows = std::vector<std::vector<int64_t>>(batches_.size());
+    for_each_index([&](const auto& index) {
+      for (const auto& [_, entry] : index) {
+        live_rows[entry.batch].push_back(entry.row);
+      }
+    });
+    auto slices_per_schema
+      = std::vector<std::vector<table_slice>>(context_types_.size());
+    for (auto batch = size_t{0}; batch < batches_.size(); ++batch) {
+      auto& rows = live_rows[batch];
+      if (rows.empty()) {
+        continue;
+      }
+      auto& slices = slices_per_schema[batch_schemas_[batch]];
+      if (rows.size() == batches_[batch].rows()) {
+        slices.push_back(batches_[batch]);
+        continue;
+      }
+      std::sort(rows.begin(), rows.end());
+      auto builder = arrow::Int64Builder{};
+      TENZIR_ASSERT_CHEAP(builder.AppendValues(rows).ok());
+      auto taken = arrow::compute::Take(to_record_batch(batches_[batch]),
+                                        builder.Finish().ValueOrDie())
+                     .ValueOrDie()
+                     .record_batch();
+      slices.emplace_back(taken, batches_[batch].schema());
+    }
+    auto result = std::vector<table_slice>{};
+    for (auto& slices : slices_per_schema) {
+      if (not slices.empty()) {
+        result.push_back(concatenate(std::move(slices)));
+      }
+    }
+    return result;
+  }
+
+  /// Drops the rows of overwritten keys from the stored batches.
+  void compact() {
+    auto slices = live_slices();
+    reset();
+    for (auto& slice : slices) {
+      add_batch(std::move(slice), nullptr);
+    }
+  }
+
+  /// The hash indices that map keys to their entries.
+  key_indices indices_ = {};
+
+  /// The stored batches with the fields `key` and `context`.
+  std::vector<table_slice> batches_ = {};
+
+  /// The index of the context type of every stored batch.
+  std::vector<uint32_t> batch_schemas_ = {};
+
+  /// The distinct context types of the stored batches.
+  std::vector<type> context_types_ = {};
+
+  /// The number of rows in the stored batches whose key was overwritten.
+  size_t dead_rows_ = {};
 };
 
+/// Loads a context that was saved in the format preceding the
+/// `LookupTableData` table, which is a list of `{key, value}` records.
+auto load_legacy_context(const fbs::Data& fb)
+  -> caf::expected<std::unique_ptr<context>> {
+  const auto* list = fb.data_as_list();
+  if (not list) {
+    return caf::make_error(ec::serialization_error,
+                           "failed to deserialize lookup table "
+                           "context: no valid list value for "
+                           "serialized context entry list");
+  }
+  if (not list->values()) {
+    return caf::make_error(ec::serialization_error,
+                           "failed to deserialize lookup table "
+                           "context: missing or invalid values for "
+                           "context entry in serialized entry list");
+  }
+  auto builder = series_builder{};
+  for (const auto* list_value : *list->values()) {
+    const auto* record = list_value->data_as_record();
+    if (not record) {
+      return caf::make_error(ec::serialization_error,
+                             "failed to deserialize lookup table "
+                             "context: invalid type for "
+                             "context entry in serialized entry list, "
+                             "entry must be a record");
+    }
+    if (not record->fields() or record->fields()->size() != 2) {
+      return caf::make_error(ec::serialization_error,
+                             "failed to deserialize lookup table "
+                             "context: invalid or missing value for "
+                             "context entry in serialized entry list, "
+                             "entry must be a record {key, value}");
+    }
+    data key;
+    data value;
+    auto err = unpack(*record->fields()->Get(0)->data(), key);
+    if (err) {
+      return caf::make_error(ec::serialization_error,
+                             fmt::format("failed to deserialize lookup "
+                                         "table "
+                                         "context: invalid key: {}",
+                                         err));
+    }
+    err = unpack(*record->fields()->Get(1)->data(), value);
+    if (err) {
+      return caf::make_error(ec::serialization_error,
+                             fmt::format("failed to deserialize lookup "
+                                         "table "
+                                         "context: invalid value: {}",
+                                         err));
+    }
+    auto row = builder.record();
+    row.field("key", key);
+    row.field("context", value);
+  }
+  return std::make_unique<ctx>(
+    builder.finish_as_table_slice("tenzir.lookup_table"));
+}
+
 class plugin : public virtual context_plugin {
   auto initialize(const record&, const record&) -> caf::error override {
     return caf::none;
@@ -258,67 +683,35 @@ class plugin : public virtual context_plugin {
 
   auto load_context(chunk_ptr serialized) const
     -> caf::expected<std::unique_ptr<context>> override {
-    auto fb = flatbuffer<fbs::Data>::make(std::move(serialized));
+    if (not fbs::context::lookup_table::LookupTableDataBufferHasIdentifier(
+          serialized->data())) {
+      auto fb = flatbuffer<fbs::Data>::make(std::move(serialized));
+      if (not fb) {
+        return caf::make_error(ec::serialization_error,
+                               fmt::format("failed to deserialize lookup "
+                                           "table context: {}",
+                                           fb.error()));
+      }
+      return load_legacy_context(**fb);
+    }
+    using lookup_table_flatbuffer
+      = flatbuffer<fbs::context::lookup_table::LookupTableData,
+                   fbs::context::lookup_table::LookupTableDataIdentifier>;
+    auto fb = lookup_table_flatbuffer::make(chunk_ptr{serialized});
     if (not fb) {
       return caf::make_error(ec::serialization_error,
                              fmt::format("failed to deserialize lookup table "
                                          "context: {}",
                                          fb.error()));
     }
-    auto context_entries = tsl::robin_map<data, data>{};
-    const auto* list = fb.value()->data_as_list();
-    if (not list) {
-      return caf::make_error(ec::serialization_error,
-                             "failed to deserialize lookup table "
-                             "context: no valid list value for "
-                             "serialized context entry list");
-    }
-    if (const auto* list = fb.value()->data_as_list()) {
-      if (not list->values()) {
-        return caf::make_error(ec::serialization_error,
-                               "failed to deserialize lookup table "
-                               "context: missing or invalid values for "
-                               "context entry in serialized entry list");
-      }
-      for (const auto* list_value : *list->values()) {
-        const auto* record = list_value->data_as_record();
-        if (not record) {
-          return caf::make_error(ec::serialization_error,
-                                 "failed to deserialize lookup table "
-                                 "context: invalid type for "
-                                 "context entry in serialized entry list, "
-                                 "entry must be a record");
-        }
-        if (not record->fields() or record->fields()->size() != 2) {
-          return caf::make_error(ec::serialization_error,
-                                 "failed to deserialize lookup table "
-                                 "context: invalid or missing value for "
-                                 "context entry in serialized entry list, "
-                                 "entry must be a record {key, value}");
-        }
-        data key;
-        data value;
-        auto err = unpack(*record->fields()->Get(0)->data(), key);
-        if (err) {
-          return caf::make_error(ec::serialization_error,
-                                 fmt::format("failed to deserialize lookup "
-                                             "table "
-                                             "context: invalid key: {}",
-                                             err));
-        }
-        err = unpack(*record->fields()->Get(1)->data(), value);
-        if (err) {
-          return caf::make_error(ec::serialization_error,
-                                 fmt::format("failed to deserialize lookup "
-                                             "table "
-                                             "context: invalid value: {}",
-                                             err));
-        }
-        context_entries.emplace(std::move(key), std::move(value));
-      }
+    // The table slices share the lifetime of the serialized context, which
+    // avoids copying the entries when the chunk is memory-mapped.
+    auto slices = std::vector<table_slice>{};
+    slices.reserve((*fb)->slices()->size());
+    for (const auto* flat_slice : *(*fb)->slices()) {
+      slices.emplace_back(*flat_slice, serialized, table_slice::verify::no);
     }
-
-    return std::make_unique<ctx>(std::move(context_entries));
+    return std::make_unique<ctx>(std::move(slices));
   }
 };
 
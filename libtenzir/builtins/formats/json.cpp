@@ -9,6 +9,7 @@
 #include <tenzir/argument_parser.hpp>
 #include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/cast.hpp>
+#include <tenzir/compiled_json_printer.hpp>
 #include <tenzir/concept/parseable/tenzir/data.hpp>
 #include <tenzir/concept/printable/tenzir/json.hpp>
 #include <tenzir/config_options.hpp>
@@ -16,7 +17,9 @@
 #include <tenzir/detail/assert.hpp>
 #include <tenzir/detail/env.hpp>
 #include <tenzir/detail/heterogeneous_string_hash.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/detail/padded_buffer.hpp>
+#include <tenzir/detail/string_inference.hpp>
 #include <tenzir/detail/string_literal.hpp>
 #include <tenzir/diagnostics.hpp>
 #include <tenzir/generator.hpp>
@@ -31,7 +34,9 @@
 #include <caf/typed_event_based_actor.hpp>
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <chrono>
+#include <future>
 #include <simdjson.h>
 
 namespace tenzir::plugins::json {
@@ -146,9 +151,11 @@ constexpr auto unknown_entry_name = std::string_view{};
 
 struct entry_data {
   explicit entry_data(std::string name,
-                      std::optional<std::reference_wrapper<const type>> schema)
+                      std::optional<std::reference_wrapper<const type>> schema,
+                      uint64_t string_inference_limit)
     : name{std::move(name)},
       builder{schema},
+      inference{string_inference_limit},
       flushed{std::chrono::steady_clock::now()} {
   }
 
@@ -160,12 +167,16 @@ struct entry_data {
 
   std::string name;
   series_builder builder;
+  detail::string_inference_cache inference;
   std::chrono::steady_clock::time_point flushed;
 };
 
 struct parser_state {
-  explicit parser_state(operator_control_plane& ctrl, bool preserve_order)
-    : ctrl_{ctrl}, preserve_order{preserve_order} {
+  explicit parser_state(operator_control_plane& ctrl, bool preserve_order,
+                        uint64_t string_inference_limit)
+    : ctrl_{ctrl},
+      preserve_order{preserve_order},
+      string_inference_limit{string_inference_limit} {
   }
 
   operator_control_plane& ctrl_;
@@ -181,6 +192,9 @@ struct parser_state {
   /// If this is false, then the JSON parser is allowed to reorder events
   /// between different schemas.
   bool preserve_order = true;
+  /// The number of plain strings after which the parser stops inferring types
+  /// for the strings of a field.
+  uint64_t string_inference_limit = 0;
 
   auto get_entry(size_t idx) -> entry_data& {
     TENZIR_ASSERT_CHEAP(idx < entries.size());
@@ -197,7 +211,8 @@ struct parser_state {
                  std::optional<std::reference_wrapper<const type>> schema
                  = std::nullopt) -> size_t {
     auto index = entries.size();
-    auto& entry = entries.emplace_back(std::move(name), schema);
+    auto& entry
+      = entries.emplace_back(std::move(name), schema, string_inference_limit);
     auto inserted = entry_map.try_emplace(entry.name, index).second;
     TENZIR_ASSERT_CHEAP(inserted);
     return index;
@@ -237,21 +252,25 @@ struct parser_state {
 
 class doc_parser {
 public:
-  doc_parser(std::string_view parsed_document, operator_control_plane& ctrl,
-             bool no_infer, bool raw)
+  doc_parser(std::string_view parsed_document, diagnostic_handler& diag,
+             bool no_infer, bool raw,
+             detail::string_inference_cache& inference)
     : parsed_document_{parsed_document},
-      ctrl_{ctrl},
+      diag_{diag},
       no_infer_{no_infer},
-      raw_{raw} {
+      raw_{raw},
+      inference_{inference} {
   }
 
-  doc_parser(std::string_view parsed_document, operator_control_plane& ctrl,
-             std::size_t parsed_lines, bool no_infer, bool raw)
+  doc_parser(std::string_view parsed_document, diagnostic_handler& diag,
+             std::size_t parsed_lines, bool no_infer, bool raw,
+             detail::string_inference_cache& inference)
     : parsed_document_{parsed_document},
-      ctrl_{ctrl},
+      diag_{diag},
       parsed_lines_{parsed_lines},
       no_infer_{no_infer},
-      raw_{raw} {
+      raw_{raw},
+      inference_{inference} {
   }
 
   [[nodiscard]] auto parse_object(simdjson::ondemand::value v,
@@ -283,9 +302,13 @@ public:
         // TODO: Consider whether we want to emit a diagnostic here.
         continue;
       }
+      const auto path_size = field_path_.size();
+      field_path_ += '.';
+      field_path_ += key;
       if (not parse_impl(val.value_unsafe(), field, depth + 1)) {
         return false;
       }
+      field_path_.resize(path_size);
     }
     return true;
   }
@@ -307,12 +330,12 @@ private:
                           std::move(description))
         .note("{} {} ...", note_prefix,
               document_to_truncate.substr(0, character_limit))
-        .emit(ctrl_.diagnostics());
+        .emit(diag_);
     }
     diagnostic::warning("failed to parse {} in the JSON document",
                         std::move(description))
       .note("{} {}", note_prefix, document_to_truncate)
-      .emit(ctrl_.diagnostics());
+      .emit(diag_);
   }
 
   void report_parse_err(auto& v, std::string description) {
@@ -329,14 +352,14 @@ private:
       diagnostic::warning("failed to parse {} in the JSON document",
                           std::move(description))
         .note("line {}", *parsed_lines_)
-        .emit(ctrl_.diagnostics());
+        .emit(diag_);
       return;
     }
     auto column = v.current_location().value_unsafe() - parsed_document_.data();
     diagnostic::warning("failed to parse {} in the JSON document",
                         std::move(description))
       .note("line {} column {}", *parsed_lines_, column)
-      .emit(ctrl_.diagnostics());
+      .emit(diag_);
   }
 
   [[nodiscard]] auto
@@ -390,16 +413,22 @@ private:
     }
     auto str = maybe_str.value_unsafe();
     if (not raw_ and not builder.is_protected()) {
-      // Attempt to parse it as data.
-      static constexpr auto parser
-        = parsers::time | parsers::duration | parsers::net | parsers::ip;
-      auto result = std::variant<time, duration, subnet, ip>{};
-      if (parser(str, result)) {
-        return std::visit(
-          [&](auto& value) {
-            return add_value(builder, std::move(value));
-          },
-          result);
+      // Attempt to parse it as data, unless the field had so many plain
+      // strings in a row that we no longer expect it to contain typed data.
+      auto& plain_strings = inference_.plain_strings(field_path_);
+      if (inference_.should_infer(plain_strings)) {
+        static constexpr auto parser
+          = parsers::time | parsers::duration | parsers::net | parsers::ip;
+        auto result = std::variant<time, duration, subnet, ip>{};
+        if (detail::could_be_typed(str) and parser(str, result)) {
+          plain_strings = 0;
+          return std::visit(
+            [&](auto& value) {
+              return add_value(builder, std::move(value));
+            },
+            result);
+        }
+        ++plain_strings;
       }
     }
     // If this doesn't work, we fall back to a string.
@@ -467,17 +496,21 @@ private:
     -> bool {
     auto result = builder.try_data(value);
     if (not result) {
-      diagnostic::warning(result.error()).emit(ctrl_.diagnostics());
+      diagnostic::warning(result.error()).emit(diag_);
       return false;
     }
     return true;
   }
 
   std::string_view parsed_document_;
-  operator_control_plane& ctrl_;
+  diagnostic_handler& diag_;
   std::optional<std::size_t> parsed_lines_;
   bool no_infer_;
   bool raw_;
+  detail::string_inference_cache& inference_;
+  /// The dot-separated path of the field being parsed. Elements of lists share
+  /// the path of their list.
+  std::string field_path_;
 };
 
 auto get_schema_name(simdjson::ondemand::document_reference doc,
@@ -565,11 +598,11 @@ auto unflatten_if_needed(std::string_view separator, table_slice slice)
 
 class parser_base {
 public:
-  parser_base(operator_control_plane& ctrl, std::optional<selector> selector,
+  parser_base(diagnostic_handler& diag, std::optional<selector> selector,
               std::optional<type> schema, std::vector<type> schemas,
               bool no_infer, bool preserve_order, bool raw,
               bool arrays_of_objects)
-    : ctrl_{ctrl},
+    : diag_{diag},
       selector_{std::move(selector)},
       schema_{std::move(schema)},
       schemas_{std::move(schemas)},
@@ -627,7 +660,7 @@ protected:
     TENZIR_ASSERT(selector_);
     auto maybe_schema_name = get_schema_name(doc_ref, *selector_);
     if (not maybe_schema_name) {
-      diagnostic::warning(maybe_schema_name.error()).emit(ctrl_.diagnostics());
+      diagnostic::warning(maybe_schema_name.error()).emit(diag_);
       if (no_infer_) {
         return {parser_action::skip, std::nullopt};
       }
@@ -649,7 +682,7 @@ protected:
       }
       return {parser_action::parse, std::nullopt};
     }
-    diagnostic::warning(maybe_slice_to_yield.error()).emit(ctrl_.diagnostics());
+    diagnostic::warning(maybe_slice_to_yield.error()).emit(diag_);
     return {parser_action::skip, std::nullopt};
   }
 
@@ -670,7 +703,7 @@ protected:
     return state.get_active_entry().flush();
   }
 
-  operator_control_plane& ctrl_;
+  diagnostic_handler& diag_;
   std::optional<selector> selector_;
   std::optional<type> schema_;
   std::vector<type> schemas_;
@@ -697,7 +730,7 @@ public:
     if (auto err = val.error()) {
       diagnostic::warning("{}", error_message(err))
         .note("skips invalid JSON `{}`", json_line)
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       co_return;
     }
     auto& doc = maybe_doc.value_unsafe();
@@ -715,7 +748,8 @@ public:
     }
     auto& builder = state.get_active_entry().builder;
     auto success
-      = doc_parser{json_line, this->ctrl_, lines_processed_, no_infer_, raw_}
+      = doc_parser{json_line, this->diag_, lines_processed_, no_infer_, raw_,
+                   state.get_active_entry().inference}
           .parse_object(val.value_unsafe(), builder.record());
     // After parsing one JSON object it is expected for the result to be at
     // the end. If it's otherwise then it means that a line contains more than
@@ -728,7 +762,7 @@ public:
       diagnostic::warning(
         "encountered more than one JSON object in a single NDJSON line")
         .note("skips remaining objects in line `{}`", json_line)
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       success = false;
     }
     if (not success) {
@@ -747,6 +781,12 @@ public:
     // Nothing to validate here.
   }
 
+  /// Sets the number of lines that precede the next line to parse, which we
+  /// refer to in diagnostics.
+  void set_lines_processed(std::size_t lines) {
+    lines_processed_ = lines;
+  }
+
 private:
   std::size_t lines_processed_ = 0u;
 };
@@ -771,7 +811,7 @@ public:
       buffer_.reset();
       diagnostic::warning("{}", error_message(err))
         .note("failed to parse")
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       co_return;
     }
     for (auto doc_it = stream_.begin(); doc_it != stream_.end(); ++doc_it) {
@@ -782,7 +822,7 @@ public:
         state.abort_requested = true;
         diagnostic::error("{}", error_message(err))
           .note("skips invalid JSON '{}'", view)
-          .emit(this->ctrl_.diagnostics());
+          .emit(this->diag_);
         co_return;
       }
       auto [action, slices]
@@ -805,13 +845,14 @@ public:
           state.abort_requested = true;
           diagnostic::error("{}", error_message(err))
             .note("expected an array of objects")
-            .emit(this->ctrl_.diagnostics());
+            .emit(this->diag_);
           co_return;
         }
         for (auto&& elem : arr.value_unsafe()) {
           auto row = builder.record();
           auto success
-            = doc_parser{doc_it.source(), this->ctrl_, no_infer_, raw_}
+            = doc_parser{doc_it.source(), this->diag_, no_infer_, raw_,
+                         state.get_active_entry().inference}
                 .parse_object(elem.value_unsafe(), row);
           if (not success) {
             // We already reported the issue.
@@ -821,8 +862,10 @@ public:
         }
       } else {
         auto row = builder.record();
-        auto success = doc_parser{doc_it.source(), this->ctrl_, no_infer_, raw_}
-                         .parse_object(doc.value_unsafe(), row);
+        auto success
+          = doc_parser{doc_it.source(), this->diag_, no_infer_, raw_,
+                       state.get_active_entry().inference}
+              .parse_object(doc.value_unsafe(), row);
         if (not success) {
           // We already reported the issue.
           builder.remove_last();
@@ -841,7 +884,7 @@ public:
   void finish(parser_state& state) {
     if (not buffer_.view().empty()) {
       diagnostic::error("parser input ended with incomplete object")
-        .emit(ctrl_.diagnostics());
+        .emit(diag_);
       state.abort_requested = true;
     }
   }
@@ -859,7 +902,7 @@ private:
       state.abort_requested = true;
       diagnostic::error("detected malformed JSON")
         .note("in input '{}'", buffer_.view())
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       return;
     }
     buffer_.truncate(truncated_bytes);
@@ -875,8 +918,9 @@ template <class GeneratorValue>
 auto make_parser(generator<GeneratorValue> json_chunk_generator,
                  operator_control_plane& ctrl, std::string separator,
                  std::optional<type> schema, bool preserve_order,
-                 auto parser_impl) -> generator<table_slice> {
-  auto state = parser_state{ctrl, preserve_order};
+                 uint64_t string_inference_limit, auto parser_impl)
+  -> generator<table_slice> {
+  auto state = parser_state{ctrl, preserve_order, string_inference_limit};
   if (schema) {
     // TODO: What about `infer_types`?
     state.active_entry = state.add_entry(schema->name(), *schema);
@@ -919,6 +963,167 @@ auto make_parser(generator<GeneratorValue> json_chunk_generator,
   }
 }
 
+/// Parses newline-delimited JSON with multiple threads.
+///
+/// We buffer the input until every thread has enough lines to parse, split the
+/// buffer into newline-aligned ranges, and let every thread parse one range
+/// with its own simdjson parser and builders. The builders are flushed after
+/// every range, and we yield the table slices of all ranges in the order of
+/// the ranges, which retains the order of the input.
+auto make_parallel_ndjson_parser(generator<chunk_ptr> input,
+                                 operator_control_plane& ctrl,
+                                 std::string separator,
+                                 std::optional<type> schema,
+                                 std::vector<type> schemas, size_t threads,
+                                 bool no_infer, bool raw,
+                                 uint64_t string_inference_limit,
+                                 std::optional<struct selector> selector)
+  -> generator<table_slice> {
+  // The number of bytes that every thread should parse at once.
+  constexpr auto target_bytes_per_thread = size_t{4} << 20;
+  // The minimum number of bytes that we hand to another thread.
+  constexpr auto min_bytes_per_thread = size_t{256} << 10;
+  struct worker {
+    worker(operator_control_plane& ctrl, const std::optional<type>& schema,
+           std::vector<type> schemas, bool no_infer, bool raw,
+           uint64_t string_inference_limit,
+           std::optional<struct selector> selector)
+      // The threads always flush their builders after parsing a range, so
+      // they can preserve the order without any overhead.
+      : state{ctrl, true, string_inference_limit},
+        parser{diagnostics, std::move(selector), schema, std::move(schemas),
+               no_infer, true, raw, false} {
+      if (schema) {
+        state.active_entry = state.add_entry(schema->name(), *schema);
+      } else {
+        state.active_entry = state.add_entry(unknown_entry_name);
+      }
+    }
+
+    /// Parses all lines of `range`, which starts at line `first_line`.
+    /// @pre The memory after `range` contains at least
+    /// `simdjson::SIMDJSON_PADDING` readable bytes.
+    void parse(std::string_view range, size_t first_line,
+               std::string_view separator) {
+      auto line = first_line;
+      while (not range.empty()) {
+        const auto newline = range.find('\n');
+        auto size = newline == std::string_view::npos ? range.size() : newline;
+        const auto* data = range.data();
+        range.remove_prefix(std::min(size + 1, range.size()));
+        if (size > 0 and data[size - 1] == '\r') {
+          --size;
+        }
+        if (size > 0) {
+          parser.set_lines_processed(line);
+          const auto view = simdjson::padded_string_view{
+            data, size, size + simdjson::SIMDJSON_PADDING};
+          for (auto& slice : parser.parse(view, state)) {
+            result.push_back(unflatten_if_needed(separator, std::move(slice)));
+          }
+        }
+        ++line;
+      }
+      for (auto&& entry : non_empty_entries(state)) {
+        for (auto& slice : entry.get().flush()) {
+          result.push_back(unflatten_if_needed(separator, std::move(slice)));
+        }
+      }
+    }
+
+    // Diagnostic handlers are not thread-safe, so every thread collects its
+    // diagnostics until we emit them on the operator's thread.
+    collecting_diagnostic_handler diagnostics;
+    parser_state state;
+    ndjson_parser parser;
+    std::vector<table_slice> result;
+  };
+  // The workers refer to their own members, so they must not move.
+  auto workers = std::vector<std::unique_ptr<worker>>{};
+  workers.reserve(threads);
+  for (auto i = size_t{0}; i < threads; ++i) {
+    workers.push_back(std::make_unique<worker>(ctrl, schema, schemas, no_infer,
+                                               raw, string_inference_limit,
+                                               selector));
+  }
+  auto buffer = std::string{};
+  auto lines_parsed = size_t{0};
+  auto last_parse = std::chrono::steady_clock::now();
+  // Parses the first `size` bytes of the buffer, which must end with a
+  // complete line, and retains the rest.
+  auto parse_buffer = [&](size_t size) -> std::vector<table_slice> {
+    last_parse = std::chrono::steady_clock::now();
+    buffer.reserve(buffer.size() + simdjson::SIMDJSON_PADDING);
+    const auto num_tasks
+      = std::clamp(size / min_bytes_per_thread, size_t{1}, threads);
+    const auto complete = std::string_view{buffer}.substr(0, size);
+    auto ranges = std::vector<std::pair<std::string_view, size_t>>{};
+    ranges.reserve(num_tasks);
+    auto begin = size_t{0};
+    for (auto task = size_t{0}; task < num_tasks; ++task) {
+      auto end = complete.size();
+      if (task + 1 < num_tasks) {
+        const auto target = std::max(begin, size * (task + 1) / num_tasks);
+        end = complete.find('\n', target);
+        end = end == std::string_view::npos ? complete.size() : end + 1;
+      }
+      const auto range = complete.substr(begin, end - begin);
+      ranges.emplace_back(range, lines_parsed);
+      lines_parsed += static_cast<size_t>(
+        std::count(range.begin(), range.end(), '\n'));
+      begin = end;
+    }
+    auto run = [&](size_t task) {
+      workers[task]->parse(ranges[task].first, ranges[task].second, separator);
+    };
+    auto tasks = std::vector<std::future<void>>{};
+    tasks.reserve(num_tasks - 1);
+    for (auto task = size_t{1}; task < num_tasks; ++task) {
+      tasks.push_back(std::async(std::launch::async, run, task));
+    }
+    run(0);
+    for (auto& task : tasks) {
+      task.get();
+    }
+    buffer.erase(0, size);
+    auto result = std::vector<table_slice>{};
+    for (auto& worker : workers) {
+      for (auto& diag : std::move(worker->diagnostics).collect()) {
+        ctrl.diagnostics().emit(std::move(diag));
+      }
+      std::move(worker->result.begin(), worker->result.end(),
+                std::back_inserter(result));
+      worker->result.clear();
+    }
+    return result;
+  };
+  for (auto&& chunk : input) {
+    const auto stalled = not chunk or chunk->size() == 0;
+    if (not stalled) {
+      buffer.append(reinterpret_cast<const char*>(chunk->data()),
+                    chunk->size());
+    }
+    const auto last_newline = buffer.rfind('\n');
+    const auto timed_out = std::chrono::steady_clock::now()
+                           > last_parse + defaults::import::batch_timeout;
+    if (last_newline != std::string::npos
+        and (stalled or timed_out
+             or buffer.size() >= threads * target_bytes_per_thread)) {
+      for (auto& slice : parse_buffer(last_newline + 1)) {
+        co_yield std::move(slice);
+      }
+    }
+    if (stalled) {
+      co_yield {};
+    }
+  }
+  if (not buffer.empty()) {
+    for (auto& slice : parse_buffer(buffer.size())) {
+      co_yield std::move(slice);
+    }
+  }
+}
+
 auto parse_selector(std::string_view x, location source) -> selector {
   auto split = detail::split(x, ":");
   TENZIR_ASSERT(!x.empty());
@@ -938,6 +1143,19 @@ auto parse_selector(std::string_view x, location source) -> selector {
   return selector{std::move(prefix), std::move(path)};
 }
 
+/// Validates the value of a `--threads` option.
+void check_threads(const std::optional<located<uint64_t>>& threads) {
+  if (threads and threads->inner == 0) {
+    diagnostic::error("the number of threads must not be 0")
+      .primary(threads->source)
+      .throw_();
+  }
+}
+
+/// The default number of plain strings after which the parser stops inferring
+/// types for the strings of a field.
+constexpr auto default_string_inference_limit = uint64_t{1'000};
+
 struct parser_args {
   std::optional<struct selector> selector;
   std::optional<located<std::string>> schema;
@@ -948,6 +1166,8 @@ struct parser_args {
   bool preserve_order = true;
   bool raw = false;
   bool arrays_of_objects = false;
+  uint64_t string_inference_limit = default_string_inference_limit;
+  std::optional<located<uint64_t>> threads;
 
   template <class Inspector>
   friend auto inspect(Inspector& f, parser_args& x) -> bool {
@@ -960,7 +1180,9 @@ struct parser_args {
               f.field("use_ndjson_mode", x.use_ndjson_mode),
               f.field("preserve_order", x.preserve_order),
               f.field("raw", x.raw),
-              f.field("arrays_of_objects", x.arrays_of_objects));
+              f.field("arrays_of_objects", x.arrays_of_objects),
+              f.field("string_inference_limit", x.string_inference_limit),
+              f.field("threads", x.threads));
   }
 };
 
@@ -1030,11 +1252,24 @@ public:
         .emit(ctrl.diagnostics());
       return {};
     }
+    if (args_.threads and not args_.use_ndjson_mode) {
+      diagnostic::error("option `--threads` requires `--ndjson`")
+        .primary(args_.threads->source)
+        .emit(ctrl.diagnostics());
+      return {};
+    }
+    if (args_.threads and args_.threads->inner > 1) {
+      return make_parallel_ndjson_parser(
+        std::move(input), ctrl, args_.unnest_separator, std::move(schema),
+        std::move(schemas), args_.threads->inner, args_.no_infer.has_value(),
+        args_.raw, args_.string_inference_limit, args_.selector);
+    }
     if (args_.use_ndjson_mode) {
       return make_parser(split_at_crlf(std::move(input)), ctrl,
                          args_.unnest_separator, schema, args_.preserve_order,
+                         args_.string_inference_limit,
                          ndjson_parser{
-                           ctrl,
+                           ctrl.diagnostics(),
                            args_.selector,
                            schema,
                            std::move(schemas),
@@ -1047,8 +1282,9 @@ public:
     if (args_.use_gelf_mode) {
       return make_parser(split_at_null(std::move(input), '\0'), ctrl,
                          args_.unnest_separator, schema, args_.preserve_order,
+                         args_.string_inference_limit,
                          ndjson_parser{
-                           ctrl,
+                           ctrl.diagnostics(),
                            args_.selector,
                            schema,
                            std::move(schemas),
@@ -1059,9 +1295,9 @@ public:
                          });
     }
     return make_parser(std::move(input), ctrl, args_.unnest_separator, schema,
-                       args_.preserve_order,
+                       args_.preserve_order, args_.string_inference_limit,
                        default_parser{
-                         ctrl,
+                         ctrl.diagnostics(),
                          args_.selector,
                          schema,
                          std::move(schemas),
@@ -1088,6 +1324,7 @@ struct printer_args {
   std::optional<location> omit_nulls;
   std::optional<location> omit_empty_objects;
   std::optional<location> omit_empty_lists;
+  std::optional<located<uint64_t>> threads;
 
   template <class Inspector>
   friend auto inspect(Inspector& f, printer_args& x) -> bool {
@@ -1099,7 +1336,8 @@ struct printer_args {
               f.field("omit_empty", x.omit_empty),
               f.field("omit_nulls", x.omit_nulls),
               f.field("omit_empty_objects", x.omit_empty_objects),
-              f.field("omit_empty_lists", x.omit_empty_lists));
+              f.field("omit_empty_lists", x.omit_empty_lists),
+              f.field("threads", x.threads));
   }
 };
 
@@ -1131,37 +1369,67 @@ public:
       = args_.omit_empty_lists.has_value() or args_.omit_empty.has_value();
     auto meta = chunk_metadata{.content_type = compact ? "application/x-ndjson"
                                                        : "application/json"};
+    auto options = json_printer_options{
+      .style = style,
+      .oneline = compact,
+      .omit_nulls = omit_nulls,
+      .omit_empty_records = omit_empty_objects,
+      .omit_empty_lists = omit_empty_lists,
+    };
+    const auto threads = args_.threads ? args_.threads->inner : uint64_t{1};
+    // The printers compile an emission plan per schema, which we keep for all
+    // subsequent slices of the same schema.
+    auto printers
+      = std::make_shared<std::unordered_map<type, compiled_json_printer>>();
     return printer_instance::make(
-      [compact, style, omit_nulls, omit_empty_objects, omit_empty_lists,
+      [options, threads, printers,
        meta = std::move(meta)](table_slice slice) -> generator<chunk_ptr> {
         if (slice.rows() == 0) {
           co_yield {};
           co_return;
         }
-        auto printer = tenzir::json_printer{{
-          .style = style,
-          .oneline = compact,
-          .omit_nulls = omit_nulls,
-          .omit_empty_records = omit_empty_objects,
-          .omit_empty_lists = omit_empty_lists,
-        }};
-        // TODO: Since this printer is per-schema we can write an optimized
-        // version of it that gets the schema ahead of time and only expects
-        // data corresponding to exactly that schema.
-        auto buffer = std::vector<char>{};
-        auto resolved_slice = resolve_enumerations(slice);
-        auto array
-          = to_record_batch(resolved_slice)->ToStructArray().ValueOrDie();
-        auto out_iter = std::back_inserter(buffer);
-        for (const auto& row :
-             values(caf::get<record_type>(resolved_slice.schema()), *array)) {
-          TENZIR_ASSERT_CHEAP(row);
-          const auto ok = printer.print(out_iter, *row);
-          TENZIR_ASSERT_CHEAP(ok);
-          out_iter = fmt::format_to(out_iter, "\n");
+        auto it = printers->find(slice.schema());
+        if (it == printers->end()) {
+          it = printers
+                 ->emplace(slice.schema(),
+                           compiled_json_printer{slice.schema(), options})
+                 .first;
+        }
+        const auto& printer = it->second;
+        // The minimum number of rows that we hand to another thread.
+        constexpr auto min_rows_per_thread = uint64_t{4'096};
+        const auto rows = slice.rows();
+        const auto num_tasks
+          = std::clamp(rows / min_rows_per_thread, uint64_t{1}, threads);
+        if (num_tasks == 1) {
+          auto buffer = std::string{};
+          printer.print(slice, buffer);
+          co_yield chunk::make(std::move(buffer), meta);
+          co_return;
+        }
+        // Every thread prints a contiguous range of rows into its own buffer,
+        // and we yield the buffers in the order of the ranges, which retains
+        // the order of the rows.
+        auto buffers = std::vector<std::string>(num_tasks);
+        auto run = [&](uint64_t task) {
+          const auto begin
+            = detail::narrow_cast<int64_t>(rows * task / num_tasks);
+          const auto end
+            = detail::narrow_cast<int64_t>(rows * (task + 1) / num_tasks);
+          printer.print(slice, begin, end, buffers[task]);
+        };
+        auto tasks = std::vector<std::future<void>>{};
+        tasks.reserve(num_tasks - 1);
+        for (auto task = uint64_t{1}; task < num_tasks; ++task) {
+          tasks.push_back(std::async(std::launch::async, run, task));
+        }
+        run(0);
+        for (auto& task : tasks) {
+          task.get();
+        }
+        for (auto& buffer : buffers) {
+          co_yield chunk::make(std::move(buffer), meta);
         }
-        auto chunk = chunk::make(std::move(buffer), meta);
-        co_yield std::move(chunk);
       });
   }
 
@@ -1198,6 +1466,9 @@ public:
     parser.add("--gelf", args.use_gelf_mode);
     parser.add("--raw", args.raw);
     parser.add("--arrays-of-objects", args.arrays_of_objects);
+    parser.add("--string-inference-limit", args.string_inference_limit,
+               "<count>");
+    parser.add("--threads", args.threads, "<count>");
     parser.parse(p);
     if (selector) {
       args.selector = parse_selector(selector->inner, selector->source);
@@ -1208,6 +1479,7 @@ public:
         .primary(selector->source)
         .throw_();
     }
+    check_threads(args.threads);
     if (args.no_infer and not(args.schema or args.selector)) {
       diagnostic::error(
         "`--no-infer` requires either `--schema` or `--selector`")
@@ -1230,7 +1502,9 @@ public:
     parser.add("--omit-nulls", args.omit_nulls);
     parser.add("--omit-empty-objects", args.omit_empty_objects);
     parser.add("--omit-empty-lists", args.omit_empty_lists);
+    parser.add("--threads", args.threads, "<count>");
     parser.parse(p);
+    check_threads(args.threads);
     return std::make_unique<json_printer>(std::move(args));
   }
 };
@@ -1267,7 +1541,9 @@ public:
       name(), fmt::format("https://docs.tenzir.com/next/formats/{}", name())};
     auto args = parser_args{};
     add_common_options_to_parser(parser, args);
+    parser.add("--threads", args.threads, "<count>");
     parser.parse(p);
+    check_threads(args.threads);
     args.use_ndjson_mode = true;
     args.selector = parse_selector(Selector.str(), location::unknown);
     args.unnest_separator = Separator.str();
@@ -30,24 +30,49 @@ using namespace tenzir::pcap;
 /// Returns a stateful function that retrieves a given number of bytes in a
 /// contiguous buffer from a generator of chunks. The last span is underful,
 /// i.e., smaller than the number of bytes requested, and zero-sized if the
-/// input boundaries are aligned. The function returns nullopt whenever it
-/// merges buffers from multiple chunks. This does not indicate completion.
+/// input boundaries are aligned. The function returns nullopt whenever the
+/// input stalls. This does not indicate completion.
+/// The returned span points into the current chunk unless the requested bytes
+/// straddle a chunk boundary, in which case the function copies only the
+/// requested bytes into an internal buffer.
 auto make_byte_reader(generator<chunk_ptr> input) {
   input.begin(); // prime the pump
   return
     [input = std::move(input), chunk = chunk_ptr{}, chunk_offset = size_t{0},
      buffer = std::vector<std::byte>{}, buffer_offset = size_t{0}](
       size_t num_bytes) mutable -> std::optional<std::span<const std::byte>> {
-      // The internal chunk is not available when we first enter this function
-      // and as well when we have no more chunks (at the end).
-      if (!chunk) {
-        TENZIR_ASSERT(chunk_offset == 0);
+      while (true) {
         // Can we fulfill our request from the buffer?
-        if (buffer.size() - buffer_offset >= num_bytes) {
+        const auto buffered = buffer.size() - buffer_offset;
+        if (buffered >= num_bytes) {
           auto result = as_bytes(buffer).subspan(buffer_offset, num_bytes);
           buffer_offset += num_bytes;
           return result;
         }
+        if (chunk) {
+          const auto available = as_bytes(chunk).subspan(chunk_offset);
+          // Enough in the chunk, simply yield from it.
+          if (buffered == 0 and available.size() >= num_bytes) {
+            chunk_offset += num_bytes;
+            return available.subspan(0, num_bytes);
+          }
+          // The request straddles the chunk boundary, so we buffer as much of
+          // the chunk as the request needs, but not more.
+          buffer.erase(buffer.begin(),
+                       buffer.begin()
+                         + detail::narrow_cast<ptrdiff_t>(buffer_offset));
+          buffer_offset = 0;
+          const auto take = std::min(num_bytes - buffered, available.size());
+          buffer.insert(buffer.end(), available.begin(),
+                        available.begin()
+                          + detail::narrow_cast<ptrdiff_t>(take));
+          chunk_offset += take;
+          if (chunk_offset == chunk->size()) {
+            chunk = nullptr;
+            chunk_offset = 0;
+          }
+          continue;
+        }
         // Can we get more chunks?
         auto current = input.unsafe_current();
         if (current == input.end()) {
@@ -62,43 +87,6 @@ auto make_byte_reader(generator<chunk_ptr> input) {
         if (!chunk)
           return std::nullopt;
       }
-      // We have a chunk.
-      TENZIR_ASSERT(chunk != nullptr);
-      if (buffer.size() == buffer_offset) {
-        // Have consumed the entire chunk last time? Then reset and try again.
-        if (chunk_offset == chunk->size()) {
-          chunk_offset = 0;
-          chunk = nullptr;
-          return std::nullopt;
-        }
-        TENZIR_ASSERT(chunk_offset < chunk->size());
-        // If we have a chunk, but not enough bytes, then we must buffer.
-        if (chunk->size() - chunk_offset < num_bytes) {
-          buffer = {chunk->begin() + chunk_offset, chunk->end()};
-          buffer_offset = 0;
-          chunk = nullptr;
-          chunk_offset = 0;
-          return std::nullopt;
-        }
-        // Enough in the chunk, simply yield from it.
-        auto result = as_bytes(*chunk).subspan(chunk_offset, num_bytes);
-        chunk_offset += num_bytes;
-        return result;
-      }
-      // If we need to process both a buffer and chunk, we copy over the chunk
-      // remainder into the buffer.
-      buffer.erase(buffer.begin(), buffer.begin() + buffer_offset);
-      buffer_offset = 0;
-      buffer.reserve(buffer.size() + chunk->size() - chunk_offset);
-      buffer.insert(buffer.end(), chunk->begin() + chunk_offset, chunk->end());
-      chunk = nullptr;
-      chunk_offset = 0;
-      if (buffer.size() >= num_bytes) {
-        auto result = as_bytes(buffer).subspan(0, num_bytes);
-        buffer_offset = num_bytes;
-        return result;
-      }
-      return std::nullopt;
     };
 }
 
@@ -113,6 +101,80 @@ auto make_file_header_table_slice(const file_header& header) -> table_slice {
   return builder.finish();
 }
 
+/// Builds `pcap.packet` table slices column by column. Every packet payload is
+/// copied exactly once, from the input directly into the Arrow data buffer.
+class packet_builder {
+public:
+  packet_builder()
+    : schema_{packet_record_type()},
+      arrow_schema_{schema_.to_arrow_schema()},
+      linktype_{uint64_type::make_arrow_builder(arrow::default_memory_pool())},
+      timestamp_{time_type::make_arrow_builder(arrow::default_memory_pool())},
+      captured_packet_length_{
+        uint64_type::make_arrow_builder(arrow::default_memory_pool())},
+      original_packet_length_{
+        uint64_type::make_arrow_builder(arrow::default_memory_pool())},
+      data_{blob_type::make_arrow_builder(arrow::default_memory_pool())} {
+  }
+
+  /// Checks whether a packet fits into the current batch, i.e., whether the
+  /// data column stays within the memory limit of its builder.
+  auto fits(const packet_record& packet) const -> bool {
+    return data_->value_data_length()
+             + detail::narrow_cast<int64_t>(packet.data.size())
+           <= data_->memory_limit();
+  }
+
+  /// Adds a packet.
+  /// @pre `fits(packet)`
+  auto add(uint32_t linktype, time timestamp, const packet_record& packet)
+    -> void {
+    auto status = linktype_->Append(linktype & 0x0000FFFF);
+    TENZIR_ASSERT(status.ok(), status.ToString().c_str());
+    status = timestamp_->Append(timestamp.time_since_epoch().count());
+    TENZIR_ASSERT(status.ok(), status.ToString().c_str());
+    status
+      = captured_packet_length_->Append(packet.header.captured_packet_length);
+    TENZIR_ASSERT(status.ok(), status.ToString().c_str());
+    status
+      = original_packet_length_->Append(packet.header.original_packet_length);
+    TENZIR_ASSERT(status.ok(), status.ToString().c_str());
+    status = data_->Append(reinterpret_cast<const uint8_t*>(packet.data.data()),
+                           detail::narrow_cast<int32_t>(packet.data.size()));
+    TENZIR_ASSERT(status.ok(), status.ToString().c_str());
+  }
+
+  /// Returns the number of packets in the current batch.
+  auto rows() const -> int64_t {
+    return data_->length();
+  }
+
+  /// Finishes the current batch.
+  auto finish() -> table_slice {
+    const auto rows = this->rows();
+    auto columns = std::vector<std::shared_ptr<arrow::Array>>{
+      linktype_->Finish().ValueOrDie(),
+      timestamp_->Finish().ValueOrDie(),
+      captured_packet_length_->Finish().ValueOrDie(),
+      original_packet_length_->Finish().ValueOrDie(),
+      data_->Finish().ValueOrDie(),
+    };
+    auto batch
+      = arrow::RecordBatch::Make(arrow_schema_, rows, std::move(columns));
+    TENZIR_ASSERT_EXPENSIVE(batch->Validate().ok());
+    return table_slice{batch, schema_};
+  }
+
+private:
+  type schema_;
+  std::shared_ptr<arrow::Schema> arrow_schema_;
+  std::shared_ptr<type_to_arrow_builder_t<uint64_type>> linktype_;
+  std::shared_ptr<type_to_arrow_builder_t<time_type>> timestamp_;
+  std::shared_ptr<type_to_arrow_builder_t<uint64_type>> captured_packet_length_;
+  std::shared_ptr<type_to_arrow_builder_t<uint64_type>> original_packet_length_;
+  std::shared_ptr<type_to_arrow_builder_t<blob_type>> data_;
+};
+
 struct parser_args {
   std::optional<location> emit_file_headers;
 
@@ -188,12 +250,13 @@ public:
       // Records, consisting of a 16-byte header and variable-length payload.
       // However, our parser is a bit smarter and also supports concatenated
       // PCAP traces.
-      auto builder = table_slice_builder{packet_record_type()};
+      auto builder = packet_builder{};
       auto num_packets = size_t{0};
       auto last_finish = std::chrono::steady_clock::now();
       while (true) {
         const auto now = std::chrono::steady_clock::now();
-        if (builder.rows() >= defaults::import::table_slice_size
+        if (builder.rows() >= detail::narrow_cast<int64_t>(
+              defaults::import::table_slice_size)
             or last_finish + defaults::import::batch_timeout < now) {
           last_finish = now;
           co_yield builder.finish();
@@ -316,18 +379,18 @@ public:
         } else {
           die("invalid magic number"); // validated earlier
         }
-        const auto* ptr = reinterpret_cast<const char*>(packet.data.data());
-        auto data = std::string_view{ptr, packet.data.size()};
-        if (!(builder.add(input_file_header.linktype & 0x0000FFFF)
-              && builder.add(timestamp)
-              && builder.add(packet.header.captured_packet_length)
-              && builder.add(packet.header.original_packet_length)
-              && builder.add(data))) {
-          diagnostic::error("failed to add packet #{}", num_packets)
-            .note("from `pcap`")
-            .emit(ctrl.diagnostics());
-          co_return;
+        if (not builder.fits(packet)) {
+          if (builder.rows() == 0) {
+            diagnostic::error("packet #{} of {} bytes is too large",
+                              num_packets, packet.data.size())
+              .note("from `pcap`")
+              .emit(ctrl.diagnostics());
+            co_return;
+          }
+          last_finish = now;
+          co_yield builder.finish();
         }
+        builder.add(input_file_header.linktype, timestamp, packet);
       }
       if (builder.rows() > 0) {
         co_yield builder.finish();
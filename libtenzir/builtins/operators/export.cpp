@@ -90,8 +90,13 @@ class export_operator final : public crtp_operator<export_operator> {
 public:
   export_operator() = default;
 
-  explicit export_operator(expression expr, bool live, bool low_priority)
-    : expr_{std::move(expr)}, live_{live}, low_priority_(low_priority) {
+  explicit export_operator(expression expr, bool live, bool low_priority,
+                           std::optional<std::vector<std::string>> fields
+                           = std::nullopt)
+    : expr_{std::move(expr)},
+      live_{live},
+      low_priority_(low_priority),
+      fields_{std::move(fields)} {
   }
 
   auto run_live(operator_control_plane& ctrl) const -> generator<table_slice> {
@@ -151,6 +156,7 @@ public:
       = tenzir::query_context::make_extract("export", blocking_self, expr_);
     query_context.priority = low_priority_ ? query_context::priority::low
                                            : query_context::priority::normal;
+    caf::get<extract_query_context>(query_context.cmd).fields = fields_;
     auto query_cursor = tenzir::query_cursor{};
     ctrl.self()
       .request(index, caf::infinite, atom::evaluate_v, query_context)
@@ -252,18 +258,30 @@ public:
                                 : expression{conjunction{std::move(clauses)}};
     return optimize_result{
       trivially_true_expression(), event_order::ordered,
-      std::make_unique<export_operator>(std::move(expr), live_, low_priority_)};
+      std::make_unique<export_operator>(std::move(expr), live_, low_priority_,
+                                        fields_)};
+  }
+
+  auto project(const std::vector<std::string>& fields) const
+    -> operator_ptr override {
+    if (live_) {
+      return nullptr;
+    }
+    return std::make_unique<export_operator>(expr_, live_, low_priority_,
+                                             fields);
   }
 
   friend auto inspect(auto& f, export_operator& x) -> bool {
     return f.object(x).fields(f.field("expression", x.expr_),
-                              f.field("live", x.live_));
+                              f.field("live", x.live_),
+                              f.field("fields", x.fields_));
   }
 
 private:
   expression expr_;
   bool live_;
   bool low_priority_;
+  std::optional<std::vector<std::string>> fields_;
 };
 
 class plugin final : public virtual operator_plugin<export_operator> {
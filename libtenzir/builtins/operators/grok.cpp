@@ -9,21 +9,25 @@
 #include <tenzir/argument_parser.hpp>
 #include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/concept/parseable/tenzir/data.hpp>
+#include <tenzir/detail/re2_translation.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/series_builder.hpp>
 
 // Both Boost.Regex and RE2 are used:
-//  - Boost.Regex is used for actual grokking
-//  - RE2 is used for parsing the patterns we're given
+//  - Boost.Regex is used for actual grokking by default
+//  - RE2 is used for parsing the patterns we're given, and for grokking with
+//    `--engine re2`
 //
-// RE2 can't be used for both, because it doesn't support all the regex features
-// the built-in patterns need.
+// RE2 can't be used for grokking by default, because it doesn't support all the
+// regex features the built-in patterns need. The `re2` engine translates the
+// patterns and approximates the missing features instead.
 //
 // Boost.Regex _could_ be used for both, but it's slow, so we're using RE2 where
 // we can.
 #include <boost/regex.hpp>
 #include <caf/make_copy_on_write.hpp>
 #include <re2/re2.h>
+#include <re2/set.h>
 
 #include <algorithm>
 #include <ranges>
@@ -81,6 +85,18 @@ bool inspect(Inspector& f, capture_type& x) {
     f, x, {"string", "integer", "floating", "infer", "unnamed", "implicit"});
 }
 
+enum class engine {
+  // Backtracking with Boost.Regex, supports the full pattern syntax
+  boost,
+  // Linear-time matching with RE2, approximates some of the pattern syntax
+  re2,
+};
+
+template <typename Inspector>
+bool inspect(Inspector& f, engine& x) {
+  return detail::inspect_enum_str(f, x, {"boost", "re2"});
+}
+
 struct pattern_store;
 
 struct pattern {
@@ -372,6 +388,79 @@ auto& get_builtin_pattern_store() {
   return store;
 }
 
+// A pattern compiled with RE2
+struct re2_pattern {
+  std::unique_ptr<re2::RE2> regex;
+  // For every named capture of the pattern, the capture groups with its name
+  std::vector<std::vector<int>> named_groups;
+  // Inputs without this literal can't match, so we don't have to run `regex`
+  std::string literal;
+};
+
+// The patterns of a parser compiled with RE2
+struct re2_program {
+  std::vector<re2_pattern> patterns;
+  // Finds all matching patterns in a single pass, if there are multiple
+  std::unique_ptr<re2::RE2::Set> set;
+};
+
+auto compile_re2(std::span<const pattern> patterns, bool indexed_captures)
+  -> std::shared_ptr<const re2_program> {
+  auto options = re2::RE2::Options{re2::RE2::Quiet};
+  // Match bytes, and let '.' match newlines, like Boost.Regex does
+  options.set_encoding(re2::RE2::Options::EncodingLatin1);
+  options.set_dot_nl(true);
+  auto result = std::make_shared<re2_program>();
+  if (patterns.size() > 1)
+    result->set
+      = std::make_unique<re2::RE2::Set>(options, re2::RE2::ANCHOR_BOTH);
+  for (const auto& input : patterns) {
+    const auto resolved = input.resolved_pattern->str();
+    auto translation
+      = detail::translate_to_re2(resolved, indexed_captures, false);
+    auto regex = std::make_unique<re2::RE2>(translation.regex, options);
+    if (regex->error_code() == re2::RE2::ErrorRepeatSize) {
+      translation = detail::translate_to_re2(resolved, indexed_captures, true);
+      regex = std::make_unique<re2::RE2>(translation.regex, options);
+    }
+    if (not regex->ok())
+      diagnostic::error("pattern is not supported by the `re2` engine")
+        .note(regex->error())
+        .hint("pattern: `{}`", resolved)
+        .hint("use `--engine boost` instead")
+        .throw_();
+    if (result->set) {
+      const auto index = result->set->Add(translation.regex, nullptr);
+      TENZIR_ASSERT_CHEAP(index >= 0);
+    }
+    auto& compiled = result->patterns.emplace_back();
+    compiled.regex = std::move(regex);
+    for (const auto& [name, type] : input.named_captures) {
+      auto& groups = compiled.named_groups.emplace_back();
+      for (const auto& [group_name, group] : translation.groups)
+        if (group_name == name)
+          groups.push_back(group);
+    }
+    compiled.literal = std::move(translation.literal);
+  }
+  // If the set runs out of memory, we try the patterns one by one
+  if (result->set and not result->set->Compile())
+    result->set = nullptr;
+  return result;
+}
+
+// The reusable buffers for matching an input
+struct match_buffers {
+  // All capture groups of the pattern that matched, if needed for indexed
+  // captures
+  std::vector<std::optional<std::string_view>> groups;
+  // The named captures of the pattern that matched
+  std::vector<std::optional<std::string_view>> named;
+  // Scratch space for the `re2` engine
+  std::vector<re2::StringPiece> submatches;
+  std::vector<int> candidates;
+};
+
 class grok_parser final : public plugin_parser {
 public:
   grok_parser() = default;
@@ -381,20 +470,40 @@ public:
     auto parser
       = argument_parser{"grok", "https://docs.tenzir.com/next/operators/"
                                 "transformations/grok"};
-    parser.add(input_pattern_.raw_pattern, "<input_pattern>");
+    std::string input_pattern{};
+    parser.add(input_pattern, "<input_pattern>");
+    std::vector<std::string> alternative_patterns{};
+    parser.add("--or", alternative_patterns, "<input_pattern>");
     std::optional<std::string> pattern_definitions{};
     parser.add("--pattern-definitions", pattern_definitions, "<patterns>");
+    std::optional<located<std::string>> engine_name{};
+    parser.add("--engine", engine_name, "<boost|re2>");
     parser.add("--indexed-captures", indexed_captures_);
     parser.add("--include-unnamed", include_unnamed_);
     parser.add("--raw", raw_);
     parser.parse(p);
+    if (engine_name) {
+      if (engine_name->inner == "re2")
+        engine_ = engine::re2;
+      else if (engine_name->inner != "boost")
+        diagnostic::error("invalid engine `{}`", engine_name->inner)
+          .primary(engine_name->source)
+          .hint("must be `boost` or `re2`")
+          .throw_();
+    }
     if (pattern_definitions)
       patterns_.unshared().add(*pattern_definitions);
     TENZIR_ASSERT_EXPENSIVE(std::ranges::all_of(
       patterns_->patterns | std::views::values, [](const auto& p) -> bool {
         return p.resolved_pattern.has_value();
       }));
-    input_pattern_.resolve(*patterns_, false);
+    input_patterns_.emplace_back(std::move(input_pattern));
+    for (auto& alternative : alternative_patterns)
+      input_patterns_.emplace_back(std::move(alternative));
+    for (auto& input : input_patterns_)
+      input.resolve(*patterns_, false);
+    if (engine_ == engine::re2)
+      re2_ = compile_re2(input_patterns_, indexed_captures_);
   }
 
   auto name() const -> std::string override {
@@ -414,21 +523,26 @@ public:
                      operator_control_plane& ctrl) const
     -> std::vector<series> override {
     auto builder = series_builder{type{record_type{}}};
+    auto buffers = match_buffers{};
     for (auto&& string : values(string_type{}, *input)) {
       if (not string) {
         builder.null();
         continue;
       }
-      boost::cmatch matches{};
-      if (not boost::regex_match(string->begin(), string->end(), matches,
-                                 *input_pattern_.resolved_pattern)) {
-        diagnostic::warning("pattern could not be matched")
-          .hint("input: `{}`", *string)
-          .hint("pattern: `{}`", input_pattern_.resolved_pattern->str())
-          .emit(ctrl.diagnostics());
+      const auto index = engine_ == engine::re2
+                           ? match_re2(*string, buffers)
+                           : match_boost(*string, buffers, ctrl);
+      if (not index) {
+        auto diag = diagnostic::warning("pattern could not be matched")
+                      .hint("input: `{}`", *string);
+        for (const auto& input_pattern : input_patterns_)
+          diag = std::move(diag).hint("pattern: `{}`",
+                                      input_pattern.resolved_pattern->str());
+        std::move(diag).emit(ctrl.diagnostics());
         builder.null();
         continue;
       }
+      const auto& input_pattern = input_patterns_[*index];
       auto record = builder.record();
       auto infer_match = [&](std::string_view in) -> data {
         const auto* f = in.begin();
@@ -438,27 +552,27 @@ public:
           return d;
         return data{std::string{in}};
       };
-      auto convert_match
-        = [&](const boost::csub_match& match, capture_type type) -> data {
-        if (!match.matched)
+      auto convert_match = [&](std::optional<std::string_view> match,
+                               capture_type type) -> data {
+        if (!match)
           return caf::none;
         switch (type) {
           case capture_type::implicit:
           case capture_type::unnamed:
             if (not raw_)
-              return infer_match(std::string_view{match.first, match.second});
-            return data{std::string{match.first, match.second}};
+              return infer_match(*match);
+            return data{std::string{*match}};
           case capture_type::infer:
-            return infer_match(std::string_view{match.first, match.second});
+            return infer_match(*match);
           case capture_type::string:
-            return data{std::string{match.first, match.second}};
+            return data{std::string{*match}};
           case capture_type::integer:
-            if (auto r = to<int64_t>(match.str()))
+            if (auto r = to<int64_t>(*match))
               return data{*r};
             // TODO: Should this be an error/warning?
             return caf::none;
           case capture_type::floating:
-            if (auto r = to<double>(match.str()))
+            if (auto r = to<double>(*match))
               return data{*r};
             return caf::none;
         }
@@ -470,23 +584,23 @@ public:
               record.field(name, std::move(d));
           };
       if (indexed_captures_) {
-        for (int i = 0; i < static_cast<int>(
-                          input_pattern_.resolved_pattern->mark_count() + 1);
-             ++i) {
-          const auto& match = matches[i];
+        for (size_t i = 0; i < buffers.groups.size(); ++i) {
+          const auto& match = buffers.groups[i];
           // Find the same capture as a named capture,
           // to get the name and conversion type to use.
           // If there isn't a matching named capture,
-          // use the (stringified) index as the field name
-          if (auto named_capture_it
-              = std::ranges::find_if(input_pattern_.named_captures,
-                                     [&](const auto& elem) {
-                                       const auto& other_match
-                                         = matches[elem.first];
-                                       return match == other_match;
-                                     });
-              named_capture_it != input_pattern_.named_captures.end()) {
-            const auto& [name, type] = *named_capture_it;
+          // use the (stringified) index as the field name.
+          //
+          // Like comparing sub-matches in Boost.Regex, this compares their
+          // contents, with captures that didn't participate being empty
+          const auto contents = [](const auto& capture) {
+            return capture.value_or(std::string_view{});
+          };
+          if (auto named_it
+              = std::ranges::find(buffers.named, contents(match), contents);
+              named_it != buffers.named.end()) {
+            const auto& [name, type]
+              = input_pattern.named_captures[named_it - buffers.named.begin()];
             TENZIR_ASSERT_CHEAP(not name.empty());
             add_field(name, convert_match(match, type), type);
           } else {
@@ -495,9 +609,10 @@ public:
           }
         }
       } else {
-        for (auto&& [name, type] : input_pattern_.named_captures) {
+        for (size_t i = 0; i < buffers.named.size(); ++i) {
+          const auto& [name, type] = input_pattern.named_captures[i];
           TENZIR_ASSERT_CHEAP(not name.empty());
-          add_field(name, convert_match(matches[name], type), type);
+          add_field(name, convert_match(buffers.named[i], type), type);
         }
       }
     }
@@ -512,21 +627,132 @@ public:
       x.patterns_ = caf::make_copy_on_write<pattern_store>(p);
       return true;
     };
+    auto compile = [&x] {
+      if (x.engine_ == engine::re2)
+        x.re2_ = compile_re2(x.input_patterns_, x.indexed_captures_);
+      return true;
+    };
     return f.object(x)
       .pretty_name("grok_parser")
+      .on_load(compile)
       .fields(f.field("patterns", get_patterns, set_patterns),
-              f.field("input_pattern", x.input_pattern_),
+              f.field("input_patterns", x.input_patterns_),
+              f.field("engine", x.engine_),
               f.field("indexed_captures", x.indexed_captures_),
               f.field("include_unnamed", x.include_unnamed_),
               f.field("raw", x.raw_));
   }
 
 private:
+  // Match `input` against the patterns one after another with Boost.Regex,
+  // and return the index of the first one that matches
+  auto match_boost(std::string_view input, match_buffers& buffers,
+                   operator_control_plane& ctrl) const
+    -> std::optional<size_t> {
+    const auto to_capture
+      = [](const boost::csub_match& match) -> std::optional<std::string_view> {
+      if (not match.matched)
+        return std::nullopt;
+      return std::string_view{match.first, match.second};
+    };
+    auto matches = boost::cmatch{};
+    for (size_t i = 0; i < input_patterns_.size(); ++i) {
+      const auto& input_pattern = input_patterns_[i];
+      try {
+        if (not boost::regex_match(input.data(), input.data() + input.size(),
+                                   matches, *input_pattern.resolved_pattern))
+          continue;
+      } catch (const std::runtime_error& err) {
+        // Boost.Regex gives up when backtracking takes too long
+        diagnostic::warning("{}", err.what())
+          .hint("input: `{}`", input)
+          .hint("pattern: `{}`", input_pattern.resolved_pattern->str())
+          .hint("use `--engine re2` to match in linear time")
+          .emit(ctrl.diagnostics());
+        continue;
+      }
+      buffers.groups.clear();
+      if (indexed_captures_)
+        for (const auto& match : matches)
+          buffers.groups.push_back(to_capture(match));
+      buffers.named.clear();
+      for (const auto& [name, type] : input_pattern.named_captures)
+        buffers.named.push_back(to_capture(matches[name]));
+      return i;
+    }
+    return std::nullopt;
+  }
+
+  // Match `input` against all patterns at once with RE2, and return the index
+  // of the first one that matches
+  auto match_re2(std::string_view input, match_buffers& buffers) const
+    -> std::optional<size_t> {
+    TENZIR_ASSERT_CHEAP(re2_);
+    const auto text = re2::StringPiece{input.data(), input.size()};
+    const auto try_match = [&](size_t index) {
+      const auto& compiled = re2_->patterns[index];
+      if (not compiled.literal.empty()
+          and input.find(compiled.literal) == std::string_view::npos)
+        return false;
+      const auto num_submatches = compiled.regex->NumberOfCapturingGroups() + 1;
+      buffers.submatches.resize(num_submatches);
+      if (not compiled.regex->Match(text, 0, text.size(),
+                                    re2::RE2::ANCHOR_BOTH,
+                                    buffers.submatches.data(), num_submatches))
+        return false;
+      const auto to_capture
+        = [](re2::StringPiece match) -> std::optional<std::string_view> {
+        if (match.data() == nullptr)
+          return std::nullopt;
+        return std::string_view{match.data(), match.size()};
+      };
+      buffers.groups.clear();
+      if (indexed_captures_)
+        for (const auto& match : buffers.submatches)
+          buffers.groups.push_back(to_capture(match));
+      buffers.named.clear();
+      for (const auto& groups : compiled.named_groups) {
+        // Like Boost.Regex, use the first group with the name that matched
+        auto capture = std::optional<std::string_view>{};
+        for (auto group : groups) {
+          capture = to_capture(buffers.submatches[group]);
+          if (capture)
+            break;
+        }
+        buffers.named.push_back(capture);
+      }
+      return true;
+    };
+    if (re2_->set) {
+      buffers.candidates.clear();
+      auto error = re2::RE2::Set::ErrorInfo{};
+      if (re2_->set->Match(text, &buffers.candidates, &error)) {
+        std::ranges::sort(buffers.candidates);
+        for (auto candidate : buffers.candidates)
+          if (try_match(candidate))
+            return candidate;
+        return std::nullopt;
+      }
+      if (error.kind == re2::RE2::Set::kNoError)
+        return std::nullopt;
+      // The set failed, e.g., because it ran out of memory, so we fall back to
+      // trying the patterns one by one
+    }
+    for (size_t i = 0; i < re2_->patterns.size(); ++i)
+      if (try_match(i))
+        return i;
+    return std::nullopt;
+  }
+
   // FIXME: The CoW semantics aren't really being taken advantage of here,
   // because inspect() has to create a copy of this every time.
   caf::intrusive_cow_ptr<pattern_store> patterns_{
     caf::make_copy_on_write<pattern_store>()};
-  pattern input_pattern_{};
+  // The patterns to try in order, the first one that matches is used
+  std::vector<pattern> input_patterns_{};
+  engine engine_{engine::boost};
+  // Only set for the `re2` engine
+  std::shared_ptr<const re2_program> re2_{};
   bool indexed_captures_{false}, include_unnamed_{false}, raw_{false};
 };
 
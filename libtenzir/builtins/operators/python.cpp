@@ -8,7 +8,6 @@
 
 #include "tenzir/detail/assert.hpp"
 #include "tenzir/detail/strip_leading_indentation.hpp"
-#include "tenzir/format/arrow.hpp"
 
 #include <tenzir/argument_parser.hpp>
 #include <tenzir/as_bytes.hpp>
@@ -16,6 +15,7 @@
 #include <tenzir/concept/parseable/string/quoted_string.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
 #include <tenzir/detail/installdirs.hpp>
+#include <tenzir/detail/posix.hpp>
 #include <tenzir/error.hpp>
 #include <tenzir/generator.hpp>
 #include <tenzir/logger.hpp>
@@ -33,10 +33,20 @@
 #include <boost/process.hpp>
 #include <caf/detail/scope_guard.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
 #include <filesystem>
 #include <mutex>
+#include <poll.h>
 #include <queue>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 
 namespace bp = boost::process;
 
@@ -72,15 +82,222 @@ auto drain_pipe(bp::ipstream& pipe) -> std::string {
   return result;
 }
 
+/// Creates an anonymous shared memory object of the given size.
+auto make_shared_memory(size_t size) -> caf::expected<int> {
+#if defined(__linux__)
+  auto fd = ::memfd_create("tenzir-python", MFD_CLOEXEC);
+#else
+  static auto counter = std::atomic<uint64_t>{0};
+  auto name = fmt::format("/tnz-py-{}-{}", ::getpid(), counter++);
+  auto fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd != -1) {
+    ::shm_unlink(name.c_str());
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+#endif
+  if (fd == -1)
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to create shared memory: {}",
+                                       detail::describe_errno()));
+  if (::ftruncate(fd, detail::narrow_cast<off_t>(size)) == -1) {
+    auto err = caf::make_error(ec::system_error,
+                               fmt::format("failed to resize shared memory: {}",
+                                           detail::describe_errno()));
+    ::close(fd);
+    return err;
+  }
+  return fd;
+}
+
+/// An Arrow buffer that owns a read-only mapping of shared memory.
+class mapped_buffer final : public arrow::Buffer {
+public:
+  mapped_buffer(const void* data, size_t size)
+    : arrow::Buffer{static_cast<const uint8_t*>(data),
+                    detail::narrow_cast<int64_t>(size)} {
+  }
+
+  ~mapped_buffer() override {
+    ::munmap(const_cast<uint8_t*>(data()), detail::narrow_cast<size_t>(size()));
+  }
+};
+
+/// Sends the size of an Arrow IPC stream together with the descriptor of the
+/// shared memory that holds it over a Unix domain socket.
+auto send_descriptor(int socket, uint64_t size, int fd) -> caf::error {
+  auto iov = iovec{&size, sizeof(size)};
+  union {
+    cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control = {};
+  auto message = msghdr{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+  auto* header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+#if defined(MSG_NOSIGNAL)
+  constexpr auto flags = MSG_NOSIGNAL;
+#else
+  constexpr auto flags = 0;
+#endif
+  if (::sendmsg(socket, &message, flags) != sizeof(size))
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to send batch to worker: {}",
+                                       detail::describe_errno()));
+  return {};
+}
+
+/// Receives the counterpart of `send_descriptor`. Returns an error with code
+/// `ec::end_of_input` if the worker closed its end of the socket.
+auto receive_descriptor(int socket)
+  -> caf::expected<std::pair<uint64_t, int>> {
+  auto size = uint64_t{0};
+  auto iov = iovec{&size, sizeof(size)};
+  union {
+    cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control = {};
+  auto message = msghdr{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+  const auto received = ::recvmsg(socket, &message, MSG_WAITALL);
+  if (received == -1)
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to receive batch from worker: "
+                                       "{}",
+                                       detail::describe_errno()));
+  if (received == 0)
+    return caf::make_error(ec::end_of_input, "worker exited unexpectedly");
+  auto fd = -1;
+  auto* header = CMSG_FIRSTHDR(&message);
+  if (header != nullptr && header->cmsg_level == SOL_SOCKET
+      && header->cmsg_type == SCM_RIGHTS)
+    std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+  if (received != sizeof(size) || fd == -1 || size == 0) {
+    if (fd != -1)
+      ::close(fd);
+    return caf::make_error(ec::invalid_result,
+                           "received malformed message from worker");
+  }
+  return std::pair{size, fd};
+}
+
+/// Serializes a record batch directly into fresh shared memory and passes it
+/// to a worker.
+auto send_batch(int socket, const arrow::RecordBatch& batch) -> caf::error {
+  auto write = [&](arrow::io::OutputStream* sink) -> arrow::Status {
+    ARROW_ASSIGN_OR_RAISE(auto writer,
+                          arrow::ipc::MakeStreamWriter(sink, batch.schema()));
+    ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(batch));
+    return writer->Close();
+  };
+  // Determine the size of the stream up front, so that we can write it into
+  // shared memory of the right size without an intermediate buffer.
+  auto counter = arrow::io::MockOutputStream{};
+  if (auto status = write(&counter); !status.ok())
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to serialize batch: {}",
+                                       status.ToString()));
+  const auto size
+    = detail::narrow_cast<uint64_t>(counter.GetExtentBytesWritten());
+  auto fd = make_shared_memory(size);
+  if (!fd)
+    return std::move(fd.error());
+  auto fd_guard = caf::detail::scope_guard{[&] {
+    ::close(*fd);
+  }};
+  auto* data
+    = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+  if (data == MAP_FAILED)
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to map shared memory: {}",
+                                       detail::describe_errno()));
+  auto sink = arrow::io::FixedSizeBufferWriter{
+    std::make_shared<arrow::MutableBuffer>(static_cast<uint8_t*>(data),
+                                           detail::narrow_cast<int64_t>(size))};
+  auto status = write(&sink);
+  ::munmap(data, size);
+  if (!status.ok())
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to serialize batch: {}",
+                                       status.ToString()));
+  return send_descriptor(socket, size, *fd);
+}
+
+/// Receives a record batch from a worker. The batch references the shared
+/// memory that the worker wrote it to without copying it.
+auto receive_batch(int socket)
+  -> caf::expected<std::shared_ptr<arrow::RecordBatch>> {
+  auto message = receive_descriptor(socket);
+  if (!message)
+    return std::move(message.error());
+  const auto [size, fd] = *message;
+  auto* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to map shared memory: {}",
+                                       detail::describe_errno()));
+  auto stream = arrow::io::BufferReader{
+    std::make_shared<mapped_buffer>(data, detail::narrow_cast<size_t>(size))};
+  auto reader = arrow::ipc::RecordBatchStreamReader::Open(&stream);
+  if (!reader.ok())
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to read batch from worker: {}",
+                                       reader.status().ToString()));
+  auto batch = (*reader)->Next();
+  if (!batch.ok() || !*batch)
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to read batch from worker: {}",
+                                       batch.status().ToString()));
+  return std::move(*batch);
+}
+
+/// Checks without blocking whether a worker has sent a result.
+auto has_pending_result(int socket) -> bool {
+  auto fd = pollfd{};
+  fd.fd = socket;
+  fd.events = POLLIN;
+  return ::poll(&fd, 1, 0) > 0;
+}
+
+/// A Python process that executes the user code for every batch that the
+/// operator passes to it.
+struct python_worker {
+  python_worker() = default;
+  python_worker(const python_worker&) = delete;
+  auto operator=(const python_worker&) -> python_worker& = delete;
+  python_worker(python_worker&&) = delete;
+  auto operator=(python_worker&&) -> python_worker& = delete;
+
+  ~python_worker() {
+    if (socket != -1)
+      ::close(socket);
+  }
+
+  bp::child child = {};
+  bp::ipstream errpipe = {};
+  int socket = -1;
+};
+
 class python_operator final : public crtp_operator<python_operator> {
 public:
   python_operator() = default;
 
   explicit python_operator(const config* config, std::string requirements,
-                           std::variant<std::filesystem::path, std::string> code)
+                           std::variant<std::filesystem::path, std::string> code,
+                           uint64_t workers)
     : config_{config},
       requirements_{std::move(requirements)},
-      code_{std::move(code)} {
+      code_{std::move(code)},
+      workers_{workers} {
   }
 
   auto execute(generator<table_slice> input, operator_control_plane& ctrl) const
@@ -113,8 +330,6 @@ public:
       }
       auto code = *maybe_code;
       // Setup python prerequisites.
-      bp::pipe std_out;
-      bp::pipe std_in;
       bp::ipstream std_err;
       auto python_executable = bp::search_path("python3");
       auto env = boost::this_process::environment();
@@ -213,95 +428,134 @@ public:
         python_executable = venv_path / "bin" / "python3";
         TENZIR_VERBOSE("python operator utilizes virtual environment {}", venv);
       }
-      bp::opstream codepipe; // pipe to transmit the code
-      // If we redirect stderr to get error information, we need to switch to a
-      // select()-style read loop to ensure python (or a child process) doesn't
-      // deadlock when trying to write to stderr. So we use a separate pipe
-      // that's only used by the python executor and has well-defined semantics.
-      bp::ipstream errpipe;
-      auto child
-        = bp::child{boost::process::filesystem::path{python_executable},
-                    "-c",
-                    PYTHON_SCAFFOLD,
-                    fmt::to_string(codepipe.pipe().native_source()),
-                    fmt::to_string(errpipe.pipe().native_sink()),
-                    env,
-                    bp::std_out > std_out,
-                    bp::std_in < std_in};
-      codepipe << detail::strip_leading_indentation(std::string{code});
-      codepipe.close();
-      ::close(errpipe.pipe().native_sink());
+      auto spawn_worker
+        = [&]() -> caf::expected<std::unique_ptr<python_worker>> {
+        // Batches travel through shared memory whose descriptors we pass
+        // over a Unix domain socket, which avoids copying them through pipes.
+        auto sockets = std::array<int, 2>{};
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()) == -1)
+          return caf::make_error(ec::system_error,
+                                 fmt::format("failed to create socket pair: {}",
+                                             detail::describe_errno()));
+        auto worker = std::make_unique<python_worker>();
+        worker->socket = sockets[0];
+        // Workers that we spawn later must not inherit our end of the socket,
+        // or this worker would never notice that we closed it.
+        ::fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+        bp::opstream codepipe; // pipe to transmit the code
+        // If we redirect stderr to get error information, we need to switch to
+        // a select()-style read loop to ensure python (or a child process)
+        // doesn't deadlock when trying to write to stderr. So we use a separate
+        // pipe that's only used by the python executor and has well-defined
+        // semantics.
+        worker->child
+          = bp::child{boost::process::filesystem::path{python_executable},
+                      "-c",
+                      PYTHON_SCAFFOLD,
+                      fmt::to_string(codepipe.pipe().native_source()),
+                      fmt::to_string(worker->errpipe.pipe().native_sink()),
+                      fmt::to_string(sockets[1]),
+                      env,
+                      bp::std_out > bp::null,
+                      bp::std_in < bp::null};
+        ::close(sockets[1]);
+        codepipe << detail::strip_leading_indentation(std::string{code});
+        codepipe.close();
+        ::close(worker->errpipe.pipe().native_sink());
+        return worker;
+      };
+      auto workers = std::vector<std::unique_ptr<python_worker>>{};
+      for (auto i = uint64_t{0}; i < workers_; ++i) {
+        auto worker = spawn_worker();
+        if (!worker) {
+          diagnostic::error(worker.error())
+            .note("failed to start python worker")
+            .emit(ctrl.diagnostics());
+          co_return;
+        }
+        workers.push_back(std::move(*worker));
+      }
       co_yield {}; // signal successful startup
+      // We dispatch batches to the workers round-robin and collect the results
+      // in the same order, which retains the order of events. The oldest batch
+      // in flight thus always belongs to the worker that gets the next batch.
+      auto in_flight = std::deque<std::pair<size_t, std::string>>{};
+      auto next_worker = size_t{0};
+      auto receive = [&]() -> caf::expected<table_slice> {
+        TENZIR_ASSERT(!in_flight.empty());
+        auto [index, original_schema_name] = std::move(in_flight.front());
+        in_flight.pop_front();
+        auto& worker = *workers[index];
+        auto result_batch = receive_batch(worker.socket);
+        if (!result_batch) {
+          // A worker only closes its socket when it exits, after it reported
+          // the reason through the error pipe.
+          if (result_batch.error() == ec::end_of_input) {
+            if (auto python_error = drain_pipe(worker.errpipe);
+                !python_error.empty())
+              return diagnostic::error("{}", python_error).to_error();
+          }
+          return std::move(result_batch.error());
+        }
+        // Prepare the output.
+        auto output = table_slice{*result_batch};
+        auto new_type = type{original_schema_name, output.schema()};
+        auto actual_result
+          = arrow::RecordBatch::Make(new_type.to_arrow_schema(),
+                                     static_cast<int64_t>(output.rows()),
+                                     (*result_batch)->columns());
+        return table_slice{actual_result, new_type};
+      };
       for (auto&& slice : input) {
         if (slice.rows() == 0) {
+          // Use the time without input to forward results that are ready.
+          if (!in_flight.empty()
+              && has_pending_result(workers[in_flight.front().first]->socket)) {
+            auto output = receive();
+            if (!output) {
+              diagnostic::error(output.error()).emit(ctrl.diagnostics());
+              co_return;
+            }
+            co_yield std::move(*output);
+            continue;
+          }
           co_yield {};
           continue;
         }
-        auto original_schema_name = slice.schema().name();
-        auto batch = to_record_batch(slice);
-        auto stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
-        auto writer = arrow::ipc::MakeStreamWriter(
-                        stream, slice.schema().to_arrow_schema())
-                        .ValueOrDie();
-        if (!writer->WriteRecordBatch(*batch).ok()) {
-          diagnostic::error("failed to convert input batch to Arrow format")
-            .note(
-              "failed to write in conversion from input batch to Arrow format")
-            .emit(ctrl.diagnostics());
-          co_return;
-        }
-        if (auto status = writer->Close(); !status.ok()) {
-          diagnostic::error("{}", status.message())
-            .note("failed to close writer in conversion from input batch to "
-                  "Arrow format")
-            .emit(ctrl.diagnostics());
-          co_return;
+        if (in_flight.size() == workers.size()) {
+          auto output = receive();
+          if (!output) {
+            diagnostic::error(output.error()).emit(ctrl.diagnostics());
+            co_return;
+          }
+          co_yield std::move(*output);
         }
-        auto result = stream->Finish();
-        if (!result.status().ok()) {
-          diagnostic::error("{}", result.status().message())
-            .note(
-              "failed to flush in conversion from input batch to Arrow format")
+        auto batch = to_record_batch(slice);
+        if (auto err = send_batch(workers[next_worker]->socket, *batch)) {
+          diagnostic::error(err)
+            .note("failed to pass input batch to python worker")
             .emit(ctrl.diagnostics());
           co_return;
         }
-        std_in.write(reinterpret_cast<const char*>((*result)->data()),
-                     detail::narrow<int>((*result)->size()));
-        auto file = format::arrow::arrow_fd_wrapper{std_out.native_source()};
-        auto reader = arrow::ipc::RecordBatchStreamReader::Open(&file);
-        if (!reader.status().ok()) {
-          auto python_error = drain_pipe(errpipe);
-          diagnostic::error("{}", python_error).emit(ctrl.diagnostics());
-          co_return;
-        }
-        auto result_batch = (*reader)->ReadNext();
-        if (!result_batch.status().ok()) {
-          auto python_error = drain_pipe(errpipe);
-          diagnostic::error("{}", python_error).emit(ctrl.diagnostics());
-          co_return;
-        }
-        // The writer on the other side writes an invalid record batch as
-        // end-of-stream marker; we have to read it now to remove it from
-        // the pipe.
-        if (auto result = (*reader)->ReadNext(); !result.ok()) {
-          diagnostic::error("{}", result.status().message())
-            .note("failed to read closing bytes")
-            .emit(ctrl.diagnostics());
+        in_flight.emplace_back(next_worker,
+                               std::string{slice.schema().name()});
+        next_worker = (next_worker + 1) % workers.size();
+      }
+      while (!in_flight.empty()) {
+        auto output = receive();
+        if (!output) {
+          diagnostic::error(output.error()).emit(ctrl.diagnostics());
           co_return;
         }
-        static_cast<void>((*reader)->Close());
-        // Prepare the output.
-        auto output = table_slice{result_batch->batch};
-        auto new_type = type{original_schema_name, output.schema()};
-        auto actual_result
-          = arrow::RecordBatch::Make(new_type.to_arrow_schema(),
-                                     static_cast<int64_t>(output.rows()),
-                                     result_batch->batch->columns());
-        output = table_slice{actual_result, new_type};
-        co_yield output;
+        co_yield std::move(*output);
       }
-      std_in.close();
-      child.wait();
+      // Closing the sockets tells the workers to shut down.
+      for (auto& worker : workers) {
+        ::close(worker->socket);
+        worker->socket = -1;
+      }
+      for (auto& worker : workers)
+        worker->child.wait();
     } catch (const std::exception& ex) {
       diagnostic::error("{}", ex.what()).emit(ctrl.diagnostics());
     }
@@ -333,13 +587,14 @@ public:
     return f.object(x)
       .pretty_name("tenzir.plugins.python.python-operator")
       .fields(f.field("requirements", x.requirements_),
-              f.field("code", x.code_));
+              f.field("code", x.code_), f.field("workers", x.workers_));
   }
 
 private:
   const config* config_ = nullptr;
   std::string requirements_ = {};
   std::variant<std::filesystem::path, std::string> code_ = {};
+  uint64_t workers_ = 1;
 };
 
 class plugin final : public virtual operator_plugin<python_operator> {
@@ -380,10 +635,12 @@ public:
     auto command = std::optional<located<std::string>>{};
     auto requirements = std::string{};
     auto filename = std::optional<located<std::string>>{};
+    auto workers = std::optional<located<uint64_t>>{};
     auto parser = argument_parser{"python", "https://docs.tenzir.com/next/"
                                             "operators/transformations/python"};
     parser.add("-r,--requirements", requirements, "<requirements>");
     parser.add("-f,--file", filename, "<filename>");
+    parser.add("-w,--workers", workers, "<count>");
     parser.add(command, "<command>");
     parser.parse(p);
     if (!filename && !command) {
@@ -397,6 +654,11 @@ public:
         .primary(command->source)
         .throw_();
     }
+    if (workers && workers->inner == 0) {
+      diagnostic::error("`--workers` must be greater than zero")
+        .primary(workers->source)
+        .throw_();
+    }
     auto code = std::variant<std::filesystem::path, std::string>{};
     if (command.has_value()) {
       code = command->inner;
@@ -404,7 +666,8 @@ public:
       code = std::filesystem::path{filename->inner};
     }
     return std::make_unique<python_operator>(&config, std::move(requirements),
-                                             std::move(code));
+                                             std::move(code),
+                                             workers ? workers->inner : 1);
   }
 };
 
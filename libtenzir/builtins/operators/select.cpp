@@ -82,6 +82,15 @@ public:
     return optimize_result::order_invariant(*this, order);
   }
 
+  auto
+  required_fields(const std::optional<std::vector<std::string>>& fields) const
+    -> std::optional<std::vector<std::string>> override {
+    // We only read the selected fields, no matter which of them are required
+    // downstream.
+    (void)fields;
+    return config_.fields;
+  }
+
   friend auto inspect(auto& f, select_operator& x) -> bool {
     return f.apply(x.config_);
   }
@@ -54,6 +54,7 @@
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
 #include <tenzir/concept/parseable/to.hpp>
 #include <tenzir/concept/printable/tenzir/json.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/detail/weak_run_delayed.hpp>
 #include <tenzir/format/json.hpp>
 #include <tenzir/node.hpp>
@@ -66,7 +67,11 @@
 #include <tenzir/status.hpp>
 #include <tenzir/table_slice.hpp>
 
+#include <arrow/io/memory.h>
+#include <arrow/ipc/writer.h>
 #include <arrow/record_batch.h>
+#include <arrow/util/compression.h>
+#include <arrow/util/key_value_metadata.h>
 #include <caf/stateful_actor.hpp>
 #include <caf/typed_event_based_actor.hpp>
 
@@ -118,6 +123,17 @@ constexpr auto SPEC_V0 = R"_(
                 example: true
                 default: false
                 description: Use an experimental, more simple format for the contained schema.
+              format:
+                type: string
+                enum: [json, arrow]
+                example: "arrow"
+                default: "json"
+                description: The format of the response. With `arrow`, the response body is a sequence of Arrow IPC streams with content type `application/vnd.apache.arrow.stream`, one for every consecutive run of events with the same schema. The schema metadata of every stream contains the next continuation token under the key `TENZIR:serve:next_continuation_token`, which is empty if the pipeline is completed. If there are no events, the body consists of a single stream without fields.
+              compression:
+                type: string
+                enum: [zstd, lz4]
+                example: "zstd"
+                description: Compress the record batches of the Arrow IPC streams. Requires `format` to be `arrow`.
     responses:
       200:
         description: Success.
@@ -175,6 +191,10 @@ constexpr auto SPEC_V0 = R"_(
                       schema: "suricata.dns"
                       schema_id: "cd4771bas235f1"
                       events: 50
+          application/vnd.apache.arrow.stream:
+            schema:
+              type: string
+              format: binary
       400:
         description: Invalid arguments.
         content:
@@ -213,10 +233,18 @@ struct request_limits {
   duration timeout = defaults::api::serve::timeout;
 };
 
+/// The format of the response body of the `/serve` endpoint.
+enum class serve_format {
+  json,
+  arrow,
+};
+
 struct serve_request {
   std::string serve_id = {};
   std::string continuation_token = {};
   bool use_simple_format = {};
+  serve_format format = serve_format::json;
+  std::optional<arrow::Compression::type> compression = {};
   request_limits limits = {};
 };
 
@@ -679,6 +707,54 @@ struct serve_handler_state {
     if (*use_simple_format) {
       result.use_simple_format = **use_simple_format;
     }
+    auto format = try_get<std::string>(params, "format");
+    if (not format) {
+      return parse_error{
+        .message = "failed to read format",
+        .detail = caf::make_error(ec::invalid_argument,
+                                  fmt::format("parameter: {}; got params {}",
+                                              format.error(), params))};
+    }
+    if (*format) {
+      if (**format == "json") {
+        result.format = serve_format::json;
+      } else if (**format == "arrow") {
+        result.format = serve_format::arrow;
+      } else {
+        return parse_error{
+          .message = fmt::format("unsupported format `{}`", **format),
+          .detail = caf::make_error(
+            ec::invalid_argument,
+            fmt::format("expected `json` or `arrow`; got params {}", params))};
+      }
+    }
+    auto compression = try_get<std::string>(params, "compression");
+    if (not compression) {
+      return parse_error{
+        .message = "failed to read compression",
+        .detail = caf::make_error(ec::invalid_argument,
+                                  fmt::format("parameter: {}; got params {}",
+                                              compression.error(), params))};
+    }
+    if (*compression) {
+      if (**compression == "zstd") {
+        result.compression = arrow::Compression::ZSTD;
+      } else if (**compression == "lz4") {
+        result.compression = arrow::Compression::LZ4_FRAME;
+      } else {
+        return parse_error{
+          .message = fmt::format("unsupported compression `{}`", **compression),
+          .detail = caf::make_error(
+            ec::invalid_argument,
+            fmt::format("expected `zstd` or `lz4`; got params {}", params))};
+      }
+      if (result.format != serve_format::arrow) {
+        return parse_error{
+          .message = "compression requires the arrow format",
+          .detail = caf::make_error(ec::invalid_argument,
+                                    fmt::format("got params {}", params))};
+      }
+    }
     return result;
   }
 
@@ -741,6 +817,74 @@ struct serve_handler_state {
     return result;
   }
 
+  /// Renders the results as a sequence of Arrow IPC streams, starting a new
+  /// stream whenever the schema changes. This avoids rendering every event
+  /// individually, and allows clients to read the columns directly.
+  static auto
+  create_arrow_response(const std::string& next_continuation_token,
+                        const std::vector<table_slice>& results,
+                        std::optional<arrow::Compression::type> compression)
+    -> caf::expected<std::string> {
+    auto options = arrow::ipc::IpcWriteOptions::Defaults();
+    if (compression) {
+      auto codec = arrow::util::Codec::Create(*compression);
+      if (not codec.ok()) {
+        return caf::make_error(ec::logic_error,
+                               fmt::format("failed to create codec: {}",
+                                           codec.status().ToString()));
+      }
+      options.codec = std::move(*codec);
+    }
+    const auto metadata = arrow::KeyValueMetadata::Make(
+      {"TENZIR:serve:next_continuation_token"}, {next_continuation_token});
+    auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+    auto writer = std::shared_ptr<arrow::ipc::RecordBatchWriter>{};
+    auto writer_schema = type{};
+    auto open_stream
+      = [&](const std::shared_ptr<arrow::Schema>& schema) -> arrow::Status {
+      if (writer) {
+        ARROW_RETURN_NOT_OK(writer->Close());
+      }
+      const auto& existing = schema->metadata();
+      ARROW_ASSIGN_OR_RAISE(
+        writer,
+        arrow::ipc::MakeStreamWriter(
+          sink,
+          schema->WithMetadata(existing ? existing->Merge(*metadata)
+                                        : metadata),
+          options));
+      return arrow::Status::OK();
+    };
+    auto write = [&]() -> arrow::Status {
+      for (const auto& slice : results) {
+        if (slice.rows() == 0) {
+          continue;
+        }
+        auto resolved_slice = resolve_enumerations(slice);
+        auto batch = to_record_batch(resolved_slice);
+        if (not writer or resolved_slice.schema() != writer_schema) {
+          ARROW_RETURN_NOT_OK(open_stream(batch->schema()));
+          writer_schema = resolved_slice.schema();
+        }
+        ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+      }
+      // Clients always find the continuation token in the first stream.
+      if (not writer) {
+        ARROW_RETURN_NOT_OK(
+          open_stream(arrow::schema(arrow::FieldVector{})));
+      }
+      return writer->Close();
+    };
+    if (auto status = write(); not status.ok()) {
+      return caf::make_error(ec::serialization_error,
+                             fmt::format("failed to write Arrow IPC stream: {}",
+                                         status.ToString()));
+    }
+    auto buffer = sink->Finish().ValueOrDie();
+    return std::string{reinterpret_cast<const char*>(buffer->data()),
+                       detail::narrow_cast<size_t>(buffer->size())};
+  }
+
   auto http_request(uint64_t endpoint_id, tenzir::record params) const
     -> caf::result<rest_response> {
     if (endpoint_id != SERVE_ENDPOINT_ID) {
@@ -762,9 +906,22 @@ struct serve_handler_state {
                 request.continuation_token, request.limits.min_events,
                 request.limits.timeout, request.limits.max_events)
       .then(
-        [rp, use_simple_format = request.use_simple_format](
+        [rp, use_simple_format = request.use_simple_format,
+         format = request.format, compression = request.compression](
           const std::tuple<std::string, std::vector<table_slice>>&
             result) mutable {
+          if (format == serve_format::arrow) {
+            auto body = create_arrow_response(std::get<0>(result),
+                                              std::get<1>(result), compression);
+            if (not body) {
+              rp.deliver(rest_response::make_error(
+                500, "failed to create response", std::move(body.error())));
+              return;
+            }
+            rp.deliver(rest_response::from_body(
+              std::move(*body), http_content_type::arrow_stream));
+            return;
+          }
           rp.deliver(rest_response::from_json_string(create_response(
             std::get<0>(result), std::get<1>(result), use_simple_format)));
         },
@@ -1006,6 +1163,8 @@ public:
           {"min_events", uint64_type{}},
           {"timeout", duration_type{}},
           {"use_simple_format", bool_type{}},
+          {"format", string_type{}},
+          {"compression", string_type{}},
         },
         .version = api_version::v0,
         .content_type = http_content_type::json,
@@ -200,6 +200,13 @@ public:
     return optimize_result{std::nullopt, event_order::ordered, copy()};
   }
 
+  auto
+  required_fields(const std::optional<std::vector<std::string>>& fields) const
+    -> std::optional<std::vector<std::string>> override {
+    // Slicing does not depend on the contents of events.
+    return fields;
+  }
+
   friend auto inspect(auto& f, slice_operator& x) -> bool {
     return f.object(x)
       .pretty_name("tenzir.plugin.slice.slice_operator")
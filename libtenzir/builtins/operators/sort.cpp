@@ -9,184 +9,596 @@
 #include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/concept/parseable/numeric/integral.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/detail/serialize.hpp>
 #include <tenzir/error.hpp>
+#include <tenzir/generator.hpp>
 #include <tenzir/logger.hpp>
 #include <tenzir/pipeline.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/table_slice.hpp>
+#include <tenzir/uuid.hpp>
 
+#include <arrow/array.h>
+#include <arrow/buffer.h>
 #include <arrow/compute/api_vector.h>
 #include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/util/byte_size.h>
+#include <caf/binary_deserializer.hpp>
+
+#include <filesystem>
+#include <fstream>
 
 namespace tenzir::plugins::sort {
 
 namespace {
 
+/// A single sort key, as passed to the operator.
+struct sort_key {
+  std::string field = {};
+  bool descending = {};
+
+  friend auto inspect(auto& f, sort_key& x) -> bool {
+    return f.object(x).fields(f.field("field", x.field),
+                              f.field("descending", x.descending));
+  }
+};
+
+/// Writes a sorted run of table slices to a file and reads it back one slice
+/// at a time. Every slice is stored as its size in bytes, followed by its
+/// binary serialization.
+class spilled_run {
+public:
+  explicit spilled_run(std::filesystem::path path) : path_{std::move(path)} {
+  }
+
+  auto write(generator<table_slice> slices) -> caf::error {
+    auto out = std::ofstream{path_, std::ios::binary | std::ios::trunc};
+    if (not out) {
+      return caf::make_error(ec::filesystem_error,
+                             fmt::format("failed to open {}", path_));
+    }
+    auto buffer = caf::byte_buffer{};
+    for (auto&& slice : slices) {
+      buffer.clear();
+      if (not detail::serialize(buffer, slice)) {
+        return caf::make_error(ec::serialization_error,
+                               "failed to serialize table slice");
+      }
+      const auto size = static_cast<uint64_t>(buffer.size());
+      out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      out.write(reinterpret_cast<const char*>(buffer.data()),
+                detail::narrow_cast<std::streamsize>(buffer.size()));
+      if (not out) {
+        return caf::make_error(ec::filesystem_error,
+                               fmt::format("failed to write to {}", path_));
+      }
+    }
+    return {};
+  }
+
+  auto read() const -> generator<caf::expected<table_slice>> {
+    auto in = std::ifstream{path_, std::ios::binary};
+    if (not in) {
+      co_yield caf::make_error(ec::filesystem_error,
+                               fmt::format("failed to open {}", path_));
+      co_return;
+    }
+    auto buffer = caf::byte_buffer{};
+    auto size = uint64_t{0};
+    while (in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+      buffer.resize(size);
+      if (not in.read(reinterpret_cast<char*>(buffer.data()),
+                      detail::narrow_cast<std::streamsize>(size))) {
+        co_yield caf::make_error(ec::filesystem_error,
+                                 fmt::format("failed to read from {}", path_));
+        co_return;
+      }
+      auto slice = table_slice{};
+      auto source = caf::binary_deserializer{nullptr, buffer};
+      if (not source.apply(slice)) {
+        co_yield caf::make_error(ec::serialization_error,
+                                 fmt::format("failed to deserialize table "
+                                             "slice: {}",
+                                             source.get_error()));
+        co_return;
+      }
+      co_yield std::move(slice);
+    }
+  }
+
+private:
+  std::filesystem::path path_ = {};
+};
+
 class sort_state {
 public:
-  sort_state(const std::string& key,
-             const arrow::compute::ArraySortOptions& sort_options)
-    : key_{key}, sort_options_{sort_options} {
+  sort_state(const std::vector<sort_key>& keys,
+             const arrow::compute::SortOptions& sort_options,
+             uint64_t memory_limit)
+    : keys_{keys}, sort_options_{sort_options}, memory_limit_{memory_limit} {
+  }
+
+  sort_state(const sort_state&) = delete;
+  auto operator=(const sort_state&) -> sort_state& = delete;
+  sort_state(sort_state&&) = delete;
+  auto operator=(sort_state&&) -> sort_state& = delete;
+
+  ~sort_state() noexcept {
+    if (not spill_directory_.empty()) {
+      auto ec = std::error_code{};
+      std::filesystem::remove_all(spill_directory_, ec);
+      if (ec) {
+        TENZIR_WARN("sort failed to remove spill directory {}: {}",
+                    spill_directory_, ec.message());
+      }
+    }
   }
 
   auto try_add(table_slice slice, operator_control_plane& ctrl) -> table_slice {
     if (slice.rows() == 0) {
       return slice;
     }
-    const auto& path = find_or_create_path(slice.schema(), ctrl);
-    if (not path) {
+    const auto& paths = find_or_create_paths(slice.schema(), ctrl);
+    if (not paths) {
       return {};
     }
     auto batch = to_record_batch(slice);
     TENZIR_ASSERT(batch);
-    auto array = path->get(*batch);
-    // TODO: Sorting in Arrow using arrow::compute::SortIndices is not
-    // supported for extension types, so eventually we'll have to roll our
-    // own implementation. In the meantime, we sort the underlying storage
-    // array, which at least sorts in some stable way.
-    if (auto ext_array
-        = std::dynamic_pointer_cast<arrow::ExtensionArray>(array)) {
-      sort_keys_.push_back(ext_array->storage());
-    } else {
-      sort_keys_.push_back(std::move(array));
+    auto key_arrays = arrow::ArrayVector{};
+    key_arrays.reserve(paths->size());
+    for (const auto& path : *paths) {
+      auto array = path.get(*batch);
+      // TODO: Sorting in Arrow using arrow::compute::SortIndices is not
+      // supported for extension types, so eventually we'll have to roll our
+      // own implementation. In the meantime, we sort the underlying storage
+      // array, which at least sorts in some stable way.
+      if (auto ext_array
+          = std::dynamic_pointer_cast<arrow::ExtensionArray>(array)) {
+        key_arrays.push_back(ext_array->storage());
+      } else {
+        key_arrays.push_back(std::move(array));
+      }
+    }
+    if (not key_schema_) {
+      auto fields = arrow::FieldVector{};
+      for (size_t i = 0; i < key_arrays.size(); ++i) {
+        fields.push_back(
+          arrow::field(fmt::to_string(i), key_arrays[i]->type()));
+      }
+      key_schema_ = arrow::schema(std::move(fields));
     }
+    key_batches_.push_back(arrow::RecordBatch::Make(
+      key_schema_, batch->num_rows(), std::move(key_arrays)));
     offset_table_.push_back(offset_table_.back()
                             + detail::narrow_cast<int64_t>(slice.rows()));
+    buffered_bytes_ += detail::narrow_cast<uint64_t>(
+      arrow::util::ReferencedBufferSize(*batch).ValueOr(0));
     cache_.push_back(std::move(slice));
+    if (memory_limit_ > 0 and buffered_bytes_ > memory_limit_) {
+      if (auto err = spill()) {
+        diagnostic::error(err)
+          .note("failed to spill sorted events to disk")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+      }
+    }
     return {};
   }
 
-  auto sorted() && -> generator<table_slice> {
-    // If there is nothing to sort, then we can just return early.
+  auto sorted(operator_control_plane& ctrl) && -> generator<table_slice> {
+    if (runs_.empty()) {
+      for (auto&& slice : sort_buffered()) {
+        co_yield std::move(slice);
+      }
+      co_return;
+    }
+    // Once we spilled, we also spill the remainder so that all runs can be
+    // merged uniformly.
+    if (auto err = spill()) {
+      diagnostic::error(err)
+        .note("failed to spill sorted events to disk")
+        .note("from `sort`")
+        .emit(ctrl.diagnostics());
+      co_return;
+    }
+    for (auto&& slice : merge_runs(ctrl)) {
+      co_yield std::move(slice);
+    }
+  }
+
+private:
+  /// A group of cached slices that share a schema, combined into a single
+  /// record batch of bounded size that we can gather rows from.
+  struct gather_source {
+    type schema = {};
+    time import_time = {};
+    std::shared_ptr<arrow::RecordBatch> batch = {};
+  };
+
+  /// Sorts the buffered slices and clears the buffer. The result consists of
+  /// batches of up to `table_slice_size` rows, each of which is gathered from
+  /// the buffered slices with a single call to `arrow::compute::Take`.
+  auto sort_buffered() -> generator<table_slice> {
     if (cache_.empty()) {
       co_return;
     }
+    auto cache = std::exchange(cache_, {});
+    auto offset_table = std::exchange(offset_table_, {0});
+    const auto keys
+      = arrow::Table::FromRecordBatches(key_schema_,
+                                        std::exchange(key_batches_, {}))
+          .ValueOrDie();
+    buffered_bytes_ = 0;
     // Arrow's sort function returns us an Int64Array of indices, which are
     // guaranteed not to be null. We map these in a two-step process onto our
-    // cached table slices, and yield slices of size 1 for each returned row.
-    // The algorithm below uses an offset table that has an additional 0 value
-    // at the start, and uses std::upper_bound to find the entry in the cache
-    // using the offset table.
-    const auto chunked_key
-      = arrow::ChunkedArray::Make(std::move(sort_keys_)).ValueOrDie();
+    // cached table slices using an offset table that has an additional 0
+    // value at the start, and std::upper_bound to find the entry in the cache.
     const auto indices
-      = arrow::compute::SortIndices(*chunked_key, sort_options_).ValueOrDie();
-    auto result_buffer = std::vector<table_slice>{};
+      = arrow::compute::SortIndices(arrow::Datum{keys}, sort_options_)
+          .ValueOrDie();
+    // Combine the cached slices of the same schema into record batches, and
+    // remember for every cached slice where its rows start in there. We bound
+    // the size of the combined batches, because string and blob columns with
+    // more than 2 GiB of data would overflow Arrow's 32-bit offsets.
+    constexpr auto max_source_bytes = int64_t{1} << 30;
+    auto sources = std::vector<gather_source>{};
+    auto source_of = std::vector<size_t>(cache.size());
+    auto source_offset = std::vector<int64_t>(cache.size());
+    {
+      auto source_index = std::unordered_map<type, size_t>{};
+      auto source_batches = std::vector<arrow::RecordBatchVector>{};
+      auto source_rows = std::vector<int64_t>{};
+      auto source_bytes = std::vector<int64_t>{};
+      for (size_t i = 0; i < cache.size(); ++i) {
+        auto batch = to_record_batch(cache[i]);
+        const auto bytes = arrow::util::ReferencedBufferSize(*batch).ValueOr(0);
+        auto it = source_index.find(cache[i].schema());
+        if (it == source_index.end()
+            or (source_rows[it->second] > 0
+                and source_bytes[it->second] + bytes > max_source_bytes)) {
+          it = source_index.insert_or_assign(cache[i].schema(), sources.size())
+                 .first;
+          sources.push_back({cache[i].schema(), cache[i].import_time(), {}});
+          source_batches.emplace_back();
+          source_rows.push_back(0);
+          source_bytes.push_back(0);
+        }
+        source_of[i] = it->second;
+        source_offset[i] = source_rows[it->second];
+        source_rows[it->second] += detail::narrow_cast<int64_t>(cache[i].rows());
+        source_bytes[it->second] += bytes;
+        source_batches[it->second].push_back(std::move(batch));
+      }
+      cache.clear();
+      for (size_t i = 0; i < sources.size(); ++i) {
+        sources[i].batch
+          = source_batches[i].size() == 1
+              ? std::move(source_batches[i].front())
+              : arrow::Table::FromRecordBatches(std::move(source_batches[i]))
+                  .ValueOrDie()
+                  ->CombineChunksToBatch()
+                  .ValueOrDie();
+      }
+    }
+    // Walk the sorted indices and gather consecutive rows of the same schema
+    // into output batches.
+    auto rows = std::vector<int64_t>{};
+    rows.reserve(std::min(defaults::import::table_slice_size,
+                          detail::narrow_cast<uint64_t>(indices->length())));
+    auto current_source = size_t{0};
     for (const auto& index : static_cast<const arrow::Int64Array&>(*indices)) {
       TENZIR_ASSERT(index.has_value());
       const auto offset = std::prev(
-        std::upper_bound(offset_table_.begin(), offset_table_.end(), *index));
-      const auto cache_index = std::distance(offset_table_.begin(), offset);
-      const auto row = *index - *offset;
-      const auto& slice = cache_[cache_index];
-      auto result = subslice(slice, row, row + 1);
-      TENZIR_ASSERT(result.rows() == 1);
-      co_yield std::move(result);
+        std::upper_bound(offset_table.begin(), offset_table.end(), *index));
+      const auto cache_index = std::distance(offset_table.begin(), offset);
+      const auto source = source_of[cache_index];
+      if (not rows.empty()
+          and (source != current_source
+               or rows.size() >= defaults::import::table_slice_size)) {
+        co_yield gather(sources[current_source], rows);
+        rows.clear();
+      }
+      current_source = source;
+      rows.push_back(source_offset[cache_index] + *index - *offset);
+    }
+    if (not rows.empty()) {
+      co_yield gather(sources[current_source], rows);
     }
   }
 
-private:
-  auto find_or_create_path(const type& schema, operator_control_plane& ctrl)
-    -> const std::optional<offset>& {
-    auto key_path = key_field_path_.find(schema);
-    if (key_path != key_field_path_.end()) {
-      return key_path->second;
+  /// Creates a table slice from the given rows of a gather source.
+  static auto gather(const gather_source& source,
+                     const std::vector<int64_t>& rows) -> table_slice {
+    const auto indices = std::make_shared<arrow::Int64Array>(
+      detail::narrow_cast<int64_t>(rows.size()), arrow::Buffer::Wrap(rows));
+    auto batch = arrow::compute::Take(source.batch, indices)
+                   .ValueOrDie()
+                   .record_batch();
+    TENZIR_ASSERT(batch);
+    auto result = table_slice{batch, source.schema};
+    result.import_time(source.import_time);
+    return result;
+  }
+
+  /// Sorts the buffered slices and writes them to a new run on disk.
+  auto spill() -> caf::error {
+    if (cache_.empty()) {
+      return {};
     }
-    // Set up the sorting and emit warnings at most once per schema.
-    key_path = key_field_path_.emplace_hint(
-      key_field_path_.end(), schema, schema.resolve_key_or_concept(key_));
-    if (not key_path->second.has_value()) {
-      diagnostic::warning("sort key `{}` does not apply to schema `{}`", key_,
-                          schema)
-        .note("events of this schema will be discarded")
-        .note("from `sort`")
-        .emit(ctrl.diagnostics());
-      return key_path->second;
+    if (spill_directory_.empty()) {
+      auto ec = std::error_code{};
+      auto directory = std::filesystem::temp_directory_path(ec) / "tenzir"
+                       / fmt::format("sort-{}", uuid::random());
+      if (not ec) {
+        std::filesystem::create_directories(directory, ec);
+      }
+      if (ec) {
+        return caf::make_error(ec::filesystem_error,
+                               fmt::format("failed to create spill directory: "
+                                           "{}",
+                                           ec.message()));
+      }
+      spill_directory_ = std::move(directory);
     }
-    auto current_key_type
-      = caf::get<record_type>(schema).field(*key_path->second).type.prune();
-    if (caf::holds_alternative<subnet_type>(current_key_type)) {
-      // TODO: Sorting in Arrow using arrow::compute::SortIndices is not
-      // supported for extension types. We can fall back to the storage array
-      // for all types but subnet, which has a nested extension type.
-      diagnostic::warning("sort key `{}` resolves to unsupported type `subnet` "
-                          "for schema `{}`",
-                          key_, schema)
-        .note("events of this schema will be discarded")
-        .note("from `sort`")
-        .emit(ctrl.diagnostics());
-      key_path->second = std::nullopt;
-      return key_path->second;
-    }
-    if (not key_type_) {
-      key_type_ = current_key_type;
-    } else if (key_type_ != current_key_type) {
-      diagnostic::warning("sort key `{}` resolves to type `{}` "
-                          "for schema `{}`, but to `{}` for a previous schema",
-                          key_, current_key_type, schema, *key_type_)
-        .note("events of this schema will be discarded")
-        .note("from `sort`")
-        .emit(ctrl.diagnostics());
-      key_path->second = std::nullopt;
+    auto& run = runs_.emplace_back(spill_directory_
+                                   / fmt::format("run-{}", runs_.size()));
+    return run.write(sort_buffered());
+  }
+
+  /// The position of a k-way merge in one of the spilled runs.
+  struct merge_cursor {
+    size_t run = {};
+    generator<caf::expected<table_slice>> slices = {};
+    generator<caf::expected<table_slice>>::iterator it = {};
+    table_slice slice = {};
+    std::vector<std::pair<type, std::shared_ptr<arrow::Array>>> columns = {};
+    int64_t row = {};
+    std::vector<data> key = {};
+  };
+
+  /// Compares the current rows of two cursors. Ties are broken by the order of
+  /// the runs, which keeps the merge stable.
+  auto cursor_less(const merge_cursor& lhs, const merge_cursor& rhs) const
+    -> bool {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      const auto& x = lhs.key[i];
+      const auto& y = rhs.key[i];
+      const auto x_null = caf::holds_alternative<caf::none_t>(x);
+      const auto y_null = caf::holds_alternative<caf::none_t>(y);
+      if (x_null or y_null) {
+        if (x_null and y_null) {
+          continue;
+        }
+        return x_null
+               == (sort_options_.null_placement
+                   == arrow::compute::NullPlacement::AtStart);
+      }
+      if (x == y) {
+        continue;
+      }
+      return keys_[i].descending ? y < x : x < y;
+    }
+    return lhs.run < rhs.run;
+  }
+
+  /// Moves a cursor to its next non-empty slice. Returns false if the run is
+  /// exhausted.
+  auto load_next_slice(merge_cursor& cursor, operator_control_plane& ctrl)
+    -> bool {
+    while (cursor.it != cursor.slices.end()) {
+      auto slice = std::move(*cursor.it);
+      ++cursor.it;
+      if (not slice) {
+        diagnostic::error(slice.error())
+          .note("failed to read spilled events")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        return false;
+      }
+      if (slice->rows() == 0) {
+        continue;
+      }
+      const auto& paths = key_field_paths_.at(slice->schema());
+      TENZIR_ASSERT(paths);
+      cursor.columns.clear();
+      for (const auto& path : *paths) {
+        cursor.columns.push_back(path.get(*slice));
+      }
+      cursor.slice = std::move(*slice);
+      cursor.row = 0;
+      load_key(cursor);
+      return true;
+    }
+    return false;
+  }
+
+  static auto load_key(merge_cursor& cursor) -> void {
+    cursor.key.clear();
+    for (const auto& [type, array] : cursor.columns) {
+      cursor.key.push_back(materialize(value_at(type, *array, cursor.row)));
+    }
+  }
+
+  /// Merges all spilled runs. Consecutive rows that come from the same run
+  /// are yielded as a single subslice.
+  auto merge_runs(operator_control_plane& ctrl) -> generator<table_slice> {
+    auto cursors = std::vector<std::unique_ptr<merge_cursor>>{};
+    for (size_t i = 0; i < runs_.size(); ++i) {
+      auto cursor = std::make_unique<merge_cursor>();
+      cursor->run = i;
+      cursor->slices = runs_[i].read();
+      cursor->it = cursor->slices.begin();
+      if (load_next_slice(*cursor, ctrl)) {
+        cursors.push_back(std::move(cursor));
+      }
+    }
+    // We maintain a min-heap of cursors, which requires inverting the order.
+    const auto heap_order = [this](const auto& lhs, const auto& rhs) {
+      return cursor_less(*rhs, *lhs);
+    };
+    std::make_heap(cursors.begin(), cursors.end(), heap_order);
+    while (not cursors.empty()) {
+      std::pop_heap(cursors.begin(), cursors.end(), heap_order);
+      auto& cursor = *cursors.back();
+      const auto begin = cursor.row;
+      const auto rows = detail::narrow_cast<int64_t>(cursor.slice.rows());
+      while (++cursor.row < rows) {
+        load_key(cursor);
+        if (cursors.size() > 1 and cursor_less(*cursors.front(), cursor)) {
+          break;
+        }
+      }
+      co_yield subslice(cursor.slice, detail::narrow_cast<size_t>(begin),
+                        detail::narrow_cast<size_t>(cursor.row));
+      if (cursor.row == rows and not load_next_slice(cursor, ctrl)) {
+        cursors.pop_back();
+        continue;
+      }
+      std::push_heap(cursors.begin(), cursors.end(), heap_order);
     }
-    return key_path->second;
   }
 
-  /// The sort field key, as passed to the operator.
-  const std::string& key_;
+  auto find_or_create_paths(const type& schema, operator_control_plane& ctrl)
+    -> const std::optional<std::vector<offset>>& {
+    auto key_paths = key_field_paths_.find(schema);
+    if (key_paths != key_field_paths_.end()) {
+      return key_paths->second;
+    }
+    // Set up the sorting and emit warnings at most once per schema.
+    key_paths = key_field_paths_.emplace_hint(key_field_paths_.end(), schema,
+                                              std::vector<offset>{});
+    key_types_.resize(keys_.size());
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      const auto& key = keys_[i].field;
+      auto path = schema.resolve_key_or_concept(key);
+      if (not path) {
+        diagnostic::warning("sort key `{}` does not apply to schema `{}`", key,
+                            schema)
+          .note("events of this schema will be discarded")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        key_paths->second = std::nullopt;
+        return key_paths->second;
+      }
+      auto current_key_type
+        = caf::get<record_type>(schema).field(*path).type.prune();
+      if (caf::holds_alternative<subnet_type>(current_key_type)) {
+        // TODO: Sorting in Arrow using arrow::compute::SortIndices is not
+        // supported for extension types. We can fall back to the storage
+        // array for all types but subnet, which has a nested extension type.
+        diagnostic::warning("sort key `{}` resolves to unsupported type "
+                            "`subnet` for schema `{}`",
+                            key, schema)
+          .note("events of this schema will be discarded")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        key_paths->second = std::nullopt;
+        return key_paths->second;
+      }
+      if (not key_types_[i]) {
+        key_types_[i] = current_key_type;
+      } else if (key_types_[i] != current_key_type) {
+        diagnostic::warning("sort key `{}` resolves to type `{}` "
+                            "for schema `{}`, but to `{}` for a previous "
+                            "schema",
+                            key, current_key_type, schema, *key_types_[i])
+          .note("events of this schema will be discarded")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        key_paths->second = std::nullopt;
+        return key_paths->second;
+      }
+      key_paths->second->push_back(std::move(*path));
+    }
+    return key_paths->second;
+  }
+
+  /// The sort keys, as passed to the operator.
+  const std::vector<sort_key>& keys_;
 
-  /// The sort options, as passed to the operator.
-  const arrow::compute::ArraySortOptions& sort_options_;
+  /// The sort options, as derived from the operator arguments.
+  const arrow::compute::SortOptions& sort_options_;
+
+  /// The number of buffered bytes after which we spill sorted runs to disk.
+  /// Zero disables spilling.
+  const uint64_t memory_limit_;
 
   /// The slices that we want to sort.
   std::vector<table_slice> cache_ = {};
 
+  /// An approximation of the number of bytes referenced by the cache.
+  uint64_t buffered_bytes_ = {};
+
   /// An offset table into the cached slices. The first entry of this is always
   /// zero, and for every slice we append to the cache we append the total
   /// number of rows in the cache to this table. This allows for using
   /// std::upper_bound to identify the index of the cache entry quickly.
   std::vector<int64_t> offset_table_ = {0};
 
-  /// The arrays that we sort by, in the same order as the offset table.
-  std::vector<std::shared_ptr<arrow::Array>> sort_keys_ = {};
+  /// The columns that we sort by, in the same order as the offset table.
+  arrow::RecordBatchVector key_batches_ = {};
+
+  /// The schema of the batches of sort keys.
+  std::shared_ptr<arrow::Schema> key_schema_ = {};
 
-  /// The cached field paths for the sorted-by field per schema. A nullopt value
+  /// The cached field paths for the sort keys per schema. A nullopt value
   /// indicates that sorting is not possible for this schema.
-  std::unordered_map<type, std::optional<offset>> key_field_path_ = {};
+  std::unordered_map<type, std::optional<std::vector<offset>>>
+    key_field_paths_ = {};
 
-  /// The type of the sorted-by field.
-  std::optional<type> key_type_ = {};
+  /// The types of the sort keys.
+  std::vector<std::optional<type>> key_types_ = {};
+
+  /// The directory that holds the spilled runs, if any.
+  std::filesystem::path spill_directory_ = {};
+
+  /// The sorted runs spilled to disk.
+  std::vector<spilled_run> runs_ = {};
 };
 
 class sort_operator final : public crtp_operator<sort_operator> {
 public:
   sort_operator() = default;
 
-  sort_operator(std::string key, bool stable, bool descending, bool nulls_first)
-    : key_{std::move(key)},
+  sort_operator(std::vector<sort_key> keys, bool stable, bool nulls_first,
+                uint64_t memory_limit)
+    : keys_{std::move(keys)},
       stable_{stable},
-      descending_{descending},
-      nulls_first_{nulls_first} {
+      nulls_first_{nulls_first},
+      memory_limit_{memory_limit} {
   }
 
   auto
   operator()(generator<table_slice> input, operator_control_plane& ctrl) const
     -> generator<table_slice> {
-    auto options = arrow::compute::ArraySortOptions::Defaults();
-    options.order = descending_ ? arrow::compute::SortOrder::Descending
-                                : arrow::compute::SortOrder::Ascending;
+    auto options = arrow::compute::SortOptions::Defaults();
+    options.sort_keys.clear();
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      options.sort_keys.emplace_back(
+        fmt::to_string(i), keys_[i].descending
+                             ? arrow::compute::SortOrder::Descending
+                             : arrow::compute::SortOrder::Ascending);
+    }
     options.null_placement = nulls_first_
                                ? arrow::compute::NullPlacement::AtStart
                                : arrow::compute::NullPlacement::AtEnd;
-    auto state = sort_state{key_, options};
+    auto state = sort_state{keys_, options, memory_limit_};
     for (auto&& slice : input) {
       co_yield state.try_add(std::move(slice), ctrl);
     }
-    // The sorted slices are very like to have size 1 each, so we rebatch them
-    // first to avoid inefficiencies in downstream operators.
+    // Sorted slices that were gathered in memory already have the desired
+    // batch size. Slices coming from merging spilled runs can be much smaller,
+    // so we rebatch them to avoid inefficiencies in downstream operators.
     auto buffer = std::vector<table_slice>{};
     auto num_buffered = uint64_t{0};
-    for (auto&& slice : std::move(state).sorted()) {
+    for (auto&& slice : std::move(state).sorted(ctrl)) {
+      if (buffer.empty()
+          and slice.rows() >= defaults::import::table_slice_size) {
+        co_yield std::move(slice);
+        continue;
+      }
       if (not buffer.empty() and buffer.back().schema() != slice.schema()) {
         while (not buffer.empty()) {
           auto [lhs, rhs] = split(buffer, defaults::import::table_slice_size);
@@ -222,21 +634,33 @@ public:
   }
 
   friend auto inspect(auto& f, sort_operator& x) -> bool {
-    return f.object(x).fields(f.field("key", x.key_),
+    return f.object(x).fields(f.field("keys", x.keys_),
                               f.field("stable", x.stable_),
-                              f.field("descending", x.descending_),
-                              f.field("nulls_first", x.nulls_first_));
+                              f.field("nulls_first", x.nulls_first_),
+                              f.field("memory_limit", x.memory_limit_));
   }
 
 private:
-  std::string key_ = {};
+  std::vector<sort_key> keys_ = {};
   bool stable_ = {};
-  bool descending_ = {};
   bool nulls_first_ = {};
+  uint64_t memory_limit_ = {};
 };
 
 class plugin final : public virtual operator_plugin<sort_operator> {
 public:
+  auto initialize(const record& plugin_config,
+                  [[maybe_unused]] const record& global_config)
+    -> caf::error override {
+    auto memory_limit = try_get_or<uint64_t>(plugin_config, "memory-limit",
+                                             uint64_t{0});
+    if (not memory_limit) {
+      return std::move(memory_limit.error());
+    }
+    memory_limit_ = *memory_limit;
+    return {};
+  }
+
   auto signature() const -> operator_signature override {
     return {.transformation = true};
   }
@@ -247,17 +671,22 @@ public:
       parsers::end_of_pipeline_operator, parsers::extractor, parsers::str;
     const auto* f = pipeline.begin();
     const auto* const l = pipeline.end();
-    auto key = std::string{};
+    auto keys = std::vector<sort_key>{};
+    const auto sort_key_parser
+      = extractor.then([&](std::string field) {
+          keys.push_back({std::move(field), false});
+        })
+        >> -(required_ws_or_comment >> (str{"asc"} | str{"desc"}))
+              .then([&](std::string sort_order) {
+                keys.back().descending = sort_order == "desc";
+              });
     const auto p
       = required_ws_or_comment
         >> -(str{"--stable"}.then([&](std::string) -> bool {
             return true;
           }) >> required_ws_or_comment)
-        >> extractor
-        >> -(required_ws_or_comment >> (str{"asc"} | str{"desc"}))
-              .then([&](std::string sort_order) {
-                return !(sort_order.empty() || sort_order == "asc");
-              })
+        >> ignore(sort_key_parser
+                  % (optional_ws_or_comment >> ',' >> optional_ws_or_comment))
         >> -(required_ws_or_comment >> (str{"nulls-first"} | str{"nulls-last"}))
               .then([&](std::string null_placement) {
                 return !(null_placement.empty()
@@ -265,9 +694,8 @@ public:
               })
         >> optional_ws_or_comment >> end_of_pipeline_operator;
     bool stable = false;
-    bool descending = false;
     bool nulls_first = false;
-    if (!p(f, l, stable, key, descending, nulls_first)) {
+    if (!p(f, l, stable, nulls_first)) {
       return {
         std::string_view{f, l},
         caf::make_error(ec::syntax_error, fmt::format("failed to parse "
@@ -277,10 +705,13 @@ public:
     }
     return {
       std::string_view{f, l},
-      std::make_unique<sort_operator>(std::move(key), stable, descending,
-                                      nulls_first),
+      std::make_unique<sort_operator>(std::move(keys), stable, nulls_first,
+                                      memory_limit_),
     };
   }
+
+private:
+  uint64_t memory_limit_ = {};
 };
 
 } // namespace
@@ -8,14 +8,19 @@
 
 #include <tenzir/aggregation_function.hpp>
 #include <tenzir/arrow_table_slice.hpp>
+#include <tenzir/as_bytes.hpp>
 #include <tenzir/concept/convertible/data.hpp>
 #include <tenzir/concept/convertible/to.hpp>
 #include <tenzir/concept/parseable/core.hpp>
+#include <tenzir/concept/parseable/numeric/integral.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
 #include <tenzir/concept/parseable/tenzir/time.hpp>
+#include <tenzir/detail/overload.hpp>
+#include <tenzir/detail/serialize.hpp>
 #include <tenzir/detail/zip_iterator.hpp>
+#include <tenzir/diagnostics.hpp>
 #include <tenzir/error.hpp>
-#include <tenzir/hash/hash_append.hpp>
+#include <tenzir/hash/xxhash.hpp>
 #include <tenzir/operator_control_plane.hpp>
 #include <tenzir/parser_interface.hpp>
 #include <tenzir/plugin.hpp>
@@ -24,12 +29,16 @@
 #include <tenzir/type.hpp>
 
 #include <arrow/compute/api_scalar.h>
+#include <arrow/compute/api_vector.h>
 #include <arrow/record_batch.h>
 #include <arrow/type.h>
 #include <caf/expected.hpp>
 #include <tsl/robin_map.h>
 
 #include <algorithm>
+#include <cstring>
+#include <future>
+#include <string_view>
 #include <utility>
 
 namespace tenzir::plugins::summarize {
@@ -131,85 +140,133 @@ struct configuration {
   /// Configuration for aggregation columns.
   std::vector<aggregation> aggregations = {};
 
+  /// The number of shards that aggregate disjoint sets of groups in parallel.
+  std::optional<uint64_t> threads = {};
+
   friend auto inspect(auto& f, configuration& x) -> bool {
     return f.object(x).fields(f.field("group_by_extractors",
                                       x.group_by_extractors),
                               f.field("time_resolution", x.time_resolution),
-                              f.field("aggregations", x.aggregations));
+                              f.field("aggregations", x.aggregations),
+                              f.field("threads", x.threads));
   }
 };
 
-/// The key by which aggregations are grouped. Essentially, this is a vector of
-/// data. We create a new type here to support a custom hash and equality
-/// operation to support lookups with non-materialized keys.
+/// The materialized values of the group-by columns of a group. We only create
+/// this once per group, as lookups use the flat encoding of the key instead.
 struct group_by_key : std::vector<data> {
   using vector::vector;
 };
 
-/// A view on a group-by key.
-struct group_by_key_view : std::vector<data_view> {
-  using vector::vector;
-
-  /// Materializes a view on a group-by key.
-  /// @param views The group-by key view to materialize.
-  friend group_by_key materialize(const group_by_key_view& views) {
-    auto result = group_by_key{};
-    result.reserve(views.size());
-    for (const auto& view : views)
-      result.push_back(materialize(view));
-    return result;
-  }
-};
+/// Appends the flat encoding of a group-by value to a key. Two values have the
+/// same encoding exactly if they compare equal, so we can look up groups by
+/// comparing bytes instead of materializing the values of every row.
+void append_group_by_value(std::string& key, const data_view& value) {
+  const auto append_bytes = [&](const void* data, size_t size) {
+    key.append(static_cast<const char*>(data), size);
+  };
+  const auto append_fixed = [&](const auto& x) {
+    append_bytes(&x, sizeof(x));
+  };
+  const auto append_variable = [&](const void* data, size_t size) {
+    append_fixed(uint64_t{size});
+    append_bytes(data, size);
+  };
+  // The index of the alternative prefixes the value, which keeps values of
+  // different types apart.
+  key.push_back(static_cast<char>(value.index()));
+  const auto f = detail::overload{
+    [](caf::none_t) {},
+    [&](bool x) {
+      append_fixed(x);
+    },
+    [&](int64_t x) {
+      append_fixed(x);
+    },
+    [&](uint64_t x) {
+      append_fixed(x);
+    },
+    [&](double x) {
+      // Positive and negative zero compare equal, so they must have the same
+      // encoding.
+      if (x == 0.0)
+        x = 0.0;
+      append_fixed(x);
+    },
+    [&](duration x) {
+      append_fixed(x.count());
+    },
+    [&](time x) {
+      append_fixed(x.time_since_epoch().count());
+    },
+    [&](std::string_view x) {
+      append_variable(x.data(), x.size());
+    },
+    [&](view<blob> x) {
+      append_variable(x.data(), x.size());
+    },
+    [&](ip x) {
+      const auto bytes = as_bytes(x);
+      append_bytes(bytes.data(), bytes.size());
+    },
+    [&](subnet x) {
+      const auto bytes = as_bytes(x.network());
+      append_bytes(bytes.data(), bytes.size());
+      append_fixed(x.length());
+    },
+    [&](enumeration x) {
+      append_fixed(x);
+    },
+    [&](const auto& x) {
+      // Patterns and containers are rare as group-by values, so we simply
+      // encode their serialized representation.
+      auto buffer = caf::byte_buffer{};
+      const auto ok = detail::serialize(buffer, materialize(x));
+      TENZIR_ASSERT(ok);
+      append_variable(buffer.data(), buffer.size());
+    },
+  };
+  caf::visit(f, value);
+}
 
-/// The hash functor for enabling use of *group_by_key* as a key in unordered
-/// map data structures with transparent lookup.
+/// The hash functor for flat group-by keys.
 struct group_by_key_hash {
-  size_t operator()(const group_by_key& x) const noexcept {
-    auto hasher = xxh64{};
-    for (const auto& value : x)
-      hash_append(hasher, make_view(value));
-    return hasher.finish();
-  }
-
-  size_t operator()(const group_by_key_view& x) const noexcept {
-    auto hasher = xxh64{};
-    for (const auto& value : x)
-      hash_append(hasher, value);
-    return hasher.finish();
+  size_t operator()(std::string_view x) const noexcept {
+    return xxh3_64::make(as_bytes(x.data(), x.size()));
   }
 };
 
-/// The equality functor for enabling use of *group_by_key* as a key in
-/// unordered map data structures with transparent lookup.
-struct group_by_key_equal {
-  using is_transparent = void;
-
-  bool
-  operator()(const group_by_key_view& x, const group_by_key& y) const noexcept {
-    return std::equal(x.begin(), x.end(), y.begin(), y.end(),
-                      [](const auto& lhs, const auto& rhs) {
-                        return lhs == make_view(rhs);
-                      });
-  }
-
-  bool
-  operator()(const group_by_key& x, const group_by_key_view& y) const noexcept {
-    return std::equal(x.begin(), x.end(), y.begin(), y.end(),
-                      [](const auto& lhs, const auto& rhs) {
-                        return make_view(lhs) == rhs;
-                      });
+/// Owns the flat group-by keys of all groups. Keys are stored contiguously in
+/// large blocks, so that creating a group does not require a separate
+/// allocation for its key. Stored keys remain valid when the arena is moved.
+class key_arena {
+public:
+  /// Copies a key into the arena.
+  /// @returns A view on the copied key that lives as long as the arena.
+  auto store(std::string_view key) -> std::string_view {
+    if (blocks_.empty() || capacity_ - size_ < key.size()) {
+      capacity_ = std::max(block_size, key.size());
+      size_ = 0;
+      blocks_.push_back(std::make_unique<char[]>(capacity_));
+    }
+    auto* data = blocks_.back().get() + size_;
+    std::memcpy(data, key.data(), key.size());
+    size_ += key.size();
+    return {data, key.size()};
   }
 
-  bool operator()(const group_by_key& x, const group_by_key& y) const noexcept {
-    return x == y;
-  }
+private:
+  static constexpr auto block_size = size_t{1} << 16;
 
-  bool operator()(const group_by_key_view& x,
-                  const group_by_key_view& y) const noexcept {
-    return x == y;
-  }
+  std::vector<std::unique_ptr<char[]>> blocks_ = {};
+  size_t capacity_ = {};
+  size_t size_ = {};
 };
 
+/// The input arrays of a table slice for the group-by and aggregation
+/// columns.
+using input_arrays = std::vector<std::optional<std::shared_ptr<arrow::Array>>>;
+
 struct column {
   struct offset offset;
   class type type;
@@ -338,6 +395,38 @@ struct binding {
   };
 };
 
+/// Computes the flat group-by key of a row.
+void make_group_by_key(std::string& key, const binding& bound,
+                       const input_arrays& group_by_arrays, int64_t row) {
+  key.clear();
+  for (size_t col = 0; col < bound.group_by_columns.size(); ++col) {
+    if (bound.group_by_columns[col]) {
+      TENZIR_ASSERT(group_by_arrays[col].has_value());
+      append_group_by_value(key, value_at(bound.group_by_columns[col]->type,
+                                          **group_by_arrays[col], row));
+    } else {
+      TENZIR_ASSERT(!group_by_arrays[col].has_value());
+      append_group_by_value(key, caf::none);
+    }
+  }
+}
+
+/// Selects the given rows of the input arrays.
+auto take_rows(const input_arrays& arrays, const arrow::Array& indices)
+  -> input_arrays {
+  auto result = input_arrays{};
+  result.reserve(arrays.size());
+  for (const auto& array : arrays) {
+    if (array) {
+      result.emplace_back(
+        arrow::compute::Take(**array, indices).ValueOrDie());
+    } else {
+      result.emplace_back(std::nullopt);
+    }
+  }
+  return result;
+}
+
 template <class T, class... Ts>
 auto zip_equal(T& x, Ts&... xs) -> detail::zip<T, Ts...> {
   auto size = x.size();
@@ -346,40 +435,32 @@ auto zip_equal(T& x, Ts&... xs) -> detail::zip<T, Ts...> {
   return detail::zip{x, xs...};
 }
 
-/// An instantiation of the inter-schematic aggregation process.
+/// An instantiation of the inter-schematic aggregation process. When running
+/// in parallel, every shard has its own instance that owns a disjoint set of
+/// groups.
 class implementation {
 public:
-  /// Divides the input into groups and feeds it to the aggregation function.
-  void add(const table_slice& slice, const configuration& config,
-           diagnostic_handler& diag) {
-    // Step 1: Resolve extractor names (if possible).
-    auto it = bindings.find(slice.schema());
-    if (it == bindings.end()) {
-      it = bindings.try_emplace(it, slice.schema(),
-                                binding::make(slice.schema(), config, diag));
-    }
-    auto const& bound = it->second;
-    // Step 2: Collect the aggregation columns and group-by columns into arrays.
-    auto batch = to_record_batch(slice);
-    auto group_by_arrays = bound.make_group_by_arrays(*batch, config);
-    auto aggregation_arrays = bound.make_aggregation_arrays(*batch);
-    // A key view used to determine the bucket for a single row.
-    auto reusable_key_view = group_by_key_view{};
-    reusable_key_view.resize(bound.group_by_columns.size(), {});
+  /// Divides the rows `[begin, end)` of the input into groups and feeds them to
+  /// the aggregation functions.
+  void add(const binding& bound, const input_arrays& group_by_arrays,
+           const input_arrays& aggregation_arrays, int64_t begin, int64_t end,
+           const configuration& config, diagnostic_handler& diag) {
+    TENZIR_ASSERT(begin < end);
+    // The flat key of the current row, and of the previous row. Consecutive
+    // rows often belong to the same group, in which case we can skip the
+    // lookup entirely.
+    auto key = std::string{};
+    auto previous_key = std::string{};
+    auto* previous_bucket = static_cast<bucket*>(nullptr);
     // Returns the group that the given row belongs to, creating new groups
     // whenever necessary.
     auto find_or_create_bucket = [&](int64_t row) -> bucket* {
-      for (size_t col = 0; col < bound.group_by_columns.size(); ++col) {
-        if (bound.group_by_columns[col]) {
-          TENZIR_ASSERT(group_by_arrays[col].has_value());
-          reusable_key_view[col] = value_at(bound.group_by_columns[col]->type,
-                                            **group_by_arrays[col], row);
-        } else {
-          TENZIR_ASSERT(!group_by_arrays[col].has_value());
-          reusable_key_view[col] = caf::none;
-        }
-      }
-      if (auto it = buckets.find(reusable_key_view); it != buckets.end()) {
+      make_group_by_key(key, bound, group_by_arrays, row);
+      if (previous_bucket && key == previous_key)
+        return previous_bucket;
+      std::swap(key, previous_key);
+      if (auto it = buckets.find(std::string_view{previous_key});
+          it != buckets.end()) {
         auto&& bucket = *it->second;
         // Check that the group-by values also have matching types.
         for (auto [existing, other] :
@@ -389,38 +470,7 @@ public:
             // already warned and can ignore it.
             continue;
           }
-          if (existing.is_dead()) {
-            continue;
-          }
-          if (existing.is_empty()) {
-            // If the group-by column did not have a type before (because the
-            // column was missing when the group was created), we can set it here.
-            existing.set_active(other->type);
-            continue;
-          }
-          auto existing_type = existing.get_active();
-          if (other->type == existing_type) {
-            // No conflict, nothing to do.
-            continue;
-          }
-          // Otherwise, there is a type mismatch for the same data. This can
-          // only happen with `null` or metadata mismatches.
-          auto pruned = existing_type.prune();
-          if (other->type.prune() == pruned) {
-            // If the type mismatch is only caused by metadata, we remove
-            // it. This for example can unify `:port` and `:uint64` into
-            // `:uint64`, which we consider an acceptable conversion.
-            existing.set_active(std::move(pruned));
-          } else {
-            // Otherwise, we have a bucket (and thus matching data) where
-            // the types are conflicting. This can only happen if the
-            // conflicting group columns both have `null` values.
-            diagnostic::warning("summarize found matching group for key `{}`, "
-                                "but the existing type `{}` clashes with `{}`",
-                                reusable_key_view, existing_type, other->type)
-              .emit(diag);
-            existing.set_dead();
-          }
+          unify(existing, other->type, bucket.key, diag);
         }
         // Check that the aggregation extractors have the same type.
         for (auto&& [aggr, column, cfg] :
@@ -451,22 +501,27 @@ public:
           if (func->input_type() != column->type) {
             diagnostic::warning("summarize aggregation function for group `{}` "
                                 "expected type `{}`, but got `{}`",
-                                reusable_key_view, func->input_type(),
-                                column->type)
+                                bucket.key, func->input_type(), column->type)
               .emit(diag);
             aggr.set_dead();
           }
         }
-        return it->second.get();
+        previous_bucket = it->second.get();
+        return previous_bucket;
       }
       // Did not find existing bucket, create a new one.
       auto new_bucket = std::make_shared<bucket>();
+      new_bucket->key.reserve(bound.group_by_columns.size());
       new_bucket->group_by_types.reserve(bound.group_by_columns.size());
-      for (auto&& column : bound.group_by_columns) {
+      for (size_t col = 0; col < bound.group_by_columns.size(); ++col) {
+        const auto& column = bound.group_by_columns[col];
         if (column) {
+          new_bucket->key.push_back(
+            materialize(value_at(column->type, **group_by_arrays[col], row)));
           new_bucket->group_by_types.push_back(
             group_type::make_active(column->type));
         } else {
+          new_bucket->key.emplace_back(caf::none);
           new_bucket->group_by_types.push_back(group_type::make_empty());
         }
       }
@@ -494,10 +549,11 @@ public:
           new_bucket->aggregations.emplace_back(aggregation::make_empty());
         }
       }
-      auto [it, inserted] = buckets.emplace(materialize(reusable_key_view),
-                                            std::move(new_bucket));
+      auto [it, inserted]
+        = buckets.emplace(keys.store(previous_key), std::move(new_bucket));
       TENZIR_ASSERT(inserted);
-      return it.value().get();
+      previous_bucket = it.value().get();
+      return previous_bucket;
     };
     // This lambda is called for consecutive rows that belong to the same group
     // and updates its aggregation functions.
@@ -518,14 +574,12 @@ public:
         aggr.get_active()->add(*(*input)->Slice(offset, length));
       }
     };
-    // Step 3: Iterate over all rows of the batch, and determine a slidin window
-    // of rows beloging to the same batch that is as large as possible, then
+    // Iterate over all rows of the batch, and determine a sliding window of
+    // rows belonging to the same batch that is as large as possible, then
     // update the corresponding bucket.
-    auto first_row = int64_t{0};
+    auto first_row = begin;
     auto* first_bucket = find_or_create_bucket(first_row);
-    TENZIR_ASSERT(slice.rows() > 0);
-    for (auto row = int64_t{1}; row < detail::narrow<int64_t>(slice.rows());
-         ++row) {
+    for (auto row = begin + 1; row < end; ++row) {
       auto* bucket = find_or_create_bucket(row);
       if (bucket == first_bucket)
         continue;
@@ -533,8 +587,7 @@ public:
       first_row = row;
       first_bucket = bucket;
     }
-    update_bucket(*first_bucket, first_row,
-                  detail::narrow<int64_t>(slice.rows()) - first_row);
+    update_bucket(*first_bucket, first_row, end - first_row);
   }
 
   /// Returns the summarization results after the input is done.
@@ -557,8 +610,7 @@ public:
     // Most summarizations yield events with equal output schemas. Hence, we
     // first "group the groups" by their output schema, and then create one
     // builder with potentially multiple rows for each output schema.
-    auto output_schemas
-      = tsl::robin_map<type, std::vector<decltype(buckets)::iterator>>{};
+    auto output_schemas = tsl::robin_map<type, std::vector<bucket*>>{};
     for (auto it = buckets.begin(); it != buckets.end(); ++it) {
       const auto& bucket = it->second;
       TENZIR_ASSERT(config.aggregations.size() == bucket->aggregations.size());
@@ -579,15 +631,14 @@ public:
       }
       auto output_schema = type{"tenzir.summarize", record_type{fields}};
       // This creates a new entry if it does not exist yet.
-      output_schemas[std::move(output_schema)].push_back(it);
+      output_schemas[std::move(output_schema)].push_back(bucket.get());
     }
     for (const auto& [output_schema, groups] : output_schemas) {
       auto builder = caf::get<record_type>(output_schema)
                        .make_arrow_builder(arrow::default_memory_pool());
       TENZIR_ASSERT(builder);
-      for (auto it : groups) {
-        const auto& group = it->first;
-        const auto& bucket = it->second;
+      for (auto* bucket : groups) {
+        const auto& group = bucket->key;
         auto status = builder->Append();
         if (!status.ok()) {
           co_yield caf::make_error(ec::system_error,
@@ -728,6 +779,9 @@ private:
   /// This is because we use only the underlying data for lookup, but need their
   /// type to add the data to the output.
   struct bucket {
+    /// The values of the grouping extractors.
+    group_by_key key;
+
     /// The type of the grouping extractors, where `type{}` denotes a missing
     /// column (which can get upgraded to another type if we encounter a column
     /// that has a `null` value but exists), and `std::nullopt` denotes a type
@@ -742,18 +796,59 @@ private:
     std::vector<aggregation> aggregations;
   };
 
-  /// We cache the offsets and types of the resolved columns for each schema.
-  tsl::robin_map<type, binding> bindings = {};
+  /// Unifies the type of a grouping extractor with the type of another column
+  /// for the same group, which can only differ if the values are `null` or if
+  /// the types differ in their metadata.
+  static void unify(group_type& existing, const type& other,
+                    const group_by_key& key, diagnostic_handler& diag) {
+    if (existing.is_dead()) {
+      return;
+    }
+    if (existing.is_empty()) {
+      // If the group-by column did not have a type before (because the
+      // column was missing when the group was created), we can set it here.
+      existing.set_active(other);
+      return;
+    }
+    auto existing_type = existing.get_active();
+    if (other == existing_type) {
+      // No conflict, nothing to do.
+      return;
+    }
+    // Otherwise, there is a type mismatch for the same data. This can
+    // only happen with `null` or metadata mismatches.
+    auto pruned = existing_type.prune();
+    if (other.prune() == pruned) {
+      // If the type mismatch is only caused by metadata, we remove
+      // it. This for example can unify `:port` and `:uint64` into
+      // `:uint64`, which we consider an acceptable conversion.
+      existing.set_active(std::move(pruned));
+    } else {
+      // Otherwise, we have a bucket (and thus matching data) where
+      // the types are conflicting. This can only happen if the
+      // conflicting group columns both have `null` values.
+      diagnostic::warning("summarize found matching group for key `{}`, "
+                          "but the existing type `{}` clashes with `{}`",
+                          key, existing_type, other)
+        .emit(diag);
+      existing.set_dead();
+    }
+  }
+
+  /// The flat keys of all buckets.
+  key_arena keys = {};
 
-  /// The buckets for the ongoing aggregation.
-  tsl::robin_map<group_by_key, std::shared_ptr<bucket>, group_by_key_hash,
-                 group_by_key_equal>
+  /// The buckets for the ongoing aggregation, keyed by their flat key.
+  tsl::robin_map<std::string_view, std::shared_ptr<bucket>, group_by_key_hash>
     buckets = {};
 };
 
 /// The summarize pipeline operator implementation.
 class summarize_operator final : public crtp_operator<summarize_operator> {
 public:
+  /// The minimum number of rows of a batch that we distribute across threads.
+  static constexpr auto min_rows_per_task = int64_t{8'192};
+
   summarize_operator() = default;
 
   /// Creates a pipeline operator from its configuration.
@@ -766,20 +861,108 @@ public:
   auto
   operator()(generator<table_slice> input, operator_control_plane& ctrl) const
     -> generator<table_slice> {
-    auto impl = implementation{};
+    // We cache the offsets and types of the resolved columns for each schema.
+    auto bindings = tsl::robin_map<type, binding>{};
+    // Every shard owns the groups whose flat keys hash to it, so that all rows
+    // of a group are aggregated by the same shard in the order of the input.
+    auto shards = std::vector<implementation>(
+      detail::narrow_cast<size_t>(config_.threads.value_or(1)));
+    // Runs a function for every index in `[0, n)`, on separate threads if
+    // `parallel` is set.
+    const auto for_each_task = [](size_t n, bool parallel, auto&& f) {
+      if (not parallel) {
+        for (auto i = size_t{0}; i < n; ++i) {
+          f(i);
+        }
+        return;
+      }
+      auto tasks = std::vector<std::future<void>>{};
+      tasks.reserve(n - 1);
+      for (auto i = size_t{1}; i < n; ++i) {
+        tasks.push_back(std::async(std::launch::async, f, i));
+      }
+      f(0);
+      for (auto& task : tasks) {
+        task.get();
+      }
+    };
     for (auto&& slice : input) {
       if (slice.rows() == 0) {
         co_yield {};
         continue;
       }
-      impl.add(slice, config_, ctrl.diagnostics());
+      // Resolve extractor names (if possible).
+      auto it = bindings.find(slice.schema());
+      if (it == bindings.end()) {
+        it = bindings.try_emplace(
+          it, slice.schema(),
+          binding::make(slice.schema(), config_, ctrl.diagnostics()));
+      }
+      const auto& bound = it->second;
+      // Collect the aggregation columns and group-by columns into arrays.
+      const auto batch = to_record_batch(slice);
+      const auto group_by_arrays = bound.make_group_by_arrays(*batch, config_);
+      const auto aggregation_arrays = bound.make_aggregation_arrays(*batch);
+      const auto rows = detail::narrow<int64_t>(slice.rows());
+      if (shards.size() == 1) {
+        shards[0].add(bound, group_by_arrays, aggregation_arrays, 0, rows,
+                      config_, ctrl.diagnostics());
+        continue;
+      }
+      // Handing rows to other threads only pays off for larger batches.
+      const auto parallel = rows >= min_rows_per_task;
+      // Assign every row to the shard that owns its group.
+      const auto num_tasks = detail::narrow_cast<size_t>(
+        std::clamp(rows / min_rows_per_task, int64_t{1},
+                   detail::narrow<int64_t>(shards.size())));
+      auto shard_of_row = std::vector<uint32_t>(rows);
+      for_each_task(num_tasks, parallel, [&](size_t task) {
+        const auto begin = rows * detail::narrow<int64_t>(task)
+                           / detail::narrow<int64_t>(num_tasks);
+        const auto end = rows * detail::narrow<int64_t>(task + 1)
+                         / detail::narrow<int64_t>(num_tasks);
+        auto key = std::string{};
+        for (auto row = begin; row < end; ++row) {
+          make_group_by_key(key, bound, group_by_arrays, row);
+          shard_of_row[row] = detail::narrow_cast<uint32_t>(
+            group_by_key_hash{}(key) % shards.size());
+        }
+      });
+      auto shard_rows = std::vector<std::vector<int64_t>>(shards.size());
+      for (auto row = int64_t{0}; row < rows; ++row) {
+        shard_rows[shard_of_row[row]].push_back(row);
+      }
+      // Diagnostic handlers are not thread-safe, so we collect the diagnostics
+      // of every shard and emit them once all shards are done.
+      auto diagnostics
+        = std::vector<collecting_diagnostic_handler>(shards.size());
+      for_each_task(shards.size(), parallel, [&](size_t shard) {
+        const auto& selection = shard_rows[shard];
+        if (selection.empty()) {
+          return;
+        }
+        const auto indices = arrow::Int64Array{
+          detail::narrow<int64_t>(selection.size()),
+          arrow::Buffer::Wrap(selection)};
+        shards[shard].add(bound, take_rows(group_by_arrays, indices),
+                          take_rows(aggregation_arrays, indices), 0,
+                          indices.length(), config_, diagnostics[shard]);
+      });
+      for (auto& handler : diagnostics) {
+        for (auto& diag : std::move(handler).collect()) {
+          ctrl.diagnostics().emit(std::move(diag));
+        }
+      }
     }
-    for (auto&& result : std::move(impl).finish(config_)) {
-      if (!result) {
-        diagnostic::error(result.error()).emit(ctrl.diagnostics());
-        co_return;
+    // The shards own disjoint sets of groups, so their results simply add up.
+    for (auto& shard : shards) {
+      for (auto&& result : std::move(shard).finish(config_)) {
+        if (!result) {
+          diagnostic::error(result.error()).emit(ctrl.diagnostics());
+          co_return;
+        }
+        co_yield std::move(*result);
       }
-      co_yield std::move(*result);
     }
   }
 
@@ -814,7 +997,8 @@ public:
     -> std::pair<std::string_view, caf::expected<operator_ptr>> override {
     using parsers::end_of_pipeline_operator, parsers::required_ws_or_comment,
       parsers::optional_ws_or_comment, parsers::duration,
-      parsers::extractor_list, parsers::aggregation_function_list;
+      parsers::extractor_list, parsers::aggregation_function_list,
+      parsers::u64;
     const auto* f = pipeline.begin();
     const auto* const l = pipeline.end();
     const auto p = required_ws_or_comment >> aggregation_function_list
@@ -822,10 +1006,13 @@ public:
                         >> extractor_list)
                    >> -(required_ws_or_comment >> "resolution"
                         >> required_ws_or_comment >> duration)
+                   >> -(required_ws_or_comment >> "threads"
+                        >> required_ws_or_comment >> u64)
                    >> optional_ws_or_comment >> end_of_pipeline_operator;
     std::tuple<std::vector<std::tuple<caf::optional<std::string>, std::string,
                                       std::string>>,
-               std::vector<std::string>, std::optional<tenzir::duration>>
+               std::vector<std::string>, std::optional<tenzir::duration>,
+               std::optional<uint64_t>>
       parsed_aggregations{};
     if (!p(f, l, parsed_aggregations)) {
       return {
@@ -877,6 +1064,21 @@ public:
                                           "without `by` clause"),
       };
     }
+    config.threads = std::get<3>(parsed_aggregations);
+    if (config.threads and config.group_by_extractors.empty()) {
+      return {
+        std::string_view{f, l},
+        caf::make_error(ec::syntax_error, "found `threads` specifier "
+                                          "without `by` clause"),
+      };
+    }
+    if (config.threads == uint64_t{0}) {
+      return {
+        std::string_view{f, l},
+        caf::make_error(ec::syntax_error, "the number of threads must not be "
+                                          "0"),
+      };
+    }
     return {
       std::string_view{f, l},
       std::make_unique<summarize_operator>(std::move(config)),
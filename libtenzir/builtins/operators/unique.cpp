@@ -7,34 +7,245 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <tenzir/argument_parser.hpp>
+#include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/hash/hash.hpp>
+#include <tenzir/hash/xxhash.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/table_slice.hpp>
 
+#include <arrow/array.h>
+#include <arrow/record_batch.h>
+
+#include <deque>
+#include <span>
+#include <unordered_map>
+
 namespace tenzir::plugins::unique {
 
 namespace {
 
+/// The hash we use for null values.
+constexpr auto null_hash = uint64_t{0x6e756c6c6e756c6c};
+
+/// Mixes the hash of a column value into the hash of a row.
+auto combine(uint64_t seed, uint64_t hash) -> uint64_t {
+  return seed ^ (hash + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
+/// Mixes the hashes of all values of a column into the given row hashes. Types
+/// with a fixed-width or string representation hash the Arrow buffers
+/// directly, records hash their fields, and all other types fall back to
+/// hashing data views.
+auto hash_column(const type& type, const arrow::Array& array,
+                 std::span<uint64_t> hashes) -> void {
+  TENZIR_ASSERT(detail::narrow_cast<size_t>(array.length()) == hashes.size());
+  auto f = [&]<concrete_type Type>(const Type& type) {
+    using array_type = type_to_arrow_array_t<Type>;
+    constexpr auto is_fixed_width
+      = detail::is_any_v<Type, int64_type, uint64_type, double_type,
+                         duration_type, time_type>;
+    if constexpr (is_fixed_width) {
+      const auto& typed_array = static_cast<const array_type&>(array);
+      const auto* values = typed_array.raw_values();
+      for (auto row = int64_t{0}; row < typed_array.length(); ++row) {
+        if (typed_array.IsNull(row)) {
+          hashes[row] = combine(hashes[row], null_hash);
+          continue;
+        }
+        auto value = values[row];
+        if constexpr (std::is_same_v<Type, double_type>) {
+          // Positive and negative zero compare equal, so they must have the
+          // same hash.
+          if (value == 0.0) {
+            value = 0.0;
+          }
+        }
+        hashes[row]
+          = combine(hashes[row], xxh3_64::make(as_bytes(&value, sizeof(value))));
+      }
+    } else if constexpr (std::is_same_v<Type, record_type>) {
+      // We hash the fields of records individually, just like the flattened
+      // columns that `table_slice::at` operates on.
+      const auto& struct_array = static_cast<const array_type&>(array);
+      for (auto i = 0; i < struct_array.num_fields(); ++i) {
+        hash_column(type.field(detail::narrow_cast<size_t>(i)).type,
+                    *struct_array.field(i), hashes);
+      }
+    } else if constexpr (std::is_same_v<Type, string_type>) {
+      const auto& typed_array = static_cast<const array_type&>(array);
+      for (auto row = int64_t{0}; row < typed_array.length(); ++row) {
+        if (typed_array.IsNull(row)) {
+          hashes[row] = combine(hashes[row], null_hash);
+          continue;
+        }
+        const auto value = typed_array.GetView(row);
+        hashes[row] = combine(hashes[row],
+                              xxh3_64::make(as_bytes(value.data(),
+                                                     value.size())));
+      }
+    } else {
+      auto row = size_t{0};
+      for (auto&& value : values(tenzir::type{type}, array)) {
+        hashes[row] = combine(hashes[row], caf::holds_alternative<caf::none_t>(
+                                             value)
+                                             ? null_hash
+                                             : hash(value));
+        ++row;
+      }
+    }
+  };
+  caf::visit(f, type);
+}
+
+/// Computes a hash for every row of a table slice. We hash one column at a
+/// time and combine the per-column hashes, which avoids materializing rows.
+/// Rows that compare equal always have the same hash.
+auto hash_rows(const table_slice& slice) -> std::vector<uint64_t> {
+  auto result = std::vector<uint64_t>(slice.rows(), 0);
+  const auto batch = to_record_batch(slice);
+  const auto& schema = caf::get<record_type>(slice.schema());
+  for (auto column = 0; column < batch->num_columns(); ++column) {
+    hash_column(schema.field(detail::narrow_cast<size_t>(column)).type,
+                *batch->column(column), result);
+  }
+  return result;
+}
+
+/// @pre `a.schema().prune() == b.schema().prune()`
+auto is_duplicate(const table_slice& a, size_t a_row, const table_slice& b,
+                  size_t b_row) -> bool {
+  TENZIR_ASSERT_EXPENSIVE(a.schema().prune() == b.schema().prune());
+  for (auto col = size_t{0}; col < a.columns(); ++col) {
+    if (a.at(a_row, col) != b.at(b_row, col)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// A bounded set of previously seen rows that evicts the oldest rows first.
+class seen_rows {
+public:
+  explicit seen_rows(uint64_t capacity) : capacity_{capacity} {
+  }
+
+  /// Inserts a row, unless an equal row was inserted before. Returns whether
+  /// the row is a duplicate. The rows are only compared for hash collisions.
+  auto insert(const table_slice& slice, const type& pruned_schema, size_t row,
+              uint64_t row_hash) -> bool {
+    const auto key = combine(row_hash, std::hash<type>{}(pruned_schema));
+    auto [first, last] = entries_.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+      if (it->second.schema == pruned_schema
+          and equals(it->second.values, slice, row)) {
+        return true;
+      }
+    }
+    auto entry = seen_row{pruned_schema, {}};
+    entry.values.reserve(slice.columns());
+    for (auto column = size_t{0}; column < slice.columns(); ++column) {
+      entry.values.push_back(materialize(slice.at(row, column)));
+    }
+    auto it = entries_.emplace(key, std::move(entry));
+    insertion_order_.emplace_back(key, &it->second);
+    while (insertion_order_.size() > capacity_) {
+      const auto [oldest_key, oldest] = insertion_order_.front();
+      insertion_order_.pop_front();
+      auto [first, last] = entries_.equal_range(oldest_key);
+      for (auto it = first; it != last; ++it) {
+        if (&it->second == oldest) {
+          entries_.erase(it);
+          break;
+        }
+      }
+    }
+    return false;
+  }
+
+private:
+  struct seen_row {
+    type schema = {};
+    std::vector<data> values = {};
+  };
+
+  using map_type = std::unordered_multimap<uint64_t, seen_row>;
+
+  static auto equals(const std::vector<data>& values, const table_slice& slice,
+                     size_t row) -> bool {
+    for (auto column = size_t{0}; column < slice.columns(); ++column) {
+      if (values[column] != slice.at(row, column)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t capacity_ = {};
+  map_type entries_ = {};
+  // Unlike iterators, pointers to the elements of an unordered multimap remain
+  // valid when inserting causes a rehash.
+  std::deque<std::pair<uint64_t, const seen_row*>> insertion_order_ = {};
+};
+
 class unique_operator final : public crtp_operator<unique_operator> {
 public:
+  static constexpr auto default_capacity = uint64_t{1'000'000};
+
   unique_operator() = default;
 
-  // Note: The following implementation does a point-wise comparison of
-  // consecutive rows. To this end, we use `table_slice::at`. This could be
-  // optimized in the future.
+  explicit unique_operator(bool global, uint64_t capacity)
+    : global_{global}, capacity_{capacity} {
+  }
+
+  // Note: We hash all rows of a slice column by column up front, and only
+  // compare rows value by value when their hashes are equal.
   auto operator()(generator<table_slice> input) const
     -> generator<table_slice> {
+    if (global_) {
+      return global(std::move(input), capacity_);
+    }
+    return adjacent(std::move(input));
+  }
+
+  auto name() const -> std::string override {
+    return "unique";
+  }
+
+  auto optimize(expression const& filter, event_order order) const
+    -> optimize_result override {
+    if (global_) {
+      // It does not matter which of several equal events we keep, so we only
+      // need the order that is required downstream.
+      return optimize_result{filter, order, copy()};
+    }
+    // TODO: We compare the *pruned* schemas above. Hence, returning
+    // `event_order::schema` here might be slightly incorrect.
+    (void)order;
+    return optimize_result{filter, event_order::schema, copy()};
+  }
+
+  friend auto inspect(auto& f, unique_operator& x) -> bool {
+    return f.object(x).fields(f.field("global", x.global_),
+                              f.field("capacity", x.capacity_));
+  }
+
+private:
+  static auto adjacent(generator<table_slice> input) -> generator<table_slice> {
     // We keep track of the last non-empty slice to compare the first event of
     // the next slice against its last event.
     auto previous = table_slice{};
+    auto previous_hash = uint64_t{0};
     for (auto&& slice : input) {
       if (slice.rows() == 0) {
         co_yield {};
         continue;
       };
+      const auto hashes = hash_rows(slice);
       // The first row could be equal to the last row of the previous batch.
       auto begin = size_t{0};
-      if (previous.rows() > 0
+      if (previous.rows() > 0 and hashes[0] == previous_hash
           && slice.schema().prune() == previous.schema().prune()) {
         if (is_duplicate(slice, 0, previous, previous.rows() - 1)) {
           begin += 1;
@@ -44,44 +255,46 @@ public:
       // table slice ends. The loop below unifies both scenarios by including a
       // row at `row == slice.rows()` that is always considered to be a duplicate.
       for (auto row = size_t{1}; row < slice.rows() + 1; ++row) {
-        if (row == slice.rows() || is_duplicate(slice, row - 1, slice, row)) {
+        if (row == slice.rows()
+            || (hashes[row - 1] == hashes[row]
+                && is_duplicate(slice, row - 1, slice, row))) {
           co_yield subslice(slice, begin, row);
           begin = row + 1;
         }
       }
       TENZIR_ASSERT(begin == slice.rows() + 1);
+      previous_hash = hashes.back();
       previous = std::move(slice);
     }
   }
 
-  auto name() const -> std::string override {
-    return "unique";
-  }
-
-  auto optimize(expression const& filter, event_order order) const
-    -> optimize_result override {
-    // TODO: We compare the *pruned* schemas above. Hence, returning
-    // `event_order::schema` here might be slightly incorrect.
-    (void)order;
-    return optimize_result{filter, event_order::schema, copy()};
-  }
-
-  friend auto inspect(auto&, unique_operator&) -> bool {
-    return true;
-  }
-
-private:
-  /// @pre `a.schema() == b.schema()`
-  static auto is_duplicate(const table_slice& a, size_t a_row,
-                           const table_slice& b, size_t b_row) -> bool {
-    TENZIR_ASSERT_EXPENSIVE(a.schema().prune() == b.schema().prune());
-    for (auto col = size_t{0}; col < a.columns(); ++col) {
-      if (a.at(a_row, col) != b.at(b_row, col)) {
-        return false;
+  static auto global(generator<table_slice> input, uint64_t capacity)
+    -> generator<table_slice> {
+    auto seen = seen_rows{capacity};
+    for (auto&& slice : input) {
+      if (slice.rows() == 0) {
+        co_yield {};
+        continue;
+      };
+      const auto hashes = hash_rows(slice);
+      const auto pruned_schema = slice.schema().prune();
+      // Same as above, we yield a subslice for every run of rows that were not
+      // seen before.
+      auto begin = size_t{0};
+      for (auto row = size_t{0}; row < slice.rows() + 1; ++row) {
+        if (row == slice.rows()
+            || seen.insert(slice, pruned_schema, row, hashes[row])) {
+          if (begin < row) {
+            co_yield subslice(slice, begin, row);
+          }
+          begin = row + 1;
+        }
       }
     }
-    return true;
   }
+
+  bool global_ = {};
+  uint64_t capacity_ = default_capacity;
 };
 
 class plugin final : public virtual operator_plugin<unique_operator> {
@@ -93,8 +306,24 @@ public:
   auto parse_operator(parser_interface& p) const -> operator_ptr override {
     auto parser = argument_parser{"unique", "https://docs.tenzir.com/next/"
                                             "operators/transformations/unique"};
+    auto global = std::optional<location>{};
+    auto capacity = std::optional<located<uint64_t>>{};
+    parser.add("--global", global);
+    parser.add("--capacity", capacity, "<count>");
     parser.parse(p);
-    return std::make_unique<unique_operator>();
+    if (capacity and not global) {
+      diagnostic::error("`--capacity` requires `--global`")
+        .primary(capacity->source)
+        .throw_();
+    }
+    if (capacity and capacity->inner == 0) {
+      diagnostic::error("capacity must not be 0")
+        .primary(capacity->source)
+        .throw_();
+    }
+    return std::make_unique<unique_operator>(
+      global.has_value(),
+      capacity ? capacity->inner : unique_operator::default_capacity);
   }
 };
 
@@ -21,9 +21,11 @@
 #include <tenzir/modules.hpp>
 #include <tenzir/pipeline.hpp>
 #include <tenzir/plugin.hpp>
+#include <tenzir/table_slice.hpp>
 #include <tenzir/table_slice_builder.hpp>
 #include <tenzir/tql/basic.hpp>
 
+#include <arrow/array.h>
 #include <arrow/type.h>
 #include <caf/expected.hpp>
 
@@ -93,11 +95,13 @@ public:
   auto process(table_slice slice, state_type& expr) const
     -> output_type override {
     // TODO: Adjust filter function return type.
-    // TODO: Replace this with an Arrow-native filter function as soon as we
-    // are able to directly evaluate expressions on a record batch.
-    if (expr)
-      return filter(slice, *expr).value_or(table_slice{});
-    return {};
+    if (not expr or slice.rows() == 0) {
+      return {};
+    }
+    // We evaluate the expression into a single mask with Arrow compute kernels
+    // and then select the matching rows in one go.
+    const auto mask = evaluate_vectorized(*expr, slice);
+    return filter(slice, *mask).value_or(table_slice{});
   }
 
   auto name() const -> std::string override {
@@ -11,8 +11,13 @@
 #include <tenzir/collect.hpp>
 #include <tenzir/concept/convertible/data.hpp>
 #include <tenzir/data.hpp>
+#include <tenzir/defaults.hpp>
 #include <tenzir/detail/narrow.hpp>
+#include <tenzir/detail/overload.hpp>
+#include <tenzir/detail/serialize.hpp>
+#include <tenzir/detail/type_traits.hpp>
 #include <tenzir/error.hpp>
+#include <tenzir/expression.hpp>
 #include <tenzir/fwd.hpp>
 #include <tenzir/generator.hpp>
 #include <tenzir/plugin.hpp>
@@ -26,6 +31,13 @@
 #include <arrow/table.h>
 #include <arrow/util/iterator.h>
 #include <arrow/util/key_value_metadata.h>
+#include <caf/binary_deserializer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 namespace tenzir::plugins::feather {
 
@@ -50,17 +62,184 @@ struct configuration {
   }
 };
 
+/// The key of the schema metadata that marks the flat layout of record batches
+/// in the store, i.e., the import time as first column followed by the
+/// top-level fields of the events. Stores without this key use the legacy
+/// layout of an import time column and a single nested event column, which
+/// does not allow for reading individual fields.
+constexpr auto flat_layout_key = std::string_view{"TENZIR:store:layout"};
+constexpr auto flat_layout_value = std::string_view{"flat"};
+
+/// The key of the schema metadata that holds the serialized statistics of all
+/// record batches in the store.
+constexpr auto statistics_key = std::string_view{"TENZIR:store:statistics"};
+
+/// Statistics over a record batch of a store that allow for skipping the
+/// record batch without decoding it.
+struct batch_statistics {
+  /// The number of rows in the record batch.
+  uint64_t rows = {};
+
+  /// The minimum and maximum values for every leaf column, or null if the
+  /// column type is not supported or the column contains only nulls.
+  std::vector<data> min = {};
+  std::vector<data> max = {};
+
+  friend auto inspect(auto& f, batch_statistics& x) -> bool {
+    return f.object(x)
+      .pretty_name("tenzir.plugins.feather.batch_statistics")
+      .fields(f.field("rows", x.rows), f.field("min", x.min),
+              f.field("max", x.max));
+  }
+};
+
+/// Computes the statistics for a table slice. We keep track of the minimum and
+/// maximum values for all column types with a total order that are commonly
+/// used in range queries.
+auto make_batch_statistics(const table_slice& slice) -> batch_statistics {
+  auto result = batch_statistics{};
+  result.rows = slice.rows();
+  const auto batch = to_record_batch(slice);
+  const auto& schema = caf::get<record_type>(slice.schema());
+  for (const auto& leaf : schema.leaves()) {
+    auto min = data{};
+    auto max = data{};
+    auto f = [&]<concrete_type Type>(const Type& type) {
+      constexpr auto is_supported
+        = detail::is_any_v<Type, int64_type, uint64_type, double_type,
+                           duration_type, time_type, ip_type>;
+      if constexpr (is_supported) {
+        const auto array = leaf.index.get(*batch);
+        auto lo = std::optional<view<type_to_data_t<Type>>>{};
+        auto hi = std::optional<view<type_to_data_t<Type>>>{};
+        for (auto&& value :
+             values(type, caf::get<type_to_arrow_array_t<Type>>(*array))) {
+          if (not value) {
+            continue;
+          }
+          if constexpr (std::is_same_v<Type, double_type>) {
+            // NaN is unordered, so it cannot be part of the range.
+            if (std::isnan(*value)) {
+              continue;
+            }
+          }
+          if (not lo or *value < *lo) {
+            lo = *value;
+          }
+          if (not hi or *hi < *value) {
+            hi = *value;
+          }
+        }
+        if (lo) {
+          min = materialize(*lo);
+          max = materialize(*hi);
+        }
+      }
+    };
+    caf::visit(f, leaf.field.type);
+    result.min.push_back(std::move(min));
+    result.max.push_back(std::move(max));
+  }
+  return result;
+}
+
+/// Checks whether a record batch with the given statistics may contain events
+/// that match a tailored expression. This must never return false negatives.
+auto may_match(const expression& expr, const batch_statistics& statistics)
+  -> bool {
+  auto f = detail::overload{
+    [&](const conjunction& xs) {
+      return std::all_of(xs.begin(), xs.end(), [&](const expression& x) {
+        return may_match(x, statistics);
+      });
+    },
+    [&](const disjunction& xs) {
+      return std::any_of(xs.begin(), xs.end(), [&](const expression& x) {
+        return may_match(x, statistics);
+      });
+    },
+    [](const negation&) {
+      // A range cannot tell whether all values match the negated expression.
+      return true;
+    },
+    [&](const predicate& x) {
+      const auto* extractor = caf::get_if<data_extractor>(&x.lhs);
+      const auto* rhs = caf::get_if<data>(&x.rhs);
+      if (not extractor or not rhs
+          or extractor->column >= statistics.min.size()) {
+        return true;
+      }
+      const auto& min = statistics.min[extractor->column];
+      const auto& max = statistics.max[extractor->column];
+      if (caf::holds_alternative<caf::none_t>(min)
+          or min.get_data().index() != rhs->get_data().index()) {
+        return true;
+      }
+      switch (x.op) {
+        case relational_operator::equal:
+          return not(*rhs < min or max < *rhs);
+        case relational_operator::less:
+          return min < *rhs;
+        case relational_operator::less_equal:
+          return min <= *rhs;
+        case relational_operator::greater:
+          return max > *rhs;
+        case relational_operator::greater_equal:
+          return max >= *rhs;
+        default:
+          return true;
+      }
+    },
+    [](caf::none_t) {
+      return true;
+    },
+  };
+  return caf::visit(f, expr);
+}
+
+/// Removes a key from the metadata if it exists.
+auto strip_metadata(arrow::KeyValueMetadata& metadata, std::string_view key)
+  -> void {
+  if (auto index = metadata.FindKey(std::string{key}); index >= 0) {
+    auto status = metadata.Delete(index);
+    TENZIR_ASSERT(status.ok(), status.ToString().c_str());
+  }
+}
+
+auto has_flat_layout(const arrow::Schema& schema) -> bool {
+  const auto& metadata = schema.metadata();
+  if (not metadata) {
+    return false;
+  }
+  auto value = metadata->Get(std::string{flat_layout_key});
+  return value.ok() and *value == flat_layout_value;
+}
+
 auto derive_import_time(const std::shared_ptr<arrow::Array>& time_col) {
   return value_at(time_type{}, *time_col, time_col->length() - 1);
 }
 
-/// Extract event column from record batch and transform into new record batch.
-/// The record batch contains a message envelope with the actual event data
-/// alongside Tenzir-related meta data (currently limited to the import time).
-/// Message envelope is unwrapped and the metadata, attached to the to-level
-/// schema the input record batch is copied to the newly created record batch.
+/// Extract event columns from record batch and transform into new record
+/// batch. The record batch contains the actual event data alongside
+/// Tenzir-related meta data (currently limited to the import time). For the
+/// legacy layout, the message envelope is unwrapped and the metadata, attached
+/// to the to-level schema the input record batch is copied to the newly
+/// created record batch. For the flat layout, the import time column is
+/// dropped and the store-specific keys are removed from the schema metadata.
 std::shared_ptr<arrow::RecordBatch>
 unwrap_record_batch(const std::shared_ptr<arrow::RecordBatch>& rb) {
+  if (has_flat_layout(*rb->schema())) {
+    auto fields = rb->schema()->fields();
+    fields.erase(fields.begin());
+    auto columns = rb->columns();
+    columns.erase(columns.begin());
+    auto metadata = rb->schema()->metadata()->Copy();
+    strip_metadata(*metadata, flat_layout_key);
+    strip_metadata(*metadata, statistics_key);
+    return arrow::RecordBatch::Make(
+      arrow::schema(std::move(fields), std::move(metadata)), rb->num_rows(),
+      std::move(columns));
+  }
   auto event_col = rb->GetColumnByName("event");
   auto schema_metadata = rb->schema()->GetFieldByName("event")->metadata();
   auto event_rb = arrow::RecordBatch::FromStructArray(event_col).ValueOrDie();
@@ -80,20 +259,26 @@ auto make_import_time_col(const time& import_time, int64_t rows) {
   return builder->Finish().ValueOrDie();
 }
 
-/// Wrap a record batch into an event envelope containing the event data
-/// as a nested struct alongside metadata as separate columns, containing
-/// the `import_time`.
+/// Wrap a record batch into the flat layout, prepending a column containing
+/// the `import_time` to the event columns. Keeping the top-level fields of
+/// events as separate columns allows for reading only some of them.
 auto wrap_record_batch(const table_slice& slice)
   -> std::shared_ptr<arrow::RecordBatch> {
   auto rb = to_record_batch(slice);
-  auto event_array = rb->ToStructArray().ValueOrDie();
   auto time_col = make_import_time_col(slice.import_time(), rb->num_rows());
-  auto schema = arrow::schema(
-    {arrow::field("import_time", time_type::to_arrow_type()),
-     arrow::field("event", event_array->type(), rb->schema()->metadata())});
-  auto new_rb
-    = arrow::RecordBatch::Make(schema, rb->num_rows(), {time_col, event_array});
-  return new_rb;
+  auto fields = rb->schema()->fields();
+  fields.insert(fields.begin(),
+                arrow::field("import_time", time_type::to_arrow_type()));
+  auto columns = rb->columns();
+  columns.insert(columns.begin(), std::move(time_col));
+  auto metadata = rb->schema()->metadata()
+                    ? rb->schema()->metadata()->Copy()
+                    : std::make_shared<arrow::KeyValueMetadata>();
+  metadata->Append(std::string{flat_layout_key},
+                   std::string{flat_layout_value});
+  return arrow::RecordBatch::Make(
+    arrow::schema(std::move(fields), std::move(metadata)), rb->num_rows(),
+    std::move(columns));
 }
 
 /// Decode an Arrow IPC stream incrementally.
@@ -136,13 +321,103 @@ auto decode_ipc_stream(chunk_ptr chunk)
   }(std::move(reader), std::move(gen));
 }
 
+/// Opens a reader for a store that reads record batches individually.
+auto open_reader(const chunk_ptr& chunk,
+                 const arrow::ipc::IpcReadOptions& options
+                 = arrow::ipc::IpcReadOptions::Defaults())
+  -> std::shared_ptr<arrow::ipc::RecordBatchFileReader> {
+  auto reader
+    = arrow::ipc::RecordBatchFileReader::Open(as_arrow_file(chunk), options);
+  if (not reader.ok()) {
+    return nullptr;
+  }
+  return reader.MoveValueUnsafe();
+}
+
+/// Reads the statistics for all record batches from the schema metadata of a
+/// store. Returns an empty list if the store has no valid statistics.
+auto read_statistics(const arrow::ipc::RecordBatchFileReader& reader)
+  -> std::vector<batch_statistics> {
+  const auto& metadata = reader.schema()->metadata();
+  if (not metadata) {
+    return {};
+  }
+  auto value = metadata->Get(std::string{statistics_key});
+  if (not value.ok()) {
+    return {};
+  }
+  auto result = std::vector<batch_statistics>{};
+  auto source
+    = caf::binary_deserializer{nullptr, value->data(), value->size()};
+  if (not source.apply(result)
+      or result.size()
+           != detail::narrow_cast<size_t>(reader.num_record_batches())) {
+    TENZIR_WARN("feather store ignores invalid record batch statistics");
+    return {};
+  }
+  return result;
+}
+
+/// A projection of the fields of a store.
+struct projection {
+  /// The reader for the store that only reads the projected fields.
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader;
+
+  /// The expression, tailored to the projected schema.
+  expression expr;
+
+  /// Whether to skip a record batch, or empty if no record batch is skipped.
+  std::vector<bool> skipped = {};
+};
+
+/// Remaps the data extractors of an expression tailored to a schema to the
+/// schema containing only the given top-level fields.
+auto remap_expression(const expression& expr, const record_type& schema,
+                      const std::vector<bool>& included) -> expression {
+  // Maps the first flat index of every top-level field to its new value.
+  auto old_begin = std::vector<size_t>{};
+  auto new_begin = std::vector<size_t>{};
+  auto old_index = size_t{0};
+  auto new_index = size_t{0};
+  for (auto i = size_t{0}; i < schema.num_fields(); ++i) {
+    old_begin.push_back(old_index);
+    new_begin.push_back(new_index);
+    const auto field_type = schema.field(i).type;
+    const auto* record = caf::get_if<record_type>(&field_type);
+    const auto num_leaves = record ? record->num_leaves() : size_t{1};
+    old_index += num_leaves;
+    if (included[i]) {
+      new_index += num_leaves;
+    }
+  }
+  auto remap = [&](operand& x) {
+    if (auto* extractor = caf::get_if<data_extractor>(&x)) {
+      const auto field = schema.resolve_flat_index(extractor->column)[0];
+      TENZIR_ASSERT(included[field]);
+      extractor->column
+        = new_begin[field] + (extractor->column - old_begin[field]);
+    }
+  };
+  return for_each_predicate(expr, [&](const predicate& x) {
+    auto result = x;
+    remap(result.lhs);
+    remap(result.rhs);
+    return expression{std::move(result)};
+  });
+}
+
 class passive_feather_store final : public passive_store {
   [[nodiscard]] caf::error load(chunk_ptr chunk) override {
+    chunk_ = chunk;
     auto decode_result = decode_ipc_stream(std::move(chunk));
     if (!decode_result)
       return caf::make_error(ec::format_error,
                              fmt::format("failed to load feather store: {}",
                                          decode_result.error()));
+    if (auto reader = open_reader(chunk_)) {
+      flat_layout_ = has_flat_layout(*reader->schema());
+      statistics_ = read_statistics(*reader);
+    }
     remaining_slices_generator_ = std::move(*decode_result);
     remaining_slices_iterator_ = remaining_slices_generator_.begin();
     return {};
@@ -159,7 +434,8 @@ class passive_feather_store final : public passive_store {
         auto batch = std::move(*remaining_slices_iterator_);
         TENZIR_ASSERT(batch);
         ++remaining_slices_iterator_;
-        auto import_time_column = batch->GetColumnByName("import_time");
+        // The import time is the first column in both layouts.
+        auto import_time_column = batch->column(0);
         auto slice = cached_slices_.empty()
                        ? table_slice{unwrap_record_batch(batch)}
                        : table_slice{unwrap_record_batch(batch),
@@ -188,7 +464,144 @@ class passive_feather_store final : public passive_store {
     die("store must not be empty");
   }
 
+  [[nodiscard]] generator<uint64_t>
+  count(expression expr, ids selection) const override {
+    auto skipped = skipped_batches(expr);
+    if (std::find(skipped.begin(), skipped.end(), true) == skipped.end()) {
+      return passive_store::count(std::move(expr), std::move(selection));
+    }
+    auto reader = open_reader(chunk_);
+    if (not reader) {
+      return passive_store::count(std::move(expr), std::move(selection));
+    }
+    return [](projection plan, std::vector<batch_statistics> statistics,
+              ids selection) -> generator<uint64_t> {
+      for (auto&& slice : read_batches(plan, statistics)) {
+        co_yield count_matching(slice, plan.expr, selection);
+      }
+    }(projection{std::move(reader), std::move(expr), std::move(skipped)},
+           statistics_, std::move(selection));
+  }
+
+  [[nodiscard]] generator<table_slice>
+  extract(expression expr, ids selection,
+          std::optional<std::vector<std::string>> fields) const override {
+    auto skipped = skipped_batches(expr);
+    auto plan = std::optional<projection>{};
+    if (fields) {
+      plan = make_projection(expr, *fields);
+    }
+    if (not plan
+        and std::find(skipped.begin(), skipped.end(), true) != skipped.end()) {
+      if (auto reader = open_reader(chunk_)) {
+        plan = projection{.reader = std::move(reader), .expr = expr};
+      }
+    }
+    if (not plan) {
+      return passive_store::extract(std::move(expr), std::move(selection),
+                                    std::nullopt);
+    }
+    plan->skipped = std::move(skipped);
+    return [](projection plan, std::vector<batch_statistics> statistics,
+              ids selection) -> generator<table_slice> {
+      for (auto&& slice : read_batches(plan, statistics)) {
+        if (auto filtered_slice = filter(slice, plan.expr, selection)) {
+          co_yield std::move(*filtered_slice);
+        }
+      }
+    }(std::move(*plan), statistics_, std::move(selection));
+  }
+
 private:
+  /// Determines which record batches cannot contain matches for a tailored
+  /// expression. Returns an empty list if there are no statistics.
+  auto skipped_batches(const expression& expr) const -> std::vector<bool> {
+    auto result = std::vector<bool>{};
+    result.reserve(statistics_.size());
+    for (const auto& statistics : statistics_) {
+      result.push_back(not may_match(expr, statistics));
+    }
+    return result;
+  }
+
+  /// Creates a projection that reads only the top-level fields that contain
+  /// the required fields or fields referenced in the expression. Returns
+  /// `std::nullopt` if that is not possible or would read all fields anyways.
+  auto make_projection(const expression& expr,
+                       const std::vector<std::string>& fields) const
+    -> std::optional<projection> {
+    if (not chunk_ or not flat_layout_) {
+      return std::nullopt;
+    }
+    const auto store_schema = schema();
+    const auto& layout = caf::get<record_type>(store_schema);
+    auto included = std::vector<bool>(layout.num_fields(), false);
+    for (const auto& field : fields) {
+      if (auto offset = store_schema.resolve_key_or_concept(field)) {
+        included[offset->front()] = true;
+      }
+    }
+    for_each_predicate(expr, [&](const predicate& x) {
+      for (const auto* operand : {&x.lhs, &x.rhs}) {
+        if (const auto* extractor = caf::get_if<data_extractor>(operand)) {
+          included[layout.resolve_flat_index(extractor->column).front()]
+            = true;
+        }
+      }
+      return expression{x};
+    });
+    const auto num_included = std::count(included.begin(), included.end(),
+                                         true);
+    if (num_included == 0
+        or detail::narrow_cast<size_t>(num_included) == included.size()) {
+      return std::nullopt;
+    }
+    // The import time is always the first column, and the event fields follow.
+    auto options = arrow::ipc::IpcReadOptions::Defaults();
+    options.included_fields.push_back(0);
+    for (auto i = size_t{0}; i < included.size(); ++i) {
+      if (included[i]) {
+        options.included_fields.push_back(detail::narrow_cast<int>(i + 1));
+      }
+    }
+    auto reader = open_reader(chunk_, options);
+    if (not reader) {
+      return std::nullopt;
+    }
+    return projection{
+      .reader = std::move(reader),
+      .expr = remap_expression(expr, layout, included),
+    };
+  }
+
+  /// Reads the record batches of a projection individually, skipping the
+  /// record batches that cannot contain matches before decoding them.
+  static auto read_batches(const projection& plan,
+                           const std::vector<batch_statistics>& statistics)
+    -> generator<table_slice> {
+    auto offset = id{};
+    auto schema = type{};
+    for (auto i = 0; i < plan.reader->num_record_batches(); ++i) {
+      const auto index = detail::narrow_cast<size_t>(i);
+      if (index < plan.skipped.size() and plan.skipped[index]) {
+        offset += statistics[index].rows;
+        continue;
+      }
+      auto batch = plan.reader->ReadRecordBatch(i).ValueOrDie();
+      auto unwrapped = unwrap_record_batch(batch);
+      auto slice
+        = schema ? table_slice{unwrapped, schema} : table_slice{unwrapped};
+      schema = slice.schema();
+      slice.offset(offset);
+      slice.import_time(derive_import_time(batch->column(0)));
+      offset += slice.rows();
+      co_yield std::move(slice);
+    }
+  }
+
+  chunk_ptr chunk_ = {};
+  bool flat_layout_ = {};
+  std::vector<batch_statistics> statistics_ = {};
   generator<std::shared_ptr<arrow::RecordBatch>> remaining_slices_generator_
     = {};
   mutable generator<std::shared_ptr<arrow::RecordBatch>>::iterator
@@ -235,19 +648,38 @@ public:
     }
     auto record_batches = arrow::RecordBatchVector{};
     record_batches.reserve(rebatched_slices_.size());
-    for (const auto& slice : rebatched_slices_)
+    auto statistics = std::vector<batch_statistics>{};
+    statistics.reserve(rebatched_slices_.size());
+    for (const auto& slice : rebatched_slices_) {
       record_batches.push_back(wrap_record_batch(slice));
-    const auto table = ::arrow::Table::FromRecordBatches(record_batches);
+      statistics.push_back(make_batch_statistics(slice));
+    }
+    auto table = ::arrow::Table::FromRecordBatches(record_batches);
     if (!table.ok())
       return caf::make_error(ec::system_error, table.status().ToString());
+    // We store the statistics of all record batches in the schema metadata,
+    // which allows for skipping record batches without decoding them.
+    auto serialized_statistics = caf::byte_buffer{};
+    if (not detail::serialize(serialized_statistics, statistics))
+      return caf::make_error(ec::serialization_error,
+                             "failed to serialize record batch statistics");
+    auto metadata = table.ValueUnsafe()->schema()->metadata()->Copy();
+    metadata->Append(
+      std::string{statistics_key},
+      std::string{reinterpret_cast<const char*>(serialized_statistics.data()),
+                  serialized_statistics.size()});
+    const auto table_with_statistics
+      = table.ValueUnsafe()->ReplaceSchemaMetadata(std::move(metadata));
     auto output_stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
     auto write_properties = arrow::ipc::feather::WriteProperties::Defaults();
-    // TODO: Set write_properties.chunksize to the expected batch size
+    // The statistics are per record batch, so the writer must not split the
+    // record batches any further.
+    write_properties.chunksize = defaults::import::table_slice_size;
     write_properties.compression = arrow::Compression::ZSTD;
     write_properties.compression_level
       = detail::narrow<int>(feather_config_.zstd_compression_level);
     const auto write_status = ::arrow::ipc::feather::WriteTable(
-      *table.ValueUnsafe(), output_stream.get(), write_properties);
+      *table_with_statistics, output_stream.get(), write_properties);
     if (!write_status.ok())
       return caf::make_error(ec::system_error, write_status.ToString());
     auto buffer = output_stream->Finish();
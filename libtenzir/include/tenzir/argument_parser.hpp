@@ -23,6 +23,7 @@ namespace tenzir {
 /// - `foo <meta>`: `add(req, "<meta>")`
 /// - `foo [<meta>]`: add(opt, "<meta>")`
 /// - `foo [-b|--bar <meta>]`: `add("-b,--bar", xyz, "<meta>")`
+/// - `foo [-b|--bar <meta>]...`: `add("-b,--bar", vec, "<meta>")`
 /// - `foo [-q|--qux]`: `add("-q,--qux", src)`
 class argument_parser {
 public:
@@ -148,6 +149,17 @@ public:
     });
   }
 
+  template <class T>
+  void add(std::string_view names, std::vector<T>& x, std::string meta) {
+    named_.push_back(named_t{
+      split_names(names),
+      std::move(meta),
+      [&x](located<std::string> y) {
+        x.push_back(convert_or_throw<T>(std::move(y)).inner);
+      },
+    });
+  }
+
   // -- flags -----------------------------------------------------------------
 
   void add(std::string_view names, bool& x) {
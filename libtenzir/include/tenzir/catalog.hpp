@@ -25,7 +25,10 @@
 #include <caf/typed_event_based_actor.hpp>
 
 #include <map>
+#include <optional>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace tenzir {
@@ -80,6 +83,77 @@ struct catalog_lookup_result {
   }
 };
 
+/// An index over the time ranges of partitions that answers range predicates
+/// in O(log n + k) instead of testing the range of every partition.
+class time_range_index {
+public:
+  /// The time range of a single partition.
+  struct range {
+    uuid partition = {};
+    time min = {};
+    time max = {};
+  };
+
+  /// Creates an index from many ranges at once. This is faster than inserting
+  /// the ranges one by one.
+  static auto make(std::vector<range> ranges) -> time_range_index;
+
+  /// Adds the time range of a partition, replacing a previous range of the
+  /// same partition.
+  void insert(const range& x);
+
+  /// Removes the time range of a partition.
+  void erase(const uuid& partition);
+
+  /// @returns The number of indexed partitions.
+  [[nodiscard]] size_t size() const noexcept;
+
+  /// Retrieves the sorted IDs of all partitions whose range may satisfy the
+  /// predicate `range op rhs`, using the semantics of `time_synopsis`.
+  /// @returns The candidates, or `std::nullopt` if the operator is not
+  /// supported by the index.
+  [[nodiscard]] std::optional<std::vector<uuid>>
+  lookup(relational_operator op, time rhs) const;
+
+private:
+  struct entry {
+    time bound = {};
+    uuid partition = {};
+
+    friend auto operator==(const entry& lhs, const entry& rhs) -> bool
+      = default;
+
+    friend auto operator<(const entry& lhs, const entry& rhs) -> bool {
+      return std::tie(lhs.bound, lhs.partition)
+             < std::tie(rhs.bound, rhs.partition);
+    }
+  };
+
+  /// The indexed partitions, sorted by their lower and upper bounds.
+  std::vector<entry> by_min_ = {};
+  std::vector<entry> by_max_ = {};
+
+  /// The range of every indexed partition.
+  std::unordered_map<uuid, range> ranges_ = {};
+};
+
+/// The time range indexes for all partitions of a single schema.
+struct catalog_time_index {
+  /// Adds the time ranges of a partition.
+  void insert(const uuid& partition, const partition_synopsis& synopsis);
+
+  /// Removes the time ranges of a partition.
+  void erase(const uuid& partition);
+
+  /// The range of import times of all partitions.
+  time_range_index import_time = {};
+
+  /// The range of values for every field that has a time synopsis, either as
+  /// field synopsis or as type synopsis. Partitions without a time synopsis
+  /// for a field are missing from its index.
+  std::unordered_map<qualified_record_field, time_range_index> fields = {};
+};
+
 /// The state of the CATALOG actor.
 struct catalog_state {
 public:
@@ -153,6 +227,10 @@ public:
                      detail::flat_map<uuid, partition_synopsis_ptr>>
     synopses_per_type = {};
 
+  /// For each type, the time range indexes over the partitions.
+  std::unordered_map<tenzir::type, catalog_time_index> time_indexes_per_type
+    = {};
+
   /// The set of fields that should not be touched by the pruner.
   detail::heterogeneous_string_hashset unprunable_fields;
 
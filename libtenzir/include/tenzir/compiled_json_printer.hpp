@@ -0,0 +1,70 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/concept/printable/tenzir/json_printer_options.hpp"
+#include "tenzir/type.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace tenzir {
+
+/// Prints table slices of a single schema as JSON. In contrast to the
+/// `json_printer`, which visits one data view per value, this printer compiles
+/// an emission plan for the schema once: the escaped and styled keys of all
+/// record fields are precomputed together with their separators and
+/// indentation, and every column gets a cursor specialized for its type that
+/// reads the values directly from the Arrow arrays. The output is identical to
+/// that of the `json_printer` with the same options applied to the rows of a
+/// slice with resolved enumerations.
+/// @note The `flattened` option is not supported.
+class compiled_json_printer {
+public:
+  /// An internal node of the emission plan.
+  class column;
+
+  /// Compiles a printer for a schema.
+  /// @param schema The schema of the table slices to print.
+  /// @param options The options for printing.
+  /// @pre `caf::holds_alternative<record_type>(schema)`
+  /// @pre `!options.flattened`
+  compiled_json_printer(type schema, const json_printer_options& options);
+
+  /// @returns The schema of the table slices to print.
+  [[nodiscard]] auto schema() const -> const type&;
+
+  /// Prints all rows of a table slice as one JSON object per row, each
+  /// followed by a newline.
+  /// @param slice The table slice to print.
+  /// @param out The buffer to append to.
+  /// @pre `slice.schema() == schema()`
+  void print(const table_slice& slice, std::string& out) const;
+
+  /// Prints the rows in the range `[begin, end)` of a table slice as one JSON
+  /// object per row, each followed by a newline. It is safe to call this
+  /// function concurrently with other ranges of the same slice.
+  /// @param slice The table slice to print.
+  /// @param begin The first row to print.
+  /// @param end The row after the last row to print.
+  /// @param out The buffer to append to.
+  /// @pre `slice.schema() == schema()`
+  /// @pre `begin <= end && end <= slice.rows()`
+  void print(const table_slice& slice, int64_t begin, int64_t end,
+             std::string& out) const;
+
+private:
+  type schema_;
+  std::shared_ptr<const column> root_;
+};
+
+} // namespace tenzir
@@ -227,8 +227,12 @@ inline constexpr caf::timespan active_partition_timeout
 /// Timeout after which a new automatic rebuild is triggered.
 inline constexpr caf::timespan rebuild_interval = std::chrono::minutes{120};
 
-/// Maximum number of in-memory INDEX partitions.
-inline constexpr size_t max_in_mem_partitions = 1;
+/// Maximum size of the passive INDEX partitions kept in memory, measured by
+/// the size of their partition and store files.
+inline constexpr size_t partition_cache_size = 1'073'741'824; // 1 Gi
+
+/// Number of upcoming INDEX partitions loaded ahead of their lookup.
+inline constexpr size_t partition_prefetch = 2;
 
 /// Number of immediately scheduled INDEX partitions.
 inline constexpr size_t taste_partitions = 5;
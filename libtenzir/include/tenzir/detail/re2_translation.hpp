@@ -0,0 +1,54 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tenzir::detail {
+
+/// A regular expression in the syntax of Boost.Regex, translated into the
+/// syntax of RE2.
+struct re2_translation {
+  /// The regex, in which named captures are plain capture groups, because RE2
+  /// is pickier about the names of groups than Boost.Regex.
+  std::string regex;
+
+  /// The capture group index of every named capture, in order of appearance.
+  std::vector<std::pair<std::string, int>> groups;
+
+  /// The longest literal that every match contains, may be empty.
+  std::string literal;
+};
+
+/// Translates a regular expression from the syntax of Boost.Regex into the
+/// syntax of RE2.
+///
+/// RE2 matches in linear time, and thus lacks some features of Boost.Regex:
+///  - atomic groups and possessive quantifiers become their regular
+///    counterparts
+///  - lookaround assertions are dropped, and the capture groups inside of
+///    them never match
+///  - with `relax_repetitions`, the upper bounds of repetitions are dropped,
+///    because RE2 limits the size of nested repetitions
+/// The translated regex thus accepts a superset of the inputs of the original.
+/// Everything else that RE2 doesn't support, like backreferences, is left for
+/// RE2 to reject.
+///
+/// @param pattern The regular expression in the syntax of Boost.Regex.
+/// @param indexed_captures Whether unnamed capture groups stay capturing.
+/// Otherwise they become non-capturing, because extracting submatches is where
+/// RE2 spends most of its time.
+/// @param relax_repetitions Whether to drop the upper bounds of repetitions.
+auto translate_to_re2(std::string_view pattern, bool indexed_captures,
+                      bool relax_repetitions) -> re2_translation;
+
+} // namespace tenzir::detail
@@ -91,6 +91,13 @@ std::string control_char_escape(std::string_view str);
 /// @relates json_unescape
 std::string json_escape(std::string_view str);
 
+/// Escapes a string according to JSON escaping and appends it to a buffer,
+/// including the surrounding double quotes.
+/// @param str The string to escape.
+/// @param out The buffer to append the escaped string to.
+/// @relates json_unescape
+void json_escape(std::string_view str, std::string& out);
+
 /// Unescapes a string escaped with JSON escaping.
 /// @param str The string to unescape.
 /// @returns The unescaped string.
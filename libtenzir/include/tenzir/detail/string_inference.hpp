@@ -0,0 +1,81 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/detail/heterogeneous_string_hash.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace tenzir::detail {
+
+/// Cheaply decides whether a string could be parsed as `time`, `duration`,
+/// `subnet`, or `ip`, without running any of their parsers.
+///
+/// Every string accepted by these parsers starts with a digit, a hex digit,
+/// one of `:@.+-`, or the first letter of `now`, `in`, `inf`, or `nan`. It
+/// also contains a digit, a colon, or the letter `n`, which covers the digit
+/// free spellings `now`, `in`, `inf`, `nan`, and IPv6 addresses such as `::`.
+inline auto could_be_typed(std::string_view str) -> bool {
+  if (str.empty()) {
+    return false;
+  }
+  const auto first = static_cast<unsigned char>(str.front());
+  const auto lower = static_cast<unsigned char>(first | 0x20);
+  const auto plausible_first
+    = (first >= '0' and first <= '9') or (lower >= 'a' and lower <= 'f')
+      or lower == 'i' or lower == 'n' or first == ':' or first == '@'
+      or first == '.' or first == '+' or first == '-';
+  if (not plausible_first) {
+    return false;
+  }
+  // This loop intentionally has no early exit and no data-dependent branches,
+  // which allows the compiler to vectorize it.
+  auto found = uint8_t{0};
+  for (auto c : str) {
+    const auto x = static_cast<unsigned char>(c);
+    found |= static_cast<uint8_t>(static_cast<unsigned char>(x - '0') < 10)
+             | static_cast<uint8_t>(x == ':')
+             | static_cast<uint8_t>((x | 0x20) == 'n');
+  }
+  return found != 0;
+}
+
+/// Remembers for every field of a schema how many string values in a row
+/// failed to parse as typed data. Once that number reaches the limit, the
+/// parser no longer attempts to infer a type for the field's strings.
+class string_inference_cache {
+public:
+  /// @param limit The number of plain strings after which to stop inferring
+  /// types for a field, or 0 to never stop.
+  explicit string_inference_cache(uint64_t limit) : limit_{limit} {
+  }
+
+  /// Returns the number of consecutive plain strings of the field at `path`.
+  auto plain_strings(std::string_view path) -> uint64_t& {
+    auto it = plain_strings_.find(path);
+    if (it == plain_strings_.end()) {
+      it = plain_strings_.emplace(std::string{path}, uint64_t{0}).first;
+    }
+    return it.value();
+  }
+
+  /// Returns whether to attempt type inference for a field that had the given
+  /// number of consecutive plain strings.
+  auto should_infer(uint64_t plain_strings) const -> bool {
+    return limit_ == 0 or plain_strings < limit_;
+  }
+
+private:
+  uint64_t limit_ = {};
+  heterogeneous_string_hashmap<uint64_t> plain_strings_ = {};
+};
+
+} // namespace tenzir::detail
@@ -0,0 +1,412 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace tenzir::detail {
+
+/// A cache that bounds the total weight of its entries, e.g., their size in
+/// bytes, and decides which entries to keep with the W-TinyLFU policy.
+///
+/// New entries enter a small LRU *window*. Entries that overflow the window
+/// move to the *probation* segment of the main cache, where they compete for
+/// admission with the least recently used probationary entry: of the two, the
+/// entry whose key was accessed less frequently in the recent past is evicted.
+/// Probationary entries that are accessed again get promoted to the
+/// *protected* segment. A count-min sketch with periodic aging estimates the
+/// access frequencies, including those of keys that are no longer cached.
+///
+/// The factory must provide `operator()(const Key&) -> Value` to load missing
+/// entries, and `weight(const Key&) -> size_t` to determine their weight.
+template <class Key, class Value, class Factory, class Hash = std::hash<Key>>
+class tinylfu_cache {
+public:
+  using key_value_pair = std::pair<Key, Value>;
+
+  /// Counters that describe the effectiveness of the cache since it was
+  /// created.
+  struct statistics {
+    /// The number of lookups that found their entry in the cache.
+    uint64_t hits = 0;
+
+    /// The number of lookups that had to load their entry.
+    uint64_t misses = 0;
+
+    /// The number of entries that were evicted to stay within the capacity.
+    uint64_t evictions = 0;
+
+    /// The number of entries that were loaded ahead of their lookup.
+    uint64_t prefetches = 0;
+  };
+
+private:
+  enum segment : size_t {
+    window_segment,
+    probation_segment,
+    protected_segment,
+    num_segments,
+  };
+
+  using list_type = std::list<key_value_pair>;
+  using lists_type = std::array<list_type, num_segments>;
+
+public:
+  /// Iterates over all entries of the cache in no particular order.
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = key_value_pair;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const key_value_pair*;
+    using reference = const key_value_pair&;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      return *it_;
+    }
+
+    pointer operator->() const {
+      return &*it_;
+    }
+
+    const_iterator& operator++() {
+      ++it_;
+      skip_exhausted_segments();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    friend bool operator==(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      return lhs.segment_ == rhs.segment_
+             && (lhs.segment_ == num_segments || lhs.it_ == rhs.it_);
+    }
+
+  private:
+    friend class tinylfu_cache;
+
+    const_iterator(const lists_type* lists, size_t segment)
+      : lists_{lists}, segment_{segment} {
+      if (segment_ < num_segments) {
+        it_ = (*lists_)[segment_].begin();
+        skip_exhausted_segments();
+      }
+    }
+
+    void skip_exhausted_segments() {
+      while (segment_ < num_segments && it_ == (*lists_)[segment_].end()) {
+        if (++segment_ < num_segments)
+          it_ = (*lists_)[segment_].begin();
+      }
+    }
+
+    const lists_type* lists_ = nullptr;
+    size_t segment_ = num_segments;
+    typename list_type::const_iterator it_ = {};
+  };
+
+  /// The share of the capacity reserved for the window in percent. The window
+  /// is larger than the 1% commonly recommended for W-TinyLFU because we
+  /// expect few but heavy entries, and it holds prefetched entries until they
+  /// are requested.
+  static constexpr size_t window_percentage = 10;
+
+  /// The share of the main cache reserved for the protected segment in
+  /// percent.
+  static constexpr size_t protected_percentage = 80;
+
+  tinylfu_cache(size_t capacity, Factory factory)
+    : capacity_{capacity}, factory_{std::move(factory)} {
+  }
+
+  void clear() {
+    for (auto& list : lists_)
+      list.clear();
+    weights_ = {};
+    prefetched_weight_ = 0;
+    slots_.clear();
+  }
+
+  /// Changes the capacity and evicts entries until the cache fits into it.
+  void resize(size_t capacity) {
+    capacity_ = capacity;
+    evict();
+  }
+
+  const_iterator begin() const {
+    return const_iterator{&lists_, 0};
+  }
+
+  const_iterator end() const {
+    return const_iterator{&lists_, num_segments};
+  }
+
+  /// Retrieves the entry for `key`, loading it with the factory if it is not
+  /// cached. The returned value remains valid even if the cache decides not
+  /// to admit it.
+  Value get_or_load(const Key& key) {
+    sketch_.increment(hasher_(key));
+    if (auto it = slots_.find(key); it != slots_.end()) {
+      ++statistics_.hits;
+      return touch(it->second);
+    }
+    ++statistics_.misses;
+    return insert(key, factory_(key));
+  }
+
+  /// Loads the entry for `key` ahead of time if it is not cached yet. Unlike
+  /// `get_or_load`, this does not count as an access of the key. Prefetched
+  /// entries stay in the window until their first access, so an entry is only
+  /// prefetched if the window can hold it alongside the other prefetched
+  /// entries.
+  /// @returns Whether the entry is cached afterwards.
+  bool prefetch(const Key& key) {
+    if (contains(key))
+      return true;
+    if (prefetched_weight_ + factory_.weight(key) > window_capacity())
+      return false;
+    ++statistics_.prefetches;
+    insert(key, factory_(key), true);
+    return true;
+  }
+
+  void drop(const Key& key) {
+    if (auto it = slots_.find(key); it != slots_.end())
+      erase(it);
+  }
+
+  /// Removes an entry from the cache and returns it, constructing it if it
+  /// didn't exist before.
+  Value eject(const Key& key) {
+    auto it = slots_.find(key);
+    if (it == slots_.end())
+      return factory_(key);
+    auto result = std::move(it->second.it->second);
+    erase(it);
+    return result;
+  }
+
+  bool contains(const Key& key) const {
+    return slots_.find(key) != slots_.end();
+  }
+
+  /// Returns the number of cached entries.
+  [[nodiscard]] size_t size() const {
+    return slots_.size();
+  }
+
+  /// Returns the total weight of the cached entries.
+  [[nodiscard]] size_t weight() const {
+    return weights_[window_segment] + weights_[probation_segment]
+           + weights_[protected_segment];
+  }
+
+  [[nodiscard]] size_t capacity() const {
+    return capacity_;
+  }
+
+  [[nodiscard]] const statistics& stats() const {
+    return statistics_;
+  }
+
+  Factory& factory() {
+    return factory_;
+  }
+
+private:
+  struct slot {
+    segment where;
+    typename list_type::iterator it;
+    size_t weight;
+    /// Whether the entry was prefetched and not accessed since.
+    bool prefetched;
+  };
+
+  using slot_map = std::unordered_map<Key, slot, Hash>;
+
+  /// Estimates how often keys were accessed recently with a count-min sketch
+  /// of 4-bit counters. All counters are halved once the number of increments
+  /// reaches the sample size, so that the estimates favor recent accesses.
+  class frequency_sketch {
+  public:
+    void increment(size_t hash) {
+      auto incremented = false;
+      for (auto row = size_t{0}; row < depth; ++row) {
+        auto& counter = counters_[row][index(hash, row)];
+        if (counter < max_count) {
+          ++counter;
+          incremented = true;
+        }
+      }
+      if (incremented && ++additions_ == sample_size) {
+        for (auto& row : counters_)
+          for (auto& counter : row)
+            counter /= 2;
+        additions_ /= 2;
+      }
+    }
+
+    [[nodiscard]] uint8_t estimate(size_t hash) const {
+      auto result = max_count;
+      for (auto row = size_t{0}; row < depth; ++row)
+        result = std::min(result, counters_[row][index(hash, row)]);
+      return result;
+    }
+
+  private:
+    static constexpr size_t depth = 4;
+    static constexpr size_t width = 1024;
+    static constexpr size_t sample_size = 10 * width;
+    static constexpr uint8_t max_count = 15;
+
+    static size_t index(size_t hash, size_t row) {
+      auto x = (uint64_t{hash} + row) * 0x9e3779b97f4a7c15ull;
+      return (x ^ (x >> 29)) & (width - 1);
+    }
+
+    std::array<std::array<uint8_t, width>, depth> counters_ = {};
+    size_t additions_ = 0;
+  };
+
+  size_t window_capacity() const {
+    return capacity_ / 100 * window_percentage;
+  }
+
+  size_t protected_capacity() const {
+    return (capacity_ - window_capacity()) / 100 * protected_percentage;
+  }
+
+  /// Moves an entry to the front of the given segment.
+  void transfer(slot& x, segment target) {
+    lists_[target].splice(lists_[target].begin(), lists_[x.where], x.it);
+    weights_[x.where] -= x.weight;
+    weights_[target] += x.weight;
+    x.where = target;
+  }
+
+  void erase(typename slot_map::iterator it) {
+    if (it->second.prefetched)
+      prefetched_weight_ -= it->second.weight;
+    lists_[it->second.where].erase(it->second.it);
+    weights_[it->second.where] -= it->second.weight;
+    slots_.erase(it);
+  }
+
+  void evict_entry(const Key& key) {
+    erase(slots_.find(key));
+    ++statistics_.evictions;
+  }
+
+  Value touch(slot& x) {
+    switch (x.where) {
+      case probation_segment:
+        transfer(x, protected_segment);
+        while (weights_[protected_segment] > protected_capacity()
+               && lists_[protected_segment].size() > 1) {
+          const auto& demoted = lists_[protected_segment].back().first;
+          transfer(slots_.find(demoted)->second, probation_segment);
+        }
+        break;
+      default:
+        if (x.prefetched) {
+          x.prefetched = false;
+          prefetched_weight_ -= x.weight;
+        }
+        transfer(x, x.where);
+        break;
+    }
+    return x.it->second;
+  }
+
+  Value insert(const Key& key, Value value, bool prefetched = false) {
+    auto& window = lists_[window_segment];
+    window.emplace_front(key, value);
+    const auto weight = factory_.weight(key);
+    slots_.emplace(key, slot{window_segment, window.begin(), weight,
+                             prefetched});
+    weights_[window_segment] += weight;
+    if (prefetched)
+      prefetched_weight_ += weight;
+    // The window always retains the most recent entry, even if that entry
+    // alone exceeds the window capacity, and prefetched entries that were not
+    // accessed yet, which have no frequency that could get them admitted.
+    while (weights_[window_segment] > window_capacity()) {
+      const auto it = std::find_if(window.rbegin(), std::prev(window.rend()),
+                                   [&](const key_value_pair& x) {
+                                     return !slots_.find(x.first)
+                                               ->second.prefetched;
+                                   });
+      if (it == std::prev(window.rend()))
+        break;
+      const auto candidate = it->first;
+      transfer(slots_.find(candidate)->second, probation_segment);
+      admit(candidate);
+    }
+    evict();
+    return value;
+  }
+
+  /// Makes room for a candidate that just moved from the window to the front
+  /// of the probation segment by evicting either the least recently used
+  /// probationary entries or the candidate itself, whichever is accessed less
+  /// frequently.
+  void admit(const Key& candidate) {
+    const auto candidate_frequency = sketch_.estimate(hasher_(candidate));
+    auto& probation = lists_[probation_segment];
+    while (weight() > capacity_ && probation.size() > 1) {
+      const auto& victim = probation.back().first;
+      if (candidate_frequency <= sketch_.estimate(hasher_(victim))) {
+        evict_entry(candidate);
+        return;
+      }
+      evict_entry(victim);
+    }
+  }
+
+  /// Evicts entries until the cache fits into its capacity, preferring
+  /// probationary over protected over window entries.
+  void evict() {
+    while (weight() > capacity_) {
+      for (auto segment : {probation_segment, protected_segment,
+                           window_segment}) {
+        if (!lists_[segment].empty()) {
+          evict_entry(Key{lists_[segment].back().first});
+          break;
+        }
+      }
+    }
+  }
+
+  size_t capacity_;
+  Factory factory_;
+  Hash hasher_ = {};
+  lists_type lists_ = {};
+  std::array<size_t, num_segments> weights_ = {};
+  size_t prefetched_weight_ = 0;
+  slot_map slots_ = {};
+  frequency_sketch sketch_ = {};
+  statistics statistics_ = {};
+};
+
+} // namespace tenzir::detail
@@ -0,0 +1,68 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/operator.hpp"
+#include "tenzir/view.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Utilities for indexing strings by their substrings of three bytes.
+namespace tenzir::detail {
+
+/// Three consecutive bytes of a string packed into an integer. ASCII letters
+/// are folded to lower case such that case-insensitive patterns can use the
+/// same trigrams.
+using trigram = uint32_t;
+
+/// Packs three bytes into a trigram.
+inline trigram make_trigram(char a, char b, char c) {
+  auto fold = [](char x) -> trigram {
+    auto byte = static_cast<uint8_t>(x);
+    if (byte >= 'A' && byte <= 'Z')
+      byte += 'a' - 'A';
+    return byte;
+  };
+  return fold(a) << 16 | fold(b) << 8 | fold(c);
+}
+
+/// Invokes a function for every trigram of a string, including duplicates.
+template <class F>
+void each_trigram(std::string_view str, F f) {
+  for (size_t i = 2; i < str.size(); ++i)
+    f(make_trigram(str[i - 2], str[i - 1], str[i]));
+}
+
+/// Computes the sorted and unique trigrams of a string.
+std::vector<trigram> trigrams(std::string_view str);
+
+/// Extracts literal substrings that every string matching a regular
+/// expression must contain. The extraction is conservative: it gives up on
+/// alternations and on constructs it does not understand, and drops the
+/// parts of the expression that are optional.
+/// @param regex The regular expression in RE2 syntax.
+/// @param case_insensitive Whether the expression matches case-insensitively.
+/// @returns The mandatory literals, or an empty list if there are none.
+std::vector<std::string>
+required_literals(std::string_view regex, bool case_insensitive);
+
+/// Computes the trigrams that a string must contain for the predicate
+/// `x op rhs` to hold.
+/// @returns The sorted and unique required trigrams, or `std::nullopt` if the
+/// predicate does not constrain the trigrams of *x*.
+std::optional<std::vector<trigram>>
+required_trigrams(relational_operator op, data_view rhs);
+
+} // namespace tenzir::detail
@@ -35,6 +35,7 @@ namespace arrow {
 
 class Array;
 class ArrayBuilder;
+class BooleanArray;
 class BooleanType;
 class Buffer;
 class DataType;
@@ -165,6 +166,7 @@ class plugin_ptr;
 class plugin;
 class port;
 class record_type;
+class roaring_bitmap;
 class segment;
 class shared_diagnostic_handler;
 class string_type;
@@ -326,6 +328,7 @@ namespace bitmap {
 
 struct EWAHBitmap;
 struct NullBitmap;
+struct RoaringBitmap;
 struct WAHBitmap;
 
 } // namespace bitmap
@@ -438,6 +441,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(tenzir_types, first_tenzir_type_id)
   TENZIR_ADD_TYPE_ID((tenzir::relational_operator))
   TENZIR_ADD_TYPE_ID((tenzir::rest_endpoint))
   TENZIR_ADD_TYPE_ID((tenzir::rest_response))
+  TENZIR_ADD_TYPE_ID((tenzir::roaring_bitmap))
   TENZIR_ADD_TYPE_ID((tenzir::shared_diagnostic_handler))
   TENZIR_ADD_TYPE_ID((tenzir::subnet))
   TENZIR_ADD_TYPE_ID((tenzir::table_slice))
@@ -36,6 +36,7 @@ auto http_method_from_string(const std::string& str)
 enum class http_content_type : uint16_t {
   json,
   ldjson,
+  arrow_stream,
 };
 
 enum class http_status_code : uint16_t {
@@ -120,6 +121,11 @@ struct rest_response {
   /// Create a response from a JSON string.
   static auto from_json_string(std::string json) -> rest_response;
 
+  /// Create a response from a body of the given content type, which overrides
+  /// the content type of the endpoint.
+  static auto from_body(std::string body, http_content_type content_type)
+    -> rest_response;
+
   /// Returns an error that uses `{error: "{message}"}` as the response body.
   static auto make_error(uint16_t error_code, std::string_view message,
                          caf::error detail = {}) -> rest_response;
@@ -136,6 +142,7 @@ struct rest_response {
   auto body() const -> const std::string&;
   auto code() const -> size_t;
   auto error_detail() const -> const caf::error&;
+  auto content_type() const -> std::optional<http_content_type>;
   auto release() && -> std::string;
 
   template <class Inspector>
@@ -143,7 +150,8 @@ struct rest_response {
     return f.object(r)
       .pretty_name("tenzir.rest_response")
       .fields(f.field("code", r.code_), f.field("body", r.body_),
-              f.field("detail", r.detail_));
+              f.field("detail", r.detail_),
+              f.field("content-type", r.content_type_));
   }
 
 private:
@@ -161,6 +169,9 @@ private:
 
   // For log messages, debugging, etc. Not returned to the client.
   caf::error detail_ = {};
+
+  // The content type of the body if it differs from the one of the endpoint.
+  std::optional<http_content_type> content_type_ = {};
 };
 
 /// Used for serializing an incoming request to be able to send it as a caf
@@ -13,8 +13,8 @@
 #include "tenzir/active_partition.hpp"
 #include "tenzir/actors.hpp"
 #include "tenzir/catalog.hpp"
-#include "tenzir/detail/lru_cache.hpp"
 #include "tenzir/detail/stable_set.hpp"
+#include "tenzir/detail/tinylfu_cache.hpp"
 #include "tenzir/fbs/index.hpp"
 #include "tenzir/importer.hpp"
 #include "tenzir/plugin.hpp"
@@ -117,6 +117,10 @@ public:
 
   partition_actor operator()(const uuid& id) const;
 
+  /// Returns the size of the partition and store files of a partition, which
+  /// determines its weight in the partition cache.
+  [[nodiscard]] size_t weight(const uuid& id) const;
+
   [[nodiscard]] size_t materializations() const;
 
 private:
@@ -264,8 +268,9 @@ struct index_state {
 
   /// The set of passive (read-only) partitions currently loaded into memory.
   /// Uses the `partition_factory` to load new partitions as needed, and evicts
-  /// old entries when the size exceeds `max_inmem_partitions`.
-  detail::lru_cache<uuid, partition_actor, partition_factory> inmem_partitions;
+  /// entries when their total size exceeds `partition_cache_size`.
+  detail::tinylfu_cache<uuid, partition_actor, partition_factory>
+    inmem_partitions;
 
   /// The set of partitions that exist on disk.
   std::unordered_set<uuid> persisted_partitions = {};
@@ -280,9 +285,8 @@ struct index_state {
   /// Timeout after which an active partition is forcibly flushed.
   duration active_partition_timeout = {};
 
-  /// The maximum size of the partition LRU cache (or the maximum number of
-  /// read-only partition loaded to memory).
-  size_t max_inmem_partitions = {};
+  /// The maximum size of the partition cache in bytes.
+  size_t partition_cache_size = {};
 
   /// The number of partitions initially returned for a query.
   uint32_t taste_partitions = {};
@@ -315,6 +319,10 @@ struct index_state {
   /// Keeps temporary statistics that are flushed with the metrics.
   index_counters counters = {};
 
+  /// The partition cache statistics at the time they were last written to the
+  /// metrics, used to calculate the deltas for the next round.
+  decltype(inmem_partitions)::statistics previous_cache_statistics = {};
+
   /// The CATALOG actor.
   catalog_actor catalog = {};
 
@@ -375,8 +383,8 @@ struct index_state {
 /// @param partition_capacity The maximum number of events per partition.
 /// @param active_partition_timeout Timeout after which an active partition is
 /// forcibly flushed.
-/// @param max_inmem_partitions The maximum number of passive partitions loaded
-/// into memory.
+/// @param partition_cache_size The maximum size of the passive partitions
+/// loaded into memory in bytes.
 /// @param taste_partitions How many lookup partitions to schedule immediately.
 /// @param max_concurrent_partition_lookups The maximum amount of concurrent
 /// lookups.
@@ -390,7 +398,7 @@ index(index_actor::stateful_pointer<index_state> self,
       accountant_actor accountant, filesystem_actor filesystem,
       catalog_actor catalog, const std::filesystem::path& dir,
       std::string store_backend, size_t partition_capacity,
-      duration active_partition_timeout, size_t max_inmem_partitions,
+      duration active_partition_timeout, size_t partition_cache_size,
       size_t taste_partitions, size_t max_concurrent_partition_lookups,
       const std::filesystem::path& catalog_dir, index_config);
 
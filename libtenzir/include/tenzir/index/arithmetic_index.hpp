@@ -38,7 +38,11 @@
 namespace tenzir {
 
 /// An index for arithmetic values.
-template <class T, class Binner = void>
+/// @tparam T The type of the indexed values.
+/// @tparam Binner The binner for the values, or `void` to choose a default.
+/// @tparam Bitmap The bitmap type of the coder. The attribute `#index=roaring`
+/// selects `roaring_bitmap`.
+template <class T, class Binner = void, class Bitmap = bitmap>
 class arithmetic_index : public value_index {
 public:
   // clang-format off
@@ -57,18 +61,18 @@ public:
   static_assert(!std::is_same_v<value_type, std::false_type>,
                 "invalid type T for arithmetic_index");
 
-  using multi_level_range_coder = multi_level_coder<range_coder<bitmap>>;
+  using multi_level_range_coder = multi_level_coder<range_coder<Bitmap>>;
 
   // clang-format off
-  // TODO: This uses a type-erased bitmap rather than a specific bitmap
-  // implementation, which is absolutely unnecessary. It can, however, not
-  // easily be changed as these bitmaps were persisted using the legacy CAF
+  // TODO: This uses a type-erased bitmap by default rather than a specific
+  // bitmap implementation, which is absolutely unnecessary. It can, however,
+  // not easily be changed as these bitmaps were persisted using the legacy CAF
   // serializer as part of the partition v0 FlatBuffers table. Once that no
   // longer exists we can and should switch to using ewah_bitmap or similar
   // here.
   using coder_type = std::conditional_t<
     std::is_same_v<T, bool>,
-    singleton_coder<bitmap>,
+    singleton_coder<Bitmap>,
     multi_level_range_coder
   >;
   // clang-format on
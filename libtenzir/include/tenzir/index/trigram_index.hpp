@@ -0,0 +1,60 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/detail/legacy_deserialize.hpp"
+#include "tenzir/detail/trigram.hpp"
+#include "tenzir/error.hpp"
+#include "tenzir/ewah_bitmap.hpp"
+#include "tenzir/ids.hpp"
+#include "tenzir/value_index.hpp"
+#include "tenzir/view.hpp"
+
+#include <caf/error.hpp>
+#include <caf/expected.hpp>
+#include <caf/fwd.hpp>
+#include <tsl/robin_map.h>
+
+namespace tenzir {
+
+/// An index for strings that maps every trigram, i.e., every substring of
+/// three bytes, to the IDs of the strings containing it. Lookups intersect the
+/// ID sets of the trigrams that a string must contain to satisfy a predicate.
+/// This makes substring searches and regular expressions with literal parts
+/// fast, but the result is a superset of the actual matches that the caller
+/// must filter. Predicates that do not imply any trigrams, e.g., substrings
+/// shorter than three bytes or negations, select all IDs.
+class trigram_index : public value_index {
+public:
+  /// Constructs a trigram index.
+  /// @param t An instance of `string_type`.
+  /// @param opts Runtime context for index parameterization.
+  explicit trigram_index(tenzir::type t, caf::settings opts = {});
+
+  bool inspect_impl(supported_inspectors& inspector) override;
+
+private:
+  bool append_impl(data_view x, id pos) override;
+
+  caf::expected<ids>
+  lookup_impl(relational_operator op, data_view x) const override;
+
+  size_t memusage_impl() const override;
+
+  flatbuffers::Offset<fbs::ValueIndex>
+  pack_impl(flatbuffers::FlatBufferBuilder& builder,
+            flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase>
+              base_offset) override;
+
+  caf::error unpack_impl(const fbs::ValueIndex& from) override;
+
+  tsl::robin_map<detail::trigram, ewah_bitmap> postings_;
+};
+
+} // namespace tenzir
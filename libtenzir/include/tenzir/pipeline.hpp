@@ -21,8 +21,11 @@
 #include <fmt/core.h>
 
 #include <memory>
+#include <optional>
+#include <string>
 #include <type_traits>
 #include <variant>
+#include <vector>
 
 namespace tenzir {
 
@@ -317,6 +320,29 @@ public:
     -> optimize_result
     = 0;
 
+  /// Returns the keys of the fields that the operator reads from its input in
+  /// order to produce the given fields of its output, where `std::nullopt`
+  /// stands for all fields.
+  ///
+  /// The function is used by `pipeline::optimize` to push projections towards
+  /// the source of a pipeline. The default implementation returns
+  /// `std::nullopt`, which makes the operator a barrier for projections.
+  virtual auto
+  required_fields(const std::optional<std::vector<std::string>>& fields) const
+    -> std::optional<std::vector<std::string>> {
+    (void)fields;
+    return std::nullopt;
+  }
+
+  /// Returns a copy of the operator that only needs to produce the given fields
+  /// of its output, or `nullptr` if the operator cannot make use of that. The
+  /// copy may still produce additional fields.
+  virtual auto project(const std::vector<std::string>& fields) const
+    -> operator_ptr {
+    (void)fields;
+    return nullptr;
+  }
+
   /// Returns the location of the operator.
   virtual auto location() const -> operator_location {
     return operator_location::anywhere;
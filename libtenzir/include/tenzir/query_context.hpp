@@ -17,6 +17,10 @@
 
 #include <caf/typed_actor_view.hpp>
 
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace tenzir {
 
 /// A count query to collect the number of hits for the expression.
@@ -48,16 +52,21 @@ struct count_query_context {
 struct extract_query_context {
   receiver_actor<table_slice> sink;
 
+  /// The keys of the fields that the sink requires, or all fields if not set.
+  /// Stores may use this to avoid loading unneeded fields, but are free to
+  /// return more fields than required.
+  std::optional<std::vector<std::string>> fields = {};
+
   friend bool operator==(const extract_query_context& lhs,
                          const extract_query_context& rhs) {
-    return lhs.sink == rhs.sink;
+    return lhs.sink == rhs.sink && lhs.fields == rhs.fields;
   }
 
   template <class Inspector>
   friend auto inspect(Inspector& f, extract_query_context& x) {
     return f.object(x)
       .pretty_name("tenzir.query.extract")
-      .fields(f.field("sink", x.sink));
+      .fields(f.field("sink", x.sink), f.field("fields", x.fields));
   }
 };
 
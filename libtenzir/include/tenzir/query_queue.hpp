@@ -113,6 +113,11 @@ public:
   /// Retrieves a handle to the contained queries.
   [[nodiscard]] const std::unordered_map<uuid, query_state>& queries() const;
 
+  /// Returns the IDs of up to `n` partitions that `next()` is going to return
+  /// soon, in the order in which they are scheduled. This is a heuristic that
+  /// ignores whether the queries of the partitions are active.
+  [[nodiscard]] std::vector<uuid> peek(size_t n) const;
+
   // -- modifiers --------------------------------------------------------------
 
   /// Inserts a new query into the queue.
@@ -0,0 +1,200 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/bitmap_base.hpp"
+#include "tenzir/detail/inspection_common.hpp"
+#include "tenzir/detail/operators.hpp"
+
+#include <vector>
+
+namespace tenzir {
+
+class roaring_bitmap_range;
+
+/// A bitmap that partitions the bit positions into chunks of 2^16 bits by
+/// their upper 48 bits, and stores the lower 16 bits of the set positions of
+/// every non-empty chunk in a *container* that picks the cheapest of three
+/// representations:
+///
+/// 1. An *array* container holds up to 4096 sorted 16-bit positions.
+/// 2. A *bitset* container holds an uncompressed bitvector of 2^16 bits.
+/// 3. A *run* container holds sorted pairs of the first and last position of
+///    runs of set bits.
+///
+/// Unlike the word-aligned run-length encodings, the bitwise operations work
+/// container by container and only look at chunks that have set bits, which
+/// makes them considerably faster for sparse bitmaps over many positions. The
+/// operations on bitset containers are plain loops over fixed-size blocks
+/// that the compiler vectorizes.
+///
+/// This implementation maintains the following invariants:
+///
+/// 1. The containers are sorted by their key and none of them is empty.
+/// 2. All set positions are less than `size()`.
+/// 3. Containers use their cheapest representation, except for the last
+///    container of a bitmap that receives appended bits. It is optimized once
+///    the bitmap grows beyond it.
+class roaring_bitmap : public bitmap_base<roaring_bitmap>,
+                       detail::equality_comparable<roaring_bitmap> {
+  friend roaring_bitmap_range;
+
+public:
+  /// The number of bits per container.
+  static constexpr size_type container_width = size_type{1} << 16;
+
+  /// The number of blocks in a bitset container.
+  static constexpr size_t container_blocks
+    = container_width / word_type::width;
+
+  /// The maximum number of positions in an array container.
+  static constexpr size_t max_array_size = 4096;
+
+  enum class container_kind : uint8_t {
+    array,
+    bitset,
+    run,
+  };
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, container_kind& x) {
+    return detail::inspect_enum(f, x);
+  }
+
+  /// The set positions of a chunk of 2^16 bits.
+  struct container {
+    /// The upper 48 bits of all positions in the container.
+    size_type key = 0;
+
+    /// The representation of the positions.
+    container_kind kind = container_kind::array;
+
+    /// The number of set positions.
+    uint32_t cardinality = 0;
+
+    /// The sorted positions of an array container, or the pairs of the first
+    /// and last position of the runs of a run container.
+    std::vector<uint16_t> values = {};
+
+    /// The blocks of a bitset container.
+    std::vector<block_type> blocks = {};
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, container& x) {
+      return detail::apply_all(f, x.key, x.kind, x.cardinality, x.values,
+                               x.blocks);
+    }
+  };
+
+  roaring_bitmap() = default;
+
+  explicit roaring_bitmap(size_type n, bool bit = false);
+
+  // -- inspectors -----------------------------------------------------------
+
+  [[nodiscard]] bool empty() const;
+
+  [[nodiscard]] size_type size() const;
+
+  [[nodiscard]] size_t memusage() const;
+
+  [[nodiscard]] const std::vector<container>& containers() const;
+
+  // -- modifiers ------------------------------------------------------------
+
+  void append_bit(bool bit);
+
+  void append_bits(bool bit, size_type n);
+
+  void append_block(block_type bits, size_type n = word_type::width);
+
+  void flip();
+
+  // -- concepts -------------------------------------------------------------
+
+  friend bool operator==(const roaring_bitmap& x, const roaring_bitmap& y);
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, roaring_bitmap& bm) {
+    return detail::apply_all(f, bm.containers_, bm.num_bits_);
+  }
+
+  friend auto
+  pack(flatbuffers::FlatBufferBuilder& builder, const roaring_bitmap& from)
+    -> flatbuffers::Offset<fbs::bitmap::RoaringBitmap>;
+
+  friend auto unpack(const fbs::bitmap::RoaringBitmap& from, roaring_bitmap& to)
+    -> caf::error;
+
+  // -- bitwise operations ---------------------------------------------------
+
+  friend roaring_bitmap
+  binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  friend roaring_bitmap
+  binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  friend roaring_bitmap
+  binary_xor(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  friend roaring_bitmap
+  binary_nand(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+private:
+  /// Sets all bits in the range *[first, last)*.
+  /// @pre `first >= size()`
+  void set_range(size_type first, size_type last);
+
+  /// Combines the containers of two bitmaps with the same key with a
+  /// container-wise operation, and keeps the containers that exist in only
+  /// one of the bitmaps if the respective flag is set.
+  template <class Operation>
+  static roaring_bitmap merge(const roaring_bitmap& lhs,
+                              const roaring_bitmap& rhs, bool keep_lhs,
+                              bool keep_rhs, Operation op);
+
+  std::vector<container> containers_;
+  size_type num_bits_ = 0;
+};
+
+class roaring_bitmap_range
+  : public bit_range_base<roaring_bitmap_range, roaring_bitmap::block_type> {
+public:
+  using word_type = roaring_bitmap::word_type;
+
+  roaring_bitmap_range() = default;
+
+  explicit roaring_bitmap_range(const roaring_bitmap& bm);
+
+  void next();
+  [[nodiscard]] bool done() const;
+
+private:
+  void scan();
+
+  /// Makes the blocks of the container with the given key available.
+  void load(roaring_bitmap::size_type key);
+
+  /// Retrieves the block at the given index.
+  roaring_bitmap::block_type block(roaring_bitmap::size_type i);
+
+  const roaring_bitmap* bm_ = nullptr;
+  roaring_bitmap::size_type block_ = 0;
+  roaring_bitmap::size_type num_blocks_ = 0;
+  size_t next_container_ = 0;
+  roaring_bitmap::size_type loaded_key_ = word_type::npos;
+  bool uniform_ = true;
+  roaring_bitmap::block_type uniform_block_ = 0;
+  std::vector<roaring_bitmap::block_type> blocks_;
+  bool done_ = true;
+};
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm);
+
+} // namespace tenzir
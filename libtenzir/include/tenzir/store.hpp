@@ -18,7 +18,10 @@
 
 #include <caf/typed_event_based_actor.hpp>
 
+#include <optional>
+#include <string>
 #include <variant>
+#include <vector>
 
 namespace tenzir {
 
@@ -50,9 +53,12 @@ public:
   /// Execute an extract query against the store.
   /// @param expr The expression to filter events.
   /// @param selection Pre-filtered ids to consider.
+  /// @param fields The keys of the required fields, or all fields if not set.
+  /// The results may contain more fields than required.
   /// @return The results of applying the extract query to each table slice.
   [[nodiscard]] virtual generator<table_slice>
-  extract(expression expr, ids selection) const;
+  extract(expression expr, ids selection,
+          std::optional<std::vector<std::string>> fields) const;
 };
 
 /// A base class for passive stores used by the store plugin.
@@ -281,13 +281,29 @@ private:
 /// @param slices The input table slices.
 table_slice concatenate(std::vector<table_slice> slices);
 
+/// Controls how `select` handles gaps between the selected rows.
+enum class select_mode {
+  /// Cuts the slice into one slice per run of selected rows, which preserves
+  /// the ids of the rows.
+  runs,
+  /// Copies all selected rows into a single slice, which does not preserve
+  /// ids.
+  compact,
+  /// Compacts if the selected rows form many short runs, and cuts the slice
+  /// into runs otherwise. Does not necessarily preserve ids.
+  adaptive,
+};
+
 /// Selects all rows in `slice` with event IDs in `selection`. Cuts `slice`
-/// into multiple slices if `selection` produces gaps.
+/// into multiple slices if `selection` produces gaps, unless `mode` allows for
+/// compacting the selected rows into a single slice.
 /// @param slice The input table slice.
 /// @param expr The filter expression.
 /// @param hints ID set for selecting events from `slice`.
+/// @param mode How to handle gaps between selected rows.
 generator<table_slice>
-select(const table_slice& slice, expression expr, const ids& hints);
+select(const table_slice& slice, expression expr, const ids& hints,
+       select_mode mode = select_mode::runs);
 
 /// Produces a new table slice consisting only of events addressed in `hints`
 /// that match the given expression. Does not preserve ids; use `select`
@@ -351,6 +367,16 @@ uint64_t rows(const std::vector<table_slice>& slices);
 ids evaluate(const expression& expr, const table_slice& slice,
              const ids& hints);
 
+/// Evaluates an expression over a table slice by applying Arrow compute
+/// kernels column-wise. Predicates without a matching kernel fall back to
+/// row-wise evaluation. The result is identical to that of `evaluate`.
+/// @param expr The tailored expression to evaluate.
+/// @param slice The table slice to apply *expr* on.
+/// @returns A mask without nulls that is true for every row of *slice* for
+/// which *expr* yields true.
+std::shared_ptr<arrow::BooleanArray>
+evaluate_vectorized(const expression& expr, const table_slice& slice);
+
 /// Produces a new table slice consisting only of events that match the given
 /// expression. Does not preserve ids, use `select`instead if the id mapping
 /// must be maintained.
@@ -371,6 +397,14 @@ filter(const table_slice& slice, const expression& expr);
 [[nodiscard]] std::optional<table_slice>
 filter(const table_slice& slice, const ids& hints);
 
+/// Produces a new table slice consisting only of the rows for which `mask` is
+/// true. Does not preserve ids.
+/// @param slice The input table slice.
+/// @param mask A mask with one entry per row of *slice*.
+/// @returns a new table slice consisting only of the selected rows.
+[[nodiscard]] std::optional<table_slice>
+filter(const table_slice& slice, const arrow::BooleanArray& mask);
+
 /// Resolves all enumeration columns in a table slice to string columns. Note
 /// that this does not go into records inside lists or maps.
 [[nodiscard]] table_slice resolve_enumerations(table_slice slice);
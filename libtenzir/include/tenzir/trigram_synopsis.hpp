@@ -0,0 +1,273 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/bloom_filter_parameters.hpp"
+#include "tenzir/bloom_filter_synopsis.hpp"
+#include "tenzir/defaults.hpp"
+#include "tenzir/detail/assert.hpp"
+#include "tenzir/detail/trigram.hpp"
+#include "tenzir/logger.hpp"
+#include "tenzir/string_synopsis.hpp"
+
+#include <caf/config_value.hpp>
+#include <caf/settings.hpp>
+
+#include <unordered_set>
+
+namespace tenzir {
+
+/// A synopsis for strings that additionally keeps the trigrams of all values
+/// in a second Bloom filter. This allows for ruling out substring searches and
+/// regular expressions whose literal parts contain a trigram that no value
+/// has. Equality lookups use the Bloom filter of the values, like the
+/// `string_synopsis`.
+template <class HashFunction>
+class trigram_synopsis final
+  : public bloom_filter_synopsis<std::string, HashFunction> {
+public:
+  using super = bloom_filter_synopsis<std::string, HashFunction>;
+  using bloom_filter_type = typename super::bloom_filter_type;
+
+  /// Constructs a trigram synopsis from a `string_type` and two Bloom
+  /// filters.
+  trigram_synopsis(type x, bloom_filter_type values,
+                   bloom_filter_type trigrams)
+    : super{std::move(x), std::move(values)}, trigrams_{std::move(trigrams)} {
+    TENZIR_ASSERT(caf::holds_alternative<string_type>(this->type()));
+  }
+
+  [[nodiscard]] synopsis_ptr clone() const override {
+    return std::make_unique<trigram_synopsis>(this->type(), this->bloom_filter_,
+                                              trigrams_);
+  }
+
+  void add(data_view x) override {
+    super::add(x);
+    detail::each_trigram(caf::get<view<std::string>>(x),
+                         [this](detail::trigram trigram) {
+                           trigrams_.add(trigram);
+                         });
+  }
+
+  [[nodiscard]] std::optional<bool>
+  lookup(relational_operator op, data_view rhs) const override {
+    if (auto trigrams = detail::required_trigrams(op, rhs))
+      for (auto trigram : *trigrams)
+        if (!trigrams_.lookup(trigram))
+          return false;
+    return super::lookup(op, rhs);
+  }
+
+  [[nodiscard]] bool equals(const synopsis& other) const noexcept override {
+    if (typeid(other) != typeid(trigram_synopsis))
+      return false;
+    auto& rhs = static_cast<const trigram_synopsis&>(other);
+    return this->type() == rhs.type()
+           && this->bloom_filter_ == rhs.bloom_filter_
+           && trigrams_ == rhs.trigrams_;
+  }
+
+  [[nodiscard]] size_t memusage() const override {
+    return super::memusage() + trigrams_.memusage();
+  }
+
+  bool inspect_impl(synopsis::supported_inspectors& inspector) override {
+    return std::visit(
+      [this](auto inspector) {
+        return inspector.get().apply(this->bloom_filter_)
+               && inspector.get().apply(trigrams_);
+      },
+      inspector);
+  }
+
+private:
+  bloom_filter_type trigrams_;
+};
+
+/// A trigram synopsis that stores a full copy of the values and their
+/// trigrams in hash tables until it gets shrunk into a `trigram_synopsis` with
+/// Bloom filters of the optimal size.
+/// @see buffered_synopsis
+template <class HashFunction>
+class buffered_trigram_synopsis final : public synopsis {
+public:
+  buffered_trigram_synopsis(tenzir::type x, double p)
+    : synopsis{std::move(x)}, p_{p} {
+    // nop
+  }
+
+  [[nodiscard]] synopsis_ptr clone() const override {
+    auto copy = std::make_unique<buffered_trigram_synopsis>(type(), p_);
+    copy->data_ = data_;
+    copy->trigrams_ = trigrams_;
+    return copy;
+  }
+
+  [[nodiscard]] synopsis_ptr shrink() const override;
+
+  void add(data_view x) override {
+    auto v = caf::get_if<view<std::string>>(&x);
+    TENZIR_ASSERT(v);
+    if (data_.insert(materialize(*v)).second)
+      detail::each_trigram(*v, [this](detail::trigram trigram) {
+        trigrams_.insert(trigram);
+      });
+  }
+
+  [[nodiscard]] size_t memusage() const override {
+    using node_type = typename decltype(trigrams_)::node_type;
+    return sizeof(p_)
+           + buffered_synopsis_traits<std::string>::memusage(data_)
+           + trigrams_.size() * sizeof(node_type);
+  }
+
+  [[nodiscard]] std::optional<bool>
+  lookup(relational_operator op, data_view rhs) const override {
+    if (auto trigrams = detail::required_trigrams(op, rhs))
+      for (auto trigram : *trigrams)
+        if (!trigrams_.contains(trigram))
+          return false;
+    switch (op) {
+      default:
+        return {};
+      case relational_operator::equal: {
+        auto str = caf::get_if<view<std::string>>(&rhs);
+        if (!str)
+          return {};
+        return data_.contains(materialize(*str));
+      }
+      case relational_operator::in: {
+        if (auto xs = caf::get_if<view<list>>(&rhs)) {
+          for (auto x : **xs) {
+            auto str = caf::get_if<view<std::string>>(&x);
+            if (!str || data_.contains(materialize(*str)))
+              return true;
+          }
+          return false;
+        }
+        return {};
+      }
+    }
+  }
+
+  bool inspect_impl(supported_inspectors&) override {
+    TENZIR_ERROR("attempted to inspect a buffered_trigram_synopsis");
+    return false;
+  }
+
+  [[nodiscard]] bool equals(const synopsis& other) const noexcept override {
+    if (auto* p = dynamic_cast<const buffered_trigram_synopsis*>(&other))
+      return data_ == p->data_;
+    return false;
+  }
+
+private:
+  double p_;
+  std::unordered_set<std::string> data_;
+  std::unordered_set<detail::trigram> trigrams_;
+};
+
+/// Creates a new type annotation from the Bloom filter parameters of the
+/// values of a trigram synopsis. The `#index=trigram` attribute makes the
+/// synopsis factory recreate a trigram synopsis upon deserialization.
+/// @relates trigram_synopsis
+inline type annotate_trigram_parameters(const type& x,
+                                        const bloom_filter_parameters& params) {
+  return type{annotate_parameters(x, params), {{"index", "trigram"}}};
+}
+
+/// Factory to construct a trigram synopsis.
+/// @tparam HashFunction The hash function to use for the Bloom filters.
+/// @param type A type instance carrying a `string_type`.
+/// @param values The Bloom filter parameters for the values.
+/// @param trigrams The Bloom filter parameters for the trigrams.
+/// @returns A type-erased pointer to a synopsis.
+/// @pre `caf::holds_alternative<string_type>(type)`.
+/// @relates trigram_synopsis
+template <class HashFunction>
+synopsis_ptr make_trigram_synopsis(tenzir::type type,
+                                   bloom_filter_parameters values,
+                                   bloom_filter_parameters trigrams) {
+  TENZIR_ASSERT(caf::holds_alternative<string_type>(type));
+  auto x = make_bloom_filter<HashFunction>(std::move(values));
+  auto y = make_bloom_filter<HashFunction>(std::move(trigrams));
+  if (!x || !y) {
+    TENZIR_WARN("{} failed to construct Bloom filter", __func__);
+    return nullptr;
+  }
+  using synopsis_type = trigram_synopsis<HashFunction>;
+  return std::make_unique<synopsis_type>(std::move(type), std::move(*x),
+                                         std::move(*y));
+}
+
+/// Factory to construct a trigram synopsis. This overload looks for a type
+/// attribute containing the Bloom filter parameters, and otherwise falls back
+/// to the synopsis options like `make_string_synopsis`.
+/// @tparam HashFunction The hash function to use for the Bloom filters.
+/// @param type A type instance carrying a `string_type`.
+/// @returns A type-erased pointer to a synopsis.
+/// @relates trigram_synopsis
+template <class HashFunction>
+synopsis_ptr
+make_trigram_synopsis(tenzir::type type, const caf::settings& opts) {
+  TENZIR_ASSERT(caf::holds_alternative<string_type>(type));
+  // The Bloom filters of a deserialized synopsis get overwritten, so the
+  // parameters of the values suffice for both of them.
+  if (auto xs = parse_parameters(type))
+    return make_trigram_synopsis<HashFunction>(std::move(type), *xs, *xs);
+  using int_type = caf::config_value::integer;
+  auto max_part_size = caf::get_if<int_type>(&opts, "max-partition-size");
+  if (!max_part_size) {
+    TENZIR_ERROR("{} could not determine Bloom filter parameters",
+                 __PRETTY_FUNCTION__);
+    return nullptr;
+  }
+  auto p = caf::get_or(opts, "string-synopsis-fp-rate", defaults::fp_rate);
+  if (caf::get_or(opts, "buffer-input-data", false))
+    return std::make_unique<buffered_trigram_synopsis<HashFunction>>(
+      std::move(type), p);
+  // Without buffering, we use the maximum partition size as an upper bound
+  // for the number of distinct trigrams as well.
+  bloom_filter_parameters params;
+  params.n = *max_part_size;
+  params.p = p;
+  return make_trigram_synopsis<HashFunction>(
+    annotate_trigram_parameters(type, params), params, params);
+}
+
+template <class HashFunction>
+synopsis_ptr buffered_trigram_synopsis<HashFunction>::shrink() const {
+  auto next_power_of_two = [](size_t n) {
+    size_t result = 1ull;
+    while (n > result)
+      result *= 2;
+    return result;
+  };
+  bloom_filter_parameters values;
+  values.p = p_;
+  values.n = next_power_of_two(data_.size());
+  bloom_filter_parameters trigrams;
+  trigrams.p = p_;
+  trigrams.n = next_power_of_two(trigrams_.size());
+  TENZIR_DEBUG("shrinks buffered trigram synopsis to {} elements and {} "
+               "trigrams",
+               *values.n, *trigrams.n);
+  auto result = make_trigram_synopsis<HashFunction>(
+    annotate_trigram_parameters(type(), values), values, trigrams);
+  if (!result)
+    return nullptr;
+  for (const auto& x : data_)
+    result->add(make_view(x));
+  return result;
+}
+
+} // namespace tenzir
@@ -109,9 +109,11 @@ void add_root_opts(command& cmd) {
   cmd.options.add<duration>("?tenzir", "active-partition-timeout",
                             "timespan after which an active partition is "
                             "forcibly flushed (default: 30s)");
+  cmd.options.add<int64_t>("?tenzir", "partition-cache-size",
+                           "maximum size of in-memory partitions in bytes "
+                           "(default: 1 GiB)");
   cmd.options.add<int64_t>("?tenzir", "max-resident-partitions",
-                           "maximum number of in-memory "
-                           "partitions (default: 1)");
+                           "deprecated; use partition-cache-size instead");
   cmd.options.add<int64_t>("?tenzir", "max-taste-partitions",
                            "maximum number of immediately "
                            "scheduled partitions");
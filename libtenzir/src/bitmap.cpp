@@ -107,6 +107,11 @@ auto pack(flatbuffers::FlatBufferBuilder& builder, const bitmap& from)
       return fbs::CreateBitmap(builder, fbs::bitmap::Bitmap::wah,
                                wah_offset.Union());
     },
+    [&](const roaring_bitmap& roaring) {
+      const auto roaring_offset = pack(builder, roaring).Union();
+      return fbs::CreateBitmap(builder, fbs::bitmap::Bitmap::roaring,
+                               roaring_offset.Union());
+    },
   };
   return caf::visit(f, from.bitmap_);
 }
@@ -128,6 +133,8 @@ auto unpack(const fbs::Bitmap& from, bitmap& to) -> caf::error {
       return do_unpack(*from.bitmap_as_null(), null_bitmap{});
     case fbs::bitmap::Bitmap::wah:
       return do_unpack(*from.bitmap_as_wah(), wah_bitmap{});
+    case fbs::bitmap::Bitmap::roaring:
+      return do_unpack(*from.bitmap_as_roaring(), roaring_bitmap{});
   }
   __builtin_unreachable();
 }
@@ -162,4 +169,36 @@ bitmap_bit_range bit_range(const bitmap& bm) {
   return bitmap_bit_range{bm};
 }
 
+bitmap binary_and(const bitmap& lhs, const bitmap& rhs) {
+  const auto* x = caf::get_if<roaring_bitmap>(&lhs.get_data());
+  const auto* y = caf::get_if<roaring_bitmap>(&rhs.get_data());
+  if (x && y)
+    return binary_and(*x, *y);
+  return binary_and<bitmap, bitmap>(lhs, rhs);
+}
+
+bitmap binary_or(const bitmap& lhs, const bitmap& rhs) {
+  const auto* x = caf::get_if<roaring_bitmap>(&lhs.get_data());
+  const auto* y = caf::get_if<roaring_bitmap>(&rhs.get_data());
+  if (x && y)
+    return binary_or(*x, *y);
+  return binary_or<bitmap, bitmap>(lhs, rhs);
+}
+
+bitmap binary_xor(const bitmap& lhs, const bitmap& rhs) {
+  const auto* x = caf::get_if<roaring_bitmap>(&lhs.get_data());
+  const auto* y = caf::get_if<roaring_bitmap>(&rhs.get_data());
+  if (x && y)
+    return binary_xor(*x, *y);
+  return binary_xor<bitmap, bitmap>(lhs, rhs);
+}
+
+bitmap binary_nand(const bitmap& lhs, const bitmap& rhs) {
+  const auto* x = caf::get_if<roaring_bitmap>(&lhs.get_data());
+  const auto* y = caf::get_if<roaring_bitmap>(&rhs.get_data());
+  if (x && y)
+    return binary_nand(*x, *y);
+  return binary_nand<bitmap, bitmap>(lhs, rhs);
+}
+
 } // namespace tenzir
@@ -43,10 +43,196 @@
 #include <caf/detail/set_thread_name.hpp>
 #include <caf/expected.hpp>
 
+#include <algorithm>
 #include <type_traits>
 
 namespace tenzir {
 
+namespace {
+
+/// Invokes `f(field, min, max)` for every field of a partition whose values
+/// are bounded by a time synopsis. Just like the catalog lookup, we fall back
+/// to the type synopsis for fields without a dedicated synopsis.
+template <class F>
+void for_each_time_range(const partition_synopsis& ps, F f) {
+  const auto* type_synopsis = static_cast<const time_synopsis*>(nullptr);
+  if (auto it = ps.type_synopses_.find(type{time_type{}});
+      it != ps.type_synopses_.end() && it->second) {
+    type_synopsis = dynamic_cast<const time_synopsis*>(it->second.get());
+  }
+  for (const auto& [field, syn] : ps.field_synopses_) {
+    const auto* bounds
+      = syn ? dynamic_cast<const time_synopsis*>(syn.get())
+            : (caf::holds_alternative<time_type>(field.type()) ? type_synopsis
+                                                               : nullptr);
+    if (bounds) {
+      f(field, bounds->min(), bounds->max());
+    }
+  }
+}
+
+} // namespace
+
+auto time_range_index::make(std::vector<range> ranges) -> time_range_index {
+  auto result = time_range_index{};
+  result.by_min_.reserve(ranges.size());
+  result.by_max_.reserve(ranges.size());
+  result.ranges_.reserve(ranges.size());
+  for (const auto& x : ranges) {
+    auto [it, inserted] = result.ranges_.emplace(x.partition, x);
+    if (not inserted) {
+      // Keep the last range per partition, just like repeated inserts would.
+      auto& previous = it->second;
+      std::erase(result.by_min_, entry{previous.min, x.partition});
+      std::erase(result.by_max_, entry{previous.max, x.partition});
+      previous = x;
+    }
+    result.by_min_.push_back(entry{x.min, x.partition});
+    result.by_max_.push_back(entry{x.max, x.partition});
+  }
+  std::sort(result.by_min_.begin(), result.by_min_.end());
+  std::sort(result.by_max_.begin(), result.by_max_.end());
+  return result;
+}
+
+void time_range_index::insert(const range& x) {
+  erase(x.partition);
+  ranges_.emplace(x.partition, x);
+  auto add = [](std::vector<entry>& entries, entry e) {
+    entries.insert(std::upper_bound(entries.begin(), entries.end(), e), e);
+  };
+  add(by_min_, entry{x.min, x.partition});
+  add(by_max_, entry{x.max, x.partition});
+}
+
+void time_range_index::erase(const uuid& partition) {
+  auto it = ranges_.find(partition);
+  if (it == ranges_.end()) {
+    return;
+  }
+  auto remove = [](std::vector<entry>& entries, entry e) {
+    auto pos = std::lower_bound(entries.begin(), entries.end(), e);
+    TENZIR_ASSERT(pos != entries.end() && pos->partition == e.partition);
+    entries.erase(pos);
+  };
+  remove(by_min_, entry{it->second.min, partition});
+  remove(by_max_, entry{it->second.max, partition});
+  ranges_.erase(it);
+}
+
+size_t time_range_index::size() const noexcept {
+  return ranges_.size();
+}
+
+std::optional<std::vector<uuid>>
+time_range_index::lookup(relational_operator op, time rhs) const {
+  // The candidates must be sorted by their ID, as the catalog relies on that
+  // for computing unions and intersections.
+  auto collect = [](auto first, auto last) {
+    auto result = std::vector<uuid>{};
+    result.reserve(std::distance(first, last));
+    for (auto it = first; it != last; ++it) {
+      result.push_back(it->partition);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  // The semantics below must match those of `min_max_synopsis::lookup`.
+  auto min_less = [&](auto pred) {
+    auto last = std::partition_point(by_min_.begin(), by_min_.end(), pred);
+    return collect(by_min_.begin(), last);
+  };
+  auto max_greater = [&](auto pred) {
+    auto first = std::partition_point(by_max_.begin(), by_max_.end(), pred);
+    return collect(first, by_max_.end());
+  };
+  switch (op) {
+    case relational_operator::less:
+      return min_less([&](const entry& x) {
+        return x.bound < rhs;
+      });
+    case relational_operator::less_equal:
+      return min_less([&](const entry& x) {
+        return x.bound <= rhs;
+      });
+    case relational_operator::greater:
+      return max_greater([&](const entry& x) {
+        return x.bound <= rhs;
+      });
+    case relational_operator::greater_equal:
+      return max_greater([&](const entry& x) {
+        return x.bound < rhs;
+      });
+    case relational_operator::equal: {
+      // A partition is a candidate if its range contains the value. We scan
+      // the smaller of the two sides that satisfy one of the bounds, and check
+      // the other bound for every entry.
+      auto min_last
+        = std::partition_point(by_min_.begin(), by_min_.end(),
+                               [&](const entry& x) {
+                                 return x.bound <= rhs;
+                               });
+      auto max_first
+        = std::partition_point(by_max_.begin(), by_max_.end(),
+                               [&](const entry& x) {
+                                 return x.bound < rhs;
+                               });
+      auto result = std::vector<uuid>{};
+      auto filter = [&](auto first, auto last, auto pred) {
+        for (auto it = first; it != last; ++it) {
+          const auto& range = ranges_.find(it->partition)->second;
+          if (pred(range)) {
+            result.push_back(it->partition);
+          }
+        }
+      };
+      if (std::distance(by_min_.begin(), min_last)
+          <= std::distance(max_first, by_max_.end())) {
+        filter(by_min_.begin(), min_last, [&](const range& x) {
+          return x.max >= rhs;
+        });
+      } else {
+        filter(max_first, by_max_.end(), [&](const range& x) {
+          return x.min <= rhs;
+        });
+      }
+      std::sort(result.begin(), result.end());
+      return result;
+    }
+    case relational_operator::not_equal:
+      // A time synopsis can never rule out a partition for inequality.
+      return collect(by_min_.begin(), by_min_.end());
+    default:
+      return std::nullopt;
+  }
+}
+
+void catalog_time_index::insert(const uuid& partition,
+                                const partition_synopsis& synopsis) {
+  erase(partition);
+  import_time.insert({
+    .partition = partition,
+    .min = synopsis.min_import_time,
+    .max = synopsis.max_import_time,
+  });
+  for_each_time_range(synopsis, [&](const qualified_record_field& field,
+                                    time min, time max) {
+    fields[field].insert({.partition = partition, .min = min, .max = max});
+  });
+}
+
+void catalog_time_index::erase(const uuid& partition) {
+  import_time.erase(partition);
+  for (auto it = fields.begin(); it != fields.end();) {
+    it->second.erase(partition);
+    if (it->second.size() == 0) {
+      it = fields.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void catalog_state::create_from(
   std::unordered_map<uuid, partition_synopsis_ptr>&& ps) {
   std::unordered_map<tenzir::type,
@@ -63,6 +249,30 @@ void catalog_state::create_from(
                  const std::pair<uuid, partition_synopsis_ptr>& rhs) {
                 return lhs.first < rhs.first;
               });
+    // Build the time range indexes in bulk, which is much faster than
+    // inserting partitions one by one.
+    auto import_ranges = std::vector<time_range_index::range>{};
+    import_ranges.reserve(flat_data.size());
+    auto field_ranges
+      = std::unordered_map<qualified_record_field,
+                           std::vector<time_range_index::range>>{};
+    for (const auto& [partition, synopsis] : flat_data) {
+      import_ranges.push_back({
+        .partition = partition,
+        .min = synopsis->min_import_time,
+        .max = synopsis->max_import_time,
+      });
+      for_each_time_range(*synopsis, [&](const qualified_record_field& field,
+                                         time min, time max) {
+        field_ranges[field].push_back(
+          {.partition = partition, .min = min, .max = max});
+      });
+    }
+    auto& time_index = time_indexes_per_type[type];
+    time_index.import_time = time_range_index::make(std::move(import_ranges));
+    for (auto& [field, ranges] : field_ranges) {
+      time_index.fields[field] = time_range_index::make(std::move(ranges));
+    }
     synopses_per_type[type]
       = decltype(synopses_per_type)::value_type::second_type::make_unsafe(
         std::move(flat_data));
@@ -71,6 +281,7 @@ void catalog_state::create_from(
 
 void catalog_state::merge(const uuid& partition, partition_synopsis_ptr ps) {
   update_unprunable_fields(*ps);
+  time_indexes_per_type[ps->schema].insert(partition, *ps);
   synopses_per_type[ps->schema][partition] = std::move(ps);
 }
 
@@ -78,7 +289,12 @@ void catalog_state::erase(const uuid& partition) {
   for (auto& [type, uuid_synopsis_map] : synopses_per_type) {
     auto erased = uuid_synopsis_map.erase(partition);
     if (erased) {
+      if (auto it = time_indexes_per_type.find(type);
+          it != time_indexes_per_type.end()) {
+        it->second.erase(partition);
+      }
       if (uuid_synopsis_map.empty()) {
+        time_indexes_per_type.erase(type);
         synopses_per_type.erase(type);
       }
       return;
@@ -150,6 +366,21 @@ catalog_state::lookup_impl(const expression& expr, const type& schema) const {
   // ensure the post-condition of returning a sorted list. We currently
   // rely on `flat_map` already traversing them in the correct order, so
   // no separate sorting step is required.
+  const auto* time_index = static_cast<const catalog_time_index*>(nullptr);
+  if (auto it = time_indexes_per_type.find(schema);
+      it != time_indexes_per_type.end()) {
+    time_index = &it->second;
+  }
+  auto to_candidates = [&](const std::vector<uuid>& partitions) {
+    auto result = catalog_lookup_result::candidate_info{};
+    result.partition_infos.reserve(partitions.size());
+    for (const auto& partition : partitions) {
+      auto it = partition_synopses.find(partition);
+      TENZIR_ASSERT(it != partition_synopses.end());
+      result.partition_infos.emplace_back(partition, *it->second);
+    }
+    return result;
+  };
   auto memoized_partitions = catalog_lookup_result::candidate_info{};
   auto all_partitions = [&] {
     if (!memoized_partitions.partition_infos.empty()
@@ -208,9 +439,47 @@ catalog_state::lookup_impl(const expression& expr, const type& schema) const {
       // data from the predicate of the expression. The match function
       // uses a qualified_record_field to determine whether the synopsis
       // should be queried.
+      // Resolves time predicates via the time range indexes, which requires
+      // all matching fields to have a time synopsis in all partitions.
+      // Otherwise, we return nothing and fall back to checking every
+      // partition individually.
+      auto search_time_index
+        = [&](auto match,
+              const data& rhs) -> std::optional<std::vector<uuid>> {
+        const auto* value = caf::get_if<tenzir::time>(&rhs);
+        if (not value || not time_index || partition_synopses.empty()) {
+          return std::nullopt;
+        }
+        auto result = std::vector<uuid>{};
+        // All partitions of a schema have the same fields, so we can take
+        // them from any one of them.
+        const auto& first = partition_synopses.begin()->second;
+        for (const auto& [field, syn] : first->field_synopses_) {
+          if (not match(field)) {
+            continue;
+          }
+          auto it = time_index->fields.find(field);
+          if (it == time_index->fields.end()
+              || it->second.size() != partition_synopses.size()) {
+            return std::nullopt;
+          }
+          auto candidates = it->second.lookup(x.op, *value);
+          if (not candidates) {
+            return std::nullopt;
+          }
+          detail::inplace_unify(result, std::move(*candidates));
+        }
+        return result;
+      };
       auto search = [&](auto match) {
         TENZIR_ASSERT(caf::holds_alternative<data>(x.rhs));
         const auto& rhs = caf::get<data>(x.rhs);
+        if (auto candidates = search_time_index(match, rhs)) {
+          TENZIR_DEBUG("{} used the time index for predicate {} and got {} "
+                       "results",
+                       detail::pretty_type_name(this), x, candidates->size());
+          return to_candidates(*candidates);
+        }
         catalog_lookup_result::candidate_info result;
         // dont iterate through all synopses, rewrite lookup_impl to use a
         // singular type all synopses loops -> relevant anymore? Use type as
@@ -303,6 +572,14 @@ catalog_state::lookup_impl(const expression& expr, const type& schema) const {
               return result;
             }
             case meta_extractor::import_time: {
+              if (time_index
+                  && time_index->import_time.size()
+                       == partition_synopses.size()) {
+                if (auto candidates = time_index->import_time.lookup(
+                      x.op, caf::get<tenzir::time>(d))) {
+                  return to_candidates(*candidates);
+                }
+              }
               catalog_lookup_result::candidate_info result;
               for (const auto& [part_id, part_syn] : partition_synopses) {
                 TENZIR_ASSERT(
@@ -0,0 +1,547 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/compiled_json_printer.hpp"
+
+#include "tenzir/arrow_table_slice.hpp"
+#include "tenzir/concept/printable/std/chrono.hpp"
+#include "tenzir/concept/printable/tenzir/ip.hpp"
+#include "tenzir/concept/printable/tenzir/subnet.hpp"
+#include "tenzir/concept/printable/to_string.hpp"
+#include "tenzir/detail/assert.hpp"
+#include "tenzir/detail/base64.hpp"
+#include "tenzir/detail/narrow.hpp"
+#include "tenzir/detail/overload.hpp"
+#include "tenzir/detail/string.hpp"
+#include "tenzir/detail/type_traits.hpp"
+#include "tenzir/table_slice.hpp"
+
+#include <arrow/array.h>
+#include <arrow/extension_type.h>
+#include <arrow/record_batch.h>
+#include <fmt/color.h>
+#include <fmt/format.h>
+
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace tenzir {
+
+namespace {
+
+/// The text that surrounds a token in a given style.
+struct style_text {
+  explicit style_text(const fmt::text_style& style) {
+    // ANSI escape sequences never contain a pipe, so we can split the styled
+    // text around it.
+    const auto styled = fmt::format(style, "|");
+    const auto pos = styled.find('|');
+    TENZIR_ASSERT(pos != std::string::npos);
+    begin = styled.substr(0, pos);
+    end = styled.substr(pos + 1);
+  }
+
+  auto operator()(std::string_view text) const -> std::string {
+    return fmt::format("{}{}{}", begin, text, end);
+  }
+
+  std::string begin;
+  std::string end;
+};
+
+/// The text of all tokens that does not depend on the data.
+struct tokens {
+  explicit tokens(const json_printer_options& options)
+    : options{options},
+      number{options.style.number},
+      string{options.style.string},
+      array{options.style.array},
+      object{options.style.object},
+      field{options.style.field},
+      null_{style_text{options.style.null_}("null")},
+      true_{style_text{options.style.true_}("true")},
+      false_{style_text{options.style.false_}("false")},
+      separator{style_text{options.style.comma}(options.oneline ? ", " : ",")} {
+    // nop
+  }
+
+  /// Returns the line break and indentation that precede a value at the given
+  /// depth.
+  auto newline(size_t depth) const -> std::string {
+    if (options.oneline)
+      return {};
+    return fmt::format("\n{: >{}}", "", depth * options.indentation);
+  }
+
+  json_printer_options options;
+  style_text number;
+  style_text string;
+  style_text array;
+  style_text object;
+  style_text field;
+  std::string null_;
+  std::string true_;
+  std::string false_;
+  std::string separator;
+};
+
+/// Appends the values of an Arrow array to a buffer.
+class cursor {
+public:
+  virtual ~cursor() noexcept = default;
+
+  /// Appends the value at a row.
+  /// @returns Whether the value is non-empty in the sense of the omit options.
+  /// The caller discards the text of empty values.
+  [[nodiscard]] virtual auto emit(int64_t row, std::string& out) const -> bool
+    = 0;
+};
+
+auto emit_null(const tokens& tokens, std::string& out) -> bool {
+  out += tokens.null_;
+  return !tokens.options.omit_nulls;
+}
+
+void emit_number(const tokens& tokens, auto x, std::string& out) {
+  out += tokens.number.begin;
+  fmt::format_to(std::back_inserter(out), "{}", x);
+  out += tokens.number.end;
+}
+
+void emit_double(const tokens& tokens, double x, std::string& out) {
+  out += tokens.number.begin;
+  if (double i; std::modf(x, &i) == 0.0) // NOLINT
+    fmt::format_to(std::back_inserter(out), "{}.0", i);
+  else
+    fmt::format_to(std::back_inserter(out), "{}", x);
+  out += tokens.number.end;
+}
+
+void emit_string(const tokens& tokens, std::string_view x, std::string& out) {
+  out += tokens.string.begin;
+  detail::json_escape(x, out);
+  out += tokens.string.end;
+}
+
+/// Appends a string that needs no escaping, e.g., a printed IP address.
+void emit_quoted(const tokens& tokens, std::string_view x, std::string& out) {
+  out += tokens.string.begin;
+  out += '"';
+  out += x;
+  out += '"';
+  out += tokens.string.end;
+}
+
+/// Returns the array that holds the data of an array of the given type, which
+/// is the storage array for extension types.
+template <concrete_type Type>
+auto storage(const arrow::Array& array)
+  -> const type_to_arrow_array_storage_t<Type>& {
+  using storage_type = type_to_arrow_array_storage_t<Type>;
+  if constexpr (arrow::is_extension_type<type_to_arrow_type_t<Type>>::value)
+    return static_cast<const storage_type&>(
+      *static_cast<const arrow::ExtensionArray&>(array).storage());
+  else
+    return static_cast<const storage_type&>(array);
+}
+
+} // namespace
+
+/// A node of the emission plan for one column of a schema.
+class compiled_json_printer::column {
+public:
+  virtual ~column() noexcept = default;
+
+  /// Creates a cursor for an array of the column's type.
+  /// @pre The array outlives the cursor.
+  [[nodiscard]] virtual auto bind(const arrow::Array& array) const
+    -> std::unique_ptr<cursor>
+    = 0;
+};
+
+namespace {
+
+using column = compiled_json_printer::column;
+
+template <concrete_type Type>
+class scalar_column final : public column {
+public:
+  using array_type = type_to_arrow_array_storage_t<Type>;
+
+  /// Constructs a column for a basic type or an enumeration.
+  /// @param tokens The tokens of the plan.
+  /// @param type The type of the column.
+  /// @param nested Whether the column is part of a list or map. Enumerations
+  /// outside of lists and maps are printed by name and by key otherwise, which
+  /// mirrors `resolve_enumerations`.
+  scalar_column(const tokens& tokens, Type type, bool nested)
+    : tokens_{tokens}, type_{std::move(type)}, nested_{nested} {
+    // nop
+  }
+
+  auto bind(const arrow::Array& array) const
+    -> std::unique_ptr<cursor> override {
+    struct scalar_cursor final : cursor {
+      scalar_cursor(const scalar_column& column, const array_type& array)
+        : column{column}, array{array} {
+        // nop
+      }
+
+      auto emit(int64_t row, std::string& out) const -> bool override {
+        if (array.IsNull(row))
+          return emit_null(column.tokens_, out);
+        column.emit(array, row, out);
+        return true;
+      }
+
+      const scalar_column& column;
+      const array_type& array;
+    };
+    return std::make_unique<scalar_cursor>(*this, storage<Type>(array));
+  }
+
+private:
+  void emit(const array_type& array, int64_t row, std::string& out) const {
+    if constexpr (std::is_same_v<Type, null_type>) {
+      out += tokens_.null_;
+    } else if constexpr (std::is_same_v<Type, bool_type>) {
+      out += array.Value(row) ? tokens_.true_ : tokens_.false_;
+    } else if constexpr (detail::is_any_v<Type, int64_type, uint64_type>) {
+      emit_number(tokens_, array.Value(row), out);
+    } else if constexpr (std::is_same_v<Type, double_type>) {
+      emit_double(tokens_, array.Value(row), out);
+    } else if constexpr (std::is_same_v<Type, duration_type>) {
+      const auto x = duration{array.Value(row)};
+      if (tokens_.options.numeric_durations)
+        emit_double(
+          tokens_,
+          std::chrono::duration_cast<std::chrono::duration<double>>(x).count(),
+          out);
+      else
+        emit_quoted(tokens_, to_string(x), out);
+    } else if constexpr (std::is_same_v<Type, time_type>) {
+      emit_quoted(tokens_, to_string(time{} + duration{array.Value(row)}),
+                  out);
+    } else if constexpr (std::is_same_v<Type, string_type>) {
+      emit_string(tokens_, array.GetView(row), out);
+    } else if constexpr (std::is_same_v<Type, blob_type>) {
+      emit_string(tokens_, detail::base64::encode(array.GetView(row)), out);
+    } else if constexpr (detail::is_any_v<Type, ip_type, subnet_type>) {
+      emit_quoted(tokens_, to_string(value_at(type_, array, row)), out);
+    } else if constexpr (std::is_same_v<Type, enumeration_type>) {
+      const auto key = value_at(type_, array, row);
+      if (nested_)
+        emit_number(tokens_, key, out);
+      else
+        emit_string(tokens_, type_.field(key), out);
+    } else {
+      static_assert(detail::always_false_v<Type>, "unhandled type");
+    }
+  }
+
+  const tokens& tokens_;
+  Type type_;
+  bool nested_;
+};
+
+class list_column final : public column {
+public:
+  list_column(const tokens& tokens, std::unique_ptr<column> element,
+              size_t depth)
+    : tokens_{tokens},
+      element_{std::move(element)},
+      open_{tokens.array("[")},
+      first_{tokens.newline(depth + 1)},
+      next_{tokens.separator + tokens.newline(depth + 1)},
+      close_{tokens.newline(depth) + tokens.array("]")},
+      close_empty_{tokens.array("]")} {
+    // nop
+  }
+
+  auto bind(const arrow::Array& array) const
+    -> std::unique_ptr<cursor> override {
+    struct list_cursor final : cursor {
+      list_cursor(const list_column& column, const arrow::ListArray& array)
+        : column{column},
+          array{array},
+          element{column.element_->bind(*array.values())} {
+        // nop
+      }
+
+      auto emit(int64_t row, std::string& out) const -> bool override {
+        if (array.IsNull(row))
+          return emit_null(column.tokens_, out);
+        out += column.open_;
+        auto printed = false;
+        for (auto i = array.value_offset(row); i < array.value_offset(row + 1);
+             ++i) {
+          const auto size = out.size();
+          out += printed ? column.next_ : column.first_;
+          if (element->emit(i, out))
+            printed = true;
+          else
+            out.resize(size);
+        }
+        out += printed ? column.close_ : column.close_empty_;
+        return printed || !column.tokens_.options.omit_empty_lists;
+      }
+
+      const list_column& column;
+      const arrow::ListArray& array;
+      std::unique_ptr<cursor> element;
+    };
+    return std::make_unique<list_cursor>(
+      *this, static_cast<const arrow::ListArray&>(array));
+  }
+
+private:
+  const tokens& tokens_;
+  std::unique_ptr<column> element_;
+  std::string open_;
+  std::string first_;
+  std::string next_;
+  std::string close_;
+  std::string close_empty_;
+};
+
+/// Maps are printed as lists of records with the fields `key` and `value`.
+class map_column final : public column {
+public:
+  map_column(const tokens& tokens, std::unique_ptr<column> key,
+             std::unique_ptr<column> item, size_t depth)
+    : tokens_{tokens},
+      key_{std::move(key)},
+      item_{std::move(item)},
+      open_{tokens.array("[")},
+      first_{tokens.newline(depth + 1) + tokens.object("{")
+             + tokens.newline(depth + 2) + tokens.field("\"key\": ")},
+      next_{tokens.separator + first_},
+      between_{tokens.separator + tokens.newline(depth + 2)
+               + tokens.field("\"value\": ")},
+      item_close_{tokens.newline(depth + 1) + tokens.object("}")},
+      close_{tokens.newline(depth) + tokens.array("]")},
+      close_empty_{tokens.array("]")} {
+    // nop
+  }
+
+  auto bind(const arrow::Array& array) const
+    -> std::unique_ptr<cursor> override {
+    struct map_cursor final : cursor {
+      map_cursor(const map_column& column, const arrow::MapArray& array)
+        : column{column},
+          array{array},
+          key{column.key_->bind(*array.keys())},
+          item{column.item_->bind(*array.items())} {
+        // nop
+      }
+
+      auto emit(int64_t row, std::string& out) const -> bool override {
+        if (array.IsNull(row))
+          return emit_null(column.tokens_, out);
+        out += column.open_;
+        auto printed = false;
+        for (auto i = array.value_offset(row); i < array.value_offset(row + 1);
+             ++i) {
+          const auto size = out.size();
+          out += printed ? column.next_ : column.first_;
+          // Keys are never omitted.
+          (void)key->emit(i, out);
+          out += column.between_;
+          if (!item->emit(i, out)) {
+            out.resize(size);
+            continue;
+          }
+          out += column.item_close_;
+          printed = true;
+        }
+        out += printed ? column.close_ : column.close_empty_;
+        return printed || !column.tokens_.options.omit_empty_maps;
+      }
+
+      const map_column& column;
+      const arrow::MapArray& array;
+      std::unique_ptr<cursor> key;
+      std::unique_ptr<cursor> item;
+    };
+    return std::make_unique<map_cursor>(
+      *this, static_cast<const arrow::MapArray&>(array));
+  }
+
+private:
+  const tokens& tokens_;
+  std::unique_ptr<column> key_;
+  std::unique_ptr<column> item_;
+  std::string open_;
+  std::string first_;
+  std::string next_;
+  std::string between_;
+  std::string item_close_;
+  std::string close_;
+  std::string close_empty_;
+};
+
+class record_column final : public column {
+public:
+  /// A field of the record with the text that precedes its value, which is
+  /// the escaped key with the separator and indentation for the first field
+  /// and for all other fields.
+  struct field {
+    std::string first;
+    std::string next;
+    std::unique_ptr<column> value;
+  };
+
+  record_column(const tokens& tokens, std::vector<field> fields, size_t depth)
+    : tokens_{tokens},
+      fields_{std::move(fields)},
+      open_{tokens.object("{")},
+      close_{tokens.newline(depth) + tokens.object("}")},
+      close_empty_{tokens.object("}")} {
+    // nop
+  }
+
+  auto bind(const arrow::Array& array) const
+    -> std::unique_ptr<cursor> override {
+    struct record_cursor final : cursor {
+      record_cursor(const record_column& column, const arrow::StructArray& array)
+        : column{column}, array{array} {
+        TENZIR_ASSERT(column.fields_.size()
+                      == detail::narrow_cast<size_t>(array.num_fields()));
+        fields.reserve(column.fields_.size());
+        for (auto i = size_t{0}; i < column.fields_.size(); ++i)
+          fields.push_back(column.fields_[i].value->bind(
+            *array.field(detail::narrow_cast<int>(i))));
+      }
+
+      auto emit(int64_t row, std::string& out) const -> bool override {
+        if (array.IsNull(row))
+          return emit_null(column.tokens_, out);
+        out += column.open_;
+        auto printed = false;
+        for (auto i = size_t{0}; i < fields.size(); ++i) {
+          const auto size = out.size();
+          out += printed ? column.fields_[i].next : column.fields_[i].first;
+          if (fields[i]->emit(row, out))
+            printed = true;
+          else
+            out.resize(size);
+        }
+        out += printed ? column.close_ : column.close_empty_;
+        return printed || !column.tokens_.options.omit_empty_records;
+      }
+
+      const record_column& column;
+      const arrow::StructArray& array;
+      std::vector<std::unique_ptr<cursor>> fields;
+    };
+    return std::make_unique<record_cursor>(
+      *this, static_cast<const arrow::StructArray&>(array));
+  }
+
+private:
+  const tokens& tokens_;
+  std::vector<field> fields_;
+  std::string open_;
+  std::string close_;
+  std::string close_empty_;
+};
+
+/// Compiles the emission plan for a value of the given type.
+/// @param tokens The tokens of the plan.
+/// @param type The type of the value.
+/// @param depth The nesting depth of the value, which determines its
+/// indentation.
+/// @param nested Whether the value is part of a list or a map.
+auto make_column(const tokens& tokens, const type& type, size_t depth,
+                 bool nested) -> std::unique_ptr<column> {
+  auto f = detail::overload{
+    [&](const list_type& list) -> std::unique_ptr<column> {
+      return std::make_unique<list_column>(
+        tokens, make_column(tokens, list.value_type(), depth + 1, true), depth);
+    },
+    [&](const map_type& map) -> std::unique_ptr<column> {
+      return std::make_unique<map_column>(
+        tokens, make_column(tokens, map.key_type(), depth + 2, true),
+        make_column(tokens, map.value_type(), depth + 2, true), depth);
+    },
+    [&](const record_type& record) -> std::unique_ptr<column> {
+      auto fields = std::vector<record_column::field>{};
+      fields.reserve(record.num_fields());
+      for (const auto& field : record.fields()) {
+        const auto key = tokens.field(detail::json_escape(field.name))
+                         + tokens.object(": ");
+        fields.push_back({
+          tokens.newline(depth + 1) + key,
+          tokens.separator + tokens.newline(depth + 1) + key,
+          make_column(tokens, field.type, depth + 1, nested),
+        });
+      }
+      return std::make_unique<record_column>(tokens, std::move(fields), depth);
+    },
+    [&]<concrete_type Type>(const Type& x) -> std::unique_ptr<column> {
+      return std::make_unique<scalar_column<Type>>(tokens, x, nested);
+    },
+  };
+  return caf::visit(f, type);
+}
+
+/// The root of the emission plan, which owns the tokens that all columns
+/// refer to.
+class root_column final : public column {
+public:
+  root_column(const type& schema, const json_printer_options& options)
+    : tokens_{options}, record_{make_column(tokens_, schema, 0, false)} {
+    // nop
+  }
+
+  auto bind(const arrow::Array& array) const
+    -> std::unique_ptr<cursor> override {
+    return record_->bind(array);
+  }
+
+private:
+  tokens tokens_;
+  std::unique_ptr<column> record_;
+};
+
+} // namespace
+
+compiled_json_printer::compiled_json_printer(
+  type schema, const json_printer_options& options)
+  : schema_{std::move(schema)},
+    root_{std::make_shared<root_column>(schema_, options)} {
+  TENZIR_ASSERT(caf::holds_alternative<record_type>(schema_));
+  TENZIR_ASSERT(!options.flattened);
+}
+
+auto compiled_json_printer::schema() const -> const type& {
+  return schema_;
+}
+
+void compiled_json_printer::print(const table_slice& slice,
+                                  std::string& out) const {
+  print(slice, 0, detail::narrow_cast<int64_t>(slice.rows()), out);
+}
+
+void compiled_json_printer::print(const table_slice& slice, int64_t begin,
+                                  int64_t end, std::string& out) const {
+  TENZIR_ASSERT(slice.schema() == schema_);
+  TENZIR_ASSERT(begin <= end);
+  TENZIR_ASSERT(end <= detail::narrow_cast<int64_t>(slice.rows()));
+  if (begin == end)
+    return;
+  const auto array = to_record_batch(slice)->ToStructArray().ValueOrDie();
+  const auto cursor = root_->bind(*array);
+  for (auto row = begin; row < end; ++row) {
+    (void)cursor->emit(row, out);
+    out += '\n';
+  }
+}
+
+} // namespace tenzir
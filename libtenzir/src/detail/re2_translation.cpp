@@ -0,0 +1,300 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/detail/re2_translation.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace tenzir::detail {
+
+auto translate_to_re2(std::string_view pattern, bool indexed_captures,
+                      bool relax_repetitions) -> re2_translation {
+  auto result = re2_translation{};
+  result.regex.reserve(pattern.size());
+  auto group = 0;
+  // For every group we're in, whether it's a lookaround assertion
+  auto assertions = std::vector<bool>{};
+  // The literal is only required if there are no alternatives at the top level,
+  // and no flags that may change how characters match
+  auto literal_is_required = true;
+  // The run of literal characters at the top level we're currently in,
+  // and whether the previous atom is part of that run
+  auto run = std::string{};
+  auto previous_is_literal = false;
+  const auto end_run = [&] {
+    if (run.size() > result.literal.size())
+      result.literal = run;
+    run.clear();
+    previous_is_literal = false;
+  };
+  const auto add_literal = [&](char c) {
+    if (not assertions.empty())
+      return;
+    run += c;
+    previous_is_literal = true;
+  };
+  // Returns the length of the repetition `{n}`, `{n,}`, or `{n,m}` at `pos`,
+  // or 0 if it's a literal '{'
+  const auto repetition_length = [&](size_t pos) -> size_t {
+    const auto end = pattern.find('}', pos);
+    if (end == std::string_view::npos or end == pos + 1)
+      return 0;
+    const auto body = pattern.substr(pos + 1, end - pos - 1);
+    if (not std::isdigit(static_cast<unsigned char>(body[0])))
+      return 0;
+    if (not std::ranges::all_of(body, [](char c) {
+          return std::isdigit(static_cast<unsigned char>(c)) or c == ',';
+        }))
+      return 0;
+    return end - pos + 1;
+  };
+  // Returns the length of the escape sequence at `pos`, which consists of a
+  // backslash followed by a letter or digit, and possibly an argument like the
+  // hex digits of `\x41`, the braces of `\x{41}` and `\p{L}`, or the digits
+  // of an octal escape or backreference
+  const auto escape_length = [&](size_t pos) -> size_t {
+    const auto is_digit = [](char c) {
+      return std::isdigit(static_cast<unsigned char>(c)) != 0;
+    };
+    const auto is_xdigit = [](char c) {
+      return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+    };
+    // Returns the position after the closing delimiter of the argument at
+    // `at`, or `at` if there is no argument with the given delimiters
+    const auto delimited = [&](size_t at, std::string_view open,
+                               std::string_view close) -> size_t {
+      if (at == pattern.size())
+        return at;
+      const auto kind = open.find(pattern[at]);
+      if (kind == std::string_view::npos)
+        return at;
+      const auto end = pattern.find(close[kind], at + 1);
+      return end == std::string_view::npos ? pattern.size() : end + 1;
+    };
+    auto end = pos + 2;
+    switch (pattern[pos + 1]) {
+      case 'x':
+        if (const auto braced = delimited(end, "{", "}"); braced != end)
+          return braced - pos;
+        while (end < pattern.size() and end < pos + 4
+               and is_xdigit(pattern[end]))
+          ++end;
+        return end - pos;
+      case 'p':
+      case 'P':
+        if (const auto braced = delimited(end, "{", "}"); braced != end)
+          return braced - pos;
+        return std::min(end + 1, pattern.size()) - pos;
+      case 'c':
+        return std::min(end + 1, pattern.size()) - pos;
+      case 'N':
+      case 'o':
+        return delimited(end, "{", "}") - pos;
+      case 'k':
+        return delimited(end, "<{'", ">}'") - pos;
+      case 'g':
+        if (const auto braced = delimited(end, "{", "}"); braced != end)
+          return braced - pos;
+        if (end < pattern.size() and pattern[end] == '-')
+          ++end;
+        while (end < pattern.size() and is_digit(pattern[end]))
+          ++end;
+        return end - pos;
+      default:
+        // Octal escapes and backreferences consist of digits only, everything
+        // else is a single letter
+        if (is_digit(pattern[pos + 1]))
+          while (end < pattern.size() and is_digit(pattern[end]))
+            ++end;
+        return end - pos;
+    }
+  };
+  auto i = size_t{0};
+  while (i < pattern.size()) {
+    const auto c = pattern[i];
+    switch (c) {
+      case '\\': {
+        if (i + 1 == pattern.size()) {
+          result.regex += c;
+          ++i;
+          break;
+        }
+        const auto next = pattern[i + 1];
+        if (next == 'Q') {
+          // Quoted sequences are copied verbatim
+          end_run();
+          auto end = pattern.find("\\E", i + 2);
+          end = end == std::string_view::npos ? pattern.size() : end + 2;
+          result.regex.append(pattern.substr(i, end - i));
+          i = end;
+          break;
+        }
+        // Escaped letters and digits start character classes, anchors,
+        // backreferences, or escape sequences for single characters, which
+        // may consist of more characters than the letter, everything else is
+        // an escaped literal
+        if (std::isalnum(static_cast<unsigned char>(next))) {
+          const auto length = escape_length(i);
+          result.regex.append(pattern.substr(i, length));
+          i += length;
+          end_run();
+        } else {
+          result.regex.append(pattern.substr(i, 2));
+          i += 2;
+          add_literal(next);
+        }
+        break;
+      }
+      case '[': {
+        end_run();
+        const auto begin = i++;
+        if (i < pattern.size() and pattern[i] == '^')
+          ++i;
+        if (i < pattern.size() and pattern[i] == ']')
+          ++i;
+        while (i < pattern.size() and pattern[i] != ']') {
+          if (pattern[i] == '\\') {
+            i += 2;
+          } else if (pattern.substr(i, 2) == "[:") {
+            const auto end = pattern.find(":]", i + 2);
+            i = end == std::string_view::npos ? i + 1 : end + 2;
+          } else {
+            ++i;
+          }
+        }
+        i = std::min(i + 1, pattern.size());
+        result.regex.append(pattern.substr(begin, i - begin));
+        break;
+      }
+      case '(': {
+        end_run();
+        const auto rest = pattern.substr(i);
+        auto name_begin = std::string_view::npos;
+        auto name_end = char{};
+        if (rest.starts_with("(?P<")) {
+          name_begin = i + 4;
+          name_end = '>';
+        } else if (rest.starts_with("(?<") and not rest.starts_with("(?<=")
+                   and not rest.starts_with("(?<!")) {
+          name_begin = i + 3;
+          name_end = '>';
+        } else if (rest.starts_with("(?'")) {
+          name_begin = i + 3;
+          name_end = '\'';
+        }
+        if (name_begin != std::string_view::npos) {
+          const auto end = pattern.find(name_end, name_begin);
+          if (end != std::string_view::npos) {
+            result.groups.emplace_back(
+              std::string{pattern.substr(name_begin, end - name_begin)},
+              ++group);
+            result.regex += '(';
+            assertions.push_back(false);
+            i = end + 1;
+            break;
+          }
+        }
+        const auto is_assertion
+          = rest.starts_with("(?=") or rest.starts_with("(?!")
+            or rest.starts_with("(?<=") or rest.starts_with("(?<!");
+        assertions.push_back(is_assertion);
+        if (is_assertion) {
+          // Repeating the assertion zero times keeps the numbering of the
+          // capture groups inside of it intact
+          result.regex += "(?:";
+          i += rest.starts_with("(?<") ? 4 : 3;
+        } else if (rest.starts_with("(?>")) {
+          result.regex += "(?:";
+          i += 3;
+        } else if (rest.starts_with("(?")) {
+          if (not rest.starts_with("(?:"))
+            literal_is_required = false;
+          result.regex += "(?";
+          i += 2;
+        } else if (indexed_captures) {
+          ++group;
+          result.regex += '(';
+          ++i;
+        } else {
+          result.regex += "(?:";
+          ++i;
+        }
+        break;
+      }
+      case ')':
+        end_run();
+        result.regex += c;
+        ++i;
+        if (not assertions.empty()) {
+          if (assertions.back())
+            result.regex += "{0}";
+          assertions.pop_back();
+        }
+        break;
+      case '|':
+        if (assertions.empty())
+          literal_is_required = false;
+        end_run();
+        result.regex += c;
+        ++i;
+        break;
+      case '?':
+      case '*':
+      case '+':
+      case '{': {
+        const auto length = c == '{' ? repetition_length(i) : size_t{1};
+        if (length == 0) {
+          add_literal(c);
+          result.regex += c;
+          ++i;
+          break;
+        }
+        // Except for '+', the quantifier makes the previous atom optional
+        if (previous_is_literal and c != '+')
+          run.pop_back();
+        end_run();
+        const auto quantifier = pattern.substr(i, length);
+        const auto comma = quantifier.find(',');
+        if (relax_repetitions and comma != std::string_view::npos) {
+          result.regex.append(quantifier.substr(0, comma + 1));
+          result.regex += '}';
+        } else {
+          result.regex.append(quantifier);
+        }
+        i += length;
+        if (i < pattern.size() and pattern[i] == '?') {
+          result.regex += '?';
+          ++i;
+        } else if (i < pattern.size() and pattern[i] == '+') {
+          // Drop the '+' of possessive quantifiers
+          ++i;
+        }
+        break;
+      }
+      case '.':
+      case '^':
+      case '$':
+        end_run();
+        result.regex += c;
+        ++i;
+        break;
+      default:
+        add_literal(c);
+        result.regex += c;
+        ++i;
+        break;
+    }
+  }
+  end_run();
+  if (not literal_is_required)
+    result.literal.clear();
+  return result;
+}
+
+} // namespace tenzir::detail
@@ -44,19 +44,53 @@ std::string control_char_escape(std::string_view str) {
   return result;
 }
 
+namespace {
+
+/// The number of bytes that we check at once when escaping JSON.
+constexpr auto json_escape_block_size = size_t{16};
+
+/// Checks whether a block of `json_escape_block_size` bytes contains a byte
+/// that requires escaping in JSON. The loop has no branches, so the compiler
+/// can turn it into a few vector instructions.
+bool requires_json_escape(const char* block) {
+  auto result = false;
+  for (auto i = size_t{0}; i < json_escape_block_size; ++i) {
+    const auto c = static_cast<unsigned char>(block[i]);
+    result |= (c < 0x20) | (c == '"') | (c == '\\') | (c == 0x7f);
+  }
+  return result;
+}
+
+} // namespace
+
 std::string json_escape(std::string_view str) {
-  if (str.empty())
-    return "\"\"";
   std::string result;
-  result.reserve(str.size() + 2);
-  result += '"';
+  json_escape(str, result);
+  return result;
+}
+
+void json_escape(std::string_view str, std::string& out) {
+  out.reserve(out.size() + str.size() + 2);
+  out += '"';
   auto f = str.begin();
   auto l = str.end();
-  auto out = std::back_inserter(result);
+  auto it = std::back_inserter(out);
+  // Most strings contain few or no characters that need escaping, so we copy
+  // entire blocks when possible and only escape the blocks that need it byte
+  // by byte.
+  while (static_cast<size_t>(l - f) >= json_escape_block_size) {
+    const auto block_end = f + json_escape_block_size;
+    if (!requires_json_escape(&*f)) {
+      out.append(f, block_end);
+      f = block_end;
+      continue;
+    }
+    while (f != block_end)
+      json_escaper(f, it);
+  }
   while (f != l)
-    json_escaper(f, out);
-  result += '"';
-  return result;
+    json_escaper(f, it);
+  out += '"';
 }
 
 std::string json_unescape(std::string_view str) {
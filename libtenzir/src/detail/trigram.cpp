@@ -0,0 +1,323 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/detail/trigram.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace tenzir::detail {
+
+namespace {
+
+/// The kind of the last atom that the literal extraction consumed, which
+/// determines the effect of a subsequent quantifier.
+enum class atom {
+  none,
+  literal,
+  group,
+  other,
+};
+
+void sort_unique(std::vector<trigram>& xs) {
+  std::sort(xs.begin(), xs.end());
+  xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+}
+
+} // namespace
+
+std::vector<trigram> trigrams(std::string_view str) {
+  auto result = std::vector<trigram>{};
+  if (str.size() < 3)
+    return result;
+  result.reserve(str.size() - 2);
+  each_trigram(str, [&](trigram x) {
+    result.push_back(x);
+  });
+  sort_unique(result);
+  return result;
+}
+
+std::vector<std::string>
+required_literals(std::string_view regex, bool case_insensitive) {
+  auto result = std::vector<std::string>{};
+  auto run = std::string{};
+  auto last = atom::none;
+  // The size of the result at the beginning of every open group, and of the
+  // group that was closed last.
+  auto groups = std::vector<size_t>{};
+  auto closed_group = size_t{0};
+  // Literals shorter than a trigram do not help narrowing down the matches.
+  auto flush = [&] {
+    if (run.size() >= 3)
+      result.push_back(std::move(run));
+    run.clear();
+  };
+  auto append = [&](char c) {
+    // RE2 folds case according to Unicode, which maps 'k' and 's' to the
+    // Kelvin sign and the long s as well. We cannot express these with
+    // trigrams, so we treat them and all non-ASCII bytes like wildcards.
+    auto lower = std::tolower(static_cast<unsigned char>(c));
+    if (case_insensitive
+        && (static_cast<unsigned char>(c) >= 0x80 || lower == 'k'
+            || lower == 's')) {
+      flush();
+      last = atom::other;
+      return;
+    }
+    run.push_back(c);
+    last = atom::literal;
+  };
+  auto i = size_t{0};
+  auto at = [&](size_t j) {
+    return j < regex.size() ? regex[j] : '\0';
+  };
+  // Applies a quantifier to the last atom. The first repetition of an atom is
+  // mandatory for `+` and `{n,m}` with n > 0; everything else is optional.
+  auto quantify = [&](bool optional) {
+    switch (last) {
+      case atom::none:
+        return false;
+      case atom::literal:
+        if (optional)
+          run.pop_back();
+        flush();
+        break;
+      case atom::group:
+        if (optional)
+          result.resize(closed_group);
+        break;
+      case atom::other:
+        break;
+    }
+    // Skip the non-greedy modifier.
+    if (at(i) == '?')
+      ++i;
+    last = atom::other;
+    return true;
+  };
+  while (i < regex.size()) {
+    auto c = regex[i++];
+    switch (c) {
+      case '|':
+        // An alternation makes every literal optional.
+        return {};
+      case '.':
+      case '^':
+      case '$':
+        flush();
+        last = atom::other;
+        break;
+      case '?':
+      case '*':
+        if (!quantify(true))
+          return {};
+        break;
+      case '+':
+        if (!quantify(false))
+          return {};
+        break;
+      case '{': {
+        auto close = regex.find('}', i);
+        if (close == std::string_view::npos)
+          return {};
+        auto min = regex.substr(i, close - i);
+        min = min.substr(0, min.find(','));
+        if (min.empty()
+            || !std::all_of(min.begin(), min.end(), [](char x) {
+                 return std::isdigit(static_cast<unsigned char>(x));
+               }))
+          return {};
+        auto optional = std::all_of(min.begin(), min.end(), [](char x) {
+          return x == '0';
+        });
+        i = close + 1;
+        if (!quantify(optional))
+          return {};
+        break;
+      }
+      case '[': {
+        // Skip over the character class.
+        auto j = i;
+        if (at(j) == '^')
+          ++j;
+        if (at(j) == ']')
+          ++j;
+        while (j < regex.size() && regex[j] != ']') {
+          if (regex[j] == '\\') {
+            j += 2;
+          } else if (regex[j] == '[' && at(j + 1) == ':') {
+            auto close = regex.find(":]", j + 2);
+            if (close == std::string_view::npos)
+              return {};
+            j = close + 2;
+          } else {
+            ++j;
+          }
+        }
+        if (j >= regex.size())
+          return {};
+        i = j + 1;
+        flush();
+        last = atom::other;
+        break;
+      }
+      case '(': {
+        flush();
+        last = atom::other;
+        if (at(i) == '?') {
+          // Parse flags, non-capturing groups, and named groups.
+          auto j = i + 1;
+          while (j < regex.size() && regex[j] != ':' && regex[j] != ')'
+                 && regex[j] != '<')
+            ++j;
+          if (j >= regex.size())
+            return {};
+          if (regex.substr(i, j - i).find('i') != std::string_view::npos)
+            case_insensitive = true;
+          if (regex[j] == '<') {
+            j = regex.find('>', j);
+            if (j == std::string_view::npos)
+              return {};
+          }
+          i = j + 1;
+          if (regex[j] == ')')
+            break;
+        }
+        groups.push_back(result.size());
+        break;
+      }
+      case ')':
+        if (groups.empty())
+          return {};
+        flush();
+        closed_group = groups.back();
+        groups.pop_back();
+        last = atom::group;
+        break;
+      case '\\': {
+        if (i >= regex.size())
+          return {};
+        auto e = regex[i++];
+        if (!std::isalnum(static_cast<unsigned char>(e))) {
+          append(e);
+          break;
+        }
+        switch (e) {
+          default:
+            // Unknown escape sequences are syntax errors in RE2.
+            return {};
+          case 'a':
+            append('\a');
+            break;
+          case 'f':
+            append('\f');
+            break;
+          case 'n':
+            append('\n');
+            break;
+          case 'r':
+            append('\r');
+            break;
+          case 't':
+            append('\t');
+            break;
+          case 'v':
+            append('\v');
+            break;
+          case 'Q': {
+            auto close = regex.find("\\E", i);
+            auto quoted = regex.substr(i, close - i);
+            for (auto q : quoted)
+              append(q);
+            i = close == std::string_view::npos ? regex.size() : close + 2;
+            break;
+          }
+          case 'p':
+          case 'P':
+          case 'x':
+            // Skip a Unicode class or a hexadecimal character code.
+            if (at(i) == '{') {
+              auto close = regex.find('}', i);
+              if (close == std::string_view::npos)
+                return {};
+              i = close + 1;
+            } else {
+              i += e == 'x' ? 2 : 1;
+            }
+            flush();
+            last = atom::other;
+            break;
+          case '0':
+          case '1':
+          case '2':
+          case '3':
+          case '4':
+          case '5':
+          case '6':
+          case '7':
+            // Skip an octal character code.
+            while (i < regex.size() && regex[i] >= '0' && regex[i] <= '7')
+              ++i;
+            flush();
+            last = atom::other;
+            break;
+          case 'A':
+          case 'b':
+          case 'B':
+          case 'C':
+          case 'd':
+          case 'D':
+          case 's':
+          case 'S':
+          case 'w':
+          case 'W':
+          case 'z':
+            flush();
+            last = atom::other;
+            break;
+        }
+        break;
+      }
+      default:
+        append(c);
+        break;
+    }
+  }
+  if (!groups.empty())
+    return {};
+  flush();
+  return result;
+}
+
+std::optional<std::vector<trigram>>
+required_trigrams(relational_operator op, data_view rhs) {
+  auto result = std::vector<trigram>{};
+  if (const auto* str = caf::get_if<view<std::string>>(&rhs)) {
+    // Both `x == "foo"` and `x ni "foo"` imply that x contains "foo".
+    if (op == relational_operator::equal || op == relational_operator::ni)
+      result = trigrams(*str);
+  } else if (const auto* pat = caf::get_if<view<pattern>>(&rhs)) {
+    // `x == /re/` matches the entire string and `x in /re/` searches for a
+    // match, so either way x contains the literals of the pattern.
+    if (op == relational_operator::equal || op == relational_operator::in) {
+      const auto literals
+        = required_literals(pat->string(), pat->case_insensitive());
+      for (const auto& literal : literals)
+        each_trigram(literal, [&](trigram x) {
+          result.push_back(x);
+        });
+      sort_unique(result);
+    }
+  }
+  if (result.empty())
+    return std::nullopt;
+  return result;
+}
+
+} // namespace tenzir::detail
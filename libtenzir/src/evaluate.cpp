@@ -9,6 +9,7 @@
 #include "tenzir/arrow_table_slice.hpp"
 #include "tenzir/bitmap_algorithms.hpp"
 #include "tenzir/detail/assert.hpp"
+#include "tenzir/detail/narrow.hpp"
 #include "tenzir/detail/overload.hpp"
 #include "tenzir/detail/passthrough.hpp"
 #include "tenzir/expression.hpp"
@@ -17,9 +18,15 @@
 #include "tenzir/table_slice.hpp"
 #include "tenzir/type.hpp"
 
+#include <arrow/array.h>
+#include <arrow/builder.h>
+#include <arrow/compute/api.h>
+#include <arrow/extension_type.h>
 #include <arrow/record_batch.h>
+#include <arrow/scalar.h>
 
 #include <cstddef>
+#include <limits>
 #include <regex>
 #include <span>
 
@@ -419,6 +426,247 @@ bool evaluate_meta_extractor(const table_slice& slice,
   __builtin_unreachable();
 }
 
+// -- vectorized evaluation ---------------------------------------------------
+
+using mask_ptr = std::shared_ptr<arrow::BooleanArray>;
+
+/// Invokes an Arrow compute function that returns a boolean array. Returns
+/// `nullptr` if the function has no kernel for the given arguments.
+mask_ptr try_call(const std::string& function,
+                  const std::vector<arrow::Datum>& args,
+                  const arrow::compute::FunctionOptions* options = nullptr) {
+  auto result = arrow::compute::CallFunction(function, args, options);
+  if (!result.ok())
+    return nullptr;
+  return std::static_pointer_cast<arrow::BooleanArray>(result->make_array());
+}
+
+/// Invokes an Arrow compute function that must have a kernel for the given
+/// arguments.
+mask_ptr call(const std::string& function,
+              const std::vector<arrow::Datum>& args) {
+  auto result = try_call(function, args);
+  TENZIR_ASSERT(result);
+  return result;
+}
+
+mask_ptr make_constant_mask(bool value, int64_t length) {
+  auto result = arrow::MakeArrayFromScalar(arrow::BooleanScalar{value}, length)
+                  .ValueOrDie();
+  return std::static_pointer_cast<arrow::BooleanArray>(result);
+}
+
+/// Converts the result of the row-wise evaluation into a mask.
+mask_ptr make_mask(const ids& selection, id offset, int64_t length) {
+  auto values = std::vector<uint8_t>(detail::narrow_cast<size_t>(length), 0);
+  for (auto id : select(selection)) {
+    TENZIR_ASSERT(id >= offset);
+    values[id - offset] = 1;
+  }
+  auto builder = arrow::BooleanBuilder{};
+  TENZIR_ASSERT_CHEAP(builder.AppendValues(values.data(), length).ok());
+  auto result = std::shared_ptr<arrow::BooleanArray>{};
+  TENZIR_ASSERT_CHEAP(builder.Finish(&result).ok());
+  return result;
+}
+
+/// Returns the name of the Arrow compute function that implements a
+/// comparison, if any.
+const char* comparison_function(relational_operator op) {
+  switch (op) {
+    case relational_operator::equal:
+      return "equal";
+    case relational_operator::not_equal:
+      return "not_equal";
+    case relational_operator::less:
+      return "less";
+    case relational_operator::less_equal:
+      return "less_equal";
+    case relational_operator::greater:
+      return "greater";
+    case relational_operator::greater_equal:
+      return "greater_equal";
+    default:
+      return nullptr;
+  }
+}
+
+std::shared_ptr<arrow::Scalar> make_ip_scalar(const ip& value) {
+  const auto bytes = as_bytes(value);
+  return std::make_shared<arrow::FixedSizeBinaryScalar>(
+    arrow::Buffer::FromString(
+      std::string{reinterpret_cast<const char*>(bytes.data()), bytes.size()}),
+    arrow::fixed_size_binary(16));
+}
+
+/// Converts the operand of a predicate into a scalar that can be compared with
+/// the storage array of the column without changing the semantics of the
+/// comparison in the row-wise evaluation. Returns `nullptr` if there is no
+/// such scalar.
+std::shared_ptr<arrow::Scalar>
+make_scalar(const type& type, const arrow::Array& storage, const data& rhs) {
+  constexpr auto int64_max
+    = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  const auto f = detail::overload{
+    [](const auto&, const auto&) -> std::shared_ptr<arrow::Scalar> {
+      return nullptr;
+    },
+    [](const int64_type&, int64_t rhs) -> std::shared_ptr<arrow::Scalar> {
+      return std::make_shared<arrow::Int64Scalar>(rhs);
+    },
+    [&](const int64_type&, uint64_t rhs) -> std::shared_ptr<arrow::Scalar> {
+      if (rhs > int64_max)
+        return nullptr;
+      return std::make_shared<arrow::Int64Scalar>(static_cast<int64_t>(rhs));
+    },
+    [](const uint64_type&, uint64_t rhs) -> std::shared_ptr<arrow::Scalar> {
+      return std::make_shared<arrow::UInt64Scalar>(rhs);
+    },
+    [](const uint64_type&, int64_t rhs) -> std::shared_ptr<arrow::Scalar> {
+      if (rhs < 0)
+        return nullptr;
+      return std::make_shared<arrow::UInt64Scalar>(static_cast<uint64_t>(rhs));
+    },
+    // Comparisons of integers with doubles convert the integers to doubles
+    // in the row-wise evaluation, and Arrow does the same.
+    []<class Type>(const Type&, double rhs) -> std::shared_ptr<arrow::Scalar>
+      requires detail::is_any_v<Type, int64_type, uint64_type, double_type>
+    {
+      return std::make_shared<arrow::DoubleScalar>(rhs);
+    },
+    []<class Rhs>(const double_type&, Rhs rhs) -> std::shared_ptr<arrow::Scalar>
+      requires detail::is_any_v<Rhs, int64_t, uint64_t>
+    {
+      return std::make_shared<arrow::DoubleScalar>(static_cast<double>(rhs));
+    },
+    [](const bool_type&, bool rhs) -> std::shared_ptr<arrow::Scalar> {
+      return std::make_shared<arrow::BooleanScalar>(rhs);
+    },
+    [&](const duration_type&, duration rhs) -> std::shared_ptr<arrow::Scalar> {
+      return std::make_shared<arrow::DurationScalar>(rhs.count(),
+                                                     storage.type());
+    },
+    [&](const time_type&, time rhs) -> std::shared_ptr<arrow::Scalar> {
+      return std::make_shared<arrow::TimestampScalar>(
+        rhs.time_since_epoch().count(), storage.type());
+    },
+    [](const string_type&, const std::string& rhs)
+      -> std::shared_ptr<arrow::Scalar> {
+      return std::make_shared<arrow::StringScalar>(rhs);
+    },
+    [](const ip_type&, const ip& rhs) -> std::shared_ptr<arrow::Scalar> {
+      return make_ip_scalar(rhs);
+    },
+  };
+  return caf::visit(f, type, rhs);
+}
+
+/// Evaluates a predicate on a column with Arrow compute kernels. Returns
+/// `nullptr` if there are no kernels for the combination of column type,
+/// operator, and operand.
+mask_ptr evaluate_column(const type& type, const arrow::Array& array,
+                         relational_operator op, const data& rhs) {
+  // Extension types have no kernels, so we operate on their storage.
+  const auto storage
+    = array.type_id() == arrow::Type::EXTENSION
+        ? static_cast<const arrow::ExtensionArray&>(array).storage()
+        : arrow::MakeArray(array.data());
+  const auto length = storage->length();
+  // Comparisons with null only look at the validity bitmap.
+  if (caf::holds_alternative<caf::none_t>(rhs)) {
+    switch (op) {
+      case relational_operator::equal:
+        return call("is_null", {storage});
+      case relational_operator::not_equal:
+        return call("is_valid", {storage});
+      default:
+        return make_constant_mask(false, length);
+    }
+  }
+  auto negate = false;
+  if (op == relational_operator::not_in) {
+    op = relational_operator::in;
+    negate = true;
+  } else if (op == relational_operator::not_ni) {
+    op = relational_operator::ni;
+    negate = true;
+  }
+  auto result = mask_ptr{};
+  if (const auto* pattern = caf::get_if<tenzir::pattern>(&rhs)) {
+    if (!caf::holds_alternative<string_type>(type))
+      return nullptr;
+    // Patterns match exactly for equality, and search otherwise. Both Arrow
+    // and our patterns use RE2, so the syntax is identical.
+    auto regex = pattern->string();
+    if (op == relational_operator::equal
+        || op == relational_operator::not_equal)
+      regex = fmt::format("^(?:{})$", regex);
+    else if (op != relational_operator::in)
+      return nullptr;
+    const auto options = arrow::compute::MatchSubstringOptions{
+      std::move(regex), pattern->options().case_insensitive};
+    result = try_call("match_substring_regex", {storage}, &options);
+    if (result && op == relational_operator::not_equal)
+      negate = !negate;
+  } else if (const auto* subnet = caf::get_if<tenzir::subnet>(&rhs)) {
+    if (!caf::holds_alternative<ip_type>(type) || op != relational_operator::in)
+      return nullptr;
+    // An address is in a subnet if it lies between the lowest and the highest
+    // address of the subnet.
+    auto lowest = subnet->network();
+    lowest.mask(subnet->length());
+    auto highest_bytes = ip::byte_array{};
+    const auto lowest_bytes = as_bytes<ip::byte_type>(lowest);
+    for (auto i = size_t{0}; i < highest_bytes.size(); ++i) {
+      const auto bit = i * 8;
+      const auto host_bits
+        = bit >= subnet->length() ? uint8_t{0xff}
+          : bit + 8 <= subnet->length()
+            ? uint8_t{0}
+            : static_cast<uint8_t>(0xff >> (subnet->length() - bit));
+      highest_bytes[i] = lowest_bytes[i] | host_bits;
+    }
+    const auto lower
+      = try_call("greater_equal", {storage, make_ip_scalar(lowest)});
+    const auto highest = ip::v6(std::span{highest_bytes});
+    const auto upper
+      = try_call("less_equal", {storage, make_ip_scalar(highest)});
+    if (!lower || !upper)
+      return nullptr;
+    result = call("and", {lower, upper});
+  } else if (const auto* elements = caf::get_if<list>(&rhs)) {
+    if (op != relational_operator::in)
+      return nullptr;
+    auto builder = arrow::MakeBuilder(storage->type()).ValueOrDie();
+    for (const auto& element : *elements) {
+      const auto scalar = make_scalar(type, *storage, element);
+      if (!scalar || !scalar->type->Equals(*storage->type()))
+        return nullptr;
+      TENZIR_ASSERT_CHEAP(builder->AppendScalar(*scalar).ok());
+    }
+    const auto value_set = builder->Finish().ValueOrDie();
+    const auto options = arrow::compute::SetLookupOptions{value_set, true};
+    result = try_call("is_in", {storage}, &options);
+  } else if (const auto* function = comparison_function(op)) {
+    const auto scalar = make_scalar(type, *storage, rhs);
+    if (!scalar)
+      return nullptr;
+    result = try_call(function, {storage, scalar});
+  } else if (op == relational_operator::ni
+             && caf::holds_alternative<string_type>(type)
+             && caf::holds_alternative<std::string>(rhs)) {
+    const auto options
+      = arrow::compute::MatchSubstringOptions{caf::get<std::string>(rhs)};
+    result = try_call("match_substring", {storage}, &options);
+  }
+  if (!result)
+    return nullptr;
+  if (negate)
+    result = call("invert", {result});
+  // Null values never match a predicate, not even a negated one.
+  return call("and_kleene", {result, call("is_valid", {storage})});
+}
+
 } // namespace
 
 // Expression evaluation takes place in multiple resolution steps:
@@ -551,4 +799,77 @@ ids evaluate(const expression& expr, const table_slice& slice,
   return result;
 }
 
+// Vectorized evaluation follows the same steps as the row-wise evaluation,
+// but produces one Arrow boolean array per expression node instead of a
+// bitmap. Predicates on columns map to Arrow compute kernels where their
+// semantics are identical to the row-wise evaluation, and fall back to the
+// row-wise evaluation otherwise. Masks never contain nulls, so that negations
+// behave like the XOR of the row-wise evaluation.
+std::shared_ptr<arrow::BooleanArray>
+evaluate_vectorized(const expression& expr, const table_slice& slice) {
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  const auto num_rows = detail::narrow_cast<int64_t>(slice.rows());
+  const auto evaluate_predicate = detail::overload{
+    [](const auto&, relational_operator, const auto&) -> mask_ptr {
+      die("predicates must be normalized and bound for evaluation");
+    },
+    [&](const meta_extractor& lhs, relational_operator op,
+        const data& rhs) -> mask_ptr {
+      return make_constant_mask(evaluate_meta_extractor(slice, lhs, op, rhs),
+                                num_rows);
+    },
+    [&](const data_extractor& lhs, relational_operator op,
+        const data& rhs) -> mask_ptr {
+      const auto index
+        = caf::get<record_type>(slice.schema()).resolve_flat_index(lhs.column);
+      const auto type_and_array = index.get(slice);
+      TENZIR_ASSERT(type_and_array.second);
+      if (auto result = evaluate_column(type_and_array.first,
+                                        *type_and_array.second, op, rhs))
+        return result;
+      // There is no kernel for this predicate, so we evaluate it row-wise.
+      const auto selection
+        = evaluate(expression{predicate{lhs, op, rhs}}, slice, {});
+      return make_mask(selection, offset, num_rows);
+    },
+  };
+  const auto evaluate_expression
+    = [&](const auto& self, const expression& expr) -> mask_ptr {
+    const auto evaluate_expression_impl = detail::overload{
+      [&](const caf::none_t&) {
+        return make_constant_mask(false, num_rows);
+      },
+      [&](const negation& negation) {
+        return call("invert", {self(self, negation.expr())});
+      },
+      [&](const conjunction& conjunction) {
+        auto result = make_constant_mask(true, num_rows);
+        for (const auto& connective : conjunction) {
+          if (result->true_count() == 0)
+            break;
+          result = call("and", {result, self(self, connective)});
+        }
+        return result;
+      },
+      [&](const disjunction& disjunction) {
+        auto result = make_constant_mask(false, num_rows);
+        for (const auto& connective : disjunction) {
+          if (result->true_count() == num_rows)
+            break;
+          result = call("or", {result, self(self, connective)});
+        }
+        return result;
+      },
+      [&](const predicate& predicate) {
+        return caf::visit(evaluate_predicate, predicate.lhs,
+                          detail::passthrough(predicate.op), predicate.rhs);
+      },
+    };
+    return caf::visit(evaluate_expression_impl, expr);
+  };
+  auto result = evaluate_expression(evaluate_expression, expr);
+  TENZIR_ASSERT(result->length() == num_rows);
+  return result;
+}
+
 } // namespace tenzir
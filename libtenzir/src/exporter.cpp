@@ -183,7 +183,8 @@ void handle_batch(exporter_actor::stateful_pointer<exporter_state> self,
     // No rows qualify.
     return;
   }
-  for (auto&& selected : select(slice, expression{}, selection)) {
+  for (auto&& selected :
+       select(slice, expression{}, selection, select_mode::adaptive)) {
     provide_to_source(self, std::move(selected));
   }
   TENZIR_DEBUG("{} continues execution because of input stream batch", *self);
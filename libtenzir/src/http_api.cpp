@@ -297,6 +297,15 @@ auto rest_response::from_json_string(std::string json) -> rest_response {
   return result;
 }
 
+auto rest_response::from_body(std::string body,
+                              http_content_type content_type) -> rest_response {
+  auto result = rest_response{};
+  result.code_ = 200;
+  result.body_ = std::move(body);
+  result.content_type_ = content_type;
+  return result;
+}
+
 auto rest_response::is_error() const -> bool {
   return is_error_;
 }
@@ -313,6 +322,11 @@ auto rest_response::error_detail() const -> const caf::error& {
   return detail_;
 }
 
+auto rest_response::content_type() const
+  -> std::optional<http_content_type> {
+  return content_type_;
+}
+
 auto rest_response::release() && -> std::string {
   return std::move(body_);
 }
@@ -310,6 +310,21 @@ partition_actor partition_factory::operator()(const uuid& id) const {
                             filesystem_, path);
 }
 
+size_t partition_factory::weight(const uuid& id) const {
+  auto err = std::error_code{};
+  auto result = size_t{0};
+  if (auto size = std::filesystem::file_size(state_.partition_path(id), err);
+      !err)
+    result += size;
+  if (auto store_path = store_path_for_partition(state_.dir / "..", id)) {
+    if (auto size = std::filesystem::file_size(*store_path, err); !err)
+      result += size;
+  }
+  // Partitions whose files we cannot find must still count towards the
+  // capacity of the cache.
+  return std::max(result, size_t{1});
+}
+
 size_t partition_factory::materializations() const {
   return materializations_;
 }
@@ -894,6 +909,17 @@ auto index_state::schedule_lookups() -> size_t {
       immediate_completion(*next);
       continue;
     }
+    // Load the partitions that are next in line while this one is busy, so
+    // that their files are already mapped once we schedule them. We stop once
+    // the cache has no more room for prefetched partitions, because later
+    // ones would only displace earlier ones.
+    for (const auto& partition_id :
+         pending_queries.peek(defaults::partition_prefetch)) {
+      if (!unpersisted.contains(partition_id)
+          && persisted_partitions.contains(partition_id)
+          && !inmem_partitions.prefetch(partition_id))
+        break;
+    }
     counters.partition_scheduled++;
     counters.partition_lookups += next->queries.size();
     // 3. request all relevant queries in a loop
@@ -1008,6 +1034,9 @@ void index_state::send_report() {
   auto counters = std::exchange(this->counters, {});
   this->counters.previous_materializations
     = inmem_partitions.factory().materializations();
+  const auto& cache_statistics = inmem_partitions.stats();
+  const auto previous_cache_statistics
+    = std::exchange(this->previous_cache_statistics, cache_statistics);
   auto query_counters = get_query_counters(pending_queries);
   auto msg = report{
     .data = {
@@ -1016,6 +1045,15 @@ void index_state::send_report() {
       {"scheduler.backlog.normal", query_counters.num_normal_prio},
       {"scheduler.partition.pending", pending_queries.num_partitions()},
       {"scheduler.partition.materializations", materializations},
+      {"scheduler.partition.cache.hits",
+       cache_statistics.hits - previous_cache_statistics.hits},
+      {"scheduler.partition.cache.misses",
+       cache_statistics.misses - previous_cache_statistics.misses},
+      {"scheduler.partition.cache.evictions",
+       cache_statistics.evictions - previous_cache_statistics.evictions},
+      {"scheduler.partition.cache.prefetches",
+       cache_statistics.prefetches - previous_cache_statistics.prefetches},
+      {"scheduler.partition.cache.size", inmem_partitions.weight()},
       {"scheduler.partition.lookups", counters.partition_lookups},
       {"scheduler.partition.scheduled", counters.partition_scheduled},
       {"scheduler.partition.remaining-capacity",
@@ -1170,18 +1208,18 @@ index(index_actor::stateful_pointer<index_state> self,
       accountant_actor accountant, filesystem_actor filesystem,
       catalog_actor catalog, const std::filesystem::path& dir,
       std::string store_backend, size_t partition_capacity,
-      duration active_partition_timeout, size_t max_inmem_partitions,
+      duration active_partition_timeout, size_t partition_cache_size,
       size_t taste_partitions, size_t max_concurrent_partition_lookups,
       const std::filesystem::path& catalog_dir, index_config index_config) {
   TENZIR_TRACE_SCOPE(
     "index {} {} {} {} {} {} {} {} {} {}", TENZIR_ARG(self->id()),
     TENZIR_ARG(filesystem), TENZIR_ARG(dir), TENZIR_ARG(partition_capacity),
-    TENZIR_ARG(active_partition_timeout), TENZIR_ARG(max_inmem_partitions),
+    TENZIR_ARG(active_partition_timeout), TENZIR_ARG(partition_cache_size),
     TENZIR_ARG(taste_partitions), TENZIR_ARG(max_concurrent_partition_lookups),
     TENZIR_ARG(catalog_dir), TENZIR_ARG(index_config));
   TENZIR_VERBOSE("{} initializes index in {} with a maximum partition "
-                 "size of {} events and {} resident partitions",
-                 *self, dir, partition_capacity, max_inmem_partitions);
+                 "size of {} events and a partition cache of {} bytes",
+                 *self, dir, partition_capacity, partition_cache_size);
   self->state.index_opts["cardinality"] = partition_capacity;
   self->state.synopsis_opts = std::move(index_config);
   if (dir != catalog_dir)
@@ -1214,7 +1252,8 @@ index(index_actor::stateful_pointer<index_state> self,
   self->state.active_partition_timeout = active_partition_timeout;
   self->state.taste_partitions = taste_partitions;
   self->state.inmem_partitions.factory().filesystem() = self->state.filesystem;
-  self->state.inmem_partitions.resize(max_inmem_partitions);
+  self->state.partition_cache_size = partition_cache_size;
+  self->state.inmem_partitions.resize(partition_cache_size);
   // Setup stream manager.
   self->state.stage = detail::attach_notifying_stream_stage(
     self,
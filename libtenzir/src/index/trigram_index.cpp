@@ -0,0 +1,162 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/index/trigram_index.hpp"
+
+#include "tenzir/bitmap_algorithms.hpp"
+#include "tenzir/detail/assert.hpp"
+#include "tenzir/detail/legacy_deserialize.hpp"
+#include "tenzir/detail/overload.hpp"
+#include "tenzir/fbs/value_index.hpp"
+#include "tenzir/index/container_lookup.hpp"
+#include "tenzir/type.hpp"
+
+#include <caf/binary_serializer.hpp>
+#include <caf/serializer.hpp>
+#include <caf/settings.hpp>
+
+#include <algorithm>
+
+namespace tenzir {
+
+trigram_index::trigram_index(tenzir::type t, caf::settings opts)
+  : value_index{std::move(t), std::move(opts)} {
+  // nop
+}
+
+bool trigram_index::inspect_impl(supported_inspectors& inspector) {
+  return value_index::inspect_impl(inspector)
+         && std::visit(
+           [this](auto visitor) {
+             return visitor.get().apply(postings_);
+           },
+           inspector);
+}
+
+bool trigram_index::append_impl(data_view x, id pos) {
+  auto str = caf::get_if<view<std::string>>(&x);
+  if (!str)
+    return false;
+  for (auto trigram : detail::trigrams(*str)) {
+    auto& bm = postings_[trigram];
+    bm.append_bits(false, pos - bm.size());
+    bm.append_bit(true);
+  }
+  return true;
+}
+
+caf::expected<ids>
+trigram_index::lookup_impl(relational_operator op, data_view x) const {
+  auto intersect = [&](const std::vector<detail::trigram>& trigrams) -> ids {
+    auto postings = std::vector<const ewah_bitmap*>{};
+    postings.reserve(trigrams.size());
+    for (auto trigram : trigrams) {
+      auto it = postings_.find(trigram);
+      if (it == postings_.end())
+        return ids{offset(), false};
+      postings.push_back(&it->second);
+    }
+    // Start with the smallest ID sets to shrink the intermediate result
+    // quickly.
+    std::sort(postings.begin(), postings.end(), [](auto* lhs, auto* rhs) {
+      return lhs->memusage() < rhs->memusage();
+    });
+    auto result = *postings.front();
+    for (auto i = 1u; i < postings.size() && !all<0>(result); ++i)
+      result &= *postings[i];
+    return result;
+  };
+  auto f = detail::overload{
+    [&](auto x) -> caf::expected<ids> {
+      return caf::make_error(ec::type_clash, materialize(x));
+    },
+    [&](view<pattern>) -> caf::expected<ids> {
+      switch (op) {
+        default:
+          return caf::make_error(ec::unsupported_operator, op);
+        case relational_operator::equal:
+        case relational_operator::in:
+          if (auto trigrams = detail::required_trigrams(op, x))
+            return intersect(*trigrams);
+          return ids{offset(), true};
+        case relational_operator::not_equal:
+        case relational_operator::not_in:
+          return ids{offset(), true};
+      }
+    },
+    [&](view<std::string>) -> caf::expected<ids> {
+      switch (op) {
+        default:
+          return caf::make_error(ec::unsupported_operator, op);
+        case relational_operator::equal:
+        case relational_operator::ni:
+          if (auto trigrams = detail::required_trigrams(op, x))
+            return intersect(*trigrams);
+          return ids{offset(), true};
+        case relational_operator::not_equal:
+        case relational_operator::not_ni:
+        case relational_operator::in:
+        case relational_operator::not_in:
+          return ids{offset(), true};
+      }
+    },
+    [&](view<list> xs) -> caf::expected<ids> {
+      // Subtracting candidate sets for `not_in` would drop actual matches.
+      if (op == relational_operator::not_in)
+        return ids{offset(), true};
+      return detail::container_lookup(*this, op, xs);
+    },
+  };
+  return caf::visit(f, x);
+}
+
+size_t trigram_index::memusage_impl() const {
+  size_t acc = postings_.size() * sizeof(decltype(postings_)::value_type);
+  for (const auto& [_, bm] : postings_)
+    acc += bm.memusage();
+  return acc;
+}
+
+flatbuffers::Offset<fbs::ValueIndex> trigram_index::pack_impl(
+  flatbuffers::FlatBufferBuilder& builder,
+  flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase> base_offset) {
+  // Sort the trigrams to make the serialized index deterministic.
+  auto sorted = std::vector<detail::trigram>{};
+  sorted.reserve(postings_.size());
+  for (const auto& [trigram, _] : postings_)
+    sorted.push_back(trigram);
+  std::sort(sorted.begin(), sorted.end());
+  auto posting_offsets = std::vector<
+    flatbuffers::Offset<fbs::value_index::detail::TrigramIndexPosting>>{};
+  posting_offsets.reserve(sorted.size());
+  for (auto trigram : sorted) {
+    const auto ids_offset = pack(builder, postings_.find(trigram)->second);
+    posting_offsets.emplace_back(
+      fbs::value_index::detail::CreateTrigramIndexPosting(builder, trigram,
+                                                          ids_offset));
+  }
+  const auto trigram_index_offset = fbs::value_index::CreateTrigramIndexDirect(
+    builder, base_offset, &posting_offsets);
+  return fbs::CreateValueIndex(builder, fbs::value_index::ValueIndex::trigram,
+                               trigram_index_offset.Union());
+}
+
+caf::error trigram_index::unpack_impl(const fbs::ValueIndex& from) {
+  const auto* from_trigram = from.value_index_as_trigram();
+  TENZIR_ASSERT(from_trigram);
+  postings_.clear();
+  postings_.reserve(from_trigram->postings()->size());
+  for (const auto* posting : *from_trigram->postings()) {
+    auto& to = postings_[posting->trigram()];
+    if (auto err = unpack(*posting->ids(), to))
+      return err;
+  }
+  return caf::none;
+}
+
+} // namespace tenzir
@@ -82,6 +82,12 @@ std::optional<double> get_field_fprate(const index_config& config,
   if (caf::visit(use_default_fprate, field.type())) {
     return config.default_fp_rate;
   }
+  // Fields with a trigram index always get a dedicated synopsis such that the
+  // catalog can prune partitions for substring queries on them.
+  if (const auto field_type = field.type();
+      field_type.attribute("index") == "trigram") {
+    return config.default_fp_rate;
+  }
   return std::nullopt;
 }
 
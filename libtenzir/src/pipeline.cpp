@@ -205,6 +205,17 @@ auto pipeline::optimize(expression const& filter, event_order order) const
     }
     current_order = opt.order;
   }
+  // Push projections towards the source of the pipeline. As we do not know
+  // which fields are required downstream, we start with all fields.
+  auto current_fields = std::optional<std::vector<std::string>>{};
+  for (auto& op : result) {
+    if (current_fields) {
+      if (auto projected = op->project(*current_fields)) {
+        op = std::move(projected);
+      }
+    }
+    current_fields = op->required_fields(current_fields);
+  }
   std::reverse(result.begin(), result.end());
   return optimize_result{current_filter, current_order,
                          std::make_unique<pipeline>(std::move(result))};
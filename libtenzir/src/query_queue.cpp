@@ -71,6 +71,17 @@ query_queue::queries() const {
   return queries_;
 }
 
+std::vector<uuid> query_queue::peek(size_t n) const {
+  auto result = std::vector<uuid>{};
+  for (auto it = partitions.rbegin(); it != partitions.rend(); ++it) {
+    if (result.size() >= n)
+      break;
+    if (!it->erased)
+      result.push_back(it->partition);
+  }
+  return result;
+}
+
 /// Inserts a new query into the queue.
 [[nodiscard]] caf::error
 query_queue::insert(query_state&& query_state,
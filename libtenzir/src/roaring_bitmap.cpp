@@ -0,0 +1,731 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/roaring_bitmap.hpp"
+
+#include "tenzir/detail/narrow.hpp"
+#include "tenzir/error.hpp"
+#include "tenzir/fbs/bitmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+namespace tenzir {
+
+namespace {
+
+using container = roaring_bitmap::container;
+using container_kind = roaring_bitmap::container_kind;
+using block_type = roaring_bitmap::block_type;
+using size_type = roaring_bitmap::size_type;
+using word_type = roaring_bitmap::word_type;
+
+constexpr auto container_width = roaring_bitmap::container_width;
+constexpr auto container_blocks = roaring_bitmap::container_blocks;
+constexpr auto max_array_size = roaring_bitmap::max_array_size;
+
+/// The number of runs at which a run container is no smaller than a bitset
+/// container.
+constexpr auto max_runs
+  = container_blocks * sizeof(block_type) / (2 * sizeof(uint16_t));
+
+using block_array = std::array<block_type, container_blocks>;
+
+/// Sets the bits *[first, last]* in the blocks of a container.
+void fill(block_type* blocks, size_t first, size_t last) {
+  const auto first_block = first / word_type::width;
+  const auto last_block = last / word_type::width;
+  const auto first_mask = word_type::all << (first % word_type::width);
+  const auto last_mask
+    = word_type::all >> (word_type::width - 1 - last % word_type::width);
+  if (first_block == last_block) {
+    blocks[first_block] |= first_mask & last_mask;
+    return;
+  }
+  blocks[first_block] |= first_mask;
+  std::fill(blocks + first_block + 1, blocks + last_block, word_type::all);
+  blocks[last_block] |= last_mask;
+}
+
+/// Writes the bits of a container into a block array.
+void materialize(const container& c, block_type* blocks) {
+  switch (c.kind) {
+    case container_kind::array:
+      std::fill_n(blocks, container_blocks, word_type::none);
+      for (auto x : c.values)
+        blocks[x / word_type::width] |= word_type::mask(x % word_type::width);
+      return;
+    case container_kind::bitset:
+      std::copy(c.blocks.begin(), c.blocks.end(), blocks);
+      return;
+    case container_kind::run:
+      std::fill_n(blocks, container_blocks, word_type::none);
+      for (auto i = size_t{0}; i < c.values.size(); i += 2)
+        fill(blocks, c.values[i], c.values[i + 1]);
+      return;
+  }
+  __builtin_unreachable();
+}
+
+/// Returns the blocks of a container, materializing them into the given
+/// scratch space unless the container is a bitset.
+const block_type* blocks_of(const container& c, block_array& scratch) {
+  if (c.kind == container_kind::bitset)
+    return c.blocks.data();
+  materialize(c, scratch.data());
+  return scratch.data();
+}
+
+uint32_t count(const block_type* blocks) {
+  auto result = uint32_t{0};
+  for (auto i = size_t{0}; i < container_blocks; ++i)
+    result += std::popcount(blocks[i]);
+  return result;
+}
+
+size_t count_runs(const block_type* blocks) {
+  auto result = size_t{0};
+  auto carry = block_type{0};
+  for (auto i = size_t{0}; i < container_blocks; ++i) {
+    const auto x = blocks[i];
+    result += std::popcount(x & ~((x << 1) | carry));
+    carry = x >> (word_type::width - 1);
+  }
+  return result;
+}
+
+size_t count_runs(const std::vector<uint16_t>& values) {
+  if (values.empty())
+    return 0;
+  auto result = size_t{1};
+  for (auto i = size_t{1}; i < values.size(); ++i)
+    if (values[i] != values[i - 1] + 1)
+      ++result;
+  return result;
+}
+
+/// Determines the representation that requires the least memory.
+container_kind cheapest_kind(size_t cardinality, size_t runs) {
+  const auto array_bytes = cardinality <= max_array_size
+                             ? cardinality * sizeof(uint16_t)
+                             : std::numeric_limits<size_t>::max();
+  const auto bitset_bytes = container_blocks * sizeof(block_type);
+  const auto run_bytes = runs * 2 * sizeof(uint16_t);
+  if (run_bytes < std::min(array_bytes, bitset_bytes))
+    return container_kind::run;
+  if (array_bytes <= bitset_bytes)
+    return container_kind::array;
+  return container_kind::bitset;
+}
+
+/// Creates a container in its cheapest representation from a block array.
+container make_container(size_type key, const block_type* blocks,
+                         uint32_t cardinality) {
+  auto result = container{};
+  result.key = key;
+  result.cardinality = cardinality;
+  if (cardinality == 0)
+    return result;
+  result.kind = cheapest_kind(cardinality, count_runs(blocks));
+  switch (result.kind) {
+    case container_kind::array:
+      result.values.reserve(cardinality);
+      for (auto i = size_t{0}; i < container_blocks; ++i)
+        for (auto x = blocks[i]; x != 0; x &= x - 1)
+          result.values.push_back(detail::narrow_cast<uint16_t>(
+            i * word_type::width + std::countr_zero(x)));
+      break;
+    case container_kind::bitset:
+      result.blocks.assign(blocks, blocks + container_blocks);
+      break;
+    case container_kind::run: {
+      // Find the runs by filling the zeros below the first set bit, and then
+      // counting the trailing ones.
+      auto i = size_t{0};
+      auto x = blocks[0];
+      while (true) {
+        while (x == word_type::none && i + 1 < container_blocks)
+          x = blocks[++i];
+        if (x == word_type::none)
+          break;
+        const auto first = i * word_type::width + std::countr_zero(x);
+        x |= x - 1;
+        while (x == word_type::all && i + 1 < container_blocks)
+          x = blocks[++i];
+        if (x == word_type::all) {
+          result.values.push_back(detail::narrow_cast<uint16_t>(first));
+          result.values.push_back(
+            detail::narrow_cast<uint16_t>(container_width - 1));
+          break;
+        }
+        const auto last = i * word_type::width + std::countr_one(x) - 1;
+        result.values.push_back(detail::narrow_cast<uint16_t>(first));
+        result.values.push_back(detail::narrow_cast<uint16_t>(last));
+        x &= x + 1;
+      }
+      break;
+    }
+  }
+  return result;
+}
+
+/// Creates a container with the first *n* bits set.
+container make_full_container(size_type key, size_t n) {
+  auto result = container{};
+  result.key = key;
+  result.cardinality = detail::narrow_cast<uint32_t>(n);
+  result.kind = cheapest_kind(n, 1);
+  if (result.kind == container_kind::array) {
+    result.values.resize(n);
+    std::iota(result.values.begin(), result.values.end(), uint16_t{0});
+  } else {
+    result.values = {0, detail::narrow_cast<uint16_t>(n - 1)};
+  }
+  return result;
+}
+
+/// Converts a container into its cheapest representation.
+void optimize(container& c) {
+  if (c.kind == container_kind::array
+      && cheapest_kind(c.cardinality, count_runs(c.values))
+           == container_kind::array)
+    return;
+  auto blocks = block_array{};
+  materialize(c, blocks.data());
+  c = make_container(c.key, blocks.data(), c.cardinality);
+}
+
+void convert_to_bitset(container& c) {
+  auto blocks = std::vector<block_type>(container_blocks);
+  materialize(c, blocks.data());
+  c.kind = container_kind::bitset;
+  c.values = {};
+  c.blocks = std::move(blocks);
+}
+
+/// Sets the bits *[first, last]* in a container whose set bits all precede
+/// *first*.
+void append_range(container& c, uint16_t first, uint16_t last) {
+  const auto n = uint32_t{last} - first + 1;
+  switch (c.kind) {
+    case container_kind::array:
+      if (c.cardinality + n <= max_array_size) {
+        for (auto i = uint32_t{first}; i <= last; ++i)
+          c.values.push_back(detail::narrow_cast<uint16_t>(i));
+        break;
+      }
+      convert_to_bitset(c);
+      [[fallthrough]];
+    case container_kind::bitset:
+      fill(c.blocks.data(), first, last);
+      break;
+    case container_kind::run:
+      if (!c.values.empty() && c.values.back() + 1 == first) {
+        c.values.back() = last;
+        break;
+      }
+      if (c.values.size() / 2 < max_runs) {
+        c.values.push_back(first);
+        c.values.push_back(last);
+        break;
+      }
+      convert_to_bitset(c);
+      fill(c.blocks.data(), first, last);
+      break;
+  }
+  c.cardinality += n;
+}
+
+bool contains(const container& c, uint16_t x) {
+  switch (c.kind) {
+    case container_kind::array:
+      return std::binary_search(c.values.begin(), c.values.end(), x);
+    case container_kind::bitset:
+      return word_type::test(c.blocks[x / word_type::width],
+                             x % word_type::width);
+    case container_kind::run: {
+      // Find the last run that starts at or before x.
+      auto lo = size_t{0};
+      auto hi = c.values.size() / 2;
+      while (lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if (c.values[2 * mid] <= x)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      return lo > 0 && x <= c.values[2 * (lo - 1) + 1];
+    }
+  }
+  __builtin_unreachable();
+}
+
+bool is_full(const container& c) {
+  return c.cardinality == container_width;
+}
+
+/// Creates an array container from the positions of an array container that
+/// satisfy a predicate.
+template <class Predicate>
+container filter(const container& c, Predicate pred) {
+  auto result = container{};
+  result.key = c.key;
+  std::copy_if(c.values.begin(), c.values.end(),
+               std::back_inserter(result.values), pred);
+  result.cardinality = detail::narrow_cast<uint32_t>(result.values.size());
+  optimize(result);
+  return result;
+}
+
+/// Combines two array containers with a set algorithm if the result is
+/// guaranteed to fit into an array container.
+template <class SetOperation>
+container combine_arrays(const container& lhs, const container& rhs,
+                         SetOperation op) {
+  auto result = container{};
+  result.key = lhs.key;
+  result.values.reserve(lhs.values.size() + rhs.values.size());
+  op(lhs.values.begin(), lhs.values.end(), rhs.values.begin(),
+     rhs.values.end(), std::back_inserter(result.values));
+  result.cardinality = detail::narrow_cast<uint32_t>(result.values.size());
+  optimize(result);
+  return result;
+}
+
+/// Combines two containers block by block. The loop operates on fixed-size
+/// arrays without branches, which allows the compiler to vectorize it.
+template <class Operation>
+container combine_blocks(const container& lhs, const container& rhs,
+                         Operation op) {
+  auto lhs_scratch = block_array{};
+  auto rhs_scratch = block_array{};
+  const auto* __restrict x = blocks_of(lhs, lhs_scratch);
+  const auto* __restrict y = blocks_of(rhs, rhs_scratch);
+  auto result = block_array{};
+  for (auto i = size_t{0}; i < container_blocks; ++i)
+    result[i] = op(x[i], y[i]);
+  return make_container(lhs.key, result.data(), count(result.data()));
+}
+
+container intersect(const container& lhs, const container& rhs) {
+  if (is_full(lhs))
+    return rhs;
+  if (is_full(rhs))
+    return lhs;
+  if (lhs.kind == container_kind::array && rhs.kind == container_kind::array)
+    return combine_arrays(lhs, rhs, [](auto... xs) {
+      return std::set_intersection(xs...);
+    });
+  if (lhs.kind == container_kind::array)
+    return filter(lhs, [&](uint16_t x) {
+      return contains(rhs, x);
+    });
+  if (rhs.kind == container_kind::array)
+    return filter(rhs, [&](uint16_t x) {
+      return contains(lhs, x);
+    });
+  return combine_blocks(lhs, rhs, [](block_type x, block_type y) {
+    return x & y;
+  });
+}
+
+container unite(const container& lhs, const container& rhs) {
+  if (is_full(lhs))
+    return lhs;
+  if (is_full(rhs))
+    return rhs;
+  if (lhs.kind == container_kind::array && rhs.kind == container_kind::array
+      && lhs.cardinality + rhs.cardinality <= max_array_size)
+    return combine_arrays(lhs, rhs, [](auto... xs) {
+      return std::set_union(xs...);
+    });
+  return combine_blocks(lhs, rhs, [](block_type x, block_type y) {
+    return x | y;
+  });
+}
+
+container symmetric_difference(const container& lhs, const container& rhs) {
+  if (lhs.kind == container_kind::array && rhs.kind == container_kind::array
+      && lhs.cardinality + rhs.cardinality <= max_array_size)
+    return combine_arrays(lhs, rhs, [](auto... xs) {
+      return std::set_symmetric_difference(xs...);
+    });
+  return combine_blocks(lhs, rhs, [](block_type x, block_type y) {
+    return x ^ y;
+  });
+}
+
+container difference(const container& lhs, const container& rhs) {
+  if (is_full(rhs))
+    return container{.key = lhs.key};
+  if (lhs.kind == container_kind::array)
+    return filter(lhs, [&](uint16_t x) {
+      return !contains(rhs, x);
+    });
+  return combine_blocks(lhs, rhs, [](block_type x, block_type y) {
+    return x & ~y;
+  });
+}
+
+} // namespace
+
+roaring_bitmap::roaring_bitmap(size_type n, bool bit) {
+  append_bits(bit, n);
+}
+
+bool roaring_bitmap::empty() const {
+  return num_bits_ == 0;
+}
+
+roaring_bitmap::size_type roaring_bitmap::size() const {
+  return num_bits_;
+}
+
+size_t roaring_bitmap::memusage() const {
+  auto result = containers_.capacity() * sizeof(container);
+  for (const auto& c : containers_)
+    result += c.values.capacity() * sizeof(uint16_t)
+              + c.blocks.capacity() * sizeof(block_type);
+  return result;
+}
+
+const std::vector<roaring_bitmap::container>&
+roaring_bitmap::containers() const {
+  return containers_;
+}
+
+void roaring_bitmap::append_bit(bool bit) {
+  append_bits(bit, 1);
+}
+
+void roaring_bitmap::append_bits(bool bit, size_type n) {
+  TENZIR_ASSERT(num_bits_ + n <= max_size);
+  if (bit)
+    set_range(num_bits_, num_bits_ + n);
+  num_bits_ += n;
+}
+
+void roaring_bitmap::append_block(block_type value, size_type n) {
+  TENZIR_ASSERT(n > 0);
+  TENZIR_ASSERT(n <= word_type::width);
+  // Append every run of ones in the block at once.
+  auto x = value & word_type::lsb_fill(n);
+  while (x != 0) {
+    const auto first = size_type(std::countr_zero(x));
+    const auto last = first + std::countr_one(x >> first);
+    set_range(num_bits_ + first, num_bits_ + last);
+    if (last == word_type::width)
+      break;
+    x &= word_type::all << last;
+  }
+  num_bits_ += n;
+}
+
+void roaring_bitmap::flip() {
+  auto result = std::vector<container>{};
+  auto current = containers_.begin();
+  const auto num_keys = (num_bits_ + container_width - 1) / container_width;
+  for (auto key = size_type{0}; key < num_keys; ++key) {
+    const auto n = std::min(container_width, num_bits_ - key * container_width);
+    if (current == containers_.end() || current->key != key) {
+      result.push_back(make_full_container(key, n));
+      continue;
+    }
+    auto blocks = block_array{};
+    materialize(*current, blocks.data());
+    for (auto& block : blocks)
+      block = ~block;
+    // Clear the bits beyond the end of the bitmap.
+    if (n < container_width) {
+      const auto partial = n % word_type::width;
+      auto first_unused = n / word_type::width;
+      if (partial > 0)
+        blocks[first_unused++] &= word_type::lsb_mask(partial);
+      std::fill(blocks.begin() + first_unused, blocks.end(), word_type::none);
+    }
+    const auto cardinality = n - current->cardinality;
+    if (cardinality > 0)
+      result.push_back(make_container(
+        key, blocks.data(), detail::narrow_cast<uint32_t>(cardinality)));
+    ++current;
+  }
+  containers_ = std::move(result);
+}
+
+void roaring_bitmap::set_range(size_type first, size_type last) {
+  while (first < last) {
+    const auto key = first / container_width;
+    const auto end = std::min(last, (key + 1) * container_width);
+    const auto lo = detail::narrow_cast<uint16_t>(first % container_width);
+    const auto hi = detail::narrow_cast<uint16_t>((end - 1) % container_width);
+    if (containers_.empty() || containers_.back().key != key) {
+      // The previous container won't receive any more bits.
+      if (!containers_.empty())
+        optimize(containers_.back());
+      auto& c = containers_.emplace_back();
+      c.key = key;
+      c.kind = lo == hi ? container_kind::array : container_kind::run;
+    }
+    append_range(containers_.back(), lo, hi);
+    first = end;
+  }
+}
+
+template <class Operation>
+roaring_bitmap
+roaring_bitmap::merge(const roaring_bitmap& lhs, const roaring_bitmap& rhs,
+                      bool keep_lhs, bool keep_rhs, Operation op) {
+  auto result = roaring_bitmap{};
+  result.num_bits_ = std::max(lhs.num_bits_, rhs.num_bits_);
+  auto copy = [&](const auto& from, auto it) {
+    result.containers_.push_back(*it);
+    if (it + 1 == from.containers_.end())
+      optimize(result.containers_.back());
+  };
+  auto x = lhs.containers_.begin();
+  auto y = rhs.containers_.begin();
+  while (x != lhs.containers_.end() && y != rhs.containers_.end()) {
+    if (x->key < y->key) {
+      if (keep_lhs)
+        copy(lhs, x);
+      ++x;
+    } else if (y->key < x->key) {
+      if (keep_rhs)
+        copy(rhs, y);
+      ++y;
+    } else {
+      auto c = op(*x, *y);
+      if (c.cardinality > 0)
+        result.containers_.push_back(std::move(c));
+      ++x;
+      ++y;
+    }
+  }
+  for (; keep_lhs && x != lhs.containers_.end(); ++x)
+    copy(lhs, x);
+  for (; keep_rhs && y != rhs.containers_.end(); ++y)
+    copy(rhs, y);
+  return result;
+}
+
+roaring_bitmap
+binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  return roaring_bitmap::merge(lhs, rhs, false, false, intersect);
+}
+
+roaring_bitmap binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  return roaring_bitmap::merge(lhs, rhs, true, true, unite);
+}
+
+roaring_bitmap
+binary_xor(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  return roaring_bitmap::merge(lhs, rhs, true, true, symmetric_difference);
+}
+
+roaring_bitmap
+binary_nand(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  return roaring_bitmap::merge(lhs, rhs, true, false, difference);
+}
+
+bool operator==(const roaring_bitmap& x, const roaring_bitmap& y) {
+  if (x.num_bits_ != y.num_bits_
+      || x.containers_.size() != y.containers_.size())
+    return false;
+  for (auto i = size_t{0}; i < x.containers_.size(); ++i) {
+    const auto& lhs = x.containers_[i];
+    const auto& rhs = y.containers_[i];
+    if (lhs.key != rhs.key || lhs.cardinality != rhs.cardinality)
+      return false;
+    if (lhs.kind == rhs.kind) {
+      if (lhs.values != rhs.values || lhs.blocks != rhs.blocks)
+        return false;
+      continue;
+    }
+    // The last container of a bitmap may not be in its cheapest
+    // representation yet, so we need to compare the bits.
+    auto lhs_scratch = block_array{};
+    auto rhs_scratch = block_array{};
+    const auto* lhs_blocks = blocks_of(lhs, lhs_scratch);
+    const auto* rhs_blocks = blocks_of(rhs, rhs_scratch);
+    if (!std::equal(lhs_blocks, lhs_blocks + container_blocks, rhs_blocks))
+      return false;
+  }
+  return true;
+}
+
+auto pack(flatbuffers::FlatBufferBuilder& builder, const roaring_bitmap& from)
+  -> flatbuffers::Offset<fbs::bitmap::RoaringBitmap> {
+  auto container_offsets = std::vector<
+    flatbuffers::Offset<fbs::bitmap::detail::RoaringContainer>>{};
+  container_offsets.reserve(from.containers_.size());
+  for (const auto& c : from.containers_) {
+    const auto kind = [&] {
+      switch (c.kind) {
+        case container_kind::array:
+          return fbs::bitmap::detail::RoaringContainerKind::array;
+        case container_kind::bitset:
+          return fbs::bitmap::detail::RoaringContainerKind::bitset;
+        case container_kind::run:
+          return fbs::bitmap::detail::RoaringContainerKind::run;
+      }
+      __builtin_unreachable();
+    }();
+    container_offsets.push_back(
+      fbs::bitmap::detail::CreateRoaringContainerDirect(
+        builder, c.key, kind, c.cardinality, &c.values, &c.blocks));
+  }
+  return fbs::bitmap::CreateRoaringBitmapDirect(builder, &container_offsets,
+                                                from.num_bits_);
+}
+
+auto unpack(const fbs::bitmap::RoaringBitmap& from, roaring_bitmap& to)
+  -> caf::error {
+  to.containers_.clear();
+  to.containers_.reserve(from.containers()->size());
+  for (const auto* from_container : *from.containers()) {
+    auto& c = to.containers_.emplace_back();
+    c.key = from_container->key();
+    c.cardinality = from_container->cardinality();
+    switch (from_container->kind()) {
+      case fbs::bitmap::detail::RoaringContainerKind::array:
+        c.kind = container_kind::array;
+        break;
+      case fbs::bitmap::detail::RoaringContainerKind::bitset:
+        c.kind = container_kind::bitset;
+        break;
+      case fbs::bitmap::detail::RoaringContainerKind::run:
+        c.kind = container_kind::run;
+        break;
+      default:
+        return caf::make_error(ec::format_error,
+                               "invalid tenzir.fbs.bitmap.detail."
+                               "RoaringContainer kind");
+    }
+    if (const auto* values = from_container->values())
+      c.values.assign(values->begin(), values->end());
+    if (const auto* blocks = from_container->blocks())
+      c.blocks.assign(blocks->begin(), blocks->end());
+    const auto valid = c.kind == container_kind::bitset
+                         ? c.blocks.size() == container_blocks
+                         : c.values.size() % 2 == 0
+                             || c.kind == container_kind::array;
+    if (!valid)
+      return caf::make_error(ec::format_error,
+                             "malformed tenzir.fbs.bitmap.detail."
+                             "RoaringContainer");
+  }
+  to.num_bits_ = from.num_bits();
+  return caf::none;
+}
+
+roaring_bitmap_range::roaring_bitmap_range(const roaring_bitmap& bm)
+  : bm_{&bm},
+    num_blocks_{(bm.num_bits_ + word_type::width - 1) / word_type::width},
+    done_{num_blocks_ == 0} {
+  if (!done_)
+    scan();
+}
+
+void roaring_bitmap_range::next() {
+  TENZIR_ASSERT(!done());
+  if (block_ == num_blocks_)
+    done_ = true;
+  else
+    scan();
+}
+
+bool roaring_bitmap_range::done() const {
+  return done_;
+}
+
+void roaring_bitmap_range::load(roaring_bitmap::size_type key) {
+  if (key == loaded_key_)
+    return;
+  loaded_key_ = key;
+  const auto& containers = bm_->containers_;
+  while (next_container_ < containers.size()
+         && containers[next_container_].key < key)
+    ++next_container_;
+  if (next_container_ == containers.size()
+      || containers[next_container_].key != key) {
+    uniform_ = true;
+    uniform_block_ = word_type::none;
+    return;
+  }
+  const auto& c = containers[next_container_];
+  if (is_full(c)) {
+    uniform_ = true;
+    uniform_block_ = word_type::all;
+    return;
+  }
+  uniform_ = false;
+  blocks_.resize(container_blocks);
+  materialize(c, blocks_.data());
+}
+
+roaring_bitmap::block_type
+roaring_bitmap_range::block(roaring_bitmap::size_type i) {
+  load(i / container_blocks);
+  return uniform_ ? uniform_block_ : blocks_[i % container_blocks];
+}
+
+void roaring_bitmap_range::scan() {
+  const auto last = num_blocks_ - 1;
+  const auto partial = bm_->num_bits_ % word_type::width;
+  const auto last_size = partial == 0 ? word_type::width : partial;
+  const auto data = block(block_);
+  if (block_ == last) {
+    // Process the last block.
+    bits_ = {data, last_size};
+    ++block_;
+    return;
+  }
+  if (!word_type::all_or_none(data)) {
+    // Process an intermediate inhomogeneous block.
+    bits_ = {data, word_type::width};
+    ++block_;
+    return;
+  }
+  // Scan for consecutive runs of all-0 or all-1 blocks, skipping over absent
+  // and full containers at once.
+  auto n = size_type{0};
+  while (block_ < last) {
+    load(block_ / container_blocks);
+    if (uniform_) {
+      if (uniform_block_ != data)
+        break;
+      const auto end
+        = std::min((block_ / container_blocks + 1) * container_blocks, last);
+      n += (end - block_) * word_type::width;
+      block_ = end;
+    } else {
+      if (blocks_[block_ % container_blocks] != data)
+        break;
+      n += word_type::width;
+      ++block_;
+    }
+  }
+  if (block_ == last) {
+    const auto mask = word_type::lsb_fill(last_size);
+    if ((block(last) & mask) == (data & mask)) {
+      n += last_size;
+      ++block_;
+    }
+  }
+  bits_ = {data, n};
+}
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm) {
+  return roaring_bitmap_range{bm};
+}
+
+} // namespace tenzir
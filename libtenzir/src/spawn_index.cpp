@@ -53,13 +53,19 @@ spawn_index(node_actor::stateful_pointer<node_state> self,
       return err;
     TENZIR_VERBOSE("using customized indexing configuration {}", index_config);
   }
+  if (get_if(&args.inv.options, "tenzir.max-resident-partitions"))
+    TENZIR_WARN("{} ignores the deprecated option "
+                "`tenzir.max-resident-partitions`; use "
+                "`tenzir.partition-cache-size` to limit the size of the "
+                "partition cache in bytes instead",
+                *self);
   auto handle = self->spawn(
     index, accountant, filesystem, catalog, indexdir,
     // TODO: Pass these options as a tenzir::data object instead.
     opt("tenzir.store-backend", std::string{sd::store_backend}),
     opt("tenzir.max-partition-size", sd::max_partition_size),
     opt("tenzir.active-partition-timeout", sd::active_partition_timeout),
-    opt("tenzir.max-resident-partitions", sd::max_in_mem_partitions),
+    opt("tenzir.partition-cache-size", sd::partition_cache_size),
     opt("tenzir.max-taste-partitions", sd::taste_partitions),
     opt("tenzir.max-queries", sd::num_query_supervisors),
     std::filesystem::path{opt("tenzir.catalog-dir", indexdir.string())},
@@ -140,7 +140,8 @@ handle_query(const auto& self, const query_context& query_context) {
         return;
       }
       state->second.result_generator
-        = self->state.store->extract(*tailored_expr, query_context.ids);
+        = self->state.store->extract(*tailored_expr, query_context.ids,
+                                     extract.fields);
       state->second.result_iterator = state->second.result_generator.begin();
       state->second.sink = extract.sink;
       state->second.start = start;
@@ -229,7 +230,9 @@ generator<uint64_t> base_store::count(expression expr, ids selection) const {
 }
 
 generator<table_slice>
-base_store::extract(expression expr, ids selection) const {
+base_store::extract(expression expr, ids selection,
+                    std::optional<std::vector<std::string>> fields) const {
+  (void)fields;
   for (const auto& slice : slices()) {
     if (auto filtered_slice = filter(slice, expr, selection))
       co_yield std::move(*filtered_slice);
@@ -17,15 +17,28 @@
 #include "tenzir/ip_synopsis.hpp"
 #include "tenzir/string_synopsis.hpp"
 #include "tenzir/time_synopsis.hpp"
+#include "tenzir/trigram_synopsis.hpp"
 #include "tenzir/uint64_synopsis.hpp"
 
 namespace tenzir {
 
+namespace {
+
+/// Strings with the `#index=trigram` attribute get a synopsis that can rule
+/// out substring searches and regular expressions.
+synopsis_ptr
+make_string_or_trigram_synopsis(type x, const caf::settings& opts) {
+  if (x.attribute("index") == "trigram")
+    return make_trigram_synopsis<legacy_hash>(std::move(x), opts);
+  return make_string_synopsis<legacy_hash>(std::move(x), opts);
+}
+
+} // namespace
+
 void factory_traits<synopsis>::initialize() {
   factory<synopsis>::add(type{ip_type{}}, make_ip_synopsis<legacy_hash>);
   factory<synopsis>::add<bool_type, bool_synopsis>();
-  factory<synopsis>::add(type{string_type{}},
-                         make_string_synopsis<legacy_hash>);
+  factory<synopsis>::add(type{string_type{}}, make_string_or_trigram_synopsis);
   factory<synopsis>::add<time_type, time_synopsis>();
   factory<synopsis>::add<duration_type, duration_synopsis>();
   factory<synopsis>::add<int64_type, int64_synopsis>();
@@ -27,7 +27,11 @@
 #include "tenzir/type.hpp"
 #include "tenzir/value_index.hpp"
 
+#include <arrow/array.h>
+#include <arrow/array/concatenate.h>
+#include <arrow/compute/api.h>
 #include <arrow/record_batch.h>
+#include <arrow/util/bit_util.h>
 
 #include <cstddef>
 #include <span>
@@ -560,25 +564,26 @@ table_slice concatenate(std::vector<table_slice> slices) {
                               return slice.schema() == schema;
                             }),
                 "concatenate requires slices to be homogeneous");
-  auto builder = caf::get<record_type>(schema).make_arrow_builder(
-    arrow::default_memory_pool());
-  auto arrow_schema = schema.to_arrow_schema();
-  const auto resize_result
-    = builder->Resize(detail::narrow_cast<int64_t>(rows(slices)));
-  TENZIR_ASSERT(resize_result.ok(), resize_result.ToString().c_str());
-
-  for (const auto& slice : slices) {
-    auto batch = to_record_batch(slice);
-    append_columns(caf::get<record_type>(schema),
-                   *batch->ToStructArray().ValueOrDie(), *builder);
+  // We concatenate the slices column by column, which copies the Arrow
+  // buffers in bulk instead of appending values one by one to a builder.
+  auto batches = std::vector<std::shared_ptr<arrow::RecordBatch>>{};
+  batches.reserve(slices.size());
+  for (const auto& slice : slices)
+    batches.push_back(to_record_batch(slice));
+  auto columns = arrow::ArrayVector{};
+  columns.reserve(batches[0]->num_columns());
+  auto chunks = arrow::ArrayVector{};
+  chunks.reserve(batches.size());
+  for (auto column = 0; column < batches[0]->num_columns(); ++column) {
+    chunks.clear();
+    for (const auto& batch : batches)
+      chunks.push_back(batch->column(column));
+    columns.push_back(
+      arrow::Concatenate(chunks, arrow::default_memory_pool()).ValueOrDie());
   }
-  const auto rows = builder->length();
-  if (rows == 0)
-    return {};
-  const auto array = builder->Finish().ValueOrDie();
   auto batch = arrow::RecordBatch::Make(
-    std::move(arrow_schema), rows,
-    caf::get<type_to_arrow_array_t<record_type>>(*array).fields());
+    schema.to_arrow_schema(), detail::narrow_cast<int64_t>(rows(slices)),
+    std::move(columns));
   auto result = table_slice{batch, schema};
   result.offset(slices[0].offset());
   result.import_time(slices[0].import_time());
@@ -586,7 +591,8 @@ table_slice concatenate(std::vector<table_slice> slices) {
 }
 
 generator<table_slice>
-select(const table_slice& slice, expression expr, const ids& hints) {
+select(const table_slice& slice, expression expr, const ids& hints,
+       select_mode mode) {
   if (slice.rows() == 0) {
     co_return;
   }
@@ -617,8 +623,36 @@ select(const table_slice& slice, expression expr, const ids& hints) {
     co_return;
   }
   // Start slicing and dicing.
-  auto batch = to_record_batch(slice);
-  for (const auto [first, last] : select_runs(selection)) {
+  auto runs = std::vector<id_range>{};
+  for (const auto run : select_runs(selection)) {
+    runs.push_back(run);
+  }
+  // Many short runs would result in many tiny slices. If the caller allows
+  // for it, we copy the selected rows into a single slice instead. Compared
+  // to concatenating the runs afterwards, this copies every column only once.
+  constexpr auto min_average_run_length = uint64_t{64};
+  const auto compact
+    = mode == select_mode::compact
+      or (mode == select_mode::adaptive and runs.size() > 1
+          and rank(selection) < runs.size() * min_average_run_length);
+  if (compact) {
+    auto mask = arrow::AllocateEmptyBitmap(
+                  detail::narrow_cast<int64_t>(slice.rows()))
+                  .ValueOrDie();
+    for (const auto [first, last] : runs) {
+      arrow::bit_util::SetBitsTo(mask->mutable_data(),
+                                 detail::narrow_cast<int64_t>(first - offset),
+                                 detail::narrow_cast<int64_t>(last - first),
+                                 true);
+    }
+    const auto mask_array = arrow::BooleanArray{
+      detail::narrow_cast<int64_t>(slice.rows()), std::move(mask)};
+    if (auto result = filter(slice, mask_array)) {
+      co_yield std::move(*result);
+    }
+    co_return;
+  }
+  for (const auto [first, last] : runs) {
     co_yield subslice(slice, first - offset, last - offset);
   }
 }
@@ -723,7 +757,8 @@ filter(const table_slice& slice, expression expr, const ids& hints) {
   if (slice.rows() == 0) {
     return {};
   }
-  auto selected = collect(select(slice, std::move(expr), hints));
+  auto selected
+    = collect(select(slice, std::move(expr), hints, select_mode::adaptive));
   if (selected.empty())
     return {};
   return concatenate(std::move(selected));
@@ -738,6 +773,25 @@ std::optional<table_slice> filter(const table_slice& slice, const ids& hints) {
   return filter(slice, expression{}, hints);
 }
 
+std::optional<table_slice>
+filter(const table_slice& slice, const arrow::BooleanArray& mask) {
+  TENZIR_ASSERT(detail::narrow_cast<uint64_t>(mask.length()) == slice.rows());
+  const auto selected = detail::narrow_cast<uint64_t>(mask.true_count());
+  if (selected == 0)
+    return {};
+  if (selected == slice.rows())
+    return slice;
+  // A single call to Filter copies the selected rows of all columns at once,
+  // instead of slicing and concatenating runs of selected rows.
+  auto batch = arrow::compute::Filter(to_record_batch(slice), mask.data())
+                 .ValueOrDie()
+                 .record_batch();
+  TENZIR_ASSERT(batch);
+  auto result = table_slice{batch, slice.schema()};
+  result.import_time(slice.import_time());
+  return result;
+}
+
 uint64_t count_matching(const table_slice& slice, const expression& expr,
                         const ids& hints) {
   if (slice.rows() == 0) {
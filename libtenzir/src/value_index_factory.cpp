@@ -19,7 +19,9 @@
 #include "tenzir/index/list_index.hpp"
 #include "tenzir/index/string_index.hpp"
 #include "tenzir/index/subnet_index.hpp"
+#include "tenzir/index/trigram_index.hpp"
 #include "tenzir/logger.hpp"
+#include "tenzir/roaring_bitmap.hpp"
 #include "tenzir/type.hpp"
 #include "tenzir/value_index.hpp"
 
@@ -34,6 +36,18 @@ using namespace std::string_view_literals;
 namespace tenzir {
 namespace {
 
+/// Maps an index type to its counterpart that uses Roaring bitmaps, or `void`
+/// if there is none.
+template <class T>
+struct roaring_index {
+  using type = void;
+};
+
+template <class T, class Binner>
+struct roaring_index<arithmetic_index<T, Binner>> {
+  using type = arithmetic_index<T, Binner, roaring_bitmap>;
+};
+
 template <class T>
 value_index_ptr make(type x, caf::settings opts) {
   using int_type = caf::config_value::integer;
@@ -116,6 +130,22 @@ value_index_ptr make(type x, caf::settings opts) {
           return std::make_unique<hash_index<8>>(std::move(x), std::move(opts));
       }
     }
+    if (*index == "trigram"sv) {
+      if (!caf::holds_alternative<string_type>(x)) {
+        TENZIR_ERROR("{} trigram index requires a string type", __func__);
+        return nullptr;
+      }
+      return std::make_unique<trigram_index>(std::move(x), std::move(opts));
+    }
+    if (*index == "roaring"sv) {
+      using index_type = typename roaring_index<T>::type;
+      if constexpr (std::is_void_v<index_type>) {
+        TENZIR_ERROR("{} roaring index requires an arithmetic type", __func__);
+        return nullptr;
+      } else {
+        return std::make_unique<index_type>(std::move(x), std::move(opts));
+      }
+    }
   }
   return std::make_unique<T>(std::move(x), std::move(opts));
 }
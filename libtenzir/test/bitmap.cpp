@@ -15,10 +15,13 @@
 #include "tenzir/flatbuffer.hpp"
 #include "tenzir/ids.hpp"
 #include "tenzir/null_bitmap.hpp"
+#include "tenzir/roaring_bitmap.hpp"
 #include "tenzir/test/test.hpp"
 
 #include <caf/test/dsl.hpp>
 
+#include <random>
+
 using namespace tenzir;
 using namespace std::string_literals;
 
@@ -494,6 +497,97 @@ TEST(bitmap) {
 
 FIXTURE_SCOPE_END()
 
+FIXTURE_SCOPE(roaring_bitmap_tests, bitmap_test_harness<roaring_bitmap>)
+
+TEST(roaring_bitmap) {
+  execute();
+}
+
+FIXTURE_SCOPE_END()
+
+TEST(roaring bitmap containers) {
+  auto bm = roaring_bitmap{};
+  bm.append_bits(false, 10);
+  bm.append_bit(true);
+  bm.append_bits(true, 100'000);
+  bm.append_bits(false, 3 * roaring_bitmap::container_width);
+  for (auto i = 0; i < 5000; ++i)
+    bm.append_bits(i % 3 == 0, 13);
+  bm.append_bit(true);
+  const auto& containers = bm.containers();
+  REQUIRE_EQUAL(containers.size(), 4u);
+  CHECK(containers[0].kind == roaring_bitmap::container_kind::run);
+  CHECK(containers[1].kind == roaring_bitmap::container_kind::run);
+  CHECK_EQUAL(containers[1].cardinality, 34'475u);
+  CHECK_EQUAL(containers[2].key, 4u);
+  MESSAGE("absent and full containers turn into runs");
+  auto sparse = roaring_bitmap{};
+  sparse.append_bits(false, 1ull << 40);
+  sparse.append_bit(true);
+  auto num_sequences = 0;
+  for ([[maybe_unused]] auto bits : bit_range(sparse))
+    ++num_sequences;
+  CHECK_EQUAL(num_sequences, 2);
+  CHECK_EQUAL(rank(sparse), 1u);
+  MESSAGE("type-erased operations stay roaring");
+  auto x = bitmap{roaring_bitmap{100, true}};
+  auto y = bitmap{roaring_bitmap{50, true}};
+  CHECK(caf::holds_alternative<roaring_bitmap>(x & y));
+  CHECK(caf::holds_alternative<roaring_bitmap>(x | y));
+  CHECK(caf::holds_alternative<roaring_bitmap>(x ^ y));
+  CHECK(caf::holds_alternative<roaring_bitmap>(x - y));
+  CHECK_EQUAL(to_string(x - y), std::string(50, '0') + std::string(50, '1'));
+}
+
+TEST(roaring bitmap agrees with EWAH) {
+  // Simulate the bitmaps of an equality-coded index over a high-cardinality
+  // attribute, e.g., IP addresses or strings, that spans multiple containers.
+  constexpr auto num_events = size_t{1} << 17;
+  constexpr auto num_values = size_t{256};
+  constexpr auto group_size = size_t{16};
+  auto engine = std::minstd_rand{42};
+  auto values = std::uniform_int_distribution<size_t>{0, num_values - 1};
+  auto ewah = std::vector<ewah_bitmap>(num_values);
+  auto roaring = std::vector<roaring_bitmap>(num_values);
+  for (auto i = size_t{0}; i < num_events; ++i) {
+    const auto value = values(engine);
+    auto& e = ewah[value];
+    e.append_bits(false, i - e.size());
+    e.append_bit(true);
+    auto& r = roaring[value];
+    r.append_bits(false, i - r.size());
+    r.append_bit(true);
+  }
+  for (auto& e : ewah)
+    e.append_bits(false, num_events - e.size());
+  for (auto& r : roaring)
+    r.append_bits(false, num_events - r.size());
+  // Evaluate disjunctions over many values, and conjunctions with a dense
+  // bitmap, as they occur for a lookup of a subnet or a set of strings.
+  auto evaluate = [&](const auto& bitmaps) {
+    using bitmap_type = std::decay_t<decltype(bitmaps.front())>;
+    auto dense = bitmap_type{};
+    for (auto i = size_t{0}; i < num_events / 64; ++i)
+      dense.append_block(0x00ff00ff00ff00ff);
+    auto result = std::vector<bitmap_type>{};
+    for (auto i = size_t{0}; i + group_size <= bitmaps.size();
+         i += group_size) {
+      auto disjunction
+        = nary_or(bitmaps.begin() + i, bitmaps.begin() + i + group_size);
+      result.push_back(disjunction & dense);
+    }
+    return result;
+  };
+  const auto ewah_results = evaluate(ewah);
+  const auto roaring_results = evaluate(roaring);
+  REQUIRE_EQUAL(ewah_results.size(), roaring_results.size());
+  for (auto i = size_t{0}; i < ewah_results.size(); ++i) {
+    CHECK_EQUAL(ewah_results[i].size(), roaring_results[i].size());
+    CHECK_EQUAL(rank(ewah_results[i]), rank(roaring_results[i]));
+    CHECK(to_string(ewah_results[i]) == to_string(roaring_results[i]));
+  }
+}
+
 namespace {
 
 ewah_bitmap make_ewah1() {
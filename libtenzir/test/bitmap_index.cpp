@@ -14,6 +14,7 @@
 #include "tenzir/detail/serialize.hpp"
 #include "tenzir/flatbuffer.hpp"
 #include "tenzir/null_bitmap.hpp"
+#include "tenzir/roaring_bitmap.hpp"
 #include "tenzir/test/test.hpp"
 #include "tenzir/time.hpp"
 
@@ -267,6 +268,12 @@ TEST(bitslice - coder append) {
   append_test<bitslice_coder<null_bitmap>>();
 }
 
+TEST(roaring - coder append) {
+  append_test<equality_coder<roaring_bitmap>>();
+  append_test<range_coder<roaring_bitmap>>();
+  append_test<bitslice_coder<roaring_bitmap>>();
+}
+
 TEST(fractional precision - binner) {
   using binner = precision_binner<2, 3>;
   using coder_type = multi_level_coder<range_coder<null_bitmap>>;
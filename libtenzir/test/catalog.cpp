@@ -497,3 +497,47 @@ TEST(catalog partition info by uuid lookup returns proper
 }
 
 FIXTURE_SCOPE_END()
+
+TEST(time range index) {
+  using namespace std::chrono_literals;
+  auto ids = std::vector<uuid>{};
+  for (auto i = 0; i < 4; ++i) {
+    ids.push_back(uuid::random());
+  }
+  std::sort(ids.begin(), ids.end());
+  const auto t = [](auto offset) {
+    return epoch + offset;
+  };
+  // The ranges are [0s, 10s], [5s, 15s], [20s, 30s], and [25s, 25s].
+  auto index = time_range_index::make({
+    {.partition = ids[0], .min = t(0s), .max = t(10s)},
+    {.partition = ids[1], .min = t(5s), .max = t(15s)},
+    {.partition = ids[2], .min = t(20s), .max = t(30s)},
+  });
+  index.insert({.partition = ids[3], .min = t(25s), .max = t(25s)});
+  REQUIRE_EQUAL(index.size(), 4u);
+  const auto lookup = [&](relational_operator op, duration offset) {
+    return unbox(index.lookup(op, t(offset)));
+  };
+  using ids_t = std::vector<uuid>;
+  CHECK_EQUAL(lookup(relational_operator::less, 5s), (ids_t{ids[0]}));
+  CHECK_EQUAL(lookup(relational_operator::less_equal, 5s),
+              (ids_t{ids[0], ids[1]}));
+  CHECK_EQUAL(lookup(relational_operator::greater, 25s), (ids_t{ids[2]}));
+  CHECK_EQUAL(lookup(relational_operator::greater_equal, 25s),
+              (ids_t{ids[2], ids[3]}));
+  CHECK_EQUAL(lookup(relational_operator::equal, 7s), (ids_t{ids[0], ids[1]}));
+  CHECK_EQUAL(lookup(relational_operator::equal, 17s), ids_t{});
+  CHECK_EQUAL(lookup(relational_operator::equal, 25s),
+              (ids_t{ids[2], ids[3]}));
+  CHECK_EQUAL(lookup(relational_operator::not_equal, 25s), ids);
+  CHECK(not index.lookup(relational_operator::in, t(0s)));
+  MESSAGE("replace and erase ranges");
+  index.insert({.partition = ids[0], .min = t(40s), .max = t(50s)});
+  CHECK_EQUAL(lookup(relational_operator::less, 5s), ids_t{});
+  CHECK_EQUAL(lookup(relational_operator::greater, 35s), (ids_t{ids[0]}));
+  index.erase(ids[2]);
+  REQUIRE_EQUAL(index.size(), 3u);
+  CHECK_EQUAL(lookup(relational_operator::greater_equal, 25s),
+              (ids_t{ids[0], ids[3]}));
+}
@@ -0,0 +1,177 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/compiled_json_printer.hpp"
+
+#include "tenzir/arrow_table_slice.hpp"
+#include "tenzir/concept/parseable/tenzir/ip.hpp"
+#include "tenzir/concept/parseable/tenzir/subnet.hpp"
+#include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/concept/printable/tenzir/json.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/table_slice_builder.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/type.hpp"
+
+#include <arrow/record_batch.h>
+#include <caf/test/dsl.hpp>
+
+#include <chrono>
+
+using namespace tenzir;
+using namespace std::chrono_literals;
+using namespace std::string_view_literals;
+
+namespace {
+
+enumeration operator"" _e(unsigned long long int x) {
+  return static_cast<enumeration>(x);
+}
+
+auto make_blob(std::string_view str) -> blob {
+  return {reinterpret_cast<const std::byte*>(str.data()), str.size()};
+}
+
+struct fixture {
+  fixture() {
+    const auto et = enumeration_type{{"foo"}, {"bar"}, {"baz"}};
+    schema = type{
+      "test.json",
+      record_type{
+        {"bool", bool_type{}},
+        {"int", int64_type{}},
+        {"count", uint64_type{}},
+        {"real", double_type{}},
+        {"duration", duration_type{}},
+        {"time", time_type{}},
+        {"string", string_type{}},
+        {"blob", blob_type{}},
+        {"ip", ip_type{}},
+        {"subnet", subnet_type{}},
+        {"enum", et},
+        {"list", list_type{int64_type{}}},
+        {"enums", list_type{et}},
+        {"map", map_type{et, uint64_type{}}},
+        {"record",
+         record_type{
+           {"a", string_type{}},
+           {"b", record_type{{"c", et}}},
+         }},
+        {"records", list_type{record_type{
+                      {"x", int64_type{}},
+                      {"y", list_type{string_type{}}},
+                    }}},
+      },
+    };
+    auto builder = table_slice_builder{schema};
+    const auto add = [&](auto&&... xs) {
+      REQUIRE((builder.add(xs) && ...));
+    };
+    add(true, int64_t{-42}, uint64_t{42}, 4.2, duration{5s},
+        time{} + duration{1'700'000'000s},
+        "\"quoted\" text with a newline\n, a tab\t, and \x01 control "
+        "characters that spans multiple blocks"sv,
+        make_blob("blob"), unbox(to<ip>("10.0.0.1")),
+        unbox(to<subnet>("10.0.0.0/8")), 1_e, list{int64_t{1}, int64_t{2}},
+        list{0_e, 2_e}, map{{0_e, uint64_t{1}}, {1_e, caf::none}}, "a"sv, 2_e,
+        list{record{{"x", int64_t{1}},
+                    {"y", list{std::string{"p"}, caf::none}}}});
+    add(caf::none, caf::none, caf::none, caf::none, caf::none, caf::none,
+        caf::none, caf::none, caf::none, caf::none, caf::none, caf::none,
+        caf::none, caf::none, caf::none, caf::none, caf::none);
+    add(false, int64_t{0}, uint64_t{0}, 1e20, duration{0s}, time{}, ""sv,
+        make_blob(""), unbox(to<ip>("2001:db8::")),
+        unbox(to<subnet>("2001:db8::/32")), 0_e, list{}, list{}, map{},
+        caf::none, caf::none,
+        list{record{{"x", caf::none}, {"y", list{}}}, caf::none});
+    slice = builder.finish();
+    REQUIRE_EQUAL(slice.rows(), 3u);
+  }
+
+  /// Prints the slice with the row-wise `json_printer`.
+  auto print_reference(const json_printer_options& options) const
+    -> std::string {
+    auto printer = json_printer{options};
+    auto result = std::string{};
+    auto out = std::back_inserter(result);
+    auto resolved = resolve_enumerations(slice);
+    auto array = to_record_batch(resolved)->ToStructArray().ValueOrDie();
+    for (const auto& row :
+         values(caf::get<record_type>(resolved.schema()), *array)) {
+      REQUIRE(row);
+      REQUIRE(printer.print(out, *row));
+      result += '\n';
+    }
+    return result;
+  }
+
+  auto print(const json_printer_options& options) const -> std::string {
+    auto result = std::string{};
+    compiled_json_printer{schema, options}.print(slice, result);
+    return result;
+  }
+
+  type schema;
+  table_slice slice;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(compiled_json_printer_tests, fixture)
+
+TEST(compiled JSON printer - oneline) {
+  const auto options = json_printer_options{.style = no_style(),
+                                            .oneline = true};
+  const auto result = print(options);
+  CHECK_EQUAL(result, print_reference(options));
+  MESSAGE(result);
+}
+
+TEST(compiled JSON printer - indented) {
+  const auto options = json_printer_options{.style = no_style()};
+  CHECK_EQUAL(print(options), print_reference(options));
+}
+
+TEST(compiled JSON printer - omit empty values) {
+  for (auto oneline : {true, false}) {
+    const auto options = json_printer_options{
+      .style = no_style(),
+      .oneline = oneline,
+      .omit_nulls = true,
+      .omit_empty_records = true,
+      .omit_empty_lists = true,
+      .omit_empty_maps = true,
+    };
+    CHECK_EQUAL(print(options), print_reference(options));
+  }
+}
+
+TEST(compiled JSON printer - styles) {
+  for (auto oneline : {true, false}) {
+    const auto options = json_printer_options{
+      .style = jq_style(),
+      .oneline = oneline,
+      .numeric_durations = true,
+      .omit_nulls = true,
+    };
+    CHECK_EQUAL(print(options), print_reference(options));
+  }
+}
+
+TEST(compiled JSON printer - row ranges) {
+  const auto options = json_printer_options{.style = no_style(),
+                                            .oneline = true};
+  const auto printer = compiled_json_printer{schema, options};
+  auto result = std::string{};
+  printer.print(slice, 0, 1, result);
+  printer.print(slice, 1, 1, result);
+  printer.print(slice, 1, 3, result);
+  CHECK_EQUAL(result, print(options));
+}
+
+FIXTURE_SCOPE_END()
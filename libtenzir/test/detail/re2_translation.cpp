@@ -0,0 +1,96 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/detail/re2_translation.hpp"
+
+#include "tenzir/test/test.hpp"
+
+using namespace std::string_literals;
+using namespace tenzir::detail;
+
+namespace {
+
+auto literal_of(std::string_view pattern) -> std::string {
+  return translate_to_re2(pattern, false, false).literal;
+}
+
+} // namespace
+
+TEST(literal - longest run) {
+  CHECK_EQUAL(literal_of("ab.cdef.g"), "cdef"s);
+  CHECK_EQUAL(literal_of("[a-z]+ foo bar"), " foo bar"s);
+  CHECK_EQUAL(literal_of("^GET "), "GET "s);
+}
+
+TEST(literal - quantifiers) {
+  CHECK_EQUAL(literal_of("abcd?"), "abc"s);
+  CHECK_EQUAL(literal_of("abcd*e"), "abc"s);
+  CHECK_EQUAL(literal_of("abcd+e"), "abcd"s);
+  CHECK_EQUAL(literal_of("abcd{2}"), "abc"s);
+  CHECK_EQUAL(literal_of("ab{c"), "ab{c"s);
+}
+
+TEST(literal - groups and alternatives) {
+  CHECK_EQUAL(literal_of("foo(?:bar)?bazz"), "bazz"s);
+  CHECK_EQUAL(literal_of("foo|barbaz"), ""s);
+  CHECK_EQUAL(literal_of("foo(?:bar|baz)"), "foo"s);
+  CHECK_EQUAL(literal_of("(?i)foobar"), ""s);
+  CHECK_EQUAL(literal_of("ab(?=cdef)"), "ab"s);
+}
+
+TEST(literal - escaped punctuation) {
+  CHECK_EQUAL(literal_of(R"(hello\.world)"), "hello.world"s);
+  CHECK_EQUAL(literal_of(R"(\[foo\])"), "[foo]"s);
+}
+
+TEST(literal - escape sequences) {
+  // The arguments of escape sequences are not part of the literal.
+  CHECK_EQUAL(literal_of(R"(abc\x41def)"), "abc"s);
+  CHECK_EQUAL(literal_of(R"(ab\x41\x42cd)"), "ab"s);
+  CHECK_EQUAL(literal_of(R"(ab\x{41}cdefg)"), "cdefg"s);
+  CHECK_EQUAL(literal_of(R"(foo\p{L}barbaz)"), "barbaz"s);
+  CHECK_EQUAL(literal_of(R"(foo\P{Lu}ba)"), "foo"s);
+  CHECK_EQUAL(literal_of(R"(x\pLyyy)"), "yyy"s);
+  CHECK_EQUAL(literal_of(R"(ab\101cde)"), "cde"s);
+  CHECK_EQUAL(literal_of(R"(ab\0cde)"), "cde"s);
+  CHECK_EQUAL(literal_of(R"(ab\cAcde)"), "cde"s);
+  CHECK_EQUAL(literal_of(R"(ab\k<name>cde)"), "cde"s);
+  CHECK_EQUAL(literal_of(R"(abc\g{-1}d)"), "abc"s);
+  CHECK_EQUAL(literal_of(R"(abc\g12d)"), "abc"s);
+  CHECK_EQUAL(literal_of(R"(\d123)"), "123"s);
+  CHECK_EQUAL(literal_of(R"(ab\QHello\E)"), "ab"s);
+}
+
+TEST(regex - escape sequences are copied verbatim) {
+  for (auto pattern : {R"(abc\x41def)", R"(ab\x{41}cd)", R"(foo\p{L}bar)",
+                       R"(ab\101cde)", R"(\d+\s*\w)"}) {
+    CHECK_EQUAL(translate_to_re2(pattern, false, false).regex,
+                std::string{pattern});
+  }
+}
+
+TEST(regex - captures) {
+  auto result = translate_to_re2("(?<a>x)(y)(?P<b>z)", false, false);
+  CHECK_EQUAL(result.regex, "(x)(?:y)(z)"s);
+  REQUIRE_EQUAL(result.groups.size(), 2u);
+  CHECK_EQUAL(result.groups[0].first, "a"s);
+  CHECK_EQUAL(result.groups[0].second, 1);
+  CHECK_EQUAL(result.groups[1].first, "b"s);
+  CHECK_EQUAL(result.groups[1].second, 2);
+  result = translate_to_re2("(?<a>x)(y)(?P<b>z)", true, false);
+  CHECK_EQUAL(result.regex, "(x)(y)(z)"s);
+  REQUIRE_EQUAL(result.groups.size(), 2u);
+  CHECK_EQUAL(result.groups[1].second, 3);
+}
+
+TEST(regex - unsupported constructs) {
+  CHECK_EQUAL(translate_to_re2("(?>ab)c++", false, false).regex, "(?:ab)c+"s);
+  CHECK_EQUAL(translate_to_re2("a(?!b)", false, false).regex, "a(?:b){0}"s);
+  CHECK_EQUAL(translate_to_re2("a{1,1000}", false, false).regex, "a{1,1000}"s);
+  CHECK_EQUAL(translate_to_re2("a{1,1000}", false, true).regex, "a{1,}"s);
+}
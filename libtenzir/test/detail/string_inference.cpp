@@ -0,0 +1,138 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/detail/string_inference.hpp"
+
+#include "tenzir/concept/parseable/tenzir/data.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <variant>
+
+using namespace tenzir;
+using namespace tenzir::detail;
+
+namespace {
+
+/// Parses a string the way the JSON parser infers types for strings.
+auto is_typed(std::string_view str) -> bool {
+  static constexpr auto parser
+    = parsers::time | parsers::duration | parsers::net | parsers::ip;
+  auto result = std::variant<time, duration, subnet, ip>{};
+  return parser(str, result);
+}
+
+/// Feeds a string of the field at `path` to the cache the way the JSON parser
+/// does, and returns whether the parser attempted to infer its type.
+auto add(string_inference_cache& cache, std::string_view path,
+         std::string_view str) -> bool {
+  auto& plain_strings = cache.plain_strings(path);
+  if (not cache.should_infer(plain_strings)) {
+    return false;
+  }
+  if (could_be_typed(str) and is_typed(str)) {
+    plain_strings = 0;
+  } else {
+    ++plain_strings;
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(could_be_typed - time) {
+  for (auto str : {"2024-01-01", "2024-01-01T12:34:56Z", "@1700000000", "now",
+                   "now - 1h", "now + 2 days", "in 2 hours", "5 min ago"}) {
+    MESSAGE(str);
+    CHECK(is_typed(str));
+    CHECK(could_be_typed(str));
+  }
+}
+
+TEST(could_be_typed - duration) {
+  for (auto str : {"1s", "-5ms", "42 minutes", "1.5h"}) {
+    MESSAGE(str);
+    CHECK(is_typed(str));
+    CHECK(could_be_typed(str));
+  }
+}
+
+TEST(could_be_typed - ip and subnet) {
+  for (auto str : {"127.0.0.1", "::", "::1", "fe80::1", "ABCD::1",
+                   "2001:db8::", "10.0.0.0/8", "::/0", "dead:beef::/32"}) {
+    MESSAGE(str);
+    CHECK(is_typed(str));
+    CHECK(could_be_typed(str));
+  }
+}
+
+TEST(could_be_typed - digit free spellings) {
+  // These spellings pass the check whether or not a parser accepts them.
+  for (auto str : {"now", "NOW", "in", "inf", "nan", "NaN", ":"}) {
+    MESSAGE(str);
+    CHECK(could_be_typed(str));
+  }
+}
+
+TEST(could_be_typed - plain strings) {
+  for (auto str : {"", "alice", "hello", "true", "false", "ghost", "deadbeef",
+                   "-", "+", ".", "@", "x86", "Zeek 6.0", " 1s", "/8"}) {
+    MESSAGE(str);
+    CHECK(not could_be_typed(str));
+    CHECK(not is_typed(str));
+  }
+}
+
+TEST(could_be_typed - no false negatives) {
+  // A string that a parser accepts must never be rejected up front.
+  for (auto str : {"0", "1", "00:00:00", "1970-01-01", "+1s", ".5s", "1e3s",
+                   "1.2.3.4", "1.2.3.4/32", "a::", "c0a8::", "F::", "@0",
+                   "in 1s", "1s ago", "hello 1.2", "done", "example.com"}) {
+    MESSAGE(str);
+    if (is_typed(str)) {
+      CHECK(could_be_typed(str));
+    }
+  }
+}
+
+TEST(string_inference_cache - stops after the limit per field) {
+  auto cache = string_inference_cache{3};
+  MESSAGE("the field `a` has only plain strings");
+  CHECK(add(cache, "a", "foo"));
+  CHECK(add(cache, "a", "bar"));
+  CHECK(add(cache, "a", "baz"));
+  CHECK(not add(cache, "a", "qux"));
+  MESSAGE("typed strings of `a` are no longer inferred");
+  CHECK(not add(cache, "a", "10.0.0.1"));
+  MESSAGE("the field `b` still infers types");
+  CHECK(add(cache, "b", "foo"));
+  CHECK(add(cache, "b", "bar"));
+  CHECK(add(cache, "b", "10.0.0.1"));
+  CHECK(add(cache, "b", "foo"));
+  CHECK(add(cache, "b", "bar"));
+  CHECK(add(cache, "b", "baz"));
+  CHECK(not add(cache, "b", "10.0.0.2"));
+  MESSAGE("nested fields count separately from their parents");
+  CHECK(add(cache, "a.b", "foo"));
+}
+
+TEST(string_inference_cache - typed strings reset the count) {
+  auto cache = string_inference_cache{2};
+  for (auto i = 0; i < 10; ++i) {
+    CHECK(add(cache, "x", "plain"));
+    CHECK(add(cache, "x", "1.2.3.4"));
+  }
+  CHECK_EQUAL(cache.plain_strings("x"), uint64_t{0});
+}
+
+TEST(string_inference_cache - a limit of 0 never stops) {
+  auto cache = string_inference_cache{0};
+  for (auto i = 0; i < 10'000; ++i) {
+    REQUIRE(add(cache, "x", "plain"));
+  }
+  CHECK_EQUAL(cache.plain_strings("x"), uint64_t{10'000});
+}
@@ -0,0 +1,135 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/detail/tinylfu_cache.hpp"
+
+#include "tenzir/test/test.hpp"
+
+namespace {
+
+/// Creates values equal to their key that weigh as much as their key.
+struct int_factory {
+  int operator()(int x) {
+    return x;
+  }
+
+  size_t weight(int x) const {
+    return static_cast<size_t>(x);
+  }
+};
+
+using cache_type = tenzir::detail::tinylfu_cache<int, int, int_factory>;
+
+} // namespace
+
+TEST(loading and dropping) {
+  auto cache = cache_type{1000, int_factory{}};
+  CHECK_EQUAL(cache.size(), 0u);
+  CHECK_EQUAL(cache.get_or_load(10), 10);
+  CHECK_EQUAL(cache.get_or_load(20), 20);
+  CHECK_EQUAL(cache.get_or_load(10), 10);
+  CHECK_EQUAL(cache.size(), 2u);
+  CHECK_EQUAL(cache.weight(), 30u);
+  CHECK_EQUAL(cache.stats().hits, 1u);
+  CHECK_EQUAL(cache.stats().misses, 2u);
+  auto sum = 0;
+  for (const auto& [key, value] : cache)
+    sum += value;
+  CHECK_EQUAL(sum, 30);
+  cache.drop(10);
+  CHECK(!cache.contains(10));
+  CHECK_EQUAL(cache.weight(), 20u);
+  cache.clear();
+  CHECK_EQUAL(cache.size(), 0u);
+  CHECK_EQUAL(cache.weight(), 0u);
+}
+
+TEST(weight bound) {
+  auto cache = cache_type{1000, int_factory{}};
+  for (auto i = 1; i <= 100; ++i) {
+    cache.get_or_load(i * 10);
+    CHECK_LESS_EQUAL(cache.weight(), cache.capacity());
+  }
+  CHECK_GREATER(cache.stats().evictions, 0u);
+  // An entry that exceeds the capacity on its own is returned, but not kept.
+  CHECK_EQUAL(cache.get_or_load(2000), 2000);
+  CHECK(!cache.contains(2000));
+  CHECK_LESS_EQUAL(cache.weight(), cache.capacity());
+}
+
+TEST(frequently used entries survive scans) {
+  auto cache = cache_type{1000, int_factory{}};
+  // Access a working set repeatedly to make it known to the frequency sketch.
+  for (auto round = 0; round < 10; ++round)
+    for (auto key : {100, 101, 102, 103})
+      cache.get_or_load(key);
+  // A scan over many keys that are accessed once must not replace the working
+  // set, which a plain LRU cache would do.
+  for (auto key = 200; key < 300; ++key)
+    cache.get_or_load(key);
+  for (auto key : {100, 101, 102, 103})
+    CHECK(cache.contains(key));
+}
+
+TEST(prefetching) {
+  auto cache = cache_type{1000, int_factory{}};
+  cache.prefetch(42);
+  cache.prefetch(42);
+  CHECK(cache.contains(42));
+  CHECK_EQUAL(cache.stats().prefetches, 1u);
+  CHECK_EQUAL(cache.stats().misses, 0u);
+  CHECK_EQUAL(cache.get_or_load(42), 42);
+  CHECK_EQUAL(cache.stats().hits, 1u);
+}
+
+TEST(prefetched entries survive until their first access) {
+  auto cache = cache_type{1000, int_factory{}};
+  // Fill the main cache with entries that were accessed repeatedly, so that
+  // new entries must compete for admission.
+  for (auto round = 0; round < 3; ++round)
+    for (auto key : {180, 181, 182, 183, 184})
+      cache.get_or_load(key);
+  CHECK(cache.prefetch(50));
+  cache.get_or_load(40);
+  // Overflowing the window moves its least recently used entry to the main
+  // cache, which must not be the prefetched one.
+  cache.get_or_load(30);
+  CHECK(cache.contains(50));
+  CHECK_LESS_EQUAL(cache.weight(), cache.capacity());
+  MESSAGE("prefetched entries are bounded by the weight of the window");
+  CHECK(!cache.prefetch(60));
+  CHECK(!cache.contains(60));
+  CHECK_EQUAL(cache.stats().prefetches, 1u);
+  MESSAGE("the first access finds the prefetched entry");
+  CHECK_EQUAL(cache.get_or_load(50), 50);
+  CHECK_EQUAL(cache.stats().hits, 11u);
+  CHECK_EQUAL(cache.stats().misses, 7u);
+}
+
+TEST(resizing) {
+  auto cache = cache_type{1000, int_factory{}};
+  cache.get_or_load(10);
+  cache.get_or_load(20);
+  cache.get_or_load(30);
+  CHECK_EQUAL(cache.size(), 3u);
+  cache.resize(40);
+  CHECK_LESS_EQUAL(cache.weight(), 40u);
+  cache.resize(0);
+  CHECK_EQUAL(cache.size(), 0u);
+}
+
+TEST(eject) {
+  auto cache = cache_type{1000, int_factory{}};
+  cache.get_or_load(1);
+  CHECK_EQUAL(cache.size(), 1u);
+  CHECK_EQUAL(cache.eject(0), 0);
+  CHECK_EQUAL(cache.size(), 1u);
+  CHECK_EQUAL(cache.eject(1), 1);
+  CHECK_EQUAL(cache.size(), 0u);
+  CHECK_EQUAL(cache.weight(), 0u);
+}
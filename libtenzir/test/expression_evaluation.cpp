@@ -9,6 +9,7 @@
 #include "tenzir/concept/parseable/tenzir/expression.hpp"
 #include "tenzir/concept/parseable/tenzir/time.hpp"
 #include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/detail/narrow.hpp"
 #include "tenzir/expression.hpp"
 #include "tenzir/expression_visitors.hpp"
 #include "tenzir/ids.hpp"
@@ -17,6 +18,7 @@
 #include "tenzir/test/fixtures/events.hpp"
 #include "tenzir/test/test.hpp"
 
+#include <arrow/array.h>
 #include <caf/test/dsl.hpp>
 
 using namespace tenzir;
@@ -92,4 +94,37 @@ TEST(evaluation - empty expression) {
   CHECK(all<0>(ids));
 }
 
+TEST(evaluation - vectorized evaluation matches row - wise evaluation) {
+  const auto exprs = std::vector<std::string_view>{
+    ":uint64 == 350",
+    ":uint64 > 350 || :uint64 < 100",
+    "\"http\" in :string && :duration > 30s",
+    "orig_h != 192.168.1.102 && proto != \"udp\"",
+    "service == null && orig_h == fe80::219:e3ff:fee7:5d23",
+    "service != null",
+    "orig_h in 192.168.1.0/24",
+    "orig_h !in 192.168.1.0/24",
+    "proto in [\"tcp\", \"icmp\"]",
+    "proto == /t.p/",
+    "proto != /t.p/",
+    "uid in /zg/",
+    "! (duration > 1s)",
+    "#schema == \"zeek.conn\" && ts > 2009-11-18T10:00:00",
+  };
+  for (const auto& str : exprs) {
+    MESSAGE("evaluating " << str);
+    const auto expr = make_conn_expr(str);
+    const auto expected = evaluate(expr, zeek_conn_log_slice, {});
+    const auto mask = evaluate_vectorized(expr, zeek_conn_log_slice);
+    REQUIRE_EQUAL(detail::narrow_cast<size_t>(mask->length()),
+                  zeek_conn_log_slice.rows());
+    CHECK_EQUAL(mask->null_count(), 0);
+    auto actual = ids{};
+    for (auto row = int64_t{0}; row < mask->length(); ++row) {
+      actual.append_bit(mask->Value(row));
+    }
+    CHECK_EQUAL(actual, expected);
+  }
+}
+
 FIXTURE_SCOPE_END()
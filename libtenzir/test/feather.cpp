@@ -6,11 +6,13 @@
 // SPDX-FileCopyrightText: (c) 2021 The Tenzir Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/chunk.hpp>
 #include <tenzir/collect.hpp>
 #include <tenzir/concept/parseable/tenzir/expression.hpp>
 #include <tenzir/concept/parseable/tenzir/subnet.hpp>
 #include <tenzir/concept/parseable/to.hpp>
+#include <tenzir/defaults.hpp>
 #include <tenzir/detail/narrow.hpp>
 #include <tenzir/detail/spawn_container_source.hpp>
 #include <tenzir/expression.hpp>
@@ -25,6 +27,10 @@
 #include <tenzir/test/memory_filesystem.hpp>
 #include <tenzir/test/test.hpp>
 
+#include <arrow/io/memory.h>
+#include <arrow/ipc/feather.h>
+#include <arrow/table.h>
+
 #include <chrono>
 
 namespace tenzir::plugins::feather {
@@ -59,6 +65,32 @@ auto compare_table_slices(const table_slice& left, const table_slice& right) {
   }
 }
 
+/// Writes a table slice in the nested layout used before stores were written
+/// flat, i.e., with an `import_time` column next to an `event` column that
+/// holds the events as a struct.
+auto make_legacy_feather(const table_slice& slice) -> chunk_ptr {
+  auto rb = to_record_batch(slice);
+  auto event_array = rb->ToStructArray().ValueOrDie();
+  auto builder = time_type::make_arrow_builder(arrow::default_memory_pool());
+  for (int64_t i = 0; i < rb->num_rows(); ++i)
+    REQUIRE(
+      builder->Append(slice.import_time().time_since_epoch().count()).ok());
+  auto time_col = builder->Finish().ValueOrDie();
+  auto schema = arrow::schema(
+    {arrow::field("import_time", time_type::to_arrow_type()),
+     arrow::field("event", event_array->type(), rb->schema()->metadata())});
+  auto wrapped
+    = arrow::RecordBatch::Make(schema, rb->num_rows(), {time_col, event_array});
+  auto table = arrow::Table::FromRecordBatches({wrapped}).ValueOrDie();
+  auto stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  auto write_properties = arrow::ipc::feather::WriteProperties::Defaults();
+  write_properties.compression = arrow::Compression::ZSTD;
+  REQUIRE(arrow::ipc::feather::WriteTable(*table, stream.get(),
+                                          write_properties)
+            .ok());
+  return chunk::make(stream->Finish().ValueOrDie());
+}
+
 uint64_t operator"" _c(unsigned long long int x) {
   return static_cast<uint64_t>(x);
 }
@@ -78,12 +110,14 @@ struct fixture : fixtures::deterministic_actor_system_and_events {
   query(const store_actor& actor, const ids& ids,
         const expression& expr = expression{
           predicate{meta_extractor{meta_extractor::schema},
-                    relational_operator::not_equal, data{std::string{}}}}) {
+                    relational_operator::not_equal, data{std::string{}}}},
+        std::optional<std::vector<std::string>> fields = std::nullopt) {
     bool done = false;
     uint64_t tally = 0;
     uint64_t rows = 0;
     std::vector<table_slice> result;
     auto query = query_context::make_extract("test", self, expr);
+    caf::get<extract_query_context>(query.cmd).fields = std::move(fields);
     query.id = uuid::random();
     query.ids = ids;
     self->send(actor, atom::query_v, query);
@@ -375,6 +409,108 @@ TEST(passive feather store selective query) {
   compare_table_slices(*expected_slice, results[0]);
 }
 
+TEST(passive feather store projected query) {
+  auto f = table_slice_fixture();
+  auto slice = f.slice;
+  auto expr = to<expression>("f1 == \"n1\"");
+  auto uuid = tenzir::uuid::random();
+  const auto* plugin
+    = tenzir::plugins::find<tenzir::store_actor_plugin>("feather");
+  REQUIRE(plugin);
+  auto builder_and_header
+    = plugin->make_store_builder(accountant, filesystem, uuid);
+  REQUIRE_NOERROR(builder_and_header);
+  auto& [builder, header] = *builder_and_header;
+  auto slices = std::vector<table_slice>{slice};
+  tenzir::detail::spawn_container_source(sys, slices, builder);
+  run();
+  auto store = plugin->make_store(accountant, filesystem, as_bytes(header));
+  REQUIRE_NOERROR(store);
+  run();
+  MESSAGE("the store reads only the required and the filtered fields");
+  auto results = query(*store, tenzir::ids{}, *expr,
+                       std::vector<std::string>{"f12.f11_2"});
+  run();
+  REQUIRE_EQUAL(results.size(), 1ull);
+  const auto& schema = caf::get<record_type>(results[0].schema());
+  REQUIRE_EQUAL(schema.num_fields(), 2ull);
+  CHECK_EQUAL(schema.field(0).name, "f1");
+  CHECK_EQUAL(schema.field(1).name, "f12");
+  CHECK_EQUAL(results[0].schema().name(), "rec");
+  REQUIRE_EQUAL(results[0].rows(), 1ull);
+  CHECK_EQUAL(materialize(results[0].at(0, 0)), data{"n1"});
+  CHECK_EQUAL(materialize(results[0].at(0, 3)),
+              data{unbox(to<ip>("172.16.7.29"))});
+}
+
+TEST(passive feather store reads legacy nested layout) {
+  auto f = table_slice_fixture();
+  auto slice = f.slice;
+  auto uuid = tenzir::uuid::random();
+  const auto* plugin
+    = tenzir::plugins::find<tenzir::store_actor_plugin>("feather");
+  REQUIRE(plugin);
+  auto path = std::filesystem::absolute(defaults::state_directory.data())
+              / "archive" / fmt::format("{}.feather", uuid);
+  self->send(filesystem, atom::write_v, path, make_legacy_feather(slice));
+  run();
+  auto header = chunk::copy(uuid);
+  auto store = plugin->make_store(accountant, filesystem, as_bytes(header));
+  REQUIRE_NOERROR(store);
+  run();
+  auto results = query(*store, tenzir::ids{});
+  run();
+  REQUIRE_EQUAL(results.size(), 1ull);
+  compare_table_slices(slice, results[0]);
+  MESSAGE("filtered queries read all fields from legacy stores");
+  results = query(*store, tenzir::ids{}, unbox(to<expression>("f1 == \"n1\"")),
+                  std::vector<std::string>{"f12.f11_2"});
+  run();
+  REQUIRE_EQUAL(results.size(), 1ull);
+  CHECK_EQUAL(results[0].schema(), slice.schema());
+  REQUIRE_EQUAL(results[0].rows(), 1ull);
+  CHECK_EQUAL(materialize(results[0].at(0, 0)), data{"n1"});
+}
+
+TEST(passive feather store skips record batches) {
+  auto schema = type{"ints", record_type{{"x", int64_type{}}}};
+  auto builder = std::make_shared<table_slice_builder>(schema);
+  const auto num_rows = defaults::import::table_slice_size + 1000;
+  for (size_t i = 0; i < num_rows; ++i) {
+    REQUIRE(builder->add(detail::narrow_cast<int64_t>(i)));
+  }
+  auto slice = builder->finish();
+  slice.import_time(std::chrono::system_clock::now());
+  const auto* plugin
+    = tenzir::plugins::find<tenzir::store_actor_plugin>("feather");
+  REQUIRE(plugin);
+  auto builder_and_header = plugin->make_store_builder(accountant, filesystem,
+                                                       tenzir::uuid::random());
+  REQUIRE_NOERROR(builder_and_header);
+  auto& [store_builder, header] = *builder_and_header;
+  auto slices = std::vector<table_slice>{slice};
+  tenzir::detail::spawn_container_source(sys, slices, store_builder);
+  run();
+  auto store = plugin->make_store(accountant, filesystem, as_bytes(header));
+  REQUIRE_NOERROR(store);
+  run();
+  MESSAGE("the results of skipped record batches are missing");
+  const auto threshold = defaults::import::table_slice_size + 500;
+  auto expr = to<expression>(fmt::format("x >= {}", threshold));
+  REQUIRE(expr);
+  auto results = query(*store, tenzir::ids{}, *expr);
+  run();
+  REQUIRE_EQUAL(rows(results), 500ull);
+  CHECK_EQUAL(results[0].offset(), threshold);
+  CHECK_EQUAL(materialize(results[0].at(0, 0)),
+              data{detail::narrow_cast<int64_t>(threshold)});
+  MESSAGE("counting also skips record batches");
+  CHECK_EQUAL(count(*store, tenzir::ids{}, *expr), 500ull);
+  expr = to<expression>("x < 10");
+  REQUIRE(expr);
+  CHECK_EQUAL(count(*store, tenzir::ids{}, *expr), 10ull);
+}
+
 TEST(passive feather store erase) {
   auto f = table_slice_fixture();
   auto slice = f.slice;
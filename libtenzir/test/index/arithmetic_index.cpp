@@ -17,6 +17,9 @@
 #include "tenzir/concept/printable/to_string.hpp"
 #include "tenzir/detail/legacy_deserialize.hpp"
 #include "tenzir/detail/serialize.hpp"
+#include "tenzir/fbs/value_index.hpp"
+#include "tenzir/flatbuffer.hpp"
+#include "tenzir/roaring_bitmap.hpp"
 #include "tenzir/table_slice.hpp"
 #include "tenzir/test/test.hpp"
 #include "tenzir/value_index_factory.hpp"
@@ -153,4 +156,57 @@ TEST(none values - arithmetic) {
   CHECK_EQUAL(to_string(unbox(bm)), "00100");
 }
 
+// The attribute #index=roaring selects Roaring bitmaps for the coder.
+TEST(roaring bitmaps) {
+  using index_type = arithmetic_index<int64_t, void, roaring_bitmap>;
+  auto t = type{int64_type{}, {{"index", "roaring"}}};
+  auto idx = factory<value_index>::make(t, caf::settings{});
+  REQUIRE_NOT_EQUAL(idx, nullptr);
+  CHECK(dynamic_cast<index_type*>(idx.get()) != nullptr);
+  auto reference
+    = factory<value_index>::make(type{int64_type{}}, caf::settings{});
+  REQUIRE_NOT_EQUAL(reference, nullptr);
+  for (auto x : {int64_t{42}, int64_t{-7}, int64_t{1'000'000}, int64_t{42},
+                 int64_t{0}, int64_t{43}}) {
+    REQUIRE(idx->append(make_data_view(x)));
+    REQUIRE(reference->append(make_data_view(x)));
+  }
+  REQUIRE(idx->append(make_data_view(caf::none)));
+  REQUIRE(reference->append(make_data_view(caf::none)));
+  const auto check_lookups = [&](const value_index& x) {
+    for (auto op : {relational_operator::equal, relational_operator::not_equal,
+                    relational_operator::less, relational_operator::greater,
+                    relational_operator::less_equal,
+                    relational_operator::greater_equal}) {
+      for (auto y : {int64_t{-10}, int64_t{0}, int64_t{42}, int64_t{43}}) {
+        CHECK_EQUAL(to_string(unbox(x.lookup(op, make_data_view(y)))),
+                    to_string(unbox(reference->lookup(op, make_data_view(y)))));
+      }
+    }
+  };
+  check_lookups(*idx);
+  CHECK_EQUAL(to_string(unbox(idx->lookup(relational_operator::equal,
+                                          make_data_view(int64_t{42})))),
+              "1001000");
+  MESSAGE("serialization");
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  const auto idx_offset = pack(builder, idx);
+  builder.Finish(idx_offset);
+  auto maybe_fb = flatbuffer<fbs::ValueIndex>::make(builder.Release());
+  REQUIRE_NOERROR(maybe_fb);
+  auto fb = *maybe_fb;
+  REQUIRE(fb);
+  auto idx2 = value_index_ptr{};
+  REQUIRE_EQUAL(unpack(*fb, idx2), caf::none);
+  CHECK_EQUAL(idx2->type(), t);
+  CHECK(dynamic_cast<index_type*>(idx2.get()) != nullptr);
+  check_lookups(*idx2);
+  MESSAGE("non-arithmetic types");
+  auto string_type_with_roaring
+    = type{string_type{}, {{"index", "roaring"}}};
+  CHECK_EQUAL(
+    factory<value_index>::make(string_type_with_roaring, caf::settings{}),
+    nullptr);
+}
+
 FIXTURE_SCOPE_END()
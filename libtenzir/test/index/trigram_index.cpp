@@ -0,0 +1,107 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/index/trigram_index.hpp"
+
+#include "tenzir/concept/printable/tenzir/bitmap.hpp"
+#include "tenzir/concept/printable/to_string.hpp"
+#include "tenzir/detail/legacy_deserialize.hpp"
+#include "tenzir/detail/serialize.hpp"
+#include "tenzir/fbs/value_index.hpp"
+#include "tenzir/flatbuffer.hpp"
+#include "tenzir/pattern.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/value_index_factory.hpp"
+
+#include <caf/test/dsl.hpp>
+
+using namespace tenzir;
+using namespace std::string_literals;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    factory<value_index>::initialize();
+  }
+
+  static auto to_pattern(std::string str, bool case_insensitive = false) {
+    return unbox(pattern::make(std::move(str), {case_insensitive}));
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(trigram_index_tests, fixture)
+
+TEST(trigram index) {
+  auto idx = factory<value_index>::make(
+    type{string_type{}, {{"index", "trigram"}}}, caf::settings{});
+  REQUIRE_NOT_EQUAL(idx, nullptr);
+  REQUIRE(dynamic_cast<trigram_index*>(idx.get()));
+  MESSAGE("append");
+  REQUIRE(idx->append(make_data_view("GET /index.html")));
+  REQUIRE(idx->append(make_data_view("POST /login.php")));
+  REQUIRE(idx->append(make_data_view(caf::none)));
+  REQUIRE(idx->append(make_data_view("GET /login.php")));
+  REQUIRE(idx->append(make_data_view("ab")));
+  REQUIRE(idx->append(make_data_view("GET /INDEX.HTML")));
+  auto lookup = [&](relational_operator op, auto x) {
+    return to_string(unbox(idx->lookup(op, make_data_view(x))));
+  };
+  MESSAGE("substrings");
+  CHECK_EQUAL(lookup(relational_operator::ni, "login"), "010100");
+  CHECK_EQUAL(lookup(relational_operator::ni, "GET"), "100101");
+  CHECK_EQUAL(lookup(relational_operator::ni, "logout"), "000000");
+  MESSAGE("substrings without trigrams select all values");
+  CHECK_EQUAL(lookup(relational_operator::ni, "ab"), "110111");
+  CHECK_EQUAL(lookup(relational_operator::not_ni, "login"), "110111");
+  MESSAGE("equality yields candidates that contain the value");
+  CHECK_EQUAL(lookup(relational_operator::equal, "/login.php"), "010100");
+  CHECK_EQUAL(lookup(relational_operator::not_equal, "/login.php"), "111111");
+  MESSAGE("patterns");
+  CHECK_EQUAL(lookup(relational_operator::equal, to_pattern("GET /.*\\.php")),
+              "000100");
+  CHECK_EQUAL(lookup(relational_operator::in, to_pattern("\\.html$")),
+              "100001");
+  CHECK_EQUAL(lookup(relational_operator::in, to_pattern("index", true)),
+              "100001");
+  CHECK_EQUAL(lookup(relational_operator::in, to_pattern("html|php")),
+              "110111");
+  CHECK_EQUAL(lookup(relational_operator::in, to_pattern("DELETE")), "000000");
+  MESSAGE("lists");
+  auto xs = list{"GET /index.html", "ab"};
+  CHECK_EQUAL(lookup(relational_operator::in, xs), "110111");
+  CHECK_EQUAL(lookup(relational_operator::not_in, xs), "110111");
+  MESSAGE("serialization");
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  const auto idx_offset = pack(builder, idx);
+  builder.Finish(idx_offset);
+  auto maybe_fb = flatbuffer<fbs::ValueIndex>::make(builder.Release());
+  REQUIRE_NOERROR(maybe_fb);
+  auto fb = *maybe_fb;
+  REQUIRE(fb);
+  auto idx2 = value_index_ptr{};
+  REQUIRE_EQUAL(unpack(*fb, idx2), caf::none);
+  REQUIRE(dynamic_cast<trigram_index*>(idx2.get()));
+  CHECK_EQUAL(idx->type(), idx2->type());
+  CHECK_EQUAL(to_string(unbox(
+                idx2->lookup(relational_operator::ni, make_data_view("login")))),
+              "010100");
+  caf::byte_buffer buf;
+  CHECK(detail::serialize(buf, idx));
+  auto idx3 = value_index_ptr{};
+  REQUIRE(detail::legacy_deserialize(buf, idx3));
+  REQUIRE_NOT_EQUAL(idx3, nullptr);
+  CHECK_EQUAL(to_string(unbox(idx3->lookup(relational_operator::in,
+                                           make_data_view(
+                                             to_pattern("\\.html$"))))),
+              "100001");
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,245 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/test/test.hpp"
+
+#include <tenzir/chunk.hpp>
+#include <tenzir/concept/parseable/tenzir/ip.hpp>
+#include <tenzir/concept/parseable/to.hpp>
+#include <tenzir/data.hpp>
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/fbs/data.hpp>
+#include <tenzir/fbs/lookup_table.hpp>
+#include <tenzir/plugin.hpp>
+#include <tenzir/series_builder.hpp>
+
+using namespace tenzir;
+
+namespace {
+
+auto plugin() -> const context_plugin& {
+  const auto* result = plugins::find<context_plugin>("lookup-table");
+  REQUIRE(result);
+  return *result;
+}
+
+auto make_context() -> std::unique_ptr<context> {
+  return unbox(plugin().make_context({}));
+}
+
+/// Updates the context with the rows of a slice, using `key` as key field.
+void update(context& ctx, const table_slice& slice, std::string key) {
+  REQUIRE_NOERROR(ctx.update(slice, {{"key", std::move(key)}}));
+}
+
+/// Returns the context that `apply` emits for every row of a slice, or null
+/// for rows without a match.
+auto lookup(const context& ctx, const table_slice& slice, std::string field)
+  -> std::vector<data> {
+  auto result = std::vector<data>{};
+  for (const auto& series : unbox(ctx.apply(slice, {{"field", field}}))) {
+    for (auto&& value : series.values()) {
+      auto row = materialize(value);
+      if (const auto* r = caf::get_if<record>(&row)) {
+        result.push_back(r->at("context"));
+      } else {
+        result.emplace_back();
+      }
+    }
+  }
+  CHECK_EQUAL(result.size(), slice.rows());
+  return result;
+}
+
+auto num_entries(const context& ctx) -> data {
+  return ctx.show().at("num_entries");
+}
+
+auto ips(const std::vector<std::string>& xs) -> table_slice {
+  auto builder = series_builder{};
+  for (const auto& x : xs) {
+    builder.record().field("ip", unbox(to<ip>(x)));
+  }
+  return builder.finish_assert_one_slice("probe");
+}
+
+auto names(const std::vector<std::string>& xs) -> table_slice {
+  auto builder = series_builder{};
+  for (const auto& x : xs) {
+    builder.record().field("name", std::string_view{x});
+  }
+  return builder.finish_assert_one_slice("probe");
+}
+
+auto ids(const std::vector<int64_t>& xs) -> table_slice {
+  auto builder = series_builder{};
+  for (auto x : xs) {
+    builder.record().field("id", x);
+  }
+  return builder.finish_assert_one_slice("probe");
+}
+
+/// Creates `{id: int64, generation: int64}` rows with the ids `[0, n)`.
+auto make_generation(int64_t n, int64_t generation) -> table_slice {
+  auto builder = series_builder{};
+  for (auto i = int64_t{0}; i < n; ++i) {
+    auto row = builder.record();
+    row.field("id", i);
+    row.field("generation", generation);
+  }
+  return builder.finish_assert_one_slice("generation");
+}
+
+auto ioc(std::string_view address, std::string_view tag) -> record {
+  return record{{"ip", unbox(to<ip>(address))}, {"tag", std::string{tag}}};
+}
+
+auto make_iocs() -> table_slice {
+  auto builder = series_builder{};
+  for (const auto& [address, tag] :
+       {std::pair{"10.0.0.1", "c2"}, std::pair{"10.0.0.2", "scanner"},
+        std::pair{"10.0.0.3", "tor"}}) {
+    auto row = builder.record();
+    row.field("ip", unbox(to<ip>(address)));
+    row.field("tag", std::string_view{tag});
+  }
+  return builder.finish_assert_one_slice("ioc");
+}
+
+} // namespace
+
+TEST(save and load round-trip) {
+  auto ctx = make_context();
+  update(*ctx, make_iocs(), "ip");
+  auto builder = series_builder{};
+  auto row = builder.record();
+  row.field("ip", unbox(to<ip>("10.0.0.2")));
+  row.field("tag", std::string_view{"benign"});
+  update(*ctx, builder.finish_assert_one_slice("ioc"), "ip");
+  auto saved = unbox(ctx->save());
+  CHECK(fbs::context::lookup_table::LookupTableDataBufferHasIdentifier(
+    saved->data()));
+  auto loaded = unbox(plugin().load_context(saved));
+  CHECK_EQUAL(num_entries(*loaded), data{uint64_t{3}});
+  const auto probe = ips({"10.0.0.3", "10.0.0.4", "10.0.0.2", "10.0.0.1"});
+  const auto expected = std::vector<data>{
+    ioc("10.0.0.3", "tor"),
+    data{},
+    ioc("10.0.0.2", "benign"),
+    ioc("10.0.0.1", "c2"),
+  };
+  CHECK_EQUAL(lookup(*ctx, probe, "ip"), expected);
+  CHECK_EQUAL(lookup(*loaded, probe, "ip"), expected);
+  MESSAGE("a loaded context accepts updates and saves again");
+  update(*loaded, make_iocs(), "ip");
+  CHECK_EQUAL(lookup(*loaded, ips({"10.0.0.2"}), "ip"),
+              std::vector<data>{ioc("10.0.0.2", "scanner")});
+  auto reloaded = unbox(plugin().load_context(unbox(loaded->save())));
+  CHECK_EQUAL(num_entries(*reloaded), data{uint64_t{3}});
+  CHECK_EQUAL(lookup(*reloaded, probe, "ip"), lookup(*loaded, probe, "ip"));
+}
+
+TEST(load legacy context) {
+  // Contexts were previously saved as a list of `{key, value}` records.
+  auto entries = list{
+    record{{"key", "alice"}, {"value", record{{"score", int64_t{1}}}}},
+    record{{"key", "bob"}, {"value", record{{"score", int64_t{2}}}}},
+  };
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  const auto offset = pack(builder, data{entries});
+  fbs::FinishDataBuffer(builder, offset);
+  auto loaded = unbox(plugin().load_context(chunk::make(builder.Release())));
+  CHECK_EQUAL(num_entries(*loaded), data{uint64_t{2}});
+  CHECK_EQUAL(lookup(*loaded, names({"bob", "carol", "alice"}), "name"),
+              (std::vector<data>{
+                record{{"score", int64_t{2}}},
+                data{},
+                record{{"score", int64_t{1}}},
+              }));
+  MESSAGE("saving a legacy context uses the current format");
+  auto saved = unbox(loaded->save());
+  CHECK(fbs::context::lookup_table::LookupTableDataBufferHasIdentifier(
+    saved->data()));
+  auto reloaded = unbox(plugin().load_context(saved));
+  CHECK_EQUAL(lookup(*reloaded, names({"alice"}), "name"),
+              std::vector<data>{record{{"score", int64_t{1}}}});
+}
+
+TEST(lookups across key types and schemas) {
+  auto ctx = make_context();
+  update(*ctx, make_iocs(), "ip");
+  auto people = series_builder{};
+  for (const auto& [name, age] :
+       {std::pair{"alice", 30}, std::pair{"bob", 40}}) {
+    auto row = people.record();
+    row.field("name", std::string_view{name});
+    row.field("age", int64_t{age});
+  }
+  update(*ctx, people.finish_assert_one_slice("person"), "name");
+  auto pets = series_builder{};
+  auto pet = pets.record();
+  pet.field("name", std::string_view{"rex"});
+  pet.field("species", std::string_view{"dog"});
+  update(*ctx, pets.finish_assert_one_slice("pet"), "name");
+  auto numbers = series_builder{};
+  auto number = numbers.record();
+  number.field("id", int64_t{42});
+  number.field("meaning", std::string_view{"everything"});
+  update(*ctx, numbers.finish_assert_one_slice("number"), "id");
+  CHECK_EQUAL(num_entries(*ctx), data{uint64_t{7}});
+  MESSAGE("keys of one type match contexts of different schemas");
+  const auto alice = record{{"name", "alice"}, {"age", int64_t{30}}};
+  const auto bob = record{{"name", "bob"}, {"age", int64_t{40}}};
+  const auto rex = record{{"name", "rex"}, {"species", "dog"}};
+  CHECK_EQUAL(lookup(*ctx, names({"alice", "rex", "nobody", "bob", "rex"}),
+                     "name"),
+              (std::vector<data>{alice, rex, data{}, bob, rex}));
+  MESSAGE("keys of a different type do not match");
+  CHECK_EQUAL(lookup(*ctx, names({"42", "10.0.0.1"}), "name"),
+              (std::vector<data>{data{}, data{}}));
+  CHECK_EQUAL(lookup(*ctx, ids({42, 0}), "id"),
+              (std::vector<data>{record{{"id", int64_t{42}},
+                                        {"meaning", "everything"}},
+                                 data{}}));
+  CHECK_EQUAL(lookup(*ctx, ips({"10.0.0.1"}), "ip"),
+              std::vector<data>{ioc("10.0.0.1", "c2")});
+  MESSAGE("a missing field yields nulls");
+  CHECK_EQUAL(lookup(*ctx, ids({1, 2}), "missing"),
+              (std::vector<data>{data{}, data{}}));
+}
+
+TEST(lookups after compaction) {
+  // Overwriting every key twice leaves more dead rows than live ones, and
+  // enough of them to trigger a compaction.
+  constexpr auto n = int64_t{70'000};
+  auto ctx = make_context();
+  for (auto i = int64_t{1}; i <= 3; ++i) {
+    update(*ctx, make_generation(n, i), "id");
+  }
+  CHECK_EQUAL(num_entries(*ctx), data{detail::narrow_cast<uint64_t>(n)});
+  auto expected = [](int64_t id, int64_t generation) -> data {
+    return record{{"id", id}, {"generation", generation}};
+  };
+  CHECK_EQUAL(lookup(*ctx, ids({0, n - 1, n, 12'345}), "id"),
+              (std::vector<data>{expected(0, 3), expected(n - 1, 3), data{},
+                                 expected(12'345, 3)}));
+  MESSAGE("updates after a compaction overwrite the compacted rows");
+  auto builder = series_builder{};
+  auto row = builder.record();
+  row.field("id", int64_t{7});
+  row.field("generation", int64_t{4});
+  update(*ctx, builder.finish_assert_one_slice("generation"), "id");
+  CHECK_EQUAL(lookup(*ctx, ids({7, 8}), "id"),
+              (std::vector<data>{expected(7, 4), expected(8, 3)}));
+  MESSAGE("a compacted context saves only the live rows");
+  auto loaded = unbox(plugin().load_context(unbox(ctx->save())));
+  CHECK_EQUAL(num_entries(*loaded), data{detail::narrow_cast<uint64_t>(n)});
+  CHECK_EQUAL(lookup(*loaded, ids({7, 8, n - 1}), "id"),
+              (std::vector<data>{expected(7, 4), expected(8, 3),
+                                 expected(n - 1, 3)}));
+}
@@ -309,14 +309,14 @@ TEST(pass partition pipeline via the index) {
   auto catalog = self->spawn(tenzir::catalog, accountant, directory / "types");
   const auto partition_capacity = 8;
   const auto active_partition_timeout = tenzir::duration{};
-  const auto in_mem_partitions = 10;
+  const auto partition_cache_size = tenzir::defaults::partition_cache_size;
   const auto taste_count = 1;
   const auto num_query_supervisors = 10;
   const auto index_config = tenzir::index_config{};
   auto index
     = self->spawn(tenzir::index, accountant, filesystem, catalog, index_dir,
                   tenzir::defaults::store_backend, partition_capacity,
-                  active_partition_timeout, in_mem_partitions, taste_count,
+                  active_partition_timeout, partition_cache_size, taste_count,
                   num_query_supervisors, index_dir, index_config);
   tenzir::detail::spawn_container_source(sys, zeek_conn_log, index);
   run();
@@ -411,7 +411,7 @@ TEST(query after transform) {
   auto catalog = self->spawn(tenzir::catalog, accountant, directory / "types");
   const auto partition_capacity = tenzir::defaults::max_partition_size;
   const auto active_partition_timeout = tenzir::duration{};
-  const auto in_mem_partitions = 10;
+  const auto partition_cache_size = tenzir::defaults::partition_cache_size;
   const auto taste_count = 1;
   const auto num_query_supervisors = 10;
   const auto index_config = tenzir::index_config{
@@ -423,7 +423,7 @@ TEST(query after transform) {
   auto index
     = self->spawn(tenzir::index, accountant, filesystem, catalog, index_dir,
                   tenzir::defaults::store_backend, partition_capacity,
-                  active_partition_timeout, in_mem_partitions, taste_count,
+                  active_partition_timeout, partition_cache_size, taste_count,
                   num_query_supervisors, index_dir, index_config);
   tenzir::detail::spawn_container_source(sys, zeek_conn_log, index);
   run();
@@ -528,13 +528,13 @@ TEST(select pipeline with an empty result set) {
   auto catalog = self->spawn(tenzir::catalog, accountant, directory / "types");
   const auto partition_capacity = 8;
   const auto active_partition_timeout = tenzir::duration{};
-  const auto in_mem_partitions = 10;
+  const auto partition_cache_size = tenzir::defaults::partition_cache_size;
   const auto taste_count = 1;
   const auto num_query_supervisors = 10;
   auto index
     = self->spawn(tenzir::index, accountant, filesystem, catalog, index_dir,
                   tenzir::defaults::store_backend, partition_capacity,
-                  active_partition_timeout, in_mem_partitions, taste_count,
+                  active_partition_timeout, partition_cache_size, taste_count,
                   num_query_supervisors, index_dir, tenzir::index_config{});
   tenzir::detail::spawn_container_source(sys, zeek_conn_log, index);
   run();
@@ -62,6 +62,14 @@ TEST(JSON string escaping) {
   CHECK_EQUAL(json_escape("foo\nbar"), "\"foo\\nbar\"");
   CHECK_EQUAL(json_escape("foo\tbar"), "\"foo\\tbar\"");
   CHECK_EQUAL(json_escape("foo\xFF\xFF"), "\"foo\xFF\xFF\"");
+  CHECK_EQUAL(json_escape("0123456789abcdef0123456789abcdef!"),
+              "\"0123456789abcdef0123456789abcdef!\"");
+  CHECK_EQUAL(json_escape("0123456789abcde\"0123456789\x01\x7f"
+                          "cdef\t"),
+              "\"0123456789abcde\\\"0123456789\\u0001\\u007Fcdef\\t\"");
+  auto buffer = std::string{"prefix "};
+  json_escape("0123456789abcdef\n", buffer);
+  CHECK_EQUAL(buffer, "prefix \"0123456789abcdef\\n\"");
 
   CHECK_EQUAL(json_unescape("\"foo\\\"bar\""), "foo\"bar");
   CHECK_EQUAL(json_unescape("\"foo\\\\bar\""), "foo\\bar");
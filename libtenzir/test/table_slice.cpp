@@ -130,6 +130,28 @@ TEST(select off by one suffix) {
   CHECK_EQUAL(make_data(xs[0]), make_data(sut, 49, 50));
 }
 
+TEST(select compact) {
+  auto sut = zeek_conn_log_full[0];
+  sut.offset(100);
+  auto ids = make_ids({{110, 120}, {170, 180}});
+  auto expected = make_data(sut, 10, 10);
+  auto second = make_data(sut, 70, 10);
+  expected.insert(expected.end(), second.begin(), second.end());
+  auto xs = collect(select(sut, {}, ids, select_mode::compact));
+  REQUIRE_EQUAL(xs.size(), 1u);
+  CHECK_EQUAL(xs[0].rows(), 20u);
+  CHECK_EQUAL(make_data(xs[0]), expected);
+  // Two runs of ten rows each are short enough to be compacted.
+  xs = collect(select(sut, {}, ids, select_mode::adaptive));
+  REQUIRE_EQUAL(xs.size(), 1u);
+  CHECK_EQUAL(make_data(xs[0]), expected);
+  // A single run never needs to be compacted.
+  xs = collect(select(sut, {}, make_ids({{110, 120}}), select_mode::adaptive));
+  REQUIRE_EQUAL(xs.size(), 1u);
+  CHECK_EQUAL(xs[0].offset(), 110u);
+  CHECK_EQUAL(make_data(xs[0]), make_data(sut, 10, 10));
+}
+
 TEST(select suffix) {
   auto sut = zeek_conn_log_full[0];
   sut.offset(100);
@@ -189,6 +211,26 @@ TEST(split) {
   CHECK_EQUAL(split_sut(7), manual_split_sut(7));
 }
 
+TEST(concatenate) {
+  auto sut = zeek_conn_log[0];
+  REQUIRE_EQUAL(sut.rows(), 8u);
+  sut.offset(100);
+  // Concatenating the parts of a split slice must restore the original slice,
+  // even though the parts start at different offsets in the Arrow arrays.
+  auto [first, rest] = split(sut, 3);
+  auto [second, third] = split(rest, 4);
+  auto result = concatenate({first, second, third});
+  CHECK_EQUAL(result.rows(), 8u);
+  CHECK_EQUAL(result.offset(), 100u);
+  CHECK_EQUAL(result.schema(), sut.schema());
+  CHECK_EQUAL(make_data(result), make_data(sut));
+  // Concatenating a slice with itself doubles its rows.
+  auto twice = concatenate({sut, sut});
+  CHECK_EQUAL(twice.rows(), 16u);
+  CHECK_EQUAL(make_data(twice, 8), make_data(sut));
+  CHECK_EQUAL(concatenate({}).rows(), 0u);
+}
+
 TEST(filter - import time) {
   auto sut
     = table_slice{chunk::copy(zeek_conn_log[0]), table_slice::verify::yes};
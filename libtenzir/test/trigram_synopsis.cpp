@@ -0,0 +1,150 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/trigram_synopsis.hpp"
+
+#include "tenzir/detail/trigram.hpp"
+#include "tenzir/hash/hash_append.hpp"
+#include "tenzir/hash/legacy_hash.hpp"
+#include "tenzir/pattern.hpp"
+#include "tenzir/si_literals.hpp"
+#include "tenzir/synopsis.hpp"
+#include "tenzir/synopsis_factory.hpp"
+#include "tenzir/test/synopsis.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/type.hpp"
+
+using namespace std::string_literals;
+using namespace tenzir;
+using namespace tenzir::test;
+using namespace tenzir::si_literals;
+
+namespace {
+
+auto literals(std::string_view regex, bool case_insensitive = false) {
+  return detail::required_literals(regex, case_insensitive);
+}
+
+using strings = std::vector<std::string>;
+
+} // namespace
+
+TEST(trigrams) {
+  CHECK(detail::trigrams("fo").empty());
+  CHECK_EQUAL(detail::trigrams("foo").size(), 1u);
+  CHECK_EQUAL(detail::trigrams("FooBar"), detail::trigrams("foobar"));
+  CHECK_EQUAL(detail::trigrams("aaaaaa").size(), 1u);
+}
+
+TEST(required literals) {
+  CHECK_EQUAL(literals("foobar"), (strings{"foobar"}));
+  CHECK_EQUAL(literals("^foo.*bar$"), (strings{"foo", "bar"}));
+  CHECK_EQUAL(literals("GET /index\\.html"), (strings{"GET /index.html"}));
+  MESSAGE("quantifiers make the last atom optional");
+  CHECK_EQUAL(literals("abc?defg"), (strings{"defg"}));
+  CHECK_EQUAL(literals("abc+def"), (strings{"abc", "def"}));
+  CHECK_EQUAL(literals("abcd{0,2}efg"), (strings{"abc", "efg"}));
+  CHECK_EQUAL(literals("(abc)?def"), (strings{"def"}));
+  CHECK_EQUAL(literals("(abc)+def"), (strings{"abc", "def"}));
+  MESSAGE("classes and escapes break literals");
+  CHECK_EQUAL(literals("[abc]defg"), (strings{"defg"}));
+  CHECK_EQUAL(literals("\\d+xyz\\.com"), (strings{"xyz.com"}));
+  CHECK_EQUAL(literals("\\x41BCD"), (strings{"BCD"}));
+  CHECK_EQUAL(literals("\\Qa.b*c\\E"), (strings{"a.b*c"}));
+  MESSAGE("alternations and invalid expressions have no required literals");
+  CHECK(literals("foo|bar").empty());
+  CHECK(literals("(foo").empty());
+  MESSAGE("case-insensitive matching ignores letters with Unicode folds");
+  CHECK_EQUAL(literals("keystone", true), (strings{"tone"}));
+  CHECK_EQUAL(literals("(?i)keystone"), (strings{"tone"}));
+}
+
+namespace {
+
+struct fixture {
+  fixture() {
+    factory<synopsis>::initialize();
+  }
+
+  static auto trigram_type() {
+    return type{string_type{}, {{"index", "trigram"}}};
+  }
+
+  static auto to_pattern(std::string str) {
+    return unbox(pattern::make(std::move(str)));
+  }
+
+  caf::settings opts;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(trigram_synopsis_tests, fixture)
+
+TEST(trigram synopsis) {
+  using namespace nft;
+  opts["max-partition-size"] = 1_k;
+  auto x = factory<synopsis>::make(trigram_type(), opts);
+  REQUIRE_NOT_EQUAL(x, nullptr);
+  REQUIRE(dynamic_cast<trigram_synopsis<legacy_hash>*>(x.get()));
+  x->add(make_data_view("GET /index.html"));
+  x->add(make_data_view("POST /login.php"));
+  auto verify = verifier{x.get()};
+  MESSAGE("exact values");
+  verify(make_data_view("GET /index.html"), {N, N, N, N, T, N, N, N, N, N});
+  MESSAGE("substrings");
+  verify(make_data_view("login"), {N, N, N, N, F, N, N, N, N, N});
+  verify(make_data_view("logout"), {N, N, F, N, F, N, N, N, N, N});
+  verify(make_data_view("ab"), {N, N, N, N, F, N, N, N, N, N});
+  MESSAGE("patterns");
+  auto matching = to_pattern("^POST /[a-z]+\\.php$");
+  CHECK(!x->lookup(relational_operator::equal, make_data_view(matching)));
+  CHECK(!x->lookup(relational_operator::in, make_data_view(matching)));
+  auto missing = to_pattern("DELETE /");
+  CHECK_EQUAL(x->lookup(relational_operator::equal, make_data_view(missing)),
+              F);
+  CHECK_EQUAL(x->lookup(relational_operator::in, make_data_view(missing)), F);
+  CHECK(!x->lookup(relational_operator::not_equal, make_data_view(missing)));
+  auto alternation = to_pattern("DELETE|PUT");
+  CHECK(!x->lookup(relational_operator::in, make_data_view(alternation)));
+  MESSAGE("serialization");
+  CHECK_ROUNDTRIP_DEREF(std::move(x));
+}
+
+TEST(buffered trigram synopsis) {
+  using namespace nft;
+  opts["buffer-input-data"] = true;
+  opts["max-partition-size"] = 1_Mi;
+  auto ptr = factory<synopsis>::make(trigram_type(), opts);
+  REQUIRE_NOT_EQUAL(ptr, nullptr);
+  ptr->add(make_data_view("foobar"));
+  ptr->add(make_data_view("foobaz"));
+  ptr->add(make_data_view("quxbar"));
+  auto lookup = [](const synopsis_ptr& syn, relational_operator op,
+                   std::string_view rhs) {
+    return syn->lookup(op, make_data_view(rhs));
+  };
+  CHECK(!lookup(ptr, relational_operator::ni, "xba"));
+  CHECK_EQUAL(lookup(ptr, relational_operator::ni, "corge"), F);
+  CHECK_EQUAL(lookup(ptr, relational_operator::equal, "foobar"), T);
+  CHECK_EQUAL(lookup(ptr, relational_operator::equal, "foobarbaz"), F);
+  auto shrunk = ptr->shrink();
+  REQUIRE_NOT_EQUAL(shrunk, nullptr);
+  auto params = unbox(parse_parameters(shrunk->type()));
+  // The size will be rounded up to the next power of two.
+  CHECK_EQUAL(*params.n, 4u);
+  CHECK(shrunk->type().attribute("index") == "trigram");
+  auto recovered = roundtrip(std::move(shrunk));
+  REQUIRE(recovered);
+  REQUIRE(dynamic_cast<trigram_synopsis<legacy_hash>*>(recovered.get()));
+  CHECK(!lookup(recovered, relational_operator::ni, "xba"));
+  CHECK_EQUAL(lookup(recovered, relational_operator::ni, "corge"), F);
+  CHECK_EQUAL(lookup(recovered, relational_operator::equal, "foobar"), T);
+}
+
+FIXTURE_SCOPE_END()
@@ -10,14 +10,19 @@
 
 #include "kafka/configuration.hpp"
 
+#include <tenzir/chunk.hpp>
+
 #include <caf/error.hpp>
 #include <caf/expected.hpp>
+#include <librdkafka/rdkafka.h>
 #include <librdkafka/rdkafkacpp.h>
 
 #include <chrono>
 #include <cstddef>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace tenzir::plugins::kafka {
@@ -31,14 +36,35 @@ public:
   /// Subscribes to a list of topics.
   auto subscribe(const std::vector<std::string>& topics) -> caf::error;
 
-  /// Consumes a message, blocking for a given maximum timeout.
-  auto consume(std::chrono::milliseconds timeout) -> caf::expected<chunk_ptr>;
+  /// Consumes messages from all assigned partitions, blocking for a given
+  /// maximum timeout, until either `max_messages` messages arrived or their
+  /// payloads add up to at least `max_bytes`. Unless `raw` is set, appends the
+  /// payloads of all messages to a single chunk, separated by newlines.
+  /// Otherwise, every payload becomes a chunk of its own.
+  /// @returns The number of consumed messages.
+  auto consume_batch(size_t max_messages, size_t max_bytes,
+                     std::chrono::milliseconds timeout, bool raw,
+                     std::vector<chunk_ptr>& chunks) -> caf::expected<size_t>;
+
+  /// Checks whether all assigned partitions reached their end, which requires
+  /// `enable.partition.eof` to be set.
+  auto reached_end() const -> bool;
+
+  /// Commits the offsets of all consumed messages without waiting for the
+  /// broker to acknowledge the commit.
+  auto commit_async() -> caf::error;
 
 private:
   consumer() = default;
 
   configuration config_{};
   std::shared_ptr<RdKafka::KafkaConsumer> consumer_{};
+  /// The queue that all assigned partitions forward their messages to. Must be
+  /// destroyed before the consumer.
+  std::shared_ptr<rd_kafka_queue_t> queue_{};
+  /// The partitions that reached their end, and did not receive messages
+  /// since then.
+  std::set<std::pair<std::string, int32_t>> partitions_at_end_{};
 };
 
 } // namespace tenzir::plugins::kafka
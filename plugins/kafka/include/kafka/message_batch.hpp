@@ -0,0 +1,54 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <tenzir/chunk.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tenzir::plugins::kafka {
+
+/// Joins the payloads of consumed messages into chunks, until either
+/// `max_messages` messages arrived or their payloads add up to at least
+/// `max_bytes`. Unless `raw` is set, the payloads are appended to a single
+/// chunk and separated by newlines. Otherwise, every non-empty payload becomes
+/// a chunk of its own.
+class message_batch {
+public:
+  message_batch(size_t max_messages, size_t max_bytes, bool raw);
+
+  /// Adds the payload of a message.
+  /// @pre `not full()`
+  void add(chunk_ptr payload);
+
+  /// Returns whether the batch reached one of its limits.
+  auto full() const -> bool;
+
+  /// Returns the number of messages that the batch can take at most.
+  auto remaining_messages() const -> size_t;
+
+  /// Returns the number of added messages.
+  auto messages() const -> size_t;
+
+  /// Returns the chunks of the batch.
+  auto finish() && -> std::vector<chunk_ptr>;
+
+private:
+  size_t max_messages_ = {};
+  size_t max_bytes_ = {};
+  bool raw_ = {};
+  size_t num_messages_ = {};
+  size_t num_bytes_ = {};
+  std::string buffer_ = {};
+  std::vector<chunk_ptr> chunks_ = {};
+};
+
+} // namespace tenzir::plugins::kafka
@@ -8,11 +8,16 @@
 
 #include "kafka/consumer.hpp"
 
+#include "kafka/message_batch.hpp"
+
 #include <tenzir/detail/narrow.hpp>
 #include <tenzir/error.hpp>
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <span>
+
 namespace tenzir::plugins::kafka {
 
 auto consumer::make(configuration config) -> caf::expected<consumer> {
@@ -22,6 +27,10 @@ auto consumer::make(configuration config) -> caf::expected<consumer> {
     RdKafka::KafkaConsumer::create(config.conf_.get(), error));
   if (!result.consumer_)
     return caf::make_error(ec::unspecified, error);
+  result.queue_.reset(rd_kafka_queue_get_consumer(result.consumer_->c_ptr()),
+                      rd_kafka_queue_destroy);
+  if (!result.queue_)
+    return caf::make_error(ec::unspecified, "failed to get consumer queue");
   result.config_ = std::move(config);
   return result;
 }
@@ -33,27 +42,93 @@ auto consumer::subscribe(const std::vector<std::string>& topics) -> caf::error {
   return {};
 }
 
-auto consumer::consume(std::chrono::milliseconds timeout)
-  -> caf::expected<chunk_ptr> {
+auto consumer::consume_batch(size_t max_messages, size_t max_bytes,
+                             std::chrono::milliseconds timeout, bool raw,
+                             std::vector<chunk_ptr>& chunks)
+  -> caf::expected<size_t> {
+  // We poll the queue in steps, so that we stop shortly after exceeding the
+  // byte budget instead of dequeuing `max_messages` large messages at once.
+  constexpr auto max_messages_per_poll = size_t{1'000};
+  auto messages = std::vector<rd_kafka_message_t*>(
+    std::min(max_messages, max_messages_per_poll));
   auto ms = detail::narrow_cast<int>(timeout.count());
-  auto* ptr = consumer_->consume(ms);
-  auto result = chunk::make(ptr->payload(), ptr->len(), [ptr]() noexcept {
-    delete ptr; // NOLINT
-  });
-  switch (ptr->err()) {
-    case RdKafka::ERR_NO_ERROR:
+  auto batch = message_batch{max_messages, max_bytes, raw};
+  auto error = caf::error{};
+  while (!error && !batch.full()) {
+    auto num_messages = rd_kafka_consume_batch_queue(
+      queue_.get(), ms, messages.data(),
+      std::min(messages.size(), batch.remaining_messages()));
+    if (num_messages < 0) {
+      error = caf::make_error(ec::unspecified,
+                              fmt::format("failed to consume messages: {}",
+                                          rd_kafka_err2str(
+                                            rd_kafka_last_error())));
+      break;
+    }
+    if (num_messages == 0)
       break;
-    case RdKafka::ERR__TIMED_OUT:
-      return ec::timeout;
-    case RdKafka::ERR__PARTITION_EOF:
-      return ec::end_of_input;
-    default:
-      return caf::make_error(ec::unspecified,
-                             fmt::format("failed to consume message: {} ({})",
-                                         ptr->errstr(),
-                                         static_cast<int>(ptr->err())));
+    // Only the first poll waits for messages to arrive.
+    ms = 0;
+    for (auto* msg : std::span{messages}.first(
+           detail::narrow_cast<size_t>(num_messages))) {
+      switch (msg->err) {
+        case RD_KAFKA_RESP_ERR_NO_ERROR:
+          partitions_at_end_.erase(
+            {rd_kafka_topic_name(msg->rkt), msg->partition});
+          if (msg->len == 0) {
+            batch.add(chunk::make_empty());
+            break;
+          }
+          // The chunk takes ownership of the message.
+          batch.add(chunk::make(msg->payload, msg->len, [msg]() noexcept {
+            rd_kafka_message_destroy(msg);
+          }));
+          continue;
+        case RD_KAFKA_RESP_ERR__PARTITION_EOF:
+          partitions_at_end_.emplace(rd_kafka_topic_name(msg->rkt),
+                                     msg->partition);
+          break;
+        default:
+          if (!error)
+            error = caf::make_error(
+              ec::unspecified,
+              fmt::format("failed to consume message: {} ({})",
+                          rd_kafka_message_errstr(msg),
+                          static_cast<int>(msg->err)));
+          break;
+      }
+      rd_kafka_message_destroy(msg);
+    }
   }
+  const auto result = batch.messages();
+  for (auto& chunk : std::move(batch).finish())
+    chunks.push_back(std::move(chunk));
+  if (error)
+    return error;
   return result;
 }
 
+auto consumer::reached_end() const -> bool {
+  auto partitions = std::vector<RdKafka::TopicPartition*>{};
+  if (consumer_->assignment(partitions) != RdKafka::ERR_NO_ERROR)
+    return false;
+  auto result = !partitions.empty();
+  for (const auto* partition : partitions)
+    if (!partitions_at_end_.contains(
+          {partition->topic(), partition->partition()}))
+      result = false;
+  RdKafka::TopicPartition::destroy(partitions);
+  return result;
+}
+
+auto consumer::commit_async() -> caf::error {
+  auto result = consumer_->commitAsync();
+  // There is nothing to commit if no messages arrived since the last commit.
+  if (result != RdKafka::ERR_NO_ERROR && result != RdKafka::ERR__NO_OFFSET)
+    return caf::make_error(ec::unspecified,
+                           fmt::format("failed to commit offsets: {}",
+                                       RdKafka::err2str(result)));
+  return {};
+}
+
 } // namespace tenzir::plugins::kafka
@@ -0,0 +1,53 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "kafka/message_batch.hpp"
+
+#include <tenzir/detail/assert.hpp>
+
+namespace tenzir::plugins::kafka {
+
+message_batch::message_batch(size_t max_messages, size_t max_bytes, bool raw)
+  : max_messages_{max_messages}, max_bytes_{max_bytes}, raw_{raw} {
+}
+
+void message_batch::add(chunk_ptr payload) {
+  TENZIR_ASSERT(payload);
+  TENZIR_ASSERT(not full());
+  ++num_messages_;
+  num_bytes_ += payload->size();
+  if (raw_) {
+    if (payload->size() > 0)
+      chunks_.push_back(std::move(payload));
+    return;
+  }
+  const auto* data = reinterpret_cast<const char*>(payload->data());
+  buffer_.append(data, payload->size());
+  if (payload->size() == 0 || data[payload->size() - 1] != '\n')
+    buffer_.push_back('\n');
+}
+
+auto message_batch::full() const -> bool {
+  return num_messages_ >= max_messages_ || num_bytes_ >= max_bytes_;
+}
+
+auto message_batch::remaining_messages() const -> size_t {
+  return full() ? 0 : max_messages_ - num_messages_;
+}
+
+auto message_batch::messages() const -> size_t {
+  return num_messages_;
+}
+
+auto message_batch::finish() && -> std::vector<chunk_ptr> {
+  if (!buffer_.empty())
+    chunks_.push_back(chunk::make(std::move(buffer_)));
+  return std::move(chunks_);
+}
+
+} // namespace tenzir::plugins::kafka
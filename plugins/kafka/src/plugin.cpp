@@ -25,9 +25,11 @@
 #include <tenzir/plugin.hpp>
 #include <tenzir/table_slice.hpp>
 
+#include <algorithm>
 #include <charconv>
 #include <chrono>
 #include <string>
+#include <utility>
 
 using namespace std::chrono_literals;
 
@@ -38,6 +40,12 @@ namespace {
 // Default topic if the user doesn't provide one.
 constexpr auto default_topic = "tenzir";
 
+// The maximum number of messages that the loader coalesces into one chunk.
+constexpr auto max_batch_messages = size_t{10'000};
+
+// The number of bytes after which the loader stops adding messages to a chunk.
+constexpr auto max_batch_bytes = size_t{16} << 20;
+
 // Valid values:
 // - beginning | end | stored
 // - <value>  (absolute offset)
@@ -72,6 +80,7 @@ struct loader_args {
   std::optional<location> exit;
   std::optional<located<std::string>> offset;
   std::optional<located<std::string>> options;
+  std::optional<location> raw;
 
   template <class Inspector>
   friend auto inspect(Inspector& f, loader_args& x) -> bool {
@@ -79,7 +88,7 @@ struct loader_args {
       .pretty_name("loader_args")
       .fields(f.field("topic", x.topic), f.field("count", x.count),
               f.field("exit", x.exit), f.field("offset", x.offset),
-              f.field("options", x.options));
+              f.field("options", x.options), f.field("raw", x.raw));
   }
 };
 
@@ -111,6 +120,16 @@ public:
         return {};
       }
     }
+    // We commit offsets ourselves after handing off every batch of messages,
+    // unless the user explicitly configures otherwise.
+    if (!config_.contains("enable.auto.commit")) {
+      if (auto err = cfg->set("enable.auto.commit", "false")) {
+        ctrl.diagnostics().emit(
+          diagnostic::error("failed to disable automatic commits: {}", err)
+            .done());
+        return {};
+      }
+    }
     // Adjust rebalance callback to set desired offset.
     auto offset = RdKafka::Topic::OFFSET_END;
     if (args_.offset) {
@@ -164,30 +183,48 @@ public:
         diagnostic::error("failed to subscribe to topic: {}", err).done());
       return {};
     }
-    // Setup the coroutine factory.
-    auto make
-      = [](loader_args args, consumer client) mutable -> generator<chunk_ptr> {
+    auto auto_commit = cfg->get("enable.auto.commit");
+    auto manual_commit = auto_commit && *auto_commit == "false";
+    // Setup the coroutine factory. We consume messages in batches from all
+    // assigned partitions at once and, unless `--raw` is set, coalesce their
+    // payloads into a single newline-delimited chunk per batch, which is much
+    // cheaper to parse than one chunk per message.
+    auto make = [](loader_args args, consumer client,
+                   bool manual_commit) mutable -> generator<chunk_ptr> {
       auto num_messages = size_t{0};
+      auto chunks = std::vector<chunk_ptr>{};
       while (true) {
-        auto msg = client.consume(500ms);
-        if (!msg) {
+        auto max_messages = max_batch_messages;
+        if (args.count)
+          max_messages
+            = std::min(max_messages, args.count->inner - num_messages);
+        auto consumed
+          = client.consume_batch(max_messages, max_batch_bytes, 500ms,
+                                 args.raw.has_value(), chunks);
+        if (!chunks.empty()) {
+          for (auto& batch : chunks)
+            co_yield std::move(batch);
+          chunks.clear();
+          // The chunks were handed off, so we can commit the offsets of their
+          // messages.
+          if (manual_commit)
+            if (auto err = client.commit_async())
+              TENZIR_WARN("kafka {}", err);
+        } else {
           co_yield {};
-          if (msg.error() == ec::timeout)
-            continue;
-          if (msg.error() == ec::end_of_input)
-            // FIXME: currently doesn't work for N partitions with N > 1.
-            // Upgrade to a counter and only break out of the loop once this
-            // signal has been received N times.
-            break;
-          TENZIR_ERROR(msg.error());
+        }
+        if (!consumed) {
+          TENZIR_ERROR(consumed.error());
           break;
         }
-        co_yield *msg;
-        if (args.count && args.count->inner == ++num_messages)
+        num_messages += *consumed;
+        if (args.count && args.count->inner == num_messages)
+          break;
+        if (args.exit && client.reached_end())
           break;
       }
     };
-    return make(args_, std::move(*client));
+    return make(args_, std::move(*client), manual_commit);
   }
 
   auto name() const -> std::string override {
@@ -331,6 +368,7 @@ public:
     parser.add("-o,--offset", args.offset, "<offset>");
     // We use -X because that's standard in Kafka applications, cf. kcat.
     parser.add("-X,--set", args.options, "<key=value>,...");
+    parser.add("--raw", args.raw);
     parser.parse(p);
     if (args.offset) {
       if (!offset_parser()(args.offset->inner))
@@ -0,0 +1,91 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "kafka/message_batch.hpp"
+
+#include <tenzir/as_bytes.hpp>
+#include <tenzir/test/test.hpp>
+
+using namespace tenzir;
+using namespace tenzir::plugins::kafka;
+using namespace std::string_literals;
+
+namespace {
+
+auto payload(std::string str) -> chunk_ptr {
+  return chunk::make(std::move(str));
+}
+
+auto to_string(const chunk_ptr& chunk) -> std::string {
+  const auto bytes = as_bytes(chunk);
+  return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+} // namespace
+
+TEST(joins payloads with newlines) {
+  auto batch = message_batch{10, 1'000, false};
+  batch.add(payload("{\"a\": 1}"));
+  batch.add(payload("{\"a\": 2}\n"));
+  batch.add(payload(""));
+  batch.add(payload("{\"a\": 3}"));
+  CHECK(not batch.full());
+  CHECK_EQUAL(batch.messages(), size_t{4});
+  auto chunks = std::move(batch).finish();
+  REQUIRE_EQUAL(chunks.size(), size_t{1});
+  CHECK_EQUAL(to_string(chunks[0]),
+              "{\"a\": 1}\n{\"a\": 2}\n\n{\"a\": 3}\n"s);
+}
+
+TEST(raw payloads stay separate) {
+  auto batch = message_batch{10, 1'000, true};
+  batch.add(payload("foo"));
+  batch.add(payload(""));
+  batch.add(payload("bar\n"));
+  CHECK_EQUAL(batch.messages(), size_t{3});
+  auto chunks = std::move(batch).finish();
+  REQUIRE_EQUAL(chunks.size(), size_t{2});
+  CHECK_EQUAL(to_string(chunks[0]), "foo"s);
+  CHECK_EQUAL(to_string(chunks[1]), "bar\n"s);
+}
+
+TEST(message limit) {
+  auto batch = message_batch{3, 1'000, false};
+  CHECK_EQUAL(batch.remaining_messages(), size_t{3});
+  batch.add(payload("a"));
+  batch.add(payload("b"));
+  CHECK_EQUAL(batch.remaining_messages(), size_t{1});
+  CHECK(not batch.full());
+  batch.add(payload("c"));
+  CHECK(batch.full());
+  CHECK_EQUAL(batch.remaining_messages(), size_t{0});
+  auto chunks = std::move(batch).finish();
+  REQUIRE_EQUAL(chunks.size(), size_t{1});
+  CHECK_EQUAL(to_string(chunks[0]), "a\nb\nc\n"s);
+}
+
+TEST(byte limit) {
+  auto batch = message_batch{100, 8, true};
+  batch.add(payload("abc"));
+  batch.add(payload("defg"));
+  CHECK(not batch.full());
+  MESSAGE("the message that exceeds the limit is part of the batch");
+  batch.add(payload("hij"));
+  CHECK(batch.full());
+  CHECK_EQUAL(batch.remaining_messages(), size_t{0});
+  CHECK_EQUAL(batch.messages(), size_t{3});
+  auto chunks = std::move(batch).finish();
+  REQUIRE_EQUAL(chunks.size(), size_t{3});
+  CHECK_EQUAL(to_string(chunks[2]), "hij"s);
+}
+
+TEST(empty batch) {
+  auto batch = message_batch{10, 1'000, false};
+  CHECK_EQUAL(batch.messages(), size_t{0});
+  CHECK(std::move(batch).finish().empty());
+}
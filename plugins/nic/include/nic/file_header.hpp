@@ -0,0 +1,38 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2026 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/pcap.hpp>
+
+#include <cstdint>
+
+namespace tenzir::plugins::nic {
+
+/// Creates the PCAP file header for packets captured from an interface.
+inline auto make_file_header(int snaplen, int linktype,
+                             uint32_t magic_number = pcap::magic_number_1)
+  -> pcap::file_header {
+  return {
+    // Timestamps have microsecond resolution when using pcap_open_live(). If we
+    // want nanosecond resolution, we must stop using pcap_open_live() and
+    // replace it with pcap_create() and pcap_activate(). See
+    // https://stackoverflow.com/q/28310922/1170277 for details. The TPACKET_V3
+    // rings always provide nanosecond resolution.
+    .magic_number = magic_number,
+    .major_version = 2,
+    .minor_version = 4,
+    .reserved1 = 0,
+    .reserved2 = 0,
+    .snaplen = detail::narrow_cast<uint32_t>(snaplen),
+    .linktype = detail::narrow_cast<uint32_t>(linktype),
+  };
+}
+
+} // namespace tenzir::plugins::nic
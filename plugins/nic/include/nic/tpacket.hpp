@@ -0,0 +1,111 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <tenzir/chunk.hpp>
+
+#include <caf/error.hpp>
+#include <caf/expected.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tenzir::plugins::nic {
+
+/// Options for capturing packets from memory-mapped TPACKET_V3 rings.
+struct tpacket_options {
+  /// The name of the interface to capture from.
+  std::string iface;
+
+  /// The maximum number of bytes to keep per packet.
+  uint32_t snaplen = 0;
+
+  /// The number of sockets in the fanout group, each of which is served by
+  /// its own thread.
+  size_t threads = 1;
+
+  /// The size of a single block of the ring, which must be a multiple of the
+  /// page size.
+  uint32_t block_size = uint32_t{1} << 20;
+
+  /// The number of blocks per ring.
+  uint32_t num_blocks = 64;
+
+  /// The time after which the kernel hands a block that is not full to user
+  /// space.
+  std::chrono::milliseconds block_timeout = std::chrono::milliseconds{100};
+
+  /// Whether every chunk starts with a PCAP file header.
+  bool emit_file_headers = false;
+};
+
+/// Captures packets from an interface with one AF_PACKET socket per thread.
+/// The sockets join a fanout group that distributes packets by flow hash, and
+/// each socket shares a ring of TPACKET_V3 blocks with the kernel.
+///
+/// Every block that the kernel hands to user space turns into a single chunk
+/// that contains all packets of the block as PCAP packet records with
+/// nanosecond timestamps. The order of packets is retained per flow, but not
+/// across flows.
+class tpacket_capture {
+public:
+  /// Opens the sockets, maps their rings, and starts the capture threads.
+  static auto make(tpacket_options options)
+    -> caf::expected<std::unique_ptr<tpacket_capture>>;
+
+  /// Stops the capture threads and releases all sockets.
+  ~tpacket_capture();
+
+  tpacket_capture(const tpacket_capture&) = delete;
+  auto operator=(const tpacket_capture&) -> tpacket_capture& = delete;
+  tpacket_capture(tpacket_capture&&) = delete;
+  auto operator=(tpacket_capture&&) -> tpacket_capture& = delete;
+
+  /// Returns the PCAP link type of the interface.
+  auto linktype() const -> uint32_t;
+
+  /// Waits at most `timeout` for the next chunk of packets.
+  /// @returns The next chunk, `nullptr` on timeout, or an error if capturing
+  /// failed.
+  auto next(std::chrono::milliseconds timeout) -> caf::expected<chunk_ptr>;
+
+private:
+  struct ring;
+
+  explicit tpacket_capture(tpacket_options options);
+
+  /// Moves the blocks that the kernel releases from a ring into the queue
+  /// until the capture stops.
+  void run(ring& r);
+
+  /// Stores the first error that a capture thread encounters.
+  void fail(caf::error err);
+
+  tpacket_options options_ = {};
+  uint32_t linktype_ = 0;
+  std::vector<std::unique_ptr<ring>> rings_ = {};
+  std::vector<std::thread> threads_ = {};
+  std::atomic<bool> stop_ = false;
+  std::mutex mutex_ = {};
+  std::condition_variable ready_ = {};
+  std::condition_variable space_ = {};
+  std::deque<chunk_ptr> queue_ = {};
+  caf::error error_ = {};
+};
+
+} // namespace tenzir::plugins::nic
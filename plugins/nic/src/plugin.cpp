@@ -6,6 +6,9 @@
 // SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "nic/file_header.hpp"
+#include "nic/tpacket.hpp"
+
 #include <tenzir/argument_parser.hpp>
 #include <tenzir/chunk.hpp>
 #include <tenzir/concept/parseable/tenzir/ip.hpp>
@@ -33,32 +36,19 @@ struct loader_args {
   located<std::string> iface;
   std::optional<located<uint32_t>> snaplen;
   std::optional<location> emit_file_headers;
+  std::optional<location> tpacket;
+  std::optional<located<uint64_t>> threads;
 
   template <class Inspector>
   friend auto inspect(Inspector& f, loader_args& x) -> bool {
     return f.object(x)
       .pretty_name("loader_args")
       .fields(f.field("iface", x.iface), f.field("snaplen", x.snaplen),
-              f.field("emit_file_headers", x.emit_file_headers));
+              f.field("emit_file_headers", x.emit_file_headers),
+              f.field("tpacket", x.tpacket), f.field("threads", x.threads));
   }
 };
 
-auto make_file_header(int snaplen, int linktype) -> pcap::file_header {
-  return {
-    // Timestamps have microsecond resolution when using pcap_open_live(). If we
-    // want nanosecond resolution, we must stop using pcap_open_live() and
-    // replace it with pcap_create() and pcap_activate(). See
-    // https://stackoverflow.com/q/28310922/1170277 for details.
-    .magic_number = pcap::magic_number_1,
-    .major_version = 2,
-    .minor_version = 4,
-    .reserved1 = 0,
-    .reserved2 = 0,
-    .snaplen = detail::narrow_cast<uint32_t>(snaplen),
-    .linktype = detail::narrow_cast<uint32_t>(linktype),
-  };
-};
-
 class nic_loader final : public plugin_loader {
 public:
   nic_loader() = default;
@@ -72,6 +62,15 @@ public:
     auto snaplen = args_.snaplen ? args_.snaplen->inner : 262'144;
     TENZIR_DEBUG("capturing from {} with snaplen of {}", args_.iface.inner,
                  snaplen);
+    if (args_.tpacket) {
+      auto options = tpacket_options{
+        .iface = args_.iface.inner,
+        .snaplen = snaplen,
+        .threads = args_.threads ? args_.threads->inner : 1,
+        .emit_file_headers = !!args_.emit_file_headers,
+      };
+      return make_tpacket(ctrl, std::move(options));
+    }
     auto make = [](auto& ctrl, auto iface, auto snaplen,
                    bool emit_file_headers) mutable -> generator<chunk_ptr> {
       auto put_iface_in_promiscuous_mode = 1;
@@ -195,6 +194,42 @@ public:
   }
 
 private:
+  /// Captures packets from memory-mapped TPACKET_V3 rings instead of libpcap.
+  /// Every chunk holds the packets of one ring block.
+  static auto make_tpacket(operator_control_plane& ctrl,
+                           tpacket_options options) -> generator<chunk_ptr> {
+    auto capture = tpacket_capture::make(options);
+    if (!capture) {
+      diagnostic::error("failed to set up TPACKET_V3 capture: {}",
+                        capture.error())
+        .note("from `nic`")
+        .emit(ctrl.diagnostics());
+      co_return;
+    }
+    // We yield once initially to signal that the operator successfully
+    // started.
+    co_yield {};
+    if (!options.emit_file_headers) {
+      auto header
+        = make_file_header(detail::narrow_cast<int>(options.snaplen),
+                           detail::narrow_cast<int>((*capture)->linktype()),
+                           pcap::magic_number_2);
+      co_yield chunk::copy(as_bytes(header));
+    }
+    while (true) {
+      auto chunk = (*capture)->next(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+          defaults::import::read_timeout));
+      if (!chunk) {
+        diagnostic::error("failed to capture packets: {}", chunk.error())
+          .note("from `nic`")
+          .emit(ctrl.diagnostics());
+        co_return;
+      }
+      co_yield std::move(*chunk);
+    }
+  }
+
   loader_args args_;
   record config_;
 };
@@ -340,7 +375,19 @@ public:
     parser.add(args.iface, "<iface>");
     parser.add("-s,--snaplen", args.snaplen, "<count>");
     parser.add("-e,--emit-file-headers", args.emit_file_headers);
+    parser.add("--tpacket", args.tpacket);
+    parser.add("--threads", args.threads, "<count>");
     parser.parse(p);
+    if (args.threads) {
+      if (!args.tpacket)
+        diagnostic::error("`--threads` requires `--tpacket`")
+          .primary(args.threads->source)
+          .throw_();
+      if (args.threads->inner == 0)
+        diagnostic::error("`--threads` must be greater than zero")
+          .primary(args.threads->source)
+          .throw_();
+    }
     return std::make_unique<nic_loader>(std::move(args));
   }
 
@@ -0,0 +1,322 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "nic/tpacket.hpp"
+
+#include "nic/file_header.hpp"
+
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/detail/posix.hpp>
+#include <tenzir/error.hpp>
+#include <tenzir/logger.hpp>
+#include <tenzir/pcap.hpp>
+
+#include <fmt/format.h>
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#  include <arpa/inet.h>
+#  include <linux/if_ether.h>
+#  include <linux/if_packet.h>
+#  include <net/if.h>
+#  include <net/if_arp.h>
+#  include <poll.h>
+#  include <sys/ioctl.h>
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+namespace tenzir::plugins::nic {
+
+namespace {
+
+/// The maximum number of chunks that wait for the loader, after which the
+/// capture threads stop releasing blocks to the kernel.
+constexpr auto max_queued_chunks = size_t{256};
+
+/// The PCAP link type for Ethernet.
+constexpr auto linktype_ethernet = uint32_t{1};
+
+#if defined(__linux__)
+
+/// The number of fanout group ids that we try before giving up.
+constexpr auto max_fanout_attempts = 16;
+
+/// Returns a fanout group id that no other capture of this process uses. The
+/// ids start at an offset derived from the process id to make collisions with
+/// other processes unlikely.
+auto next_fanout_group() -> uint32_t {
+  static auto counter
+    = std::atomic<uint32_t>{static_cast<uint32_t>(::getpid()) << 4};
+  return counter.fetch_add(1, std::memory_order_relaxed) & 0xffff;
+}
+
+#endif
+
+} // namespace
+
+#if defined(__linux__)
+
+struct tpacket_capture::ring {
+  ~ring() {
+    if (map != MAP_FAILED)
+      ::munmap(map, size);
+    if (fd != -1)
+      ::close(fd);
+  }
+
+  int fd = -1;
+  void* map = MAP_FAILED;
+  size_t size = 0;
+};
+
+auto tpacket_capture::make(tpacket_options options)
+  -> caf::expected<std::unique_ptr<tpacket_capture>> {
+  if (options.threads == 0)
+    return caf::make_error(ec::invalid_argument,
+                           "TPACKET_V3 capture requires at least one thread");
+  const auto ifindex = ::if_nametoindex(options.iface.c_str());
+  if (ifindex == 0)
+    return caf::make_error(ec::invalid_argument,
+                           fmt::format("failed to find interface {}: {}",
+                                       options.iface, detail::describe_errno()));
+  auto result
+    = std::unique_ptr<tpacket_capture>{new tpacket_capture{std::move(options)}};
+  const auto& opts = result->options_;
+  // All sockets of this capture join the same fanout group, which is unique
+  // among the captures of this process.
+  auto fanout_group = next_fanout_group();
+  for (auto i = size_t{0}; i < opts.threads; ++i) {
+    auto r = std::make_unique<ring>();
+    r->fd = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (r->fd == -1)
+      return caf::make_error(ec::system_error,
+                             fmt::format("failed to create packet socket: {}",
+                                         detail::describe_errno()));
+    auto fail = [&](std::string_view what) {
+      return caf::make_error(ec::system_error,
+                             fmt::format("failed to {}: {}", what,
+                                         detail::describe_errno()));
+    };
+    if (i == 0) {
+      auto request = ifreq{};
+      std::strncpy(request.ifr_name, opts.iface.c_str(), IFNAMSIZ - 1);
+      if (::ioctl(r->fd, SIOCGIFHWADDR, &request) == -1)
+        return fail("get hardware type of interface");
+      switch (request.ifr_hwaddr.sa_family) {
+        case ARPHRD_ETHER:
+        case ARPHRD_LOOPBACK:
+          // The kernel prepends an Ethernet header for loopback devices.
+          result->linktype_ = linktype_ethernet;
+          break;
+        default:
+          return caf::make_error(
+            ec::invalid_argument,
+            fmt::format("unsupported hardware type {} of interface {}",
+                        request.ifr_hwaddr.sa_family, opts.iface));
+      }
+    }
+    auto version = TPACKET_V3;
+    if (::setsockopt(r->fd, SOL_PACKET, PACKET_VERSION, &version,
+                     sizeof(version))
+        == -1)
+      return fail("select TPACKET_V3");
+    // With TPACKET_V3, frames have variable sizes and are packed into blocks.
+    // The frame size only matters for validating the request.
+    constexpr auto frame_size = uint32_t{TPACKET_ALIGNMENT << 7};
+    auto request = tpacket_req3{};
+    request.tp_block_size = opts.block_size;
+    request.tp_block_nr = opts.num_blocks;
+    request.tp_frame_size = frame_size;
+    request.tp_frame_nr = opts.block_size / frame_size * opts.num_blocks;
+    request.tp_retire_blk_tov
+      = detail::narrow_cast<unsigned int>(opts.block_timeout.count());
+    request.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+    if (::setsockopt(r->fd, SOL_PACKET, PACKET_RX_RING, &request,
+                     sizeof(request))
+        == -1)
+      return fail("create receive ring");
+    r->size = size_t{opts.block_size} * opts.num_blocks;
+    r->map = ::mmap(nullptr, r->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    r->fd, 0);
+    if (r->map == MAP_FAILED)
+      return fail("map receive ring");
+    auto address = sockaddr_ll{};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = detail::narrow_cast<int>(ifindex);
+    if (::bind(r->fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+        == -1)
+      return fail("bind packet socket");
+    auto membership = packet_mreq{};
+    membership.mr_ifindex = detail::narrow_cast<int>(ifindex);
+    membership.mr_type = PACKET_MR_PROMISC;
+    if (::setsockopt(r->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership,
+                     sizeof(membership))
+        == -1)
+      return fail("enable promiscuous mode");
+    if (opts.threads > 1) {
+      auto join_fanout_group = [&] {
+        const auto fanout = static_cast<int>(
+          fanout_group | (uint32_t{PACKET_FANOUT_HASH} << 16));
+        return ::setsockopt(r->fd, SOL_PACKET, PACKET_FANOUT, &fanout,
+                            sizeof(fanout))
+               == 0;
+      };
+      auto joined = join_fanout_group();
+      // The first socket creates the group. If another process already uses
+      // the id with different settings, we move on to the next id.
+      for (auto attempt = 1;
+           not joined and i == 0 and errno == EADDRINUSE
+           and attempt < max_fanout_attempts;
+           ++attempt) {
+        fanout_group = next_fanout_group();
+        joined = join_fanout_group();
+      }
+      if (not joined)
+        return fail("join fanout group");
+    }
+    result->rings_.push_back(std::move(r));
+  }
+  for (auto& r : result->rings_)
+    result->threads_.emplace_back([capture = result.get(), r = r.get()] {
+      capture->run(*r);
+    });
+  return result;
+}
+
+void tpacket_capture::run(ring& r) {
+  const auto& opts = options_;
+  auto* base = static_cast<std::byte*>(r.map);
+  auto current = uint32_t{0};
+  while (!stop_) {
+    auto* block
+      = reinterpret_cast<tpacket_block_desc*>(base + current * opts.block_size);
+    auto& status = block->hdr.bh1.block_status;
+    if ((std::atomic_ref{status}.load(std::memory_order_acquire)
+         & TP_STATUS_USER)
+        == 0) {
+      auto fd = pollfd{};
+      fd.fd = r.fd;
+      fd.events = POLLIN | POLLERR;
+      if (::poll(&fd, 1, 100) == -1 && errno != EINTR) {
+        fail(caf::make_error(ec::system_error,
+                             fmt::format("failed to poll packet socket: {}",
+                                         detail::describe_errno())));
+        return;
+      }
+      continue;
+    }
+    // Convert the packets of the block into PCAP packet records. These are
+    // never larger than the block itself, because the TPACKET_V3 header of
+    // every packet is larger than a PCAP packet header.
+    auto buffer = std::vector<std::byte>{};
+    buffer.reserve(block->hdr.bh1.blk_len + sizeof(pcap::file_header));
+    if (opts.emit_file_headers) {
+      const auto header
+        = make_file_header(detail::narrow_cast<int>(opts.snaplen),
+                           detail::narrow_cast<int>(linktype_),
+                           pcap::magic_number_2);
+      const auto bytes = as_bytes(header);
+      buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+    }
+    const auto* packet = reinterpret_cast<const tpacket3_hdr*>(
+      reinterpret_cast<const std::byte*>(block)
+      + block->hdr.bh1.offset_to_first_pkt);
+    for (auto i = uint32_t{0}; i < block->hdr.bh1.num_pkts; ++i) {
+      const auto captured = std::min(packet->tp_snaplen, opts.snaplen);
+      const auto header = pcap::packet_header{
+        .timestamp = packet->tp_sec,
+        .timestamp_fraction = packet->tp_nsec,
+        .captured_packet_length = captured,
+        .original_packet_length = packet->tp_len,
+      };
+      const auto* data
+        = reinterpret_cast<const std::byte*>(packet) + packet->tp_mac;
+      const auto size = buffer.size();
+      buffer.resize(size + sizeof(header) + captured);
+      std::memcpy(buffer.data() + size, &header, sizeof(header));
+      std::memcpy(buffer.data() + size + sizeof(header), data, captured);
+      packet = reinterpret_cast<const tpacket3_hdr*>(
+        reinterpret_cast<const std::byte*>(packet) + packet->tp_next_offset);
+    }
+    // Hand the block back to the kernel before we potentially wait for the
+    // loader, so that the kernel can keep filling the ring.
+    std::atomic_ref{status}.store(TP_STATUS_KERNEL, std::memory_order_release);
+    current = (current + 1) % opts.num_blocks;
+    auto lock = std::unique_lock{mutex_};
+    space_.wait(lock, [&] {
+      return stop_ || queue_.size() < max_queued_chunks;
+    });
+    if (stop_)
+      return;
+    queue_.push_back(chunk::make(std::move(buffer)));
+    ready_.notify_one();
+  }
+}
+
+#else
+
+struct tpacket_capture::ring {};
+
+auto tpacket_capture::make(tpacket_options)
+  -> caf::expected<std::unique_ptr<tpacket_capture>> {
+  return caf::make_error(ec::unimplemented,
+                         "TPACKET_V3 capture is only available on Linux");
+}
+
+void tpacket_capture::run(ring&) {
+}
+
+#endif
+
+tpacket_capture::tpacket_capture(tpacket_options options)
+  : options_{std::move(options)} {
+}
+
+tpacket_capture::~tpacket_capture() {
+  {
+    auto lock = std::unique_lock{mutex_};
+    stop_ = true;
+  }
+  space_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+auto tpacket_capture::linktype() const -> uint32_t {
+  return linktype_;
+}
+
+auto tpacket_capture::next(std::chrono::milliseconds timeout)
+  -> caf::expected<chunk_ptr> {
+  auto lock = std::unique_lock{mutex_};
+  ready_.wait_for(lock, timeout, [&] {
+    return !queue_.empty() || error_;
+  });
+  if (error_)
+    return error_;
+  if (queue_.empty())
+    return chunk_ptr{};
+  auto result = std::move(queue_.front());
+  queue_.pop_front();
+  space_.notify_one();
+  return result;
+}
+
+void tpacket_capture::fail(caf::error err) {
+  auto lock = std::unique_lock{mutex_};
+  if (!error_)
+    error_ = std::move(err);
+  ready_.notify_all();
+}
+
+} // namespace tenzir::plugins::nic
@@ -0,0 +1,100 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/data.hpp"
+#include "tenzir/expression.hpp"
+#include "tenzir/type.hpp"
+
+#include <arrow/type_fwd.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tenzir::plugins::sigma {
+
+/// A loaded Sigma rule.
+struct rule {
+  /// The file that defines the rule.
+  std::string path;
+
+  /// The rule contents converted from YAML.
+  data yaml;
+
+  /// The detection of the rule as tenzir expression.
+  expression expr;
+
+  /// The schema of *yaml*, which is part of every match of the rule.
+  type schema;
+};
+
+/// A set of Sigma rules that gets compiled once per schema. Compiling tailors
+/// the detection of every rule to the schema and deduplicates identical
+/// predicates across rules, so that evaluating the set runs every distinct
+/// predicate at most once per table slice and the rules only combine the
+/// resulting masks.
+class rule_set {
+public:
+  /// The rows of a table slice that a rule matches.
+  struct match {
+    /// The index of the rule in `rules()`.
+    size_t rule;
+
+    /// A mask that is true for every matching row.
+    std::shared_ptr<arrow::BooleanArray> mask;
+  };
+
+  rule_set() = default;
+
+  /// Constructs a rule set.
+  /// @param rules The rules of the set.
+  explicit rule_set(std::vector<rule> rules);
+
+  /// @returns The rules of the set.
+  [[nodiscard]] auto rules() const -> const std::vector<rule>&;
+
+  /// Evaluates all rules over a table slice in one pass.
+  /// @param slice The table slice to evaluate the rules on.
+  /// @returns The rules that match at least one row of *slice*, in the order
+  /// of `rules()`.
+  auto evaluate(const table_slice& slice) -> std::vector<match>;
+
+  /// @returns The number of distinct predicates of the rules tailored to
+  /// *schema*.
+  auto num_predicates(const type& schema) -> size_t;
+
+private:
+  /// A detection tailored to a schema, whose leaves refer to the distinct
+  /// predicates of the compiled program.
+  struct node {
+    enum class kind { none, predicate, conjunction, disjunction, negation };
+
+    kind op = kind::none;
+    size_t predicate = 0;
+    std::vector<node> operands = {};
+  };
+
+  /// The rule set compiled for a single schema.
+  struct program {
+    std::vector<predicate> predicates = {};
+    std::vector<std::pair<size_t, node>> detections = {};
+  };
+
+  auto compile(const type& schema) -> const program&;
+
+  std::vector<rule> rules_ = {};
+  std::unordered_map<type, program> programs_ = {};
+};
+
+} // namespace tenzir::plugins::sigma
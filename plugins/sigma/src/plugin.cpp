@@ -7,6 +7,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "sigma/parse.hpp"
+#include "sigma/rule_set.hpp"
 
 #include <tenzir/argument_parser.hpp>
 #include <tenzir/arrow_table_slice.hpp>
@@ -29,6 +30,7 @@
 #include <caf/typed_event_based_actor.hpp>
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <thread>
 
 namespace tenzir::plugins::sigma {
@@ -42,12 +44,48 @@ public:
   }
 
   struct monitor_state {
-    auto update(const std::filesystem::path& path, operator_control_plane& ctrl)
-      -> void {
+    /// Reloads all rules from *path* and recompiles the rule set if any rule
+    /// changed.
+    auto update(operator_control_plane& ctrl) -> void {
       auto old_rules = std::exchange(rules, {});
+      load(path, ctrl);
+      auto changed = false;
+      for (const auto& [path, rule] : rules) {
+        const auto old_rule = old_rules.find(path);
+        if (old_rule == old_rules.end()) {
+          TENZIR_VERBOSE("added Sigma rule {}", path);
+          changed = true;
+        } else if (old_rule->second != rule) {
+          TENZIR_VERBOSE("updated Sigma rule {}", path);
+          changed = true;
+        }
+      }
+      for (const auto& [path, _] : old_rules) {
+        if (not rules.contains(path)) {
+          TENZIR_VERBOSE("removed Sigma rule {}", path);
+          changed = true;
+        }
+      }
+      if (not changed) {
+        return;
+      }
+      auto xs = std::vector<rule>{};
+      xs.reserve(rules.size());
+      for (const auto& [path, entry] : rules) {
+        const auto& [yaml, expr] = entry;
+        xs.push_back({path, yaml, expr, type::infer(yaml).value_or(type{})});
+      }
+      std::sort(xs.begin(), xs.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.path < rhs.path;
+      });
+      compiled = rule_set{std::move(xs)};
+    }
+
+    auto load(const std::filesystem::path& path, operator_control_plane& ctrl)
+      -> void {
       if (std::filesystem::is_directory(path)) {
         for (const auto& entry : std::filesystem::directory_iterator(path)) {
-          update(entry.path(), ctrl);
+          load(entry.path(), ctrl);
         }
         return;
       }
@@ -60,6 +98,7 @@ public:
         diagnostic::warning("sigma operator ignores rule '{}'", path.string())
           .note("failed to read file: {}", query.error())
           .emit(ctrl.diagnostics());
+        return;
       }
       auto query_str = std::string_view{
         reinterpret_cast<const char*>(query->data()),
@@ -79,24 +118,11 @@ public:
         return;
       }
       rules[path.string()] = {std::move(*yaml), std::move(*rule)};
-      for (const auto& [path, rule] : rules) {
-        const auto old_rule = old_rules.find(path);
-        if (old_rule == old_rules.end()) {
-          TENZIR_VERBOSE("added Sigma rule {}", path);
-        } else if (old_rule->second != rule) {
-          TENZIR_VERBOSE("updated Sigma rule {}", path);
-        }
-      }
-      for (const auto& [path, _] : old_rules) {
-        if (not rules.contains(path)) {
-          TENZIR_VERBOSE("removed Sigma rule {}", path);
-        }
-      }
-      return;
     }
 
     std::filesystem::path path;
     std::unordered_map<std::string, std::pair<data, expression>> rules = {};
+    rule_set compiled = {};
   };
 
   auto
@@ -104,7 +130,7 @@ public:
     -> generator<table_slice> {
     auto state = monitor_state{};
     state.path = path_;
-    state.update(state.path, ctrl);
+    state.update(ctrl);
     auto last_update = std::chrono::steady_clock::now();
     co_yield {}; // signal that we're done initializing
     for (auto&& slice : input) {
@@ -113,18 +139,13 @@ public:
         continue;
       }
       if (last_update + refresh_interval_ < std::chrono::steady_clock::now()) {
-        state.update(state.path, ctrl);
+        state.update(ctrl);
         last_update = std::chrono::steady_clock::now();
       }
-      for (const auto& [path, entry] : state.rules) {
-        const auto& [yaml, rule] = entry;
-        auto expr = tailor(rule, slice.schema());
-        if (not expr) {
-          continue;
-        }
-        if (auto event = filter(slice, *expr)) {
-          const auto rule_schema
-            = caf::get<record_type>(type::infer(yaml).value_or(type{}));
+      for (const auto& match : state.compiled.evaluate(slice)) {
+        const auto& rule = state.compiled.rules()[match.rule];
+        if (auto event = filter(slice, *match.mask)) {
+          const auto& rule_schema = caf::get<record_type>(rule.schema);
           const auto result_schema = type{
             "tenzir.sigma",
             record_type{
@@ -152,7 +173,7 @@ public:
               caf::get<arrow::StructBuilder>(
                 *caf::get<arrow::StructBuilder>(*result_builder)
                    .field_builder(1)),
-              caf::get<view<record>>(make_view(yaml)));
+              caf::get<view<record>>(make_view(rule.yaml)));
             TENZIR_ASSERT(append_rule_result.ok());
           }
           auto result = result_builder->Finish().ValueOrDie();
@@ -0,0 +1,165 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "sigma/rule_set.hpp"
+
+#include <tenzir/detail/assert.hpp>
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/detail/overload.hpp>
+#include <tenzir/die.hpp>
+#include <tenzir/logger.hpp>
+#include <tenzir/table_slice.hpp>
+
+#include <arrow/array.h>
+#include <arrow/compute/api.h>
+#include <arrow/scalar.h>
+
+#include <type_traits>
+
+namespace tenzir::plugins::sigma {
+
+namespace {
+
+using mask_ptr = std::shared_ptr<arrow::BooleanArray>;
+
+/// Invokes a boolean Arrow compute function on masks.
+mask_ptr call(const std::string& function,
+              const std::vector<arrow::Datum>& args) {
+  auto result = arrow::compute::CallFunction(function, args);
+  TENZIR_ASSERT(result.ok());
+  return std::static_pointer_cast<arrow::BooleanArray>(result->make_array());
+}
+
+mask_ptr make_constant_mask(bool value, int64_t length) {
+  auto result = arrow::MakeArrayFromScalar(arrow::BooleanScalar{value}, length)
+                  .ValueOrDie();
+  return std::static_pointer_cast<arrow::BooleanArray>(result);
+}
+
+} // namespace
+
+rule_set::rule_set(std::vector<rule> rules) : rules_{std::move(rules)} {
+  // nop
+}
+
+auto rule_set::rules() const -> const std::vector<rule>& {
+  return rules_;
+}
+
+auto rule_set::evaluate(const table_slice& slice) -> std::vector<match> {
+  auto result = std::vector<match>{};
+  if (slice.rows() == 0 || rules_.empty())
+    return result;
+  const auto& program = compile(slice.schema());
+  const auto length = detail::narrow_cast<int64_t>(slice.rows());
+  // The masks of the distinct predicates, which we compute lazily such that
+  // predicates only reachable through short-circuited nodes never run.
+  auto masks = std::vector<mask_ptr>(program.predicates.size());
+  const auto evaluate_node = [&](const auto& self, const node& x) -> mask_ptr {
+    switch (x.op) {
+      case node::kind::none:
+        return make_constant_mask(false, length);
+      case node::kind::predicate: {
+        auto& mask = masks[x.predicate];
+        if (!mask)
+          mask = evaluate_vectorized(
+            expression{program.predicates[x.predicate]}, slice);
+        return mask;
+      }
+      case node::kind::conjunction: {
+        auto acc = mask_ptr{};
+        for (const auto& operand : x.operands) {
+          auto mask = self(self, operand);
+          acc = acc ? call("and", {acc, mask}) : std::move(mask);
+          if (acc->true_count() == 0)
+            break;
+        }
+        return acc ? acc : make_constant_mask(true, length);
+      }
+      case node::kind::disjunction: {
+        auto acc = mask_ptr{};
+        for (const auto& operand : x.operands) {
+          auto mask = self(self, operand);
+          acc = acc ? call("or", {acc, mask}) : std::move(mask);
+          if (acc->true_count() == length)
+            break;
+        }
+        return acc ? acc : make_constant_mask(false, length);
+      }
+      case node::kind::negation: {
+        TENZIR_ASSERT(x.operands.size() == 1);
+        return call("invert", {self(self, x.operands[0])});
+      }
+    }
+    die("unhandled node kind");
+  };
+  for (const auto& [index, detection] : program.detections) {
+    auto mask = evaluate_node(evaluate_node, detection);
+    if (mask->true_count() > 0)
+      result.push_back({index, std::move(mask)});
+  }
+  return result;
+}
+
+auto rule_set::num_predicates(const type& schema) -> size_t {
+  return compile(schema).predicates.size();
+}
+
+auto rule_set::compile(const type& schema) -> const program& {
+  if (auto it = programs_.find(schema); it != programs_.end())
+    return it->second;
+  auto result = program{};
+  auto indexes = std::unordered_map<predicate, size_t>{};
+  const auto make_node = [&](const auto& self, const expression& x) -> node {
+    auto f = detail::overload{
+      [&](const caf::none_t&) {
+        return node{};
+      },
+      [&](const predicate& pred) {
+        auto [it, inserted]
+          = indexes.try_emplace(pred, result.predicates.size());
+        if (inserted)
+          result.predicates.push_back(pred);
+        return node{node::kind::predicate, it->second};
+      },
+      [&](const negation& neg) {
+        auto operands = std::vector<node>{};
+        operands.push_back(self(self, neg.expr()));
+        return node{node::kind::negation, 0, std::move(operands)};
+      },
+      [&]<class Connective>(const Connective& xs) -> node {
+        static_assert(std::is_same_v<Connective, conjunction>
+                      || std::is_same_v<Connective, disjunction>);
+        constexpr auto op = std::is_same_v<Connective, conjunction>
+                              ? node::kind::conjunction
+                              : node::kind::disjunction;
+        auto operands = std::vector<node>{};
+        operands.reserve(xs.size());
+        for (const auto& operand : xs)
+          operands.push_back(self(self, operand));
+        return node{op, 0, std::move(operands)};
+      },
+    };
+    return caf::visit(f, x);
+  };
+  for (size_t i = 0; i < rules_.size(); ++i) {
+    // Rules that do not apply to the schema never match, so we leave them out
+    // of the program entirely.
+    auto expr = tailor(rules_[i].expr, schema);
+    if (!expr)
+      continue;
+    result.detections.emplace_back(i, make_node(make_node, *expr));
+  }
+  TENZIR_DEBUG("sigma compiled {} of {} rules with {} distinct predicates for "
+               "schema {}",
+               result.detections.size(), rules_.size(),
+               result.predicates.size(), schema.name());
+  return programs_.emplace(schema, std::move(result)).first->second;
+}
+
+} // namespace tenzir::plugins::sigma
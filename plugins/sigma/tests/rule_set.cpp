@@ -0,0 +1,120 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "sigma/rule_set.hpp"
+
+#include <tenzir/concept/parseable/tenzir/expression.hpp>
+#include <tenzir/concept/parseable/to.hpp>
+#include <tenzir/series_builder.hpp>
+#include <tenzir/table_slice.hpp>
+#include <tenzir/test/test.hpp>
+
+#include <arrow/array.h>
+#include <caf/test/dsl.hpp>
+#include <fmt/format.h>
+
+using namespace tenzir;
+using namespace tenzir::plugins::sigma;
+
+namespace {
+
+auto make_events(size_t num_events) -> table_slice {
+  auto b = series_builder{};
+  for (size_t i = 0; i < num_events; ++i) {
+    auto event = b.record();
+    event.field("EventID", int64_t{static_cast<int64_t>(i % 20)});
+    event.field("Image", fmt::format("/usr/bin/tool{}", i % 30));
+    event.field("CommandLine",
+                fmt::format("run --flag{} --opt{}", i % 50, i % 7));
+    event.field("User", i % 3 == 0 ? "root" : fmt::format("user{}", i % 5));
+  }
+  return b.finish_assert_one_slice("sysmon.process_creation");
+}
+
+/// Generates rules that share most of their predicates, like rules in a real
+/// Sigma corpus that all look at the same handful of fields.
+auto make_rules(size_t num_rules) -> std::vector<rule> {
+  auto result = std::vector<rule>{};
+  result.reserve(num_rules);
+  for (size_t i = 0; i < num_rules; ++i) {
+    auto detection = fmt::format(
+      "EventID == {} && (CommandLine ni \"flag{}\" || Image == "
+      "\"/usr/bin/tool{}\")",
+      i % 20, i % 50, i % 30);
+    if (i % 4 == 0)
+      detection += fmt::format(" && CommandLine == /.*opt{}$/", i % 7);
+    if (i % 3 == 0)
+      detection += " && ! (User == \"root\")";
+    if (i % 10 == 9)
+      detection += " && ParentImage == \"/bin/sh\"";
+    auto yaml = record{{"title", fmt::format("rule {}", i)}};
+    result.push_back({
+      fmt::format("rules/{}.yml", i),
+      yaml,
+      unbox(to<expression>(detection)),
+      type::infer(yaml).value_or(type{}),
+    });
+  }
+  return result;
+}
+
+/// Counts the matches of every rule by evaluating the rules one after another.
+auto evaluate_naively(const std::vector<rule>& rules, const table_slice& slice)
+  -> std::vector<size_t> {
+  auto result = std::vector<size_t>(rules.size(), 0);
+  for (size_t i = 0; i < rules.size(); ++i) {
+    auto expr = tailor(rules[i].expr, slice.schema());
+    if (!expr)
+      continue;
+    if (auto event = filter(slice, *expr))
+      result[i] = event->rows();
+  }
+  return result;
+}
+
+auto count_matches(const std::vector<rule_set::match>& matches,
+                   size_t num_rules) -> std::vector<size_t> {
+  auto result = std::vector<size_t>(num_rules, 0);
+  for (const auto& match : matches)
+    result[match.rule] = match.mask->true_count();
+  return result;
+}
+
+} // namespace
+
+TEST(rule set) {
+  const auto slice = make_events(100);
+  auto rules = make_rules(40);
+  const auto expected = evaluate_naively(rules, slice);
+  auto engine = rule_set{std::move(rules)};
+  const auto matches = engine.evaluate(slice);
+  REQUIRE(!matches.empty());
+  for (size_t i = 1; i < matches.size(); ++i)
+    CHECK_LESS(matches[i - 1].rule, matches[i].rule);
+  CHECK_EQUAL(count_matches(matches, engine.rules().size()), expected);
+  MESSAGE("predicates are shared across rules");
+  // Tailoring drops the rules 9, 19, 29, and 39 that refer to a missing
+  // field, which leaves 18 event IDs, 36 flags, 27 images, 7 patterns, and
+  // the user.
+  CHECK_EQUAL(engine.num_predicates(slice.schema()),
+              size_t{18 + 36 + 27 + 7 + 1});
+  MESSAGE("rules that do not apply to a schema never match");
+  auto other = series_builder{};
+  other.record().field("EventID", int64_t{1});
+  CHECK(engine.evaluate(other.finish_assert_one_slice("other")).empty());
+}
+
+TEST(rule set with many rules) {
+  const auto slice = make_events(200);
+  auto rules = make_rules(300);
+  const auto expected = evaluate_naively(rules, slice);
+  auto engine = rule_set{std::move(rules)};
+  CHECK_EQUAL(count_matches(engine.evaluate(slice), 300), expected);
+  MESSAGE("evaluating again reuses the compiled predicates");
+  CHECK_EQUAL(count_matches(engine.evaluate(slice), 300), expected);
+}
@@ -42,6 +42,9 @@ public:
 
   void abort(uint16_t error_code, std::string message, caf::error detail);
 
+  // Override the content type that was derived from the endpoint.
+  void set_content_type(http_content_type type);
+
   // Add a custom response header.
   void add_header(std::string field, std::string value);
 
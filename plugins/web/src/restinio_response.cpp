@@ -16,6 +16,8 @@ static std::string content_type_to_string(tenzir::http_content_type type) {
       return "application/json; charset=utf-8";
     case http_content_type::ldjson:
       return "application/ld+json; charset=utf-8";
+    case http_content_type::arrow_stream:
+      return "application/vnd.apache.arrow.stream";
   }
   // Unreachable
   return "application/octet-stream";
@@ -68,6 +70,11 @@ void restinio_response::abort(uint16_t error_code, std::string message,
   // it from being called multiple times.
 }
 
+void restinio_response::set_content_type(http_content_type type) {
+  response_.header().set_field(restinio::http_field::content_type,
+                               content_type_to_string(type));
+}
+
 void restinio_response::add_header(std::string field, std::string value) {
   response_.append_header(std::move(field), std::move(value));
 }
@@ -204,6 +204,8 @@ request_dispatcher_actor::behavior_type request_dispatcher(
                   endpoint.endpoint_id, std::move(*params))
         .then(
           [response](rest_response& rsp) {
+            if (auto content_type = rsp.content_type())
+              response->set_content_type(*content_type);
             auto&& body = std::move(rsp).release();
             response->finish(std::move(body));
           },
@@ -33,3 +33,11 @@ setup() {
 @test "accumulate chunks and match when the input exhausted" {
   echo 'foo bar' | check tenzir "load stdin | repeat 2 | yara ${RULE}"
 }
+
+@test "match blockwise per chunk with multiple threads" {
+  echo 'foo bar' | check tenzir "load stdin | repeat 4 | yara -B --threads 2 ${RULE}"
+}
+
+@test "scan overlapping windows of the input" {
+  echo 'foo bar baz' | check tenzir "load stdin | yara --block-size 4 --overlap 3 ${RULE}"
+}
@@ -7,12 +7,15 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <tenzir/argument_parser.hpp>
+#include <tenzir/concept/parseable/tenzir/si.hpp>
 #include <tenzir/die.hpp>
 #include <tenzir/logger.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/series_builder.hpp>
+#include <tenzir/si_literals.hpp>
 
 #include <deque>
+#include <future>
 #include <yara.h>
 
 namespace tenzir::plugins::yara {
@@ -25,13 +28,19 @@ struct operator_args {
   bool compiled_rules;
   bool fast_scan;
   std::vector<std::string> rules;
+  uint64_t threads = 1;
+  std::optional<uint64_t> block_size;
+  uint64_t overlap = 0;
 
   friend auto inspect(auto& f, operator_args& x) -> bool {
     return f.object(x)
       .pretty_name("operator_args")
       .fields(f.field("blockwise", x.blockwise),
               f.field("compiled_rules", x.compiled_rules),
-              f.field("fast_scan", x.fast_scan), f.field("rules", x.rules));
+              f.field("fast_scan", x.fast_scan), f.field("rules", x.rules),
+              f.field("threads", x.threads),
+              f.field("block_size", x.block_size),
+              f.field("overlap", x.overlap));
   }
 };
 
@@ -41,6 +50,24 @@ struct scan_options {
   std::chrono::seconds timeout{1'000'000};
 };
 
+/// A contiguous range of the input that a scanner checks for matches.
+struct scan_window {
+  /// The bytes to scan.
+  chunk_ptr bytes;
+  /// The offset of the bytes in the input.
+  uint64_t base = 0;
+  /// The offset in the window from which on matches are left for the next
+  /// window, which overlaps with this one.
+  uint64_t limit = std::numeric_limits<uint64_t>::max();
+};
+
+/// The state of a single scan that the YARA callback operates on.
+struct scan_state {
+  series_builder builder;
+  uint64_t base = 0;
+  uint64_t limit = std::numeric_limits<uint64_t>::max();
+};
+
 /// Translates a YARA status code to an error.
 auto to_error(int status) -> caf::error {
   switch (status) {
@@ -258,36 +285,67 @@ public:
   /// Performs a one-shot scan of a given block of memory.
   auto scan(std::span<const std::byte> bytes)
     -> caf::expected<std::vector<table_slice>> {
-    auto buffer = reinterpret_cast<const uint8_t*>(bytes.data());
-    auto buffer_size = bytes.size();
-    auto builder = series_builder{};
-    yr_scanner_set_callback(scanner_, callback, &builder);
-    auto status = yr_scanner_scan_mem(scanner_, buffer, buffer_size);
-    if (auto err = to_error(status))
-      return err;
-    return builder.finish_as_table_slice("yara.match");
+    return scan(bytes, scan_state{});
+  }
+
+  /// Performs a one-shot scan of a window of the input.
+  auto scan(const scan_window& window)
+    -> caf::expected<std::vector<table_slice>> {
+    return scan(as_bytes(window.bytes), scan_state{
+                                          .base = window.base,
+                                          .limit = window.limit,
+                                        });
   }
 
   /// Checks a sequence of memory blocks for rule matches.
   auto scan(memory_block_vector& blocks)
     -> caf::expected<std::vector<table_slice>> {
-    auto builder = series_builder{};
-    yr_scanner_set_callback(scanner_, callback, &builder);
+    auto state = scan_state{};
+    yr_scanner_set_callback(scanner_, callback, &state);
     auto status = yr_scanner_scan_mem_blocks(scanner_, blocks.iterator());
     if (auto err = to_error(status))
       return err;
-    return builder.finish_as_table_slice("yara.match");
+    return state.builder.finish_as_table_slice("yara.match");
   }
 
 private:
+  auto scan(std::span<const std::byte> bytes, scan_state state)
+    -> caf::expected<std::vector<table_slice>> {
+    auto buffer = reinterpret_cast<const uint8_t*>(bytes.data());
+    auto buffer_size = bytes.size();
+    yr_scanner_set_callback(scanner_, callback, &state);
+    auto status = yr_scanner_scan_mem(scanner_, buffer, buffer_size);
+    if (auto err = to_error(status))
+      return err;
+    return state.builder.finish_as_table_slice("yara.match");
+  }
+
   static auto callback(YR_SCAN_CONTEXT* context, int message,
                        void* message_data, void* user_data) -> int {
     TENZIR_ASSERT(user_data != nullptr);
-    auto* builder = reinterpret_cast<series_builder*>(user_data);
+    auto* state = reinterpret_cast<scan_state*>(user_data);
     if (message == CALLBACK_MSG_RULE_MATCHING) {
       auto* rule = reinterpret_cast<YR_RULE*>(message_data);
       TENZIR_DEBUG("got a match for rule {}", rule->identifier);
-      auto row = builder->record();
+      // The next window contains the entire overlap with this window, so we
+      // leave rules whose matches all begin in the overlap to the next window.
+      auto has_matches = false;
+      auto has_matches_before_limit = false;
+      YR_STRING* string = nullptr;
+      yr_rule_strings_foreach(rule, string) {
+        YR_MATCH* match = nullptr;
+        yr_string_matches_foreach(context, string, match) {
+          has_matches = true;
+          if (detail::narrow_cast<uint64_t>(match->offset) < state->limit)
+            has_matches_before_limit = true;
+        }
+      }
+      if (has_matches and not has_matches_before_limit) {
+        TENZIR_DEBUG("deferring match for rule {} to next window",
+                     rule->identifier);
+        return CALLBACK_CONTINUE;
+      }
+      auto row = state->builder.record();
       auto rec = row.field("rule").record();
       rec.field("identifier").data(rule->identifier);
       rec.field("namespace").data(std::string_view{rule->ns->name});
@@ -310,7 +368,7 @@ private:
       // First we bring all strings to the attention of the user. This is
       // valuable rule context in case the rule is not immediately handly.
       auto strings = rec.field("strings").record();
-      YR_STRING* string = nullptr;
+      string = nullptr;
       yr_rule_strings_foreach(rule, string) {
         // TODO: should this be byte?
         auto rule_string
@@ -318,14 +376,29 @@ private:
                              detail::narrow_cast<size_t>(string->length)};
         strings.field(string->identifier).data(rule_string);
       }
-      // Second we go through the subset of strings that have matches.
+      // Second we go through the subset of strings that have matches. Matches
+      // that begin in the overlap with the next window are reported by the
+      // next window, so we drop them here to avoid reporting them twice.
+      const auto before_limit = [&](const YR_MATCH* match) {
+        return detail::narrow_cast<uint64_t>(match->offset) < state->limit;
+      };
       auto matches = row.field("matches").record();
       string = nullptr;
       yr_rule_strings_foreach(rule, string) {
-        if (context->matches[string->idx].head != nullptr) {
+        auto has_string_matches_before_limit = false;
+        YR_MATCH* match = nullptr;
+        yr_string_matches_foreach(context, string, match) {
+          if (before_limit(match)) {
+            has_string_matches_before_limit = true;
+            break;
+          }
+        }
+        if (has_string_matches_before_limit) {
           auto list = matches.field(string->identifier).list();
-          YR_MATCH* match = nullptr;
+          match = nullptr;
           yr_string_matches_foreach(context, string, match) {
+            if (not before_limit(match))
+              continue;
             auto match_rec = list.record();
             auto bytes = std::span<const std::byte>{
               reinterpret_cast<const std::byte*>(match->data),
@@ -333,7 +406,8 @@ private:
             auto blob_view
               = std::basic_string_view<std::byte>{bytes.data(), bytes.size()};
             match_rec.field("data").data(blob_view);
-            match_rec.field("base").data(match->base);
+            match_rec.field("base").data(
+              detail::narrow_cast<int64_t>(state->base) + match->base);
             match_rec.field("offset").data(match->offset);
             match_rec.field("match_length")
               .data(detail::narrow_cast<uint64_t>(match->match_length));
@@ -472,6 +546,159 @@ private:
   YR_COMPILER* compiler_ = nullptr;
 };
 
+/// Cuts a stream of bytes into windows of `block_size + overlap` bytes that
+/// begin every `block_size` bytes, so that every window shares its last
+/// `overlap` bytes with the next one. Matches no longer than the overlap that
+/// cross a block boundary are thus fully contained in one of the windows.
+class window_splitter {
+public:
+  window_splitter(uint64_t block_size, uint64_t overlap)
+    : block_size_{block_size}, overlap_{overlap} {
+    TENZIR_ASSERT(overlap_ < block_size_);
+  }
+
+  /// Adds the next chunk of the input.
+  /// @returns The windows that are complete.
+  auto add(const chunk_ptr& chunk) -> std::vector<scan_window> {
+    auto result = std::vector<scan_window>{};
+    const auto window_size = block_size_ + overlap_;
+    auto offset = size_t{0};
+    // Top up the buffered bytes only until they complete a window. The bytes
+    // of the chunk past that window are not copied into the buffer.
+    while (not buffer_.empty()) {
+      const auto missing = window_size - buffer_.size();
+      if (chunk->size() - offset < missing) {
+        buffer_.insert(buffer_.end(), chunk->begin() + offset, chunk->end());
+        return result;
+      }
+      buffer_.insert(buffer_.end(), chunk->begin() + offset,
+                     chunk->begin() + offset + missing);
+      offset += missing;
+      auto window = chunk::make(std::exchange(buffer_, {}));
+      if (missing < overlap_) {
+        // The next window still begins in the buffered bytes.
+        const auto tail = as_bytes(window).subspan(block_size_);
+        buffer_.assign(tail.begin(), tail.end());
+      } else {
+        offset -= overlap_;
+      }
+      result.push_back(scan_window{
+        .bytes = std::move(window),
+        .base = base_,
+        .limit = block_size_,
+      });
+      base_ += block_size_;
+    }
+    // Windows that lie entirely in the chunk share its memory.
+    while (chunk->size() - offset >= window_size) {
+      result.push_back(scan_window{
+        .bytes = chunk->slice(offset, window_size),
+        .base = base_,
+        .limit = block_size_,
+      });
+      base_ += block_size_;
+      offset += block_size_;
+    }
+    const auto rest = as_bytes(chunk).subspan(offset);
+    buffer_.assign(rest.begin(), rest.end());
+    return result;
+  }
+
+  /// Signals the end of the input.
+  /// @returns The last window, unless the input was empty.
+  auto finish() -> std::optional<scan_window> {
+    if (buffer_.empty())
+      return std::nullopt;
+    return scan_window{
+      .bytes = chunk::make(std::exchange(buffer_, {})),
+      .base = base_,
+    };
+  }
+
+private:
+  uint64_t block_size_ = {};
+  uint64_t overlap_ = {};
+  std::vector<std::byte> buffer_ = {};
+  uint64_t base_ = {};
+};
+
+/// A fixed set of scanners that share their rules and scan windows
+/// concurrently. The results become available in the order of the windows.
+class scanner_pool {
+public:
+  using result_type = caf::expected<std::vector<table_slice>>;
+
+  /// Constructs a pool with one scanner per thread.
+  static auto make(const rules& rules, scan_options opts, uint64_t threads)
+    -> std::optional<scanner_pool> {
+    TENZIR_ASSERT(threads > 0);
+    auto result = scanner_pool{};
+    result.scanners_.reserve(threads);
+    for (auto i = uint64_t{0}; i < threads; ++i) {
+      auto scanner = scanner::make(rules, opts);
+      if (not scanner)
+        return std::nullopt;
+      result.scanners_.push_back(std::move(*scanner));
+    }
+    return result;
+  }
+
+  /// Hands out the results of finished windows, and waits for the oldest
+  /// windows until no more than `max_in_flight` remain in flight.
+  auto collect(size_t max_in_flight, auto&& on_error)
+    -> std::vector<table_slice> {
+    auto result = std::vector<table_slice>{};
+    while (not in_flight_.empty()) {
+      auto& front = in_flight_.front();
+      if (in_flight_.size() <= max_in_flight
+          and front.wait_for(std::chrono::seconds{0})
+                != std::future_status::ready)
+        break;
+      auto slices = front.get();
+      in_flight_.pop_front();
+      if (not slices) {
+        on_error(slices.error());
+        continue;
+      }
+      result.insert(result.end(), std::make_move_iterator(slices->begin()),
+                    std::make_move_iterator(slices->end()));
+    }
+    return result;
+  }
+
+  /// Starts scanning a window. A single scanner scans right away instead.
+  /// @pre The number of windows in flight is less than the number of
+  /// scanners.
+  auto submit(scan_window window) -> void {
+    TENZIR_ASSERT(in_flight_.size() < scanners_.size());
+    // The windows are collected in order, so the scanner that scanned the
+    // window as many windows ago as there are scanners is idle by now.
+    auto& scanner = scanners_[next_++ % scanners_.size()];
+    if (scanners_.size() == 1) {
+      auto promise = std::promise<result_type>{};
+      promise.set_value(scanner.scan(window));
+      in_flight_.push_back(promise.get_future());
+      return;
+    }
+    in_flight_.push_back(
+      std::async(std::launch::async, [&scanner, window = std::move(window)] {
+        return scanner.scan(window);
+      }));
+  }
+
+  /// Returns the number of scanners.
+  auto size() const -> size_t {
+    return scanners_.size();
+  }
+
+private:
+  scanner_pool() = default;
+
+  std::vector<scanner> scanners_ = {};
+  std::deque<std::future<result_type>> in_flight_ = {};
+  size_t next_ = 0;
+};
+
 /// The `yara` operator implementation.
 class yara_operator final : public crtp_operator<yara_operator> {
 public:
@@ -511,31 +738,83 @@ public:
       }
       rules = compiler->compile();
     }
+    if (not rules) {
+      diagnostic::error("failed to compile YARA rules")
+        .note("{}", rules.error())
+        .emit(ctrl.diagnostics());
+      co_return;
+    }
     auto opts = scan_options{
       .fast_scan = args_.fast_scan,
     };
-    auto scanner = scanner::make(*rules, opts);
-    if (not scanner) {
+    auto pool = scanner_pool::make(*rules, opts, args_.threads);
+    if (not pool) {
       diagnostic::warning("failed to construct YARA scanner")
         .emit(ctrl.diagnostics());
       co_return;
     }
-    if (args_.blockwise) {
+    auto failed = false;
+    const auto on_error = [&](const caf::error& err) {
+      if (args_.blockwise) {
+        diagnostic::warning("failed to scan block with YARA rules")
+          .hint("{}", err)
+          .emit(ctrl.diagnostics());
+        return;
+      }
+      diagnostic::error("failed to scan blocks with YARA rules")
+        .hint("{}", err)
+        .emit(ctrl.diagnostics());
+      failed = true;
+    };
+    // Bounds the memory in flight to one window per scanner, and hands out
+    // the results of all windows that are done scanning.
+    const auto scan = [&](scan_window window) {
+      auto result = pool->collect(pool->size() - 1, on_error);
+      pool->submit(std::move(window));
+      auto done = pool->collect(pool->size(), on_error);
+      result.insert(result.end(), std::make_move_iterator(done.begin()),
+                    std::make_move_iterator(done.end()));
+      return result;
+    };
+    if (args_.blockwise or args_.block_size) {
+      auto splitter = std::optional<window_splitter>{};
+      if (args_.block_size)
+        splitter.emplace(*args_.block_size, args_.overlap);
       for (auto&& chunk : input) {
         if (not chunk) {
+          for (auto&& slice : pool->collect(pool->size(), on_error))
+            co_yield slice;
+          if (failed)
+            co_return;
           co_yield {};
           continue;
         }
-        if (auto slices = scanner->scan(as_bytes(chunk))) {
-          for (auto&& slice : *slices)
-            co_yield slice;
+        auto windows = std::vector<scan_window>{};
+        if (not splitter) {
+          windows.push_back(scan_window{.bytes = std::move(chunk)});
         } else {
-          diagnostic::warning("failed to scan block with YARA rules")
-            .hint("{}", slices.error())
-            .emit(ctrl.diagnostics());
-          co_yield {};
+          windows = splitter->add(chunk);
+          if (args_.blockwise) {
+            // Every chunk is a separate input, so we start from scratch.
+            if (auto last = splitter->finish())
+              windows.push_back(std::move(*last));
+            splitter.emplace(*args_.block_size, args_.overlap);
+          }
         }
+        for (auto& window : windows) {
+          for (auto&& slice : scan(std::move(window)))
+            co_yield slice;
+          if (failed)
+            co_return;
+        }
+      }
+      if (splitter and not args_.blockwise) {
+        if (auto last = splitter->finish())
+          for (auto&& slice : scan(std::move(*last)))
+            co_yield slice;
       }
+      for (auto&& slice : pool->collect(0, on_error))
+        co_yield slice;
     } else {
       // Small optimization: in case the entire input consists of a single
       // chunk, we don't want to copy it at all. This actually may happen
@@ -557,15 +836,13 @@ public:
           buffer.insert(buffer.end(), chunk->begin(), chunk->end());
         }
       }
-      auto bytes = buffer.empty() ? as_bytes(first) : as_bytes(buffer);
-      if (auto slices = scanner->scan(bytes)) {
-        for (auto&& slice : *slices)
-          co_yield slice;
-      } else {
-        diagnostic::error("failed to scan blocks with YARA rules")
-          .hint("{}", slices.error())
-          .emit(ctrl.diagnostics());
-      }
+      auto bytes = not buffer.empty() ? chunk::make(std::move(buffer))
+                   : first              ? std::move(first)
+                                        : chunk::make_empty();
+      for (auto&& slice : scan(scan_window{.bytes = std::move(bytes)}))
+        co_yield slice;
+      for (auto&& slice : pool->collect(0, on_error))
+        co_yield slice;
     }
   }
 
@@ -607,7 +884,26 @@ public:
   }
 
   auto parse_operator(parser_interface& p) const -> operator_ptr override {
+    using namespace si_literals;
     auto args = operator_args{};
+    auto threads = std::optional<located<uint64_t>>{};
+    auto block_size = std::optional<located<uint64_t>>{};
+    auto overlap = std::optional<located<uint64_t>>{};
+    const auto parse_value = [&](const located<std::string>& option,
+                                 const auto& parser) {
+      auto value = p.accept_shell_arg();
+      if (not value)
+        diagnostic::error("`{}` requires a value", option.inner)
+          .primary(option.source)
+          .throw_();
+      auto result = uint64_t{0};
+      if (not parser(value->inner, result))
+        diagnostic::error("invalid value for `{}`: {}", option.inner,
+                          value->inner)
+          .primary(value->source)
+          .throw_();
+      return located<uint64_t>{result, value->source};
+    };
     while (auto arg = p.accept_shell_arg()) {
       if (arg) {
         if (arg->inner == "-C" || arg->inner == "--compiled-rules")
@@ -616,6 +912,12 @@ public:
           args.fast_scan = true;
         else if (arg->inner == "-B" || arg->inner == "--blockwise")
           args.blockwise = true;
+        else if (arg->inner == "--threads")
+          threads = parse_value(*arg, parsers::count);
+        else if (arg->inner == "--block-size")
+          block_size = parse_value(*arg, parsers::bytesize);
+        else if (arg->inner == "--overlap")
+          overlap = parse_value(*arg, parsers::bytesize);
         else
           args.rules.push_back(std::move(arg->inner));
       }
@@ -626,6 +928,36 @@ public:
       diagnostic::error("can't accept multiple rules in compiled form")
         .hint("provide exactly one rule argument")
         .throw_();
+    if (threads) {
+      if (threads->inner == 0)
+        diagnostic::error("the number of threads must not be 0")
+          .primary(threads->source)
+          .throw_();
+      // YARA limits the number of concurrent scans per set of rules.
+      if (threads->inner > YR_MAX_THREADS)
+        diagnostic::error("the number of threads must not exceed {}",
+                          YR_MAX_THREADS)
+          .primary(threads->source)
+          .throw_();
+      args.threads = threads->inner;
+    }
+    if (overlap and not block_size)
+      diagnostic::error("`--overlap` requires `--block-size`")
+        .primary(overlap->source)
+        .throw_();
+    if (block_size) {
+      if (block_size->inner == 0)
+        diagnostic::error("the block size must not be 0")
+          .primary(block_size->source)
+          .throw_();
+      args.block_size = block_size->inner;
+      args.overlap = overlap ? overlap->inner
+                             : std::min(uint64_t{4_Ki}, block_size->inner / 2);
+      if (args.overlap >= block_size->inner)
+        diagnostic::error("the overlap must be smaller than the block size")
+          .primary(overlap->source)
+          .throw_();
+    }
     return std::make_unique<yara_operator>(std::move(args));
   }
 };
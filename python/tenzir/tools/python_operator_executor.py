@@ -1,6 +1,9 @@
 """User code wrapper of the Tenzir python operator."""
+import mmap
 import os
+import socket
 import sys
+import tempfile
 from collections import defaultdict
 from types import ModuleType
 from typing import (
@@ -340,12 +343,71 @@ def _execute_user_code(__batch: pa.RecordBatch, __code: str) -> pa.RecordBatch:
     return __buffer.finish()
 
 
+# The size of a message on the socket to the operator. Every message holds the
+# size of an Arrow IPC stream, and comes with the descriptor of the shared
+# memory that contains the stream.
+_MESSAGE_SIZE = 8
+
+
+def _make_shared_memory(size: int) -> int:
+    if hasattr(os, "memfd_create"):
+        fd = os.memfd_create("tenzir-python")
+    else:
+        with tempfile.TemporaryFile() as f:
+            fd = os.dup(f.fileno())
+    os.ftruncate(fd, size)
+    return fd
+
+
+def _receive_batch(sock: socket.socket) -> Optional[pa.RecordBatch]:
+    """Receive the next record batch from the operator.
+
+    The batch references the shared memory it was received in without copying
+    it. Returns `None` when the operator closed the connection.
+    """
+    message, fds, _, _ = socket.recv_fds(sock, _MESSAGE_SIZE, 1)
+    if not message:
+        return None
+    if len(message) != _MESSAGE_SIZE or len(fds) != 1:
+        raise Exception("received malformed message from operator")
+    size = int.from_bytes(message, sys.byteorder)
+    try:
+        memory = mmap.mmap(fds[0], size, prot=mmap.PROT_READ)
+    finally:
+        os.close(fds[0])
+    return pa.ipc.open_stream(pa.py_buffer(memory)).read_next_batch()
+
+
+def _send_batch(sock: socket.socket, batch: pa.RecordBatch) -> None:
+    """Write a record batch into fresh shared memory and pass it to the
+    operator.
+    """
+
+    def write(sink: pa.NativeFile) -> None:
+        with pa.ipc.new_stream(sink, batch.schema) as writer:
+            writer.write_batch(batch)
+
+    # Determine the size of the stream up front, so that we can write it into
+    # shared memory of the right size without an intermediate buffer.
+    counter = pa.MockOutputStream()
+    write(counter)
+    size = counter.size()
+    fd = _make_shared_memory(size)
+    try:
+        memory = mmap.mmap(fd, size)
+        write(pa.FixedSizeBufferWriter(pa.py_buffer(memory)))
+        socket.send_fds(sock, [size.to_bytes(_MESSAGE_SIZE, sys.byteorder)], [fd])
+    finally:
+        os.close(fd)
+
+
 def main() -> int:
     """Run the user provided code on behalf of the operator.
 
-    Expects two open file descriptor numbers as arguments.
+    Expects three open file descriptor numbers as arguments.
     The first is for receiving the user code.
     The second is to write back a message in case an error occurred.
+    The third is a Unix domain socket for exchanging record batches.
     """
     # The parent uses `codepipe` to transfer the user code to be executed
     # into this program.
@@ -356,31 +418,18 @@ def main() -> int:
     # of `errpipe` and aborts the pipeline with them as the error.
     errpipe = int(sys.argv[2])
 
-    # The parent uses stdin and stdout to transfer the arrow record batches
-    # back and forth.
-    istream = pa.input_stream(sys.stdin.buffer)
-    ostream = pa.output_stream(sys.stdout.buffer)
+    # The parent passes the arrow record batches back and forth through shared
+    # memory, whose descriptors it sends over `sock`. The parent closes the
+    # socket to shut us down.
+    sock = socket.socket(fileno=int(sys.argv[3]))
 
     try:
         while True:
-            reader = pa.ipc.RecordBatchStreamReader(istream)
-            batch_in = reader.read_next_batch()
-            # The writer writes an invalid record batch as end-of-stream
-            # marker; we have to read it now to remove it from the pipe
-            # buffer.
-            try:
-                reader.read_next_batch()
-            except StopIteration:
-                pass
+            batch_in = _receive_batch(sock)
+            if batch_in is None:
+                break
             batch_out = _execute_user_code(batch_in, code.decode())
-            writer = pa.ipc.RecordBatchStreamWriter(ostream, batch_out.schema)
-            writer.write_batch(batch_out)
-            writer.close()
-            sys.stdout.flush()
-    except pa.lib.ArrowInvalid as ae:
-        # The reader throws `ArrowInvalid` when the input is closed
-        # by the parent process.
-        pass
+            _send_batch(sock, batch_out)
     except Exception as e:
         message = str(e).encode("utf-8")
         # Ensure we will never block while trying to write the error message
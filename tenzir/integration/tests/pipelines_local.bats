@@ -105,6 +105,26 @@ setup() {
   check tenzir "from file ${INPUTSDIR}/suricata/eve.json read json --selector=pcap_cnt | put x=#schema"
 }
 
+# bats test_tags=pipelines,json
+@test "Read NDJSON with multiple threads" {
+  # Interleave logs of different schemas into an input of several MiB, so that
+  # the lines spread over many chunks and over multiple ranges per thread.
+  input="${BATS_TEST_TMPDIR}/input.json"
+  for _ in $(seq 6); do
+    for log in conn dns rdp snmp ssh weird; do
+      gunzip -c "${INPUTSDIR}/json/${log}.log.json.gz" >>"${input}"
+    done
+  done
+  tenzir "from file ${input} read json --ndjson | write json -c" \
+    >"${BATS_TEST_TMPDIR}/serial.json"
+  for threads in 2 4; do
+    tenzir "from file ${input} read json --ndjson --threads ${threads} | write json -c" \
+      >"${BATS_TEST_TMPDIR}/parallel.json"
+    cmp "${BATS_TEST_TMPDIR}/serial.json" "${BATS_TEST_TMPDIR}/parallel.json"
+  done
+  check ! tenzir "read json --ndjson --threads 0"
+}
+
 # bats test_tags=pipelines
 @test "Read from suricata file" {
   check tenzir "from file ${INPUTSDIR}/suricata/eve.json read suricata | write json"
@@ -362,6 +382,10 @@ setup() {
   # Concatenate PCAPs and process them. The test ensures that we have the
   # right sequencing of file header and packet header events.
   check tenzir "shell \"cat ${INPUTSDIR}/pcap/vlan-*.pcap\" | read pcap -e | put schema=#schema | write json -c"
+  # Memory-mapping the trace yields a single chunk, from which the parser reads
+  # all packets without buffering. The output is again identical to the input.
+  gunzip -c "${INPUTSDIR}/pcap/example.pcap.gz" > "${BATS_TEST_TMPDIR}/example.pcap"
+  check -c "tenzir 'load file --mmap ${BATS_TEST_TMPDIR}/example.pcap | read pcap -e | write pcap' | md5sum | cut -f 1 -d ' '"
 }
 
 # bats test_tags=pipelines, compression
@@ -463,6 +487,11 @@ setup() {
   check tenzir "from ${INPUTSDIR}/syslog/syslog-rfc3164.log read lines | parse line grok --include-unnamed \"(<%{NONNEGINT:priority}>\s*)?%{SYSLOGTIMESTAMP:timestamp} (%{HOSTNAME:hostname}/%{IPV4:hostip}|%{WORD:host}) %{SYSLOGPROG}:%{GREEDYDATA:message}\""
   check tenzir 'show version | put version="v4.5.0-71-gae887a0ca3-dirty" | parse version grok "%{TIMESTAMP_ISO8601}"'
   check tenzir 'show version | put line="55.3.244.1 GET /index.html 15824 0.043" | parse line grok "%{IP:client} %{WORD:method} %{URIPATHPARAM:request} %{NUMBER:bytes} %{NUMBER:duration}"'
+  check tenzir 'show version | put version="v4.5.0-71-gae887a0ca3-dirty" | parse version grok --engine re2 "v%{INT:major:int}\.%{INT:minor:int}\.%{INT:patch:int}(-%{INT:tweak:int}-%{DATA:ref}(-%{DATA:extra})?)?"'
+  check tenzir 'show version | put version="v4.5.0-71-gae887a0ca3-dirty" | parse version grok --engine re2 --indexed-captures "v%{INT:major:int}\.%{INT:minor:int}\.%{INT:patch:int}(-%{INT:tweak}-%{DATA:ref}(-%{DATA:extra})?)?"'
+  check tenzir "from ${INPUTSDIR}/syslog/syslog-rfc3164.log read lines | parse line grok --engine re2 --include-unnamed \"(<%{NONNEGINT:priority}>\s*)?%{SYSLOGTIMESTAMP:timestamp} (%{HOSTNAME:hostname}/%{IPV4:hostip}|%{WORD:host}) %{SYSLOGPROG}:%{GREEDYDATA:message}\""
+  check tenzir 'show version | put version="v4.5.0-71-gae887a0ca3-dirty" | parse version grok "%{TIMESTAMP_ISO8601}" --or "%{GREEDYDATA:version}"'
+  check tenzir 'show version | put version="v4.5.0-71-gae887a0ca3-dirty" | parse version grok --engine re2 "%{TIMESTAMP_ISO8601}" --or "%{GREEDYDATA:version}"'
 }
 
 # bats test_tags=pipelines, csv